@@ -0,0 +1,176 @@
+#include "Game/AABB2Grid.hpp"
+#include "Game/BVH2D.hpp"
+#include <float.h>
+#include <math.h>
+
+void AABB2Grid::Build(std::vector<AABB2> const& boxes, AABB2 const& gridBounds, float cellSize)
+{
+	m_bounds = gridBounds;
+	m_cellSize = (cellSize > 0.f) ? cellSize : 1.f;
+	m_numCellsX = static_cast<int>(ceilf((gridBounds.m_maxs.x - gridBounds.m_mins.x) / m_cellSize));
+	m_numCellsY = static_cast<int>(ceilf((gridBounds.m_maxs.y - gridBounds.m_mins.y) / m_cellSize));
+	m_numCellsX = (m_numCellsX > 1) ? m_numCellsX : 1;
+	m_numCellsY = (m_numCellsY > 1) ? m_numCellsY : 1;
+	int numCells = m_numCellsX * m_numCellsY;
+	int numBoxes = static_cast<int>(boxes.size());
+
+	// Count each cell's boxes, turn the counts into starts, then fill
+	m_cellStarts.assign(numCells + 1, 0);
+	for (int boxIndex = 0; boxIndex < numBoxes; ++boxIndex)
+	{
+		int minCellX, minCellY, maxCellX, maxCellY;
+		GetOverlappedCells(boxes[boxIndex], minCellX, minCellY, maxCellX, maxCellY);
+		for (int cellY = minCellY; cellY <= maxCellY; ++cellY)
+		{
+			for (int cellX = minCellX; cellX <= maxCellX; ++cellX)
+			{
+				++m_cellStarts[GetCellIndex(cellX, cellY) + 1];
+			}
+		}
+	}
+	for (int cellIndex = 0; cellIndex < numCells; ++cellIndex)
+	{
+		m_cellStarts[cellIndex + 1] += m_cellStarts[cellIndex];
+	}
+
+	m_cellBoxIndices.resize(m_cellStarts[numCells]);
+	std::vector<int> cellFillCounts(numCells, 0);
+	for (int boxIndex = 0; boxIndex < numBoxes; ++boxIndex)
+	{
+		int minCellX, minCellY, maxCellX, maxCellY;
+		GetOverlappedCells(boxes[boxIndex], minCellX, minCellY, maxCellX, maxCellY);
+		for (int cellY = minCellY; cellY <= maxCellY; ++cellY)
+		{
+			for (int cellX = minCellX; cellX <= maxCellX; ++cellX)
+			{
+				int cellIndex = GetCellIndex(cellX, cellY);
+				m_cellBoxIndices[m_cellStarts[cellIndex] + cellFillCounts[cellIndex]] = boxIndex;
+				++cellFillCounts[cellIndex];
+			}
+		}
+	}
+
+	m_boxRaycastStamps.assign(numBoxes, 0);
+	m_raycastStamp = 0;
+}
+
+void AABB2Grid::GetOverlappedCells(AABB2 const& box, int& out_minCellX, int& out_minCellY, int& out_maxCellX, int& out_maxCellY) const
+{
+	// Boxes reaching past the grid are clamped into its edge cells, so rays along the edge still find them
+	out_minCellX = static_cast<int>(floorf((box.m_mins.x - m_bounds.m_mins.x) / m_cellSize));
+	out_minCellY = static_cast<int>(floorf((box.m_mins.y - m_bounds.m_mins.y) / m_cellSize));
+	out_maxCellX = static_cast<int>(floorf((box.m_maxs.x - m_bounds.m_mins.x) / m_cellSize));
+	out_maxCellY = static_cast<int>(floorf((box.m_maxs.y - m_bounds.m_mins.y) / m_cellSize));
+	out_minCellX = (out_minCellX < 0) ? 0 : ((out_minCellX >= m_numCellsX) ? m_numCellsX - 1 : out_minCellX);
+	out_minCellY = (out_minCellY < 0) ? 0 : ((out_minCellY >= m_numCellsY) ? m_numCellsY - 1 : out_minCellY);
+	out_maxCellX = (out_maxCellX < 0) ? 0 : ((out_maxCellX >= m_numCellsX) ? m_numCellsX - 1 : out_maxCellX);
+	out_maxCellY = (out_maxCellY < 0) ? 0 : ((out_maxCellY >= m_numCellsY) ? m_numCellsY - 1 : out_maxCellY);
+}
+
+AABB2 AABB2Grid::GetCellBounds(IntVec2 const& cell) const
+{
+	Vec2 cellMins(m_bounds.m_mins.x + m_cellSize * static_cast<float>(cell.x), m_bounds.m_mins.y + m_cellSize * static_cast<float>(cell.y));
+	return AABB2(cellMins, cellMins + Vec2(m_cellSize, m_cellSize));
+}
+
+RaycastResult2D AABB2Grid::Raycast(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, std::vector<AABB2> const& boxes,
+	int& out_boxIndex, AABB2GridQueryStats& out_stats, std::vector<IntVec2>* out_visitedCells)
+{
+	RaycastResult2D nearestImpact;
+	out_boxIndex = -1;
+	out_stats = AABB2GridQueryStats();
+	if (out_visitedCells != nullptr)
+	{
+		out_visitedCells->clear();
+	}
+
+	// Rays starting outside the grid begin walking where they enter it
+	float entryDistance = BVH2D::GetRayEntryDistance(rayStart, rayFwdNormal, rayMaxLength, m_bounds);
+	if (entryDistance < 0.f || m_cellStarts.empty())
+	{
+		return nearestImpact;
+	}
+	++m_raycastStamp;
+
+	Vec2 entryPoint = rayStart + rayFwdNormal * entryDistance;
+	int cellX = static_cast<int>(floorf((entryPoint.x - m_bounds.m_mins.x) / m_cellSize));
+	int cellY = static_cast<int>(floorf((entryPoint.y - m_bounds.m_mins.y) / m_cellSize));
+	cellX = (cellX < 0) ? 0 : ((cellX >= m_numCellsX) ? m_numCellsX - 1 : cellX);
+	cellY = (cellY < 0) ? 0 : ((cellY >= m_numCellsY) ? m_numCellsY - 1 : cellY);
+
+	// Distance to the next vertical and horizontal cell border, and between borders; a snapped
+	// ray never crosses borders on its zero axis
+	int stepX = (rayFwdNormal.x > 0.f) ? 1 : ((rayFwdNormal.x < 0.f) ? -1 : 0);
+	int stepY = (rayFwdNormal.y > 0.f) ? 1 : ((rayFwdNormal.y < 0.f) ? -1 : 0);
+	float nextBorderDistanceX = FLT_MAX;
+	float nextBorderDistanceY = FLT_MAX;
+	float borderSpacingX = FLT_MAX;
+	float borderSpacingY = FLT_MAX;
+	if (stepX != 0)
+	{
+		float borderX = m_bounds.m_mins.x + m_cellSize * static_cast<float>((stepX > 0) ? cellX + 1 : cellX);
+		nextBorderDistanceX = (borderX - rayStart.x) / rayFwdNormal.x;
+		borderSpacingX = m_cellSize / fabsf(rayFwdNormal.x);
+	}
+	if (stepY != 0)
+	{
+		float borderY = m_bounds.m_mins.y + m_cellSize * static_cast<float>((stepY > 0) ? cellY + 1 : cellY);
+		nextBorderDistanceY = (borderY - rayStart.y) / rayFwdNormal.y;
+		borderSpacingY = m_cellSize / fabsf(rayFwdNormal.y);
+	}
+
+	for (;;)
+	{
+		++out_stats.m_numCellsVisited;
+		if (out_visitedCells != nullptr)
+		{
+			out_visitedCells->push_back(IntVec2(cellX, cellY));
+		}
+
+		int cellIndex = GetCellIndex(cellX, cellY);
+		for (int entryIndex = m_cellStarts[cellIndex]; entryIndex < m_cellStarts[cellIndex + 1]; ++entryIndex)
+		{
+			int boxIndex = m_cellBoxIndices[entryIndex];
+			if (m_boxRaycastStamps[boxIndex] == m_raycastStamp)
+			{
+				continue;
+			}
+			m_boxRaycastStamps[boxIndex] = m_raycastStamp;
+
+			++out_stats.m_numBoxesTested;
+			RaycastResult2D impact = RaycastVsAABB2D(rayStart, rayFwdNormal, rayMaxLength, boxes[boxIndex]);
+			if (impact.m_didImpact && (out_boxIndex < 0 || impact.m_impactDist < nearestImpact.m_impactDist))
+			{
+				nearestImpact = impact;
+				out_boxIndex = boxIndex;
+			}
+		}
+
+		float cellExitDistance = (nextBorderDistanceX < nextBorderDistanceY) ? nextBorderDistanceX : nextBorderDistanceY;
+		if (out_boxIndex >= 0 && nearestImpact.m_impactDist <= cellExitDistance)
+		{
+			break;
+		}
+		if (cellExitDistance > rayMaxLength)
+		{
+			break;
+		}
+
+		if (nextBorderDistanceX < nextBorderDistanceY)
+		{
+			cellX += stepX;
+			nextBorderDistanceX += borderSpacingX;
+		}
+		else
+		{
+			cellY += stepY;
+			nextBorderDistanceY += borderSpacingY;
+		}
+		if (cellX < 0 || cellX >= m_numCellsX || cellY < 0 || cellY >= m_numCellsY)
+		{
+			break;
+		}
+	}
+
+	return nearestImpact;
+}
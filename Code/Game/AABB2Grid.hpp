@@ -0,0 +1,51 @@
+#pragma once
+#include "Engine/Math/AABB2.h"
+#include "Engine/Math/IntVec2.hpp"
+#include "Engine/Math/RaycastUtils.hpp"
+#include <vector>
+// -----------------------------------------------------------------------------
+struct AABB2GridQueryStats
+{
+	int m_numCellsVisited = 0;
+	int m_numBoxesTested = 0;
+};
+// -----------------------------------------------------------------------------
+// Uniform grid of box indices over a fixed area; a box is listed in every cell it overlaps.
+// Raycasts walk the cells along the ray with an Amanatides-Woo DDA, nearest first, and stop
+// once the best hit is no farther than where the ray leaves the current cell, since every box
+// holding a nearer point has been tested by then.
+// -----------------------------------------------------------------------------
+class AABB2Grid
+{
+public:
+	void Build(std::vector<AABB2> const& boxes, AABB2 const& gridBounds, float cellSize);
+
+	// Each box is tested at most once per raycast, however many visited cells list it.
+	// out_visitedCells, when given, gets every cell walked, in order.
+	RaycastResult2D Raycast(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, std::vector<AABB2> const& boxes,
+		int& out_boxIndex, AABB2GridQueryStats& out_stats, std::vector<IntVec2>* out_visitedCells = nullptr);
+
+	AABB2 GetCellBounds(IntVec2 const& cell) const;
+	int   GetNumCellsX() const			{ return m_numCellsX; }
+	int   GetNumCellsY() const			{ return m_numCellsY; }
+	float GetCellSize() const			{ return m_cellSize; }
+	int   GetNumEntries() const			{ return static_cast<int>(m_cellBoxIndices.size()); }
+
+private:
+	int GetCellIndex(int cellX, int cellY) const { return cellY * m_numCellsX + cellX; }
+	void GetOverlappedCells(AABB2 const& box, int& out_minCellX, int& out_minCellY, int& out_maxCellX, int& out_maxCellY) const;
+
+private:
+	AABB2 m_bounds;
+	float m_cellSize = 1.f;
+	int	  m_numCellsX = 0;
+	int	  m_numCellsY = 0;
+
+	// Counting-sorted: cell i lists m_cellBoxIndices[m_cellStarts[i]] up to m_cellStarts[i + 1]
+	std::vector<int> m_cellStarts;
+	std::vector<int> m_cellBoxIndices;
+
+	// The raycast a box was last tested in
+	std::vector<int> m_boxRaycastStamps;
+	int m_raycastStamp = 0;
+};
@@ -0,0 +1,256 @@
+#include "Game/AABB2RaycastPackets.hpp"
+#include "Game/SimdUtils.hpp"
+#include <chrono>
+#include <float.h>
+#include <math.h>
+
+// -----------------------------------------------------------------------------
+// std::chrono rather than the engine clock, so the benchmark runs without the platform layer
+static double GetBenchmarkTimeSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// -----------------------------------------------------------------------------
+void AABB2Batch2D::Clear()
+{
+	m_numBoxes = 0;
+	m_minX.clear();
+	m_minY.clear();
+	m_maxX.clear();
+	m_maxY.clear();
+}
+
+void AABB2Batch2D::AddBox(AABB2 const& box)
+{
+	if (m_numBoxes == static_cast<int>(m_minX.size()))
+	{
+		m_minX.resize(m_numBoxes + SIMD_WIDTH, 0.f);
+		m_minY.resize(m_numBoxes + SIMD_WIDTH, 0.f);
+		m_maxX.resize(m_numBoxes + SIMD_WIDTH, 0.f);
+		m_maxY.resize(m_numBoxes + SIMD_WIDTH, 0.f);
+	}
+	m_minX[m_numBoxes] = box.m_mins.x;
+	m_minY[m_numBoxes] = box.m_mins.y;
+	m_maxX[m_numBoxes] = box.m_maxs.x;
+	m_maxY[m_numBoxes] = box.m_maxs.y;
+	++m_numBoxes;
+}
+
+// -----------------------------------------------------------------------------
+// Distances the ray enters and leaves one slab in each lane. With no motion along the axis,
+// 0 * infinity would make NaNs, so the slab is instead always or never overlapped.
+static void GetSlabDistances(float rayStart, float rayFwd, float inverseRayFwd, SimdFloat slabMin, SimdFloat slabMax, SimdFloat& out_entryDistance, SimdFloat& out_exitDistance)
+{
+	if (rayFwd == 0.f)
+	{
+		SimdFloat start = SimdSet(rayStart);
+		SimdFloat isInside = SimdAnd(SimdLessEqual(slabMin, start), SimdLessEqual(start, slabMax));
+		out_entryDistance = SimdSelect(isInside, SimdSet(-FLT_MAX), SimdSet(FLT_MAX));
+		out_exitDistance = SimdSelect(isInside, SimdSet(FLT_MAX), SimdSet(-FLT_MAX));
+		return;
+	}
+
+	SimdFloat start = SimdSet(rayStart);
+	SimdFloat inverseFwd = SimdSet(inverseRayFwd);
+	SimdFloat minDistance = SimdMul(SimdSub(slabMin, start), inverseFwd);
+	SimdFloat maxDistance = SimdMul(SimdSub(slabMax, start), inverseFwd);
+	out_entryDistance = SimdMin(minDistance, maxDistance);
+	out_exitDistance = SimdMax(minDistance, maxDistance);
+}
+
+// One RaycastVsAABB2D per box of the batch, for rays whose SIMD pick the scalar test rejects
+static RaycastResult2D RaycastVsAABB2Batch2DScalar(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, AABB2Batch2D const& boxes, int& out_boxIndex)
+{
+	RaycastResult2D nearestImpact;
+	out_boxIndex = -1;
+	for (int boxIndex = 0; boxIndex < boxes.GetNumBoxes(); ++boxIndex)
+	{
+		AABB2 box(Vec2(boxes.m_minX[boxIndex], boxes.m_minY[boxIndex]), Vec2(boxes.m_maxX[boxIndex], boxes.m_maxY[boxIndex]));
+		RaycastResult2D impact = RaycastVsAABB2D(rayStart, rayFwdNormal, rayMaxLength, box);
+		if (impact.m_didImpact && (out_boxIndex < 0 || impact.m_impactDist < nearestImpact.m_impactDist))
+		{
+			nearestImpact = impact;
+			out_boxIndex = boxIndex;
+		}
+	}
+	return nearestImpact;
+}
+
+RaycastResult2D RaycastVsAABB2Packets2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, AABB2Batch2D const& boxes, int& out_boxIndex)
+{
+	static float const LANE_INDICES[8] = { 0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f };
+	SimdFloat laneIndices = SimdLoad(LANE_INDICES);
+	SimdFloat zero = SimdSet(0.f);
+	SimdFloat maxLength = SimdSet(rayMaxLength);
+	SimdFloat numBoxes = SimdSet(static_cast<float>(boxes.GetNumBoxes()));
+
+	float inverseFwdX = (rayFwdNormal.x != 0.f) ? 1.f / rayFwdNormal.x : 0.f;
+	float inverseFwdY = (rayFwdNormal.y != 0.f) ? 1.f / rayFwdNormal.y : 0.f;
+
+	// Each lane keeps the nearest box among the ones that passed through it; box indices ride
+	// along as floats, exact up to 2^24 boxes
+	SimdFloat nearestDistance = SimdSet(FLT_MAX);
+	SimdFloat nearestBox = SimdSet(-1.f);
+	for (int firstBox = 0; firstBox < boxes.GetNumBoxes(); firstBox += SIMD_WIDTH)
+	{
+		SimdFloat entryX, exitX, entryY, exitY;
+		GetSlabDistances(rayStart.x, rayFwdNormal.x, inverseFwdX, SimdLoad(&boxes.m_minX[firstBox]), SimdLoad(&boxes.m_maxX[firstBox]), entryX, exitX);
+		GetSlabDistances(rayStart.y, rayFwdNormal.y, inverseFwdY, SimdLoad(&boxes.m_minY[firstBox]), SimdLoad(&boxes.m_maxY[firstBox]), entryY, exitY);
+
+		// A ray starting inside a box hits it at distance 0
+		SimdFloat entryDistance = SimdMax(entryX, entryY);
+		SimdFloat exitDistance = SimdMin(exitX, exitY);
+		SimdFloat impactDistance = SimdMax(entryDistance, zero);
+		SimdFloat hitMask = SimdAnd(SimdLessEqual(impactDistance, exitDistance), SimdLessEqual(impactDistance, maxLength));
+
+		SimdFloat boxIndices = SimdAdd(laneIndices, SimdSet(static_cast<float>(firstBox)));
+		hitMask = SimdAnd(hitMask, SimdLessThan(boxIndices, numBoxes));
+
+		SimdFloat isNearer = SimdAnd(hitMask, SimdLessThan(impactDistance, nearestDistance));
+		nearestDistance = SimdSelect(isNearer, impactDistance, nearestDistance);
+		nearestBox = SimdSelect(isNearer, boxIndices, nearestBox);
+	}
+
+	// Ties go to the lowest box index, as in the scalar loop
+	float laneDistances[SIMD_WIDTH];
+	float laneBoxes[SIMD_WIDTH];
+	SimdStore(laneDistances, nearestDistance);
+	SimdStore(laneBoxes, nearestBox);
+	int bestBox = -1;
+	float bestDistance = FLT_MAX;
+	for (int lane = 0; lane < SIMD_WIDTH; ++lane)
+	{
+		int laneBox = static_cast<int>(laneBoxes[lane]);
+		if (laneBox >= 0 && (laneDistances[lane] < bestDistance || (laneDistances[lane] == bestDistance && laneBox < bestBox)))
+		{
+			bestDistance = laneDistances[lane];
+			bestBox = laneBox;
+		}
+	}
+
+	out_boxIndex = -1;
+	if (bestBox < 0)
+	{
+		return RaycastResult2D();
+	}
+
+	AABB2 box(Vec2(boxes.m_minX[bestBox], boxes.m_minY[bestBox]), Vec2(boxes.m_maxX[bestBox], boxes.m_maxY[bestBox]));
+	RaycastResult2D impact = RaycastVsAABB2D(rayStart, rayFwdNormal, rayMaxLength, box);
+	if (!impact.m_didImpact)
+	{
+		// The slabs passed a box the scalar test grazes past; another box may still hit
+		return RaycastVsAABB2Batch2DScalar(rayStart, rayFwdNormal, rayMaxLength, boxes, out_boxIndex);
+	}
+	out_boxIndex = bestBox;
+	return impact;
+}
+
+RaycastResult2D RaycastVsAABB2s2DScalar(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, std::vector<AABB2> const& boxes, int& out_boxIndex)
+{
+	RaycastResult2D nearestImpact;
+	out_boxIndex = -1;
+	for (int boxIndex = 0; boxIndex < static_cast<int>(boxes.size()); ++boxIndex)
+	{
+		RaycastResult2D impact = RaycastVsAABB2D(rayStart, rayFwdNormal, rayMaxLength, boxes[boxIndex]);
+		if (impact.m_didImpact && (out_boxIndex < 0 || impact.m_impactDist < nearestImpact.m_impactDist))
+		{
+			nearestImpact = impact;
+			out_boxIndex = boxIndex;
+		}
+	}
+	return nearestImpact;
+}
+
+// -----------------------------------------------------------------------------
+std::vector<AABB2RaycastBenchmarkResult> RunAABB2RaycastBenchmark()
+{
+	constexpr int NUM_RAYS = 256;
+	constexpr int NUM_BOX_COUNTS = 3;
+	constexpr int BOX_COUNTS[NUM_BOX_COUNTS] = { 16, 1024, 65536 };
+	constexpr int TESTS_PER_RUN = 20000000;
+
+	// Every third ray is snapped vertical and every third horizontal, like the V and H keys;
+	// no RNG so the game's random stream is untouched
+	std::vector<Vec2> rayStarts(NUM_RAYS);
+	std::vector<Vec2> rayFwdNormals(NUM_RAYS);
+	std::vector<float> rayMaxLengths(NUM_RAYS);
+	for (int rayIndex = 0; rayIndex < NUM_RAYS; ++rayIndex)
+	{
+		float fraction = static_cast<float>(rayIndex);
+		rayStarts[rayIndex] = Vec2(fmodf(fraction * 37.3f, 1600.f), fmodf(fraction * 19.7f, 800.f));
+		float angleRadians = fraction * 2.399963f;
+		rayFwdNormals[rayIndex] = Vec2(cosf(angleRadians), sinf(angleRadians));
+		if (rayIndex % 3 == 1)
+		{
+			rayFwdNormals[rayIndex] = Vec2(0.f, (rayFwdNormals[rayIndex].y < 0.f) ? -1.f : 1.f);
+		}
+		else if (rayIndex % 3 == 2)
+		{
+			rayFwdNormals[rayIndex] = Vec2((rayFwdNormals[rayIndex].x < 0.f) ? -1.f : 1.f, 0.f);
+		}
+		rayMaxLengths[rayIndex] = 100.f + fmodf(fraction * 53.1f, 900.f);
+	}
+
+	std::vector<AABB2RaycastBenchmarkResult> results;
+	for (int countIndex = 0; countIndex < NUM_BOX_COUNTS; ++countIndex)
+	{
+		int numBoxes = BOX_COUNTS[countIndex];
+		std::vector<AABB2> boxes;
+		AABB2Batch2D boxBatch;
+		for (int boxIndex = 0; boxIndex < numBoxes; ++boxIndex)
+		{
+			float fraction = static_cast<float>(boxIndex);
+			Vec2 mins(fmodf(fraction * 7.31f + 11.f, 1500.f), fmodf(fraction * 3.71f + 5.f, 700.f));
+			Vec2 size(2.f + fmodf(fraction * 0.37f, 60.f), 2.f + fmodf(fraction * 0.53f, 60.f));
+			boxes.push_back(AABB2(mins, mins + size));
+			boxBatch.AddBox(boxes.back());
+		}
+		double numTestsPerPass = static_cast<double>(NUM_RAYS) * static_cast<double>(numBoxes);
+		int numPasses = static_cast<int>(TESTS_PER_RUN / numTestsPerPass) + 1;
+		double numTests = numTestsPerPass * static_cast<double>(numPasses);
+
+		AABB2RaycastBenchmarkResult result;
+		result.m_numBoxes = numBoxes;
+		result.m_numRays = NUM_RAYS;
+		std::vector<RaycastResult2D> scalarResults(NUM_RAYS);
+		std::vector<RaycastResult2D> simdResults(NUM_RAYS);
+		std::vector<int> scalarBoxes(NUM_RAYS);
+		std::vector<int> simdBoxes(NUM_RAYS);
+
+		double startTime = GetBenchmarkTimeSeconds();
+		for (int passIndex = 0; passIndex < numPasses; ++passIndex)
+		{
+			for (int rayIndex = 0; rayIndex < NUM_RAYS; ++rayIndex)
+			{
+				scalarResults[rayIndex] = RaycastVsAABB2s2DScalar(rayStarts[rayIndex], rayFwdNormals[rayIndex], rayMaxLengths[rayIndex], boxes, scalarBoxes[rayIndex]);
+			}
+		}
+		result.m_scalarNsPerTest = (GetBenchmarkTimeSeconds() - startTime) * 1.0e9 / numTests;
+
+		startTime = GetBenchmarkTimeSeconds();
+		for (int passIndex = 0; passIndex < numPasses; ++passIndex)
+		{
+			for (int rayIndex = 0; rayIndex < NUM_RAYS; ++rayIndex)
+			{
+				simdResults[rayIndex] = RaycastVsAABB2Packets2D(rayStarts[rayIndex], rayFwdNormals[rayIndex], rayMaxLengths[rayIndex], boxBatch, simdBoxes[rayIndex]);
+			}
+		}
+		result.m_simdNsPerTest = (GetBenchmarkTimeSeconds() - startTime) * 1.0e9 / numTests;
+
+		for (int rayIndex = 0; rayIndex < NUM_RAYS; ++rayIndex)
+		{
+			RaycastResult2D const& scalarResult = scalarResults[rayIndex];
+			RaycastResult2D const& simdResult = simdResults[rayIndex];
+			if (scalarBoxes[rayIndex] != simdBoxes[rayIndex] || scalarResult.m_didImpact != simdResult.m_didImpact || scalarResult.m_impactDist != simdResult.m_impactDist ||
+				scalarResult.m_impactPos != simdResult.m_impactPos || scalarResult.m_impactNormal != simdResult.m_impactNormal)
+			{
+				++result.m_numMismatches;
+			}
+		}
+
+		results.push_back(result);
+	}
+
+	return results;
+}
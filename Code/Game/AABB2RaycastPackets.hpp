@@ -0,0 +1,42 @@
+#pragma once
+#include "Engine/Math/AABB2.h"
+#include "Engine/Math/RaycastUtils.hpp"
+#include <vector>
+// -----------------------------------------------------------------------------
+// Boxes one array per component so SIMD_WIDTH of them load at once; the last packet is
+// masked off past m_numBoxes
+// -----------------------------------------------------------------------------
+struct AABB2Batch2D
+{
+	void Clear();
+	void AddBox(AABB2 const& box);
+	int  GetNumBoxes() const			{ return m_numBoxes; }
+
+	int m_numBoxes = 0;
+	std::vector<float> m_minX;
+	std::vector<float> m_minY;
+	std::vector<float> m_maxX;
+	std::vector<float> m_maxY;
+};
+// -----------------------------------------------------------------------------
+struct AABB2RaycastBenchmarkResult
+{
+	int	   m_numBoxes = 0;
+	int	   m_numRays = 0;
+	double m_scalarNsPerTest = 0.0;
+	double m_simdNsPerTest = 0.0;
+	int	   m_numMismatches = 0;
+};
+// -----------------------------------------------------------------------------
+// Nearest box a ray hits, or -1, testing SIMD_WIDTH boxes per slab test against a precomputed
+// inverse ray direction. A zero direction component, as V/H snapped rays have, is handled as
+// the ray running inside or outside that slab for its whole length. The returned result is
+// the scalar RaycastVsAABB2D of the nearest box, so it matches the scalar path exactly. If that
+// test rejects the box the slabs picked, the ray is rescanned with it rather than missing.
+RaycastResult2D RaycastVsAABB2Packets2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, AABB2Batch2D const& boxes, int& out_boxIndex);
+
+// The same query with one RaycastVsAABB2D per box
+RaycastResult2D RaycastVsAABB2s2DScalar(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, std::vector<AABB2> const& boxes, int& out_boxIndex);
+
+// ns per ray-box test for both paths over random and snapped rays, and how many rays they disagreed on
+std::vector<AABB2RaycastBenchmarkResult> RunAABB2RaycastBenchmark();
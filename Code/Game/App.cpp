@@ -67,6 +67,10 @@ void App::Startup()
 
 void App::Shutdown()
 {
+	// The game goes first, joining its worker and bake threads while the engine is still up
+	delete m_theGame;
+	m_theGame = nullptr;
+
 	g_theRenderer->Shutdown();
 	g_theWindow->Shutdown();
 	g_theInput->Shutdown();
@@ -116,12 +120,14 @@ void App::Update()
 	if (g_theInput->WasKeyJustPressed(KEYCODE_F7))
 	{
 		m_currentGameMode = GetNextGameMode();
+		delete m_theGame;
 		m_theGame = CreateNewGameForMode(m_currentGameMode);
 	}
 
 	if (g_theInput->WasKeyJustPressed(KEYCODE_F6))
 	{
 		m_currentGameMode = GetPreviousGameMode();
+		delete m_theGame;
 		m_theGame = CreateNewGameForMode(m_currentGameMode);
 	}
 }
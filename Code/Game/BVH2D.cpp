@@ -0,0 +1,305 @@
+#include "Game/BVH2D.hpp"
+#include <algorithm>
+#include <math.h>
+
+static float GetPerimeter(AABB2 const& bounds)
+{
+	return 2.f * ((bounds.m_maxs.x - bounds.m_mins.x) + (bounds.m_maxs.y - bounds.m_mins.y));
+}
+
+static void GrowBounds(AABB2& bounds, AABB2 const& boundsToInclude)
+{
+	bounds.m_mins.x = fminf(bounds.m_mins.x, boundsToInclude.m_mins.x);
+	bounds.m_mins.y = fminf(bounds.m_mins.y, boundsToInclude.m_mins.y);
+	bounds.m_maxs.x = fmaxf(bounds.m_maxs.x, boundsToInclude.m_maxs.x);
+	bounds.m_maxs.y = fmaxf(bounds.m_maxs.y, boundsToInclude.m_maxs.y);
+}
+
+static int GetSAHBinIndex(float center, float centerMin, float binScale)
+{
+	int binIndex = static_cast<int>((center - centerMin) * binScale);
+	return (binIndex < BVH2D_NUM_SAH_BINS - 1) ? binIndex : BVH2D_NUM_SAH_BINS - 1;
+}
+
+// -----------------------------------------------------------------------------
+void BVH2D::Build(std::vector<AABB2> const& primitiveBounds)
+{
+	int numPrimitives = static_cast<int>(primitiveBounds.size());
+	m_nodes.clear();
+	m_depth = 0;
+	m_primitiveIndices.resize(numPrimitives);
+	m_primitiveCenters.resize(numPrimitives);
+	for (int primitiveIndex = 0; primitiveIndex < numPrimitives; ++primitiveIndex)
+	{
+		AABB2 const& bounds = primitiveBounds[primitiveIndex];
+		m_primitiveIndices[primitiveIndex] = primitiveIndex;
+		m_primitiveCenters[primitiveIndex] = Vec2((bounds.m_mins.x + bounds.m_maxs.x) * 0.5f, (bounds.m_mins.y + bounds.m_maxs.y) * 0.5f);
+	}
+	if (numPrimitives == 0)
+	{
+		return;
+	}
+
+	// A binary tree with leaves of at least one primitive never has more than 2n - 1 nodes, so node references stay valid
+	m_nodes.reserve(2 * numPrimitives - 1);
+	m_nodes.push_back(BVH2DNode());
+	BuildNode(0, 0, numPrimitives, 1, primitiveBounds);
+	m_sahCost = ComputeSAHCost();
+	m_buildSAHCost = m_sahCost;
+}
+
+void BVH2D::Clear()
+{
+	m_nodes.clear();
+	m_primitiveIndices.clear();
+	m_depth = 0;
+	m_sahCost = 0.f;
+	m_buildSAHCost = 0.f;
+}
+
+void BVH2D::Refit(std::vector<AABB2> const& primitiveBounds)
+{
+	// Children always come after their parent, so walking backwards refits them first
+	for (int nodeIndex = static_cast<int>(m_nodes.size()) - 1; nodeIndex >= 0; --nodeIndex)
+	{
+		BVH2DNode& node = m_nodes[nodeIndex];
+		if (node.IsLeaf())
+		{
+			node.m_bounds = primitiveBounds[m_primitiveIndices[node.m_firstChildOrPrimitive]];
+			for (int entryIndex = node.m_firstChildOrPrimitive + 1; entryIndex < node.m_firstChildOrPrimitive + node.m_numPrimitives; ++entryIndex)
+			{
+				GrowBounds(node.m_bounds, primitiveBounds[m_primitiveIndices[entryIndex]]);
+			}
+		}
+		else
+		{
+			node.m_bounds = m_nodes[node.m_firstChildOrPrimitive].m_bounds;
+			GrowBounds(node.m_bounds, m_nodes[node.m_firstChildOrPrimitive + 1].m_bounds);
+		}
+	}
+	m_sahCost = ComputeSAHCost();
+}
+
+void BVH2D::BuildNode(int nodeIndex, int firstPrimitive, int numPrimitives, int depth, std::vector<AABB2> const& primitiveBounds)
+{
+	if (depth > m_depth)
+	{
+		m_depth = depth;
+	}
+
+	// Bounds of the primitives, and of their centers to pick the split axis
+	AABB2 bounds = primitiveBounds[m_primitiveIndices[firstPrimitive]];
+	Vec2 centerMins = m_primitiveCenters[m_primitiveIndices[firstPrimitive]];
+	Vec2 centerMaxs = centerMins;
+	for (int entryIndex = firstPrimitive + 1; entryIndex < firstPrimitive + numPrimitives; ++entryIndex)
+	{
+		int primitiveIndex = m_primitiveIndices[entryIndex];
+		Vec2 const& center = m_primitiveCenters[primitiveIndex];
+		GrowBounds(bounds, primitiveBounds[primitiveIndex]);
+		centerMins.x = fminf(centerMins.x, center.x);
+		centerMins.y = fminf(centerMins.y, center.y);
+		centerMaxs.x = fmaxf(centerMaxs.x, center.x);
+		centerMaxs.y = fmaxf(centerMaxs.y, center.y);
+	}
+
+	BVH2DNode& node = m_nodes[nodeIndex];
+	node.m_bounds = bounds;
+
+	// Primitives sharing one center can't be told apart by any split, so they stay together
+	float centerWidth = centerMaxs.x - centerMins.x;
+	float centerHeight = centerMaxs.y - centerMins.y;
+	if (numPrimitives <= BVH2D_MAX_LEAF_PRIMITIVES || (centerWidth == 0.f && centerHeight == 0.f))
+	{
+		node.m_firstChildOrPrimitive = firstPrimitive;
+		node.m_numPrimitives = numPrimitives;
+		return;
+	}
+
+	bool isSplitOnX = centerWidth >= centerHeight;
+	int numLeftPrimitives = 0;
+	if (depth < BVH2D_MAX_SAH_DEPTH)
+	{
+		numLeftPrimitives = PartitionAtSAHSplit(firstPrimitive, numPrimitives, isSplitOnX, isSplitOnX ? centerMins.x : centerMins.y,
+			isSplitOnX ? centerWidth : centerHeight, primitiveBounds);
+	}
+
+	// Too deep for SAH splits, or every center landed in one bin
+	if (numLeftPrimitives == 0)
+	{
+		numLeftPrimitives = numPrimitives / 2;
+		std::vector<Vec2> const& centers = m_primitiveCenters;
+		std::nth_element(m_primitiveIndices.begin() + firstPrimitive, m_primitiveIndices.begin() + firstPrimitive + numLeftPrimitives,
+			m_primitiveIndices.begin() + firstPrimitive + numPrimitives,
+			[&centers, isSplitOnX](int primitiveA, int primitiveB)
+			{
+				return isSplitOnX ? (centers[primitiveA].x < centers[primitiveB].x) : (centers[primitiveA].y < centers[primitiveB].y);
+			});
+	}
+
+	int firstChild = static_cast<int>(m_nodes.size());
+	node.m_firstChildOrPrimitive = firstChild;
+	node.m_numPrimitives = 0;
+	m_nodes.push_back(BVH2DNode());
+	m_nodes.push_back(BVH2DNode());
+
+	BuildNode(firstChild, firstPrimitive, numLeftPrimitives, depth + 1, primitiveBounds);
+	BuildNode(firstChild + 1, firstPrimitive + numLeftPrimitives, numPrimitives - numLeftPrimitives, depth + 1, primitiveBounds);
+}
+
+int BVH2D::PartitionAtSAHSplit(int firstPrimitive, int numPrimitives, bool isSplitOnX, float centerMin, float centerExtent,
+	std::vector<AABB2> const& primitiveBounds)
+{
+	// Bin the primitives by center
+	int	  binCounts[BVH2D_NUM_SAH_BINS] = {};
+	AABB2 binBounds[BVH2D_NUM_SAH_BINS];
+	float binScale = static_cast<float>(BVH2D_NUM_SAH_BINS) / centerExtent;
+	for (int entryIndex = firstPrimitive; entryIndex < firstPrimitive + numPrimitives; ++entryIndex)
+	{
+		int primitiveIndex = m_primitiveIndices[entryIndex];
+		Vec2 const& center = m_primitiveCenters[primitiveIndex];
+		int binIndex = GetSAHBinIndex(isSplitOnX ? center.x : center.y, centerMin, binScale);
+		if (binCounts[binIndex] == 0)
+		{
+			binBounds[binIndex] = primitiveBounds[primitiveIndex];
+		}
+		else
+		{
+			GrowBounds(binBounds[binIndex], primitiveBounds[primitiveIndex]);
+		}
+		++binCounts[binIndex];
+	}
+
+	// Split s puts bins [0, s] on the left; sweep from the right first for each split's right side
+	float rightPerimeters[BVH2D_NUM_SAH_BINS - 1];
+	int	  rightCounts[BVH2D_NUM_SAH_BINS - 1];
+	AABB2 rightBounds;
+	int	  rightCount = 0;
+	for (int binIndex = BVH2D_NUM_SAH_BINS - 1; binIndex > 0; --binIndex)
+	{
+		if (binCounts[binIndex] > 0)
+		{
+			if (rightCount == 0)
+			{
+				rightBounds = binBounds[binIndex];
+			}
+			else
+			{
+				GrowBounds(rightBounds, binBounds[binIndex]);
+			}
+			rightCount += binCounts[binIndex];
+		}
+		rightCounts[binIndex - 1] = rightCount;
+		rightPerimeters[binIndex - 1] = (rightCount > 0) ? GetPerimeter(rightBounds) : 0.f;
+	}
+
+	// The node's own traversal cost and perimeter are the same for every split, so only the children are compared
+	int	  bestSplit = -1;
+	int	  bestNumLeftPrimitives = 0;
+	float bestCost = 0.f;
+	AABB2 leftBounds;
+	int	  leftCount = 0;
+	for (int splitIndex = 0; splitIndex < BVH2D_NUM_SAH_BINS - 1; ++splitIndex)
+	{
+		if (binCounts[splitIndex] > 0)
+		{
+			if (leftCount == 0)
+			{
+				leftBounds = binBounds[splitIndex];
+			}
+			else
+			{
+				GrowBounds(leftBounds, binBounds[splitIndex]);
+			}
+			leftCount += binCounts[splitIndex];
+		}
+		if (leftCount == 0 || rightCounts[splitIndex] == 0)
+		{
+			continue;
+		}
+
+		float cost = GetPerimeter(leftBounds) * static_cast<float>(leftCount) + rightPerimeters[splitIndex] * static_cast<float>(rightCounts[splitIndex]);
+		if (bestSplit < 0 || cost < bestCost)
+		{
+			bestSplit = splitIndex;
+			bestNumLeftPrimitives = leftCount;
+			bestCost = cost;
+		}
+	}
+
+	if (bestSplit < 0)
+	{
+		return 0;
+	}
+
+	std::vector<Vec2> const& centers = m_primitiveCenters;
+	std::partition(m_primitiveIndices.begin() + firstPrimitive, m_primitiveIndices.begin() + firstPrimitive + numPrimitives,
+		[&centers, isSplitOnX, centerMin, binScale, bestSplit](int primitiveIndex)
+		{
+			return GetSAHBinIndex(isSplitOnX ? centers[primitiveIndex].x : centers[primitiveIndex].y, centerMin, binScale) <= bestSplit;
+		});
+	return bestNumLeftPrimitives;
+}
+
+float BVH2D::ComputeSAHCost() const
+{
+	// Expected cost of a ray through the root, each node weighted by the chance a ray through the root also passes through it
+	if (m_nodes.empty())
+	{
+		return 0.f;
+	}
+	float rootPerimeter = GetPerimeter(m_nodes[0].m_bounds);
+	if (rootPerimeter <= 0.f)
+	{
+		return 0.f;
+	}
+
+	float cost = 0.f;
+	for (int nodeIndex = 0; nodeIndex < static_cast<int>(m_nodes.size()); ++nodeIndex)
+	{
+		BVH2DNode const& node = m_nodes[nodeIndex];
+		float nodeCost = node.IsLeaf() ? BVH2D_SAH_PRIMITIVE_COST * static_cast<float>(node.m_numPrimitives) : BVH2D_SAH_TRAVERSAL_COST;
+		cost += nodeCost * GetPerimeter(node.m_bounds) / rootPerimeter;
+	}
+	return cost;
+}
+
+float BVH2D::GetRayEntryDistance(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, AABB2 const& bounds)
+{
+	// Slab test; a ray parallel to a slab is either inside it the whole way or never
+	float entryDistance = 0.f;
+	float exitDistance = rayMaxLength;
+
+	if (rayFwdNormal.x == 0.f)
+	{
+		if (rayStart.x < bounds.m_mins.x || rayStart.x > bounds.m_maxs.x)
+		{
+			return -1.f;
+		}
+	}
+	else
+	{
+		float inverseFwdX = 1.f / rayFwdNormal.x;
+		float minXDistance = (bounds.m_mins.x - rayStart.x) * inverseFwdX;
+		float maxXDistance = (bounds.m_maxs.x - rayStart.x) * inverseFwdX;
+		entryDistance = fmaxf(entryDistance, fminf(minXDistance, maxXDistance));
+		exitDistance = fminf(exitDistance, fmaxf(minXDistance, maxXDistance));
+	}
+
+	if (rayFwdNormal.y == 0.f)
+	{
+		if (rayStart.y < bounds.m_mins.y || rayStart.y > bounds.m_maxs.y)
+		{
+			return -1.f;
+		}
+	}
+	else
+	{
+		float inverseFwdY = 1.f / rayFwdNormal.y;
+		float minYDistance = (bounds.m_mins.y - rayStart.y) * inverseFwdY;
+		float maxYDistance = (bounds.m_maxs.y - rayStart.y) * inverseFwdY;
+		entryDistance = fmaxf(entryDistance, fminf(minYDistance, maxYDistance));
+		exitDistance = fminf(exitDistance, fmaxf(minYDistance, maxYDistance));
+	}
+
+	return (entryDistance <= exitDistance) ? entryDistance : -1.f;
+}
@@ -0,0 +1,313 @@
+#pragma once
+#include "Engine/Math/AABB2.h"
+#include "Engine/Math/RaycastUtils.hpp"
+#include "Game/WorkerPool.hpp"
+#include <vector>
+// -----------------------------------------------------------------------------
+// Nodes are split until they hold at most this many primitives
+const int BVH2D_MAX_LEAF_PRIMITIVES = 4;
+
+// Split candidates per node along its longer centroid axis
+const int BVH2D_NUM_SAH_BINS = 16;
+
+// Below this depth nodes split at the median instead, so the tree stays shallow however the
+// primitives lie
+const int BVH2D_MAX_SAH_DEPTH = 32;
+
+// Deep enough for BVH2D_MAX_SAH_DEPTH levels of SAH splits over median splits of an int-sized primitive count
+const int BVH2D_MAX_STACK_DEPTH = 64;
+
+// Surface area heuristic costs of stepping into a node and of testing one primitive
+const float BVH2D_SAH_TRAVERSAL_COST = 1.f;
+const float BVH2D_SAH_PRIMITIVE_COST = 1.f;
+// -----------------------------------------------------------------------------
+struct BVH2DNode
+{
+	bool IsLeaf() const { return m_numPrimitives > 0; }
+
+	AABB2 m_bounds;
+
+	// An inner node's children are nodes m_firstChildOrPrimitive and m_firstChildOrPrimitive + 1;
+	// a leaf's primitives are that many entries of the primitive index list from there
+	int	  m_firstChildOrPrimitive = 0;
+	int	  m_numPrimitives = 0;
+};
+// -----------------------------------------------------------------------------
+// 64-bit, since batches and benchmarks sum these over millions of rays
+struct BVH2DQueryStats
+{
+	long long m_numNodesVisited = 0;
+	long long m_numPrimitivesTested = 0;
+};
+// -----------------------------------------------------------------------------
+struct BVH2DRay
+{
+	Vec2  m_start = Vec2::ZERO;
+	Vec2  m_fwdNormal = Vec2::ZERO;
+	float m_maxLength = 0.f;
+};
+// -----------------------------------------------------------------------------
+// Bounding volume hierarchy over 2D primitives, built from their bounds alone so any shape
+// type can sit in it. Each node is split where the surface area heuristic (perimeter, in 2D)
+// says a ray is cheapest to trace, among bins along its longer centroid axis. When primitives
+// move, Refit grows and shrinks the same tree around them; GetSAHCost against GetBuildSAHCost
+// says how much worse it has become than a fresh build.
+// The primitive test is passed into each query, which keeps the tree free of shape types.
+// -----------------------------------------------------------------------------
+class BVH2D
+{
+public:
+	void Build(std::vector<AABB2> const& primitiveBounds);
+	void Clear();
+
+	// Recomputes every node's bounds bottom-up from new primitive bounds, keeping the tree's shape;
+	// there must be as many primitives as it was built with
+	void Refit(std::vector<AABB2> const& primitiveBounds);
+
+	int  GetNumNodes() const			{ return static_cast<int>(m_nodes.size()); }
+	int  GetNumPrimitives() const		{ return static_cast<int>(m_primitiveIndices.size()); }
+	int  GetDepth() const				{ return m_depth; }
+	float GetSAHCost() const			{ return m_sahCost; }
+	float GetBuildSAHCost() const		{ return m_buildSAHCost; }
+
+	// Visits the nearer child first and skips any node that starts past the best hit so far.
+	// raycastPrimitive(primitiveIndex) returns a RaycastResult2D for the same ray.
+	template <typename RaycastPrimitive>
+	RaycastResult2D RaycastNearest(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, RaycastPrimitive const& raycastPrimitive,
+		int& out_primitiveIndex, BVH2DQueryStats& out_stats) const;
+
+	// True as soon as any primitive is hit, for line-of-sight checks that don't need the nearest one.
+	// doesRayHitPrimitive(primitiveIndex) returns whether the same ray hits it; out_primitiveIndex
+	// is the first primitive found, or -1.
+	template <typename DoesRayHitPrimitive>
+	bool RaycastAny(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, DoesRayHitPrimitive const& doesRayHitPrimitive,
+		int& out_primitiveIndex, BVH2DQueryStats& out_stats) const;
+
+	// RaycastNearest for every ray, in chunks of consecutive rays spread over workerPool.
+	// raycastPrimitive(ray, primitiveIndex) returns a RaycastResult2D and must be safe to call
+	// from several threads at once. out_stats is summed over all rays.
+	template <typename RaycastPrimitive>
+	void RaycastNearestBatch(WorkerPool& workerPool, std::vector<BVH2DRay> const& rays, RaycastPrimitive const& raycastPrimitive,
+		std::vector<RaycastResult2D>& out_results, std::vector<int>& out_primitiveIndices, BVH2DQueryStats& out_stats) const;
+
+	// Distance along the ray where it enters the box (0 if it starts inside), or -1 if it misses within rayMaxLength
+	static float GetRayEntryDistance(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, AABB2 const& bounds);
+
+private:
+	void BuildNode(int nodeIndex, int firstPrimitive, int numPrimitives, int depth, std::vector<AABB2> const& primitiveBounds);
+	int  PartitionAtSAHSplit(int firstPrimitive, int numPrimitives, bool isSplitOnX, float centerMin, float centerExtent,
+		std::vector<AABB2> const& primitiveBounds);
+	float ComputeSAHCost() const;
+
+private:
+	std::vector<BVH2DNode> m_nodes;
+	std::vector<int>	   m_primitiveIndices;
+	int m_depth = 0;
+	float m_sahCost = 0.f;
+	float m_buildSAHCost = 0.f;
+
+	// Build scratch, kept so rebuilding the same count doesn't allocate
+	std::vector<Vec2> m_primitiveCenters;
+};
+
+// -----------------------------------------------------------------------------
+template <typename RaycastPrimitive>
+RaycastResult2D BVH2D::RaycastNearest(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, RaycastPrimitive const& raycastPrimitive,
+	int& out_primitiveIndex, BVH2DQueryStats& out_stats) const
+{
+	RaycastResult2D nearestImpact;
+	out_primitiveIndex = -1;
+	out_stats = BVH2DQueryStats();
+	if (m_nodes.empty())
+	{
+		return nearestImpact;
+	}
+
+	float rootEntryDistance = GetRayEntryDistance(rayStart, rayFwdNormal, rayMaxLength, m_nodes[0].m_bounds);
+	if (rootEntryDistance < 0.f)
+	{
+		return nearestImpact;
+	}
+
+	// Nodes wait on the stack with the distance the ray enters them, so a hit found meanwhile can cull them
+	int   stackNodeIndices[BVH2D_MAX_STACK_DEPTH];
+	float stackEntryDistances[BVH2D_MAX_STACK_DEPTH];
+	int   stackSize = 0;
+	stackNodeIndices[stackSize] = 0;
+	stackEntryDistances[stackSize] = rootEntryDistance;
+	++stackSize;
+
+	while (stackSize > 0)
+	{
+		--stackSize;
+		if (nearestImpact.m_didImpact && stackEntryDistances[stackSize] > nearestImpact.m_impactDist)
+		{
+			continue;
+		}
+
+		BVH2DNode const& node = m_nodes[stackNodeIndices[stackSize]];
+		++out_stats.m_numNodesVisited;
+
+		if (node.IsLeaf())
+		{
+			for (int entryIndex = node.m_firstChildOrPrimitive; entryIndex < node.m_firstChildOrPrimitive + node.m_numPrimitives; ++entryIndex)
+			{
+				int primitiveIndex = m_primitiveIndices[entryIndex];
+				++out_stats.m_numPrimitivesTested;
+				RaycastResult2D impact = raycastPrimitive(primitiveIndex);
+				if (impact.m_didImpact && (!nearestImpact.m_didImpact || impact.m_impactDist < nearestImpact.m_impactDist))
+				{
+					nearestImpact = impact;
+					out_primitiveIndex = primitiveIndex;
+				}
+			}
+			continue;
+		}
+
+		float bestDistance = nearestImpact.m_didImpact ? nearestImpact.m_impactDist : rayMaxLength;
+		int childIndexA = node.m_firstChildOrPrimitive;
+		int childIndexB = node.m_firstChildOrPrimitive + 1;
+		float entryDistanceA = GetRayEntryDistance(rayStart, rayFwdNormal, bestDistance, m_nodes[childIndexA].m_bounds);
+		float entryDistanceB = GetRayEntryDistance(rayStart, rayFwdNormal, bestDistance, m_nodes[childIndexB].m_bounds);
+
+		// Push the farther child first so the nearer one is popped next
+		if (entryDistanceA > entryDistanceB)
+		{
+			int swapIndex = childIndexA;
+			childIndexA = childIndexB;
+			childIndexB = swapIndex;
+			float swapDistance = entryDistanceA;
+			entryDistanceA = entryDistanceB;
+			entryDistanceB = swapDistance;
+		}
+		if (entryDistanceB >= 0.f)
+		{
+			stackNodeIndices[stackSize] = childIndexB;
+			stackEntryDistances[stackSize] = entryDistanceB;
+			++stackSize;
+		}
+		if (entryDistanceA >= 0.f)
+		{
+			stackNodeIndices[stackSize] = childIndexA;
+			stackEntryDistances[stackSize] = entryDistanceA;
+			++stackSize;
+		}
+	}
+
+	return nearestImpact;
+}
+
+// -----------------------------------------------------------------------------
+template <typename DoesRayHitPrimitive>
+bool BVH2D::RaycastAny(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, DoesRayHitPrimitive const& doesRayHitPrimitive,
+	int& out_primitiveIndex, BVH2DQueryStats& out_stats) const
+{
+	out_primitiveIndex = -1;
+	out_stats = BVH2DQueryStats();
+	if (m_nodes.empty() || GetRayEntryDistance(rayStart, rayFwdNormal, rayMaxLength, m_nodes[0].m_bounds) < 0.f)
+	{
+		return false;
+	}
+
+	// No hit ever shortens the ray, so nodes only need their index on the stack
+	int stackNodeIndices[BVH2D_MAX_STACK_DEPTH];
+	int stackSize = 0;
+	stackNodeIndices[stackSize] = 0;
+	++stackSize;
+
+	while (stackSize > 0)
+	{
+		--stackSize;
+		BVH2DNode const& node = m_nodes[stackNodeIndices[stackSize]];
+		++out_stats.m_numNodesVisited;
+
+		if (node.IsLeaf())
+		{
+			for (int entryIndex = node.m_firstChildOrPrimitive; entryIndex < node.m_firstChildOrPrimitive + node.m_numPrimitives; ++entryIndex)
+			{
+				int primitiveIndex = m_primitiveIndices[entryIndex];
+				++out_stats.m_numPrimitivesTested;
+				if (doesRayHitPrimitive(primitiveIndex))
+				{
+					out_primitiveIndex = primitiveIndex;
+					return true;
+				}
+			}
+			continue;
+		}
+
+		// The nearer child still goes on top, since blockers near the start tend to be found sooner
+		int childIndexA = node.m_firstChildOrPrimitive;
+		int childIndexB = node.m_firstChildOrPrimitive + 1;
+		float entryDistanceA = GetRayEntryDistance(rayStart, rayFwdNormal, rayMaxLength, m_nodes[childIndexA].m_bounds);
+		float entryDistanceB = GetRayEntryDistance(rayStart, rayFwdNormal, rayMaxLength, m_nodes[childIndexB].m_bounds);
+		if (entryDistanceA > entryDistanceB)
+		{
+			int swapIndex = childIndexA;
+			childIndexA = childIndexB;
+			childIndexB = swapIndex;
+			float swapDistance = entryDistanceA;
+			entryDistanceA = entryDistanceB;
+			entryDistanceB = swapDistance;
+		}
+		if (entryDistanceB >= 0.f)
+		{
+			stackNodeIndices[stackSize] = childIndexB;
+			++stackSize;
+		}
+		if (entryDistanceA >= 0.f)
+		{
+			stackNodeIndices[stackSize] = childIndexA;
+			++stackSize;
+		}
+	}
+
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+template <typename RaycastPrimitive>
+void BVH2D::RaycastNearestBatch(WorkerPool& workerPool, std::vector<BVH2DRay> const& rays, RaycastPrimitive const& raycastPrimitive,
+	std::vector<RaycastResult2D>& out_results, std::vector<int>& out_primitiveIndices, BVH2DQueryStats& out_stats) const
+{
+	int numRays = static_cast<int>(rays.size());
+	out_results.resize(numRays);
+	out_primitiveIndices.resize(numRays);
+	out_stats = BVH2DQueryStats();
+	if (numRays == 0)
+	{
+		return;
+	}
+
+	// A few chunks per thread so one slow chunk of long rays doesn't leave the others idle
+	int numTasks = workerPool.GetNumThreads() * 4;
+	numTasks = (numTasks < numRays) ? numTasks : numRays;
+	int raysPerTask = (numRays + numTasks - 1) / numTasks;
+	std::vector<BVH2DQueryStats> taskStats(numTasks);
+
+	workerPool.ParallelFor(numTasks, [this, &rays, &raycastPrimitive, &out_results, &out_primitiveIndices, &taskStats, numRays, raysPerTask](int taskIndex)
+	{
+		int firstRay = taskIndex * raysPerTask;
+		int lastRay = (firstRay + raysPerTask < numRays) ? firstRay + raysPerTask : numRays;
+		BVH2DQueryStats& stats = taskStats[taskIndex];
+		for (int rayIndex = firstRay; rayIndex < lastRay; ++rayIndex)
+		{
+			BVH2DRay const& ray = rays[rayIndex];
+			BVH2DQueryStats rayStats;
+			out_results[rayIndex] = RaycastNearest(ray.m_start, ray.m_fwdNormal, ray.m_maxLength,
+				[&raycastPrimitive, &ray](int primitiveIndex)
+				{
+					return raycastPrimitive(ray, primitiveIndex);
+				},
+				out_primitiveIndices[rayIndex], rayStats);
+			stats.m_numNodesVisited += rayStats.m_numNodesVisited;
+			stats.m_numPrimitivesTested += rayStats.m_numPrimitivesTested;
+		}
+	});
+
+	for (int taskIndex = 0; taskIndex < numTasks; ++taskIndex)
+	{
+		out_stats.m_numNodesVisited += taskStats[taskIndex].m_numNodesVisited;
+		out_stats.m_numPrimitivesTested += taskStats[taskIndex].m_numPrimitivesTested;
+	}
+}
@@ -0,0 +1,336 @@
+#include "Game/DiscRaycastPackets.hpp"
+#include "Game/SimdUtils.hpp"
+#include <chrono>
+#include <float.h>
+#include <math.h>
+
+// -----------------------------------------------------------------------------
+// std::chrono rather than the engine clock, so the benchmark runs without the platform layer
+static double GetBenchmarkTimeSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int GetNumPaddedEntries(int numEntries)
+{
+	return ((numEntries + SIMD_WIDTH - 1) / SIMD_WIDTH) * SIMD_WIDTH;
+}
+
+// -----------------------------------------------------------------------------
+void RayBatch2D::Resize(int numRays)
+{
+	int numPaddedRays = GetNumPaddedEntries(numRays);
+	m_numRays = numRays;
+	m_startX.assign(numPaddedRays, 0.f);
+	m_startY.assign(numPaddedRays, 0.f);
+	m_fwdX.assign(numPaddedRays, 1.f);
+	m_fwdY.assign(numPaddedRays, 0.f);
+	m_maxLength.assign(numPaddedRays, -1.f);
+}
+
+void RayBatch2D::SetRay(int rayIndex, Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength)
+{
+	m_startX[rayIndex] = rayStart.x;
+	m_startY[rayIndex] = rayStart.y;
+	m_fwdX[rayIndex] = rayFwdNormal.x;
+	m_fwdY[rayIndex] = rayFwdNormal.y;
+	m_maxLength[rayIndex] = rayMaxLength;
+}
+
+// -----------------------------------------------------------------------------
+void DiscBatch2D::Clear()
+{
+	m_numDiscs = 0;
+	m_centerX.clear();
+	m_centerY.clear();
+	m_radius.clear();
+}
+
+void DiscBatch2D::AddDisc(Vec2 const& center, float radius)
+{
+	if (m_numDiscs == static_cast<int>(m_radius.size()))
+	{
+		m_centerX.resize(m_numDiscs + SIMD_WIDTH, 0.f);
+		m_centerY.resize(m_numDiscs + SIMD_WIDTH, 0.f);
+		m_radius.resize(m_numDiscs + SIMD_WIDTH, 0.f);
+	}
+	m_centerX[m_numDiscs] = center.x;
+	m_centerY[m_numDiscs] = center.y;
+	m_radius[m_numDiscs] = radius;
+	++m_numDiscs;
+}
+
+// -----------------------------------------------------------------------------
+// Distance each lane's ray enters its disc, and a mask of the lanes that hit within their length.
+// A ray starting inside a disc hits it at distance 0, as RaycastVsDisc2D reports it.
+static SimdFloat GetRayVsDiscImpactDistances(SimdFloat startX, SimdFloat startY, SimdFloat fwdX, SimdFloat fwdY, SimdFloat maxLength,
+	SimdFloat centerX, SimdFloat centerY, SimdFloat radius, SimdFloat& out_hitMask)
+{
+	SimdFloat zero = SimdSet(0.f);
+	SimdFloat startToCenterX = SimdSub(centerX, startX);
+	SimdFloat startToCenterY = SimdSub(centerY, startY);
+	SimdFloat alongRay = SimdAdd(SimdMul(startToCenterX, fwdX), SimdMul(startToCenterY, fwdY));
+	SimdFloat centerDistanceSquared = SimdAdd(SimdMul(startToCenterX, startToCenterX), SimdMul(startToCenterY, startToCenterY));
+	SimdFloat acrossRaySquared = SimdSub(centerDistanceSquared, SimdMul(alongRay, alongRay));
+	SimdFloat radiusSquared = SimdMul(radius, radius);
+
+	SimdFloat halfChord = SimdSqrt(SimdMax(SimdSub(radiusSquared, acrossRaySquared), zero));
+	SimdFloat impactDistance = SimdSub(alongRay, halfChord);
+
+	SimdFloat isStartInside = SimdLessThan(centerDistanceSquared, radiusSquared);
+	SimdFloat isEnteredAhead = SimdAnd(SimdLessThan(acrossRaySquared, radiusSquared), SimdLessEqual(zero, impactDistance));
+	impactDistance = SimdSelect(isStartInside, zero, impactDistance);
+	out_hitMask = SimdAnd(SimdOr(isStartInside, isEnteredAhead), SimdLessEqual(impactDistance, maxLength));
+	return impactDistance;
+}
+
+static RaycastResult2D RaycastVsDiscs2DScalar(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, DiscBatch2D const& discs, int& out_discIndex)
+{
+	RaycastResult2D nearestImpact;
+	out_discIndex = -1;
+	for (int discIndex = 0; discIndex < discs.GetNumDiscs(); ++discIndex)
+	{
+		Vec2 discCenter(discs.m_centerX[discIndex], discs.m_centerY[discIndex]);
+		RaycastResult2D impact = RaycastVsDisc2D(rayStart, rayFwdNormal, rayMaxLength, discCenter, discs.m_radius[discIndex]);
+		if (impact.m_didImpact && (out_discIndex < 0 || impact.m_impactDist < nearestImpact.m_impactDist))
+		{
+			nearestImpact = impact;
+			out_discIndex = discIndex;
+		}
+	}
+	return nearestImpact;
+}
+
+static void FillNearestResult(RayBatch2D const& rays, DiscBatch2D const& discs, int rayIndex, int discIndex, RaycastResult2D& out_result, int& out_discIndex)
+{
+	Vec2 rayStart(rays.m_startX[rayIndex], rays.m_startY[rayIndex]);
+	Vec2 rayFwdNormal(rays.m_fwdX[rayIndex], rays.m_fwdY[rayIndex]);
+	float rayMaxLength = rays.m_maxLength[rayIndex];
+	if (discIndex < 0)
+	{
+		out_result = RaycastResult2D();
+		out_discIndex = -1;
+		return;
+	}
+
+	Vec2 discCenter(discs.m_centerX[discIndex], discs.m_centerY[discIndex]);
+	out_result = RaycastVsDisc2D(rayStart, rayFwdNormal, rayMaxLength, discCenter, discs.m_radius[discIndex]);
+	out_discIndex = discIndex;
+	if (!out_result.m_didImpact)
+	{
+		// The SIMD test passed a disc the scalar one grazes past; another disc may still hit
+		out_result = RaycastVsDiscs2DScalar(rayStart, rayFwdNormal, rayMaxLength, discs, out_discIndex);
+	}
+}
+
+// -----------------------------------------------------------------------------
+void RaycastRaysVsDiscs2DScalar(RayBatch2D const& rays, DiscBatch2D const& discs, std::vector<RaycastResult2D>& out_results, std::vector<int>& out_discIndices)
+{
+	out_results.resize(rays.GetNumRays());
+	out_discIndices.resize(rays.GetNumRays());
+	for (int rayIndex = 0; rayIndex < rays.GetNumRays(); ++rayIndex)
+	{
+		Vec2 rayStart(rays.m_startX[rayIndex], rays.m_startY[rayIndex]);
+		Vec2 rayFwdNormal(rays.m_fwdX[rayIndex], rays.m_fwdY[rayIndex]);
+		out_results[rayIndex] = RaycastVsDiscs2DScalar(rayStart, rayFwdNormal, rays.m_maxLength[rayIndex], discs, out_discIndices[rayIndex]);
+	}
+}
+
+void RaycastRayPacketsVsDiscs2D(RayBatch2D const& rays, DiscBatch2D const& discs, std::vector<RaycastResult2D>& out_results, std::vector<int>& out_discIndices)
+{
+	out_results.resize(rays.GetNumRays());
+	out_discIndices.resize(rays.GetNumRays());
+
+	float nearestDiscs[SIMD_WIDTH];
+	for (int firstRay = 0; firstRay < rays.GetNumRays(); firstRay += SIMD_WIDTH)
+	{
+		SimdFloat startX = SimdLoad(&rays.m_startX[firstRay]);
+		SimdFloat startY = SimdLoad(&rays.m_startY[firstRay]);
+		SimdFloat fwdX = SimdLoad(&rays.m_fwdX[firstRay]);
+		SimdFloat fwdY = SimdLoad(&rays.m_fwdY[firstRay]);
+		SimdFloat maxLength = SimdLoad(&rays.m_maxLength[firstRay]);
+
+		// Disc indices ride along as floats, exact up to 2^24 discs
+		SimdFloat nearestDistance = SimdSet(FLT_MAX);
+		SimdFloat nearestDisc = SimdSet(-1.f);
+		for (int discIndex = 0; discIndex < discs.GetNumDiscs(); ++discIndex)
+		{
+			SimdFloat hitMask;
+			SimdFloat impactDistance = GetRayVsDiscImpactDistances(startX, startY, fwdX, fwdY, maxLength,
+				SimdSet(discs.m_centerX[discIndex]), SimdSet(discs.m_centerY[discIndex]), SimdSet(discs.m_radius[discIndex]), hitMask);
+
+			SimdFloat isNearer = SimdAnd(hitMask, SimdLessThan(impactDistance, nearestDistance));
+			nearestDistance = SimdSelect(isNearer, impactDistance, nearestDistance);
+			nearestDisc = SimdSelect(isNearer, SimdSet(static_cast<float>(discIndex)), nearestDisc);
+		}
+
+		SimdStore(nearestDiscs, nearestDisc);
+		for (int lane = 0; lane < SIMD_WIDTH && firstRay + lane < rays.GetNumRays(); ++lane)
+		{
+			FillNearestResult(rays, discs, firstRay + lane, static_cast<int>(nearestDiscs[lane]), out_results[firstRay + lane], out_discIndices[firstRay + lane]);
+		}
+	}
+}
+
+RaycastResult2D RaycastVsDiscPackets2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, DiscBatch2D const& discs, int& out_discIndex)
+{
+	static float const LANE_INDICES[8] = { 0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f };
+	SimdFloat laneIndices = SimdLoad(LANE_INDICES);
+
+	SimdFloat startX = SimdSet(rayStart.x);
+	SimdFloat startY = SimdSet(rayStart.y);
+	SimdFloat fwdX = SimdSet(rayFwdNormal.x);
+	SimdFloat fwdY = SimdSet(rayFwdNormal.y);
+	SimdFloat maxLength = SimdSet(rayMaxLength);
+
+	// Each lane keeps the nearest disc among the ones that passed through it
+	SimdFloat nearestDistance = SimdSet(FLT_MAX);
+	SimdFloat nearestDisc = SimdSet(-1.f);
+	for (int firstDisc = 0; firstDisc < discs.GetNumDiscs(); firstDisc += SIMD_WIDTH)
+	{
+		SimdFloat hitMask;
+		SimdFloat impactDistance = GetRayVsDiscImpactDistances(startX, startY, fwdX, fwdY, maxLength,
+			SimdLoad(&discs.m_centerX[firstDisc]), SimdLoad(&discs.m_centerY[firstDisc]), SimdLoad(&discs.m_radius[firstDisc]), hitMask);
+
+		SimdFloat discIndices = SimdAdd(laneIndices, SimdSet(static_cast<float>(firstDisc)));
+		hitMask = SimdAnd(hitMask, SimdLessThan(discIndices, SimdSet(static_cast<float>(discs.GetNumDiscs()))));
+
+		SimdFloat isNearer = SimdAnd(hitMask, SimdLessThan(impactDistance, nearestDistance));
+		nearestDistance = SimdSelect(isNearer, impactDistance, nearestDistance);
+		nearestDisc = SimdSelect(isNearer, discIndices, nearestDisc);
+	}
+
+	// Ties go to the lowest disc index, as in the scalar loop
+	float laneDistances[SIMD_WIDTH];
+	float laneDiscs[SIMD_WIDTH];
+	SimdStore(laneDistances, nearestDistance);
+	SimdStore(laneDiscs, nearestDisc);
+	int bestDisc = -1;
+	float bestDistance = FLT_MAX;
+	for (int lane = 0; lane < SIMD_WIDTH; ++lane)
+	{
+		int laneDisc = static_cast<int>(laneDiscs[lane]);
+		if (laneDisc >= 0 && (laneDistances[lane] < bestDistance || (laneDistances[lane] == bestDistance && laneDisc < bestDisc)))
+		{
+			bestDistance = laneDistances[lane];
+			bestDisc = laneDisc;
+		}
+	}
+
+	out_discIndex = -1;
+	if (bestDisc < 0)
+	{
+		return RaycastResult2D();
+	}
+
+	RaycastResult2D impact = RaycastVsDisc2D(rayStart, rayFwdNormal, rayMaxLength, Vec2(discs.m_centerX[bestDisc], discs.m_centerY[bestDisc]), discs.m_radius[bestDisc]);
+	if (!impact.m_didImpact)
+	{
+		// The SIMD test passed a disc the scalar one grazes past; another disc may still hit
+		return RaycastVsDiscs2DScalar(rayStart, rayFwdNormal, rayMaxLength, discs, out_discIndex);
+	}
+	out_discIndex = bestDisc;
+	return impact;
+}
+
+void RaycastRaysVsDiscPackets2D(RayBatch2D const& rays, DiscBatch2D const& discs, std::vector<RaycastResult2D>& out_results, std::vector<int>& out_discIndices)
+{
+	out_results.resize(rays.GetNumRays());
+	out_discIndices.resize(rays.GetNumRays());
+	for (int rayIndex = 0; rayIndex < rays.GetNumRays(); ++rayIndex)
+	{
+		Vec2 rayStart(rays.m_startX[rayIndex], rays.m_startY[rayIndex]);
+		Vec2 rayFwdNormal(rays.m_fwdX[rayIndex], rays.m_fwdY[rayIndex]);
+		out_results[rayIndex] = RaycastVsDiscPackets2D(rayStart, rayFwdNormal, rays.m_maxLength[rayIndex], discs, out_discIndices[rayIndex]);
+	}
+}
+
+// -----------------------------------------------------------------------------
+static int CountMismatchedRays(std::vector<RaycastResult2D> const& expectedResults, std::vector<int> const& expectedDiscs, std::vector<RaycastResult2D> const& results, std::vector<int> const& discIndices)
+{
+	// The nearest disc may differ on an exact tie in distance, so only the impact itself is compared
+	int numMismatches = 0;
+	for (int rayIndex = 0; rayIndex < static_cast<int>(expectedResults.size()); ++rayIndex)
+	{
+		RaycastResult2D const& expected = expectedResults[rayIndex];
+		RaycastResult2D const& result = results[rayIndex];
+		if (expected.m_didImpact != result.m_didImpact || (expectedDiscs[rayIndex] < 0) != (discIndices[rayIndex] < 0))
+		{
+			++numMismatches;
+		}
+		else if (expected.m_didImpact && (expected.m_impactDist != result.m_impactDist || expected.m_impactPos != result.m_impactPos || expected.m_impactNormal != result.m_impactNormal))
+		{
+			++numMismatches;
+		}
+	}
+	return numMismatches;
+}
+
+std::vector<DiscRaycastBenchmarkResult> RunDiscRaycastBenchmark()
+{
+	constexpr int NUM_RAYS = 1024;
+	constexpr int NUM_DISC_COUNTS = 3;
+	constexpr int DISC_COUNTS[NUM_DISC_COUNTS] = { 16, 256, 4096 };
+	constexpr int TESTS_PER_RUN = 20000000;
+	constexpr float RAY_LENGTH = 600.f;
+
+	// A fan from the middle of the screen; no RNG so the game's random stream is untouched
+	RayBatch2D rays;
+	rays.Resize(NUM_RAYS);
+	for (int rayIndex = 0; rayIndex < NUM_RAYS; ++rayIndex)
+	{
+		float angleRadians = 6.2831853f * static_cast<float>(rayIndex) / static_cast<float>(NUM_RAYS);
+		rays.SetRay(rayIndex, Vec2(800.f, 400.f), Vec2(cosf(angleRadians), sinf(angleRadians)), RAY_LENGTH);
+	}
+
+	std::vector<DiscRaycastBenchmarkResult> results;
+	std::vector<RaycastResult2D> scalarResults;
+	std::vector<RaycastResult2D> packetResults;
+	std::vector<int> scalarDiscs;
+	std::vector<int> packetDiscs;
+
+	for (int countIndex = 0; countIndex < NUM_DISC_COUNTS; ++countIndex)
+	{
+		int numDiscs = DISC_COUNTS[countIndex];
+		DiscBatch2D discs;
+		for (int discIndex = 0; discIndex < numDiscs; ++discIndex)
+		{
+			float fraction = static_cast<float>(discIndex);
+			discs.AddDisc(Vec2(fmodf(fraction * 7.31f + 13.f, 1600.f), fmodf(fraction * 3.71f + 7.f, 800.f)), 2.f + fmodf(fraction * 0.37f, 20.f));
+		}
+		double numTestsPerPass = static_cast<double>(NUM_RAYS) * static_cast<double>(numDiscs);
+		int numPasses = static_cast<int>(TESTS_PER_RUN / numTestsPerPass) + 1;
+		double numTests = numTestsPerPass * static_cast<double>(numPasses);
+
+		DiscRaycastBenchmarkResult result;
+		result.m_numRays = NUM_RAYS;
+		result.m_numDiscs = numDiscs;
+
+		double startTime = GetBenchmarkTimeSeconds();
+		for (int passIndex = 0; passIndex < numPasses; ++passIndex)
+		{
+			RaycastRaysVsDiscs2DScalar(rays, discs, scalarResults, scalarDiscs);
+		}
+		result.m_scalarNsPerTest = (GetBenchmarkTimeSeconds() - startTime) * 1.0e9 / numTests;
+
+		startTime = GetBenchmarkTimeSeconds();
+		for (int passIndex = 0; passIndex < numPasses; ++passIndex)
+		{
+			RaycastRayPacketsVsDiscs2D(rays, discs, packetResults, packetDiscs);
+		}
+		result.m_rayPacketNsPerTest = (GetBenchmarkTimeSeconds() - startTime) * 1.0e9 / numTests;
+		result.m_numMismatches += CountMismatchedRays(scalarResults, scalarDiscs, packetResults, packetDiscs);
+
+		startTime = GetBenchmarkTimeSeconds();
+		for (int passIndex = 0; passIndex < numPasses; ++passIndex)
+		{
+			RaycastRaysVsDiscPackets2D(rays, discs, packetResults, packetDiscs);
+		}
+		result.m_discPacketNsPerTest = (GetBenchmarkTimeSeconds() - startTime) * 1.0e9 / numTests;
+		result.m_numMismatches += CountMismatchedRays(scalarResults, scalarDiscs, packetResults, packetDiscs);
+
+		results.push_back(result);
+	}
+
+	return results;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "Engine/Math/RaycastUtils.hpp"
+#include <vector>
+// -----------------------------------------------------------------------------
+// Rays one array per component so SIMD_WIDTH of them load at once. The arrays are padded
+// to whole packets with rays of negative length, which can never hit anything.
+// -----------------------------------------------------------------------------
+struct RayBatch2D
+{
+	void Resize(int numRays);
+	void SetRay(int rayIndex, Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength);
+	int  GetNumRays() const				{ return m_numRays; }
+
+	int m_numRays = 0;
+	std::vector<float> m_startX;
+	std::vector<float> m_startY;
+	std::vector<float> m_fwdX;
+	std::vector<float> m_fwdY;
+	std::vector<float> m_maxLength;
+};
+// -----------------------------------------------------------------------------
+// Discs one array per component; the last packet is masked off past m_numDiscs
+// -----------------------------------------------------------------------------
+struct DiscBatch2D
+{
+	void Clear();
+	void AddDisc(Vec2 const& center, float radius);
+	int  GetNumDiscs() const			{ return m_numDiscs; }
+
+	int m_numDiscs = 0;
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_radius;
+};
+// -----------------------------------------------------------------------------
+struct DiscRaycastBenchmarkResult
+{
+	int	   m_numRays = 0;
+	int	   m_numDiscs = 0;
+	double m_scalarNsPerTest = 0.0;
+	double m_rayPacketNsPerTest = 0.0;
+	double m_discPacketNsPerTest = 0.0;
+	int	   m_numMismatches = 0;
+};
+// -----------------------------------------------------------------------------
+// Nearest hit of every ray against every disc; out_discIndices is -1 for a ray that hit nothing.
+// The SIMD kernels only pick the nearest disc, then fill its result with the scalar
+// RaycastVsDisc2D, so every result matches the scalar path's for the same disc. A ray
+// whose pick the scalar test rejects is rescanned with it, so it never misses spuriously.
+void RaycastRaysVsDiscs2DScalar(RayBatch2D const& rays, DiscBatch2D const& discs, std::vector<RaycastResult2D>& out_results, std::vector<int>& out_discIndices);
+
+// SIMD_WIDTH rays against one disc at a time
+void RaycastRayPacketsVsDiscs2D(RayBatch2D const& rays, DiscBatch2D const& discs, std::vector<RaycastResult2D>& out_results, std::vector<int>& out_discIndices);
+
+// One ray against SIMD_WIDTH discs at a time
+RaycastResult2D RaycastVsDiscPackets2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, DiscBatch2D const& discs, int& out_discIndex);
+void RaycastRaysVsDiscPackets2D(RayBatch2D const& rays, DiscBatch2D const& discs, std::vector<RaycastResult2D>& out_results, std::vector<int>& out_discIndices);
+
+// ns per ray-disc test for all three paths, and how many rays the SIMD paths disagreed with the scalar path on
+std::vector<DiscRaycastBenchmarkResult> RunDiscRaycastBenchmark();
@@ -17,6 +17,8 @@ enum GameMode
 class Game
 {
 public:
+	virtual ~Game() = default;
+
 	virtual void Update(float deltaSeconds) = 0;
 	virtual void Render() const = 0;
 
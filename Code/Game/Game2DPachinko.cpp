@@ -1,11 +1,34 @@
 #include "Game/Game2DPachinko.hpp"
 #include "Game/App.h"
 #include "Engine/Core/EngineCommon.h"
-#include "Engine/Core/Timer.hpp"
 #include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
 #include "Engine/Input/InputSystem.h"
 #include "Engine/Renderer/Renderer.h"
 #include "Engine/Math/MathUtils.h"
+#include "Game/SimdUtils.hpp"
+#include "Game/PachinkoTimestepController.hpp"
+#include "Game/PachinkoRecording.hpp"
+#include "Game/PachinkoProfiler.hpp"
+#include "Game/PachinkoStressRamp.hpp"
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+
+static char const* GetPachinkoProfileRowName(int rowIndex)
+{
+	if (rowIndex < PACHINKO_PHASE_COUNT)
+	{
+		return GetPachinkoPhaseName(static_cast<PachinkoPhase>(rowIndex));
+	}
+
+	switch (rowIndex)
+	{
+	case PACHINKO_PROFILE_ROW_SHAPE_VERTS: return "shapeVerts";
+	case PACHINKO_PROFILE_ROW_BALL_VERTS:  return "ballVerts";
+	default:							   return "unknown";
+	}
+}
 
 Game2DPachinko::Game2DPachinko(App* owner)
 	:m_theApp(owner)
@@ -16,60 +39,85 @@ Game2DPachinko::Game2DPachinko(App* owner)
 	m_rayCastStart = Vec2(SCREEN_CENTER_X, SCREEN_CENTER_Y);
 	m_rayCastEnd = Vec2(900.f, 300.f);
 
-	m_timeStepAmount = 0.005f;
-	m_physicsTimer = new Timer(static_cast<double>(m_timeStepAmount), m_theApp->m_gameClock);
-	m_physicsTimer->m_startTime = m_theApp->m_gameClock->GetTotalSeconds();
-
-	InitializeGameConfigElements();
-	RandomizeFixedShapes();
+	float targetTimeStep = g_gameConfigBlackboard.GetValue("pachinkoTimeStep", 0.005f);
+	int maxSubsteps = g_gameConfigBlackboard.GetValue("pachinkoMaxSubsteps", 8);
+	bool isAdaptiveTimeStep = g_gameConfigBlackboard.GetValue("pachinkoAdaptiveTimeStep", false);
+	m_timestepController = new PachinkoTimestepController(targetTimeStep, maxSubsteps, isAdaptiveTimeStep);
+
+	m_recordingFilePath = g_gameConfigBlackboard.GetValue("pachinkoRecordingFile", "Data/PachinkoRecording.pchk");
+	m_recordChecksumInterval = g_gameConfigBlackboard.GetValue("pachinkoRecordChecksumInterval", 60);
+	m_profilerNumFrames = g_gameConfigBlackboard.GetValue("pachinkoProfilerFrames", 120);
+
+	float stressSpawnsPerSecond = g_gameConfigBlackboard.GetValue("pachinkoStressSpawnsPerSecond", 1000.f);
+	float stressFrameBudget = g_gameConfigBlackboard.GetValue("pachinkoStressFrameBudget", 0.0166f);
+	int stressOverBudgetFrames = g_gameConfigBlackboard.GetValue("pachinkoStressOverBudgetFrames", 30);
+	int stressSampleInterval = g_gameConfigBlackboard.GetValue("pachinkoStressSampleInterval", 250);
+	m_stressRamp = new PachinkoStressRamp(stressSpawnsPerSecond, stressFrameBudget, stressOverBudgetFrames, stressSampleInterval);
+
+	// Phases are only timed while the profiler is showing
+	m_simulation.SetPhaseTimingOn(false);
+	m_simulation.RandomizeFixedShapes(*g_rng);
+	m_ballVerts.Initialize(m_simulation.GetBalls().GetCapacity());
 }
 
-void Game2DPachinko::InitializeGameConfigElements()
+Game2DPachinko::~Game2DPachinko()
 {
-	// Balls
-	m_pachinkoMinBallRadius = g_gameConfigBlackboard.GetValue("pachinkoMinBallRadius", 0.0f);
-	m_pachinkoMaxBallRadius = g_gameConfigBlackboard.GetValue("pachinkoMaxBallRadius", 0.0f);
-
-	// Discs
-	m_numFixedDiscs = g_gameConfigBlackboard.GetValue("pachinkoNumDiscBumpers", 0);
-	m_fixedDiscMinRadius = g_gameConfigBlackboard.GetValue("pachinkoMinDiscBumperRadius", 0.0f);
-	m_fixedDiscMaxRadius = g_gameConfigBlackboard.GetValue("pachinkoMaxDiscBumperRadius", 0.0f);
-
-	// Capsules
-	m_numFixedCapsules = g_gameConfigBlackboard.GetValue("pachinkoNumCapsuleBumpers", 0);
-	m_minCapsuleLength = g_gameConfigBlackboard.GetValue("pachinkoMinCapsuleBumperLength", 0.0f);
-	m_maxCapsuleLength = g_gameConfigBlackboard.GetValue("pachinkoMaxCapsuleBumperLength", 0.0f);
-	m_minCapsuleRadius = g_gameConfigBlackboard.GetValue("pachinkoMinCapsuleBumperRadius", 0.0f);
-	m_maxCapsuleRadius = g_gameConfigBlackboard.GetValue("pachinkoMaxCapsuleBumperRadius", 0.0f);
-
-	// Obb2s
-	m_numFixedOBB2s = g_gameConfigBlackboard.GetValue("pachinkoNumObbBumpers", 0);
-	m_minOBBwidth = g_gameConfigBlackboard.GetValue("pachinkoMinObbBumperWidth", 0.0f);
-	m_maxOBBwidth = g_gameConfigBlackboard.GetValue("pachinkoMaxObbBumperWidth", 0.0f);
-
-	// Elasticity
-	m_wallElasticity = g_gameConfigBlackboard.GetValue("pachinkoWallElasticity", 0.0f);
-	m_minElasticity = g_gameConfigBlackboard.GetValue("pachinkoMinBumperElasticity", 0.0f);
-	m_maxElasticity = g_gameConfigBlackboard.GetValue("pachinkoMaxBumperElasticity", 0.0f);
-	m_extraWarpHeight = g_gameConfigBlackboard.GetValue("pachinkoExtraWarpHeight", 0);
+	StopRecording();
+
+	delete m_profiler;
+	m_profiler = nullptr;
+
+	delete m_stressRamp;
+	m_stressRamp = nullptr;
+
+	delete m_timestepController;
+	m_timestepController = nullptr;
 }
 
 void Game2DPachinko::Update(float deltaSeconds)
 {
+	unsigned long long numAllocations = GetNumHeapAllocations();
+	m_numFrameAllocations = numAllocations - m_lastFrameAllocationCount;
+	m_lastFrameAllocationCount = numAllocations;
+
+	// The stress ramp needs real frame time, unscaled and unclamped by the game clock
+	double updateStartSeconds = GetCurrentTimeSeconds();
+	float realFrameSeconds = (m_lastUpdateStartSeconds > 0.0) ? static_cast<float>(updateStartSeconds - m_lastUpdateStartSeconds) : 0.f;
+	m_lastUpdateStartSeconds = updateStartSeconds;
+
 	AdjustForPauseAndTimeDistortion(deltaSeconds);
 	ArrowMovement();
 
 	if (g_theInput->WasKeyJustPressed(KEYCODE_F8))
 	{
-		RandomizeFixedShapes();
+		m_simulation.RandomizeFixedShapes(*g_rng);
 	}
 
 	AdjustBallElasticity();
+
+	unsigned long long spawnStartAllocations = GetNumHeapAllocations();
 	BallSpawning();
+	UpdateStressRamp(realFrameSeconds);
+	m_numSimulationAllocations = GetNumHeapAllocations() - spawnStartAllocations;
 
 	if (g_theInput->WasKeyJustPressed('B'))
 	{
-		m_isBottomWarpOn = !m_isBottomWarpOn;
+		m_simulation.ToggleBottomWarp();
+	}
+
+	if (g_theInput->WasKeyJustPressed('Z'))
+	{
+		m_simulation.ToggleSleeping();
+	}
+
+	if (g_theInput->WasKeyJustPressed('O'))
+	{
+		m_simulation.ToggleContinuousCollision();
+	}
+
+	if (g_theInput->WasKeyJustPressed('Q'))
+	{
+		m_simulation.ToggleContactSolver();
 	}
 
 	if (g_theInput->WasKeyJustPressed('P'))
@@ -77,135 +125,94 @@ void Game2DPachinko::Update(float deltaSeconds)
 		m_isFixedTimeStep = !m_isFixedTimeStep;
 	}
 
-	if (m_isFixedTimeStep)
+	if (g_theInput->WasKeyJustPressed('U'))
 	{
-		AdjustTimeStep();
+		m_simulation.ToggleBallGrid();
+	}
+
+	if (g_theInput->WasKeyJustPressed('M'))
+	{
+		RunKernelBenchmark();
+	}
 
-		while (m_physicsTimer->DecrementPeriodIfElapsed())
+	if (g_theInput->WasKeyJustPressed('R'))
+	{
+		if (m_recorder != nullptr)
+		{
+			StopRecording();
+		}
+		else
 		{
-			UpdatePhysics(m_timeStepAmount);
+			StartRecording();
 		}
 	}
-	else
+
+	if (g_theInput->WasKeyJustPressed('V'))
 	{
-		UpdatePhysics(deltaSeconds);
+		ToggleProfiler();
 	}
-}
 
-void Game2DPachinko::AdjustTimeStep()
-{
-	if (g_theInput->WasKeyJustPressed(KEYCODE_RIGHTBRACKET))
+	if (g_theInput->WasKeyJustPressed('X'))
 	{
-		m_timeStepAmount *= 1.1f;
+		ToggleStressRamp();
 	}
-	else if (g_theInput->WasKeyJustPressed(KEYCODE_LEFTBRACKET))
+
+	if (m_profiler != nullptr)
 	{
-		m_timeStepAmount /= 1.1f;
+		m_profiler->BeginFrame();
 	}
-}
+	m_simulation.ResetAccumulatedPhaseSeconds();
 
-void Game2DPachinko::UpdatePhysics(float deltaSeconds)
-{
-	ApplyGravityAndMoveBalls(deltaSeconds);
-	BallsVsBalls();
-	BallsVsBumpers();
-	BallsVsWalls();
-}
+	unsigned long long physicsStartAllocations = GetNumHeapAllocations();
+	if (m_isFixedTimeStep)
+	{
+		AdjustTimeStep();
 
-void Game2DPachinko::ApplyGravityAndMoveBalls(float deltaSeconds)
-{
-	Vec2 downwardAcceleration = Vec2(0.f, -1.f) * 100.f;
+		m_timestepController->Advance(m_simulation, deltaSeconds);
+	}
+	else
+	{
+		m_simulation.Step(deltaSeconds);
+	}
+	m_numSimulationAllocations += GetNumHeapAllocations() - physicsStartAllocations;
 
-	for (int ballIndex = 0; ballIndex < static_cast<int>(m_balls.size()); ++ballIndex)
+	// Ball verts are built here rather than in Render, once the interpolation fraction for this frame is known
 	{
-		m_balls[ballIndex].m_velocity += downwardAcceleration * deltaSeconds;
-		m_balls[ballIndex].m_discCenter += m_balls[ballIndex].m_velocity * deltaSeconds;
+		PachinkoProfileScope profileScope(m_profiler, PACHINKO_PROFILE_ROW_BALL_VERTS);
+		float interpolationFraction = m_isFixedTimeStep ? m_timestepController->GetInterpolationFraction() : 1.f;
+		m_ballVerts.UpdateVerts(m_simulation.GetBalls(), interpolationFraction);
 	}
-}
 
-void Game2DPachinko::BallsVsBalls()
-{
-	for (int i = 0; i < static_cast<int>(m_balls.size()) - 1; ++i)
 	{
-		for (int j = i + 1; j < static_cast<int>(m_balls.size()); ++j)
-		{
-			BounceDiscsOffEachOther2D(m_balls[i].m_discCenter, m_balls[j].m_discCenter, m_balls[i].m_discRadius,     m_balls[j].m_discRadius,
-									  m_balls[i].m_velocity,   m_balls[j].m_velocity,   m_balls[i].m_ballElasticity, m_balls[j].m_ballElasticity);
-		}
+		PachinkoProfileScope profileScope(m_profiler, PACHINKO_PROFILE_ROW_SHAPE_VERTS);
+		BuildShapeVerts();
 	}
-}
 
-void Game2DPachinko::BallsVsBumpers()
-{
-	for (int ballIndex = 0; ballIndex < static_cast<int>(m_balls.size()); ++ballIndex)
+	if (m_profiler != nullptr)
 	{
-		Balls& ball = m_balls[ballIndex];
-		for (int shapeIndex = 0; shapeIndex < static_cast<int>(m_shapes.size()); ++shapeIndex)
+		// Every substep this frame has been summed into the accumulated phase times
+		for (int phaseIndex = 0; phaseIndex < PACHINKO_PHASE_COUNT; ++phaseIndex)
 		{
-			Shapes& shape = m_shapes[shapeIndex];
-
-			// Check fixed disc
-			BounceDiscOffFixedDisc2D(ball.m_discCenter, ball.m_discRadius, ball.m_velocity, ball.m_ballElasticity, shape.m_discCenter, shape.m_discRadius, shape.m_fixedShapeElasticity);
-
-			// Check Capsule
-			Vec2 nearestPointOnCapsule = GetNearestPointOnCapsule2D(ball.m_discCenter, shape.m_capsuleboneStart, shape.m_capsuleboneEnd, shape.m_capsuleRadius);
-			float radiusSum = ball.m_discRadius + shape.m_capsuleRadius;
-			float radiusSumSquared = radiusSum * radiusSum;
-			float distanceSquaredCapsule = GetDistanceSquared2D(ball.m_discCenter, nearestPointOnCapsule);
-
-			if (distanceSquaredCapsule < radiusSumSquared)
-			{
-				BounceDiscOffFixedPoint(ball.m_discCenter, ball.m_discRadius, ball.m_velocity, ball.m_ballElasticity, nearestPointOnCapsule, shape.m_fixedShapeElasticity);
-			}
-
-			//// Check OBB2
-			Vec2 nearestPointOnOBB = GetNearestPointOnOBB2D(ball.m_discCenter, shape.m_orientedBox);
-			float distanceSquared = GetDistanceSquared2D(ball.m_discCenter, nearestPointOnOBB);
-			float ballRadiusSquared = ball.m_discRadius * ball.m_discRadius;
-
-			if (distanceSquared < ballRadiusSquared)
-			{
-				BounceDiscOffFixedPoint(ball.m_discCenter, ball.m_discRadius, ball.m_velocity, ball.m_ballElasticity, nearestPointOnOBB, shape.m_fixedShapeElasticity);
-			}
+			m_profiler->AddSample(phaseIndex, m_simulation.GetAccumulatedPhaseSeconds(static_cast<PachinkoPhase>(phaseIndex)));
 		}
+		m_profiler->EndFrame();
 	}
 }
 
-void Game2DPachinko::BallsVsWalls()
-{
-	CheckNorthAndSouthWalls();
-	CheckEastAndWestWalls();
-}
-
-void Game2DPachinko::CheckEastAndWestWalls()
+void Game2DPachinko::AdjustTimeStep()
 {
-	for (int ballIndex = 0; ballIndex < static_cast<int>(m_balls.size()); ++ballIndex)
+	if (g_theInput->WasKeyJustPressed(KEYCODE_RIGHTBRACKET))
 	{
-		Balls& ball = m_balls[ballIndex];
-		if (ball.m_discCenter.x < ball.m_discRadius)
-		{
-			BounceDiscOffFixedPoint(ball.m_discCenter, ball.m_discRadius, ball.m_velocity, ball.m_ballElasticity, Vec2(0.f, ball.m_discCenter.y), m_wallElasticity);
-		}
-		else if (ball.m_discCenter.x > ball.m_discRadius)
-		{
-			BounceDiscOffFixedPoint(ball.m_discCenter, ball.m_discRadius, ball.m_velocity, ball.m_ballElasticity, Vec2(SCREEN_SIZE_X, ball.m_discCenter.y), m_wallElasticity);
-		}
+		m_timestepController->SetTargetTimeStep(m_timestepController->GetTargetTimeStep() * 1.1f);
+	}
+	else if (g_theInput->WasKeyJustPressed(KEYCODE_LEFTBRACKET))
+	{
+		m_timestepController->SetTargetTimeStep(m_timestepController->GetTargetTimeStep() / 1.1f);
 	}
-}
 
-void Game2DPachinko::CheckNorthAndSouthWalls()
-{
-	for (int ballIndex = 0; ballIndex < static_cast<int>(m_balls.size()); ++ballIndex)
+	if (g_theInput->WasKeyJustPressed('A'))
 	{
-		Balls& ball = m_balls[ballIndex];
-		if (!m_isBottomWarpOn && ball.m_discCenter.y < ball.m_discRadius)
-		{
-			BounceDiscOffFixedPoint(ball.m_discCenter, ball.m_discRadius, ball.m_velocity, ball.m_ballElasticity, Vec2(ball.m_discCenter.x, 0.f), m_wallElasticity);
-		}
-		else if (m_isBottomWarpOn && ball.m_discCenter.y < -ball.m_discRadius)
-		{
-			ball.m_discCenter.y = SCREEN_SIZE_Y + ball.m_discRadius + m_extraWarpHeight;
-		}
+		m_timestepController->ToggleAdaptive();
 	}
 }
 
@@ -219,21 +226,21 @@ void Game2DPachinko::BallSpawning()
 	{
 		SpawnBalls();
 	}
+	if (g_theInput->IsKeyDown('C') && m_simulation.GetBalls().GetNumBalls() > 0)
+	{
+		m_simulation.DespawnBall(0);
+	}
 }
 
 void Game2DPachinko::AdjustBallElasticity()
 {
-	for (int ballIndex = 0; ballIndex < static_cast<int>(m_balls.size()); ++ballIndex)
+	if (g_theInput->WasKeyJustPressed('G'))
 	{
-		m_balls[ballIndex].m_ballElasticity = GetClamped(m_balls[ballIndex].m_ballElasticity, 0.f, 1.f);
-		if (g_theInput->WasKeyJustPressed('G'))
-		{
-			m_balls[ballIndex].m_ballElasticity -= 0.05f;
-		}
-		if (g_theInput->WasKeyJustPressed('H'))
-		{
-			m_balls[ballIndex].m_ballElasticity += 0.05f;
-		}
+		m_simulation.AdjustBallElasticity(-0.05f);
+	}
+	if (g_theInput->WasKeyJustPressed('H'))
+	{
+		m_simulation.AdjustBallElasticity(0.05f);
 	}
 }
 
@@ -310,79 +317,172 @@ void Game2DPachinko::ArrowMovement()
 	}
 }
 
-void Game2DPachinko::RandomizeFixedShapes()
+void Game2DPachinko::SpawnBalls()
 {
-	m_shapes.clear();
-	m_balls.clear();
-
-	// Randomizing Discs
-	for (int discsIndex = 0; discsIndex < m_numFixedDiscs; ++discsIndex)
+	if (m_simulation.GetBalls().IsFull())
 	{
-		Shapes newDiscs;
-		newDiscs.m_discCenter = Vec2(g_rng->RollRandomFloatInRange(0.f, SCREEN_SIZE_X), g_rng->RollRandomFloatInRange(0.f, SCREEN_SIZE_Y));
-		newDiscs.m_discRadius = g_rng->RollRandomFloatInRange(m_fixedDiscMinRadius, m_fixedDiscMaxRadius);
+		return;
+	}
 
-		newDiscs.m_fixedShapeElasticity = g_rng->RollRandomFloatInRange(m_minElasticity, m_maxElasticity);
-		float elasticityAmount = RangeMap(newDiscs.m_fixedShapeElasticity, m_minElasticity, m_maxElasticity, 0.f, 1.f);
-		newDiscs.m_fixedShapeColor = newDiscs.m_fixedShapeColor.Rgba8Interpolate(Rgba8::RED, Rgba8::GREEN, elasticityAmount);
+	float ballRadius = g_rng->RollRandomFloatInRange(m_simulation.GetMinBallRadius(), m_simulation.GetMaxBallRadius());
 
-		m_shapes.push_back(newDiscs);
-	}
+	float colorFraction = g_rng->RollRandomFloatInRange(0.f, 0.9f);
+	Rgba8 ballColor = Rgba8::WHITE;
+	ballColor = ballColor.Rgba8Interpolate(Rgba8::BLUE, Rgba8::WHITE, colorFraction);
 
-	// Randomizing Capsules
-	for (int capsulesIndex = 0; capsulesIndex < m_numFixedCapsules; ++capsulesIndex)
+	m_simulation.SpawnBall(m_rayCastStart, ballRadius, m_rayCastEnd - m_rayCastStart, 0.9f, ballColor);
+}
+
+void Game2DPachinko::StartRecording()
+{
+	m_recorder = new PachinkoRecorder(m_recordChecksumInterval);
+	if (!m_recorder->Open(m_recordingFilePath.c_str()))
 	{
-		Shapes newCapsules;
-		Vec2 center = Vec2(g_rng->RollRandomFloatInRange(50.f, SCREEN_SIZE_X - 50.f),
-			g_rng->RollRandomFloatInRange(50.f, SCREEN_SIZE_Y - 50.f));
+		DebuggerPrintf("Could not open pachinko recording \"%s\"\n", m_recordingFilePath.c_str());
+		delete m_recorder;
+		m_recorder = nullptr;
+		return;
+	}
 
-		float angleDegrees = g_rng->RollRandomFloatInRange(0.f, 360.f);
-		float length = g_rng->RollRandomFloatInRange(m_minCapsuleLength, m_maxCapsuleLength);
-		float halfLength = length * 0.5f;
-		Vec2 direction = Vec2::MakeFromPolarDegrees(angleDegrees);
+	// A recording starts from a fresh, seeded layout so the whole session is in the file
+	unsigned int seed = static_cast<unsigned int>(time(nullptr));
+	srand(seed);
+	m_recorder->BeginSession(seed, m_simulation);
+	m_simulation.SetRecorder(m_recorder);
+	m_simulation.RandomizeFixedShapes(*g_rng);
+}
 
-		newCapsules.m_capsuleboneStart = center - direction * halfLength;
-		newCapsules.m_capsuleboneEnd = center + direction * halfLength;
-		newCapsules.m_capsuleRadius = g_rng->RollRandomFloatInRange(m_minCapsuleRadius, m_maxCapsuleRadius);
+void Game2DPachinko::StopRecording()
+{
+	m_simulation.SetRecorder(nullptr);
+	delete m_recorder;
+	m_recorder = nullptr;
+}
 
-		newCapsules.m_fixedShapeElasticity = g_rng->RollRandomFloatInRange(m_minElasticity, m_maxElasticity);
-		float elasticityAmount = RangeMap(newCapsules.m_fixedShapeElasticity, m_minElasticity, m_maxElasticity, 0.f, 1.f);
-		newCapsules.m_fixedShapeColor = newCapsules.m_fixedShapeColor.Rgba8Interpolate(Rgba8::RED, Rgba8::GREEN, elasticityAmount);
+void Game2DPachinko::ToggleProfiler()
+{
+	if (m_profiler != nullptr)
+	{
+		delete m_profiler;
+		m_profiler = nullptr;
+	}
+	else
+	{
+		m_profiler = new PachinkoProfiler(PACHINKO_PROFILE_ROW_COUNT, m_profilerNumFrames);
+	}
+	m_simulation.SetPhaseTimingOn(m_profiler != nullptr);
+}
 
-		m_shapes.push_back(newCapsules);
+void Game2DPachinko::ToggleStressRamp()
+{
+	if (m_stressRamp->IsRunning())
+	{
+		m_stressRamp->Stop();
+		ReportStressResult();
+	}
+	else
+	{
+		m_stressRamp->Start(m_simulation.GetBalls().GetNumBalls());
+		m_stressResultText.clear();
 	}
+}
 
-	// Randomizing OBB2s
-	for (int obbIndex = 0; obbIndex < m_numFixedOBB2s; ++obbIndex)
+void Game2DPachinko::UpdateStressRamp(float realFrameSeconds)
+{
+	if (!m_stressRamp->IsRunning())
 	{
-		Shapes newOBBs;
+		return;
+	}
 
-		float halfWidth = g_rng->RollRandomFloatInRange(m_minOBBwidth, m_maxOBBwidth);
-		float halfHeight = g_rng->RollRandomFloatInRange(m_minOBBwidth, m_maxOBBwidth);
-		Vec2 boxCenter(g_rng->RollRandomFloatInRange(50.f + halfWidth, SCREEN_SIZE_X - 50.f - halfWidth), g_rng->RollRandomFloatInRange(50.f + halfHeight, SCREEN_SIZE_Y - 50.f - halfHeight));
-		float angle = g_rng->RollRandomFloatInRange(0.f, 360.f);
-		Vec2 iBasisNormal(CosDegrees(angle), SinDegrees(angle));
-		newOBBs.m_orientedBox = OBB2(boxCenter, iBasisNormal, Vec2(halfWidth, halfHeight));
+	PachinkoBalls const& balls = m_simulation.GetBalls();
+	int numSpawns = m_stressRamp->Update(realFrameSeconds, balls.GetNumBalls(), balls.IsFull());
+	for (int spawnIndex = 0; spawnIndex < numSpawns; ++spawnIndex)
+	{
+		SpawnBalls();
+	}
 
-		newOBBs.m_fixedShapeElasticity = g_rng->RollRandomFloatInRange(m_minElasticity, m_maxElasticity);
-		float elasticityAmount = RangeMap(newOBBs.m_fixedShapeElasticity, m_minElasticity, m_maxElasticity, 0.f, 1.f);
-		newOBBs.m_fixedShapeColor = newOBBs.m_fixedShapeColor.Rgba8Interpolate(Rgba8::RED, Rgba8::GREEN, elasticityAmount);
+	if (!m_stressRamp->IsRunning())
+	{
+		ReportStressResult();
+	}
+}
 
-		m_shapes.push_back(newOBBs);
+void Game2DPachinko::ReportStressResult()
+{
+	float budgetMs = m_stressRamp->GetFrameBudgetSeconds() * 1000.f;
+	float peakMs = m_stressRamp->GetPeakFrameSeconds() * 1000.f;
+	int maxBalls = m_stressRamp->GetMaxSustainableBalls();
+	switch (m_stressRamp->GetResult())
+	{
+	case PACHINKO_STRESS_RESULT_OVER_BUDGET:
+		m_stressResultText = Stringf("Stress (X): max sustainable = %d balls under %.1f ms (peak %.1f ms), %d bumpers, %d threads", maxBalls, budgetMs, peakMs,
+			m_simulation.GetBumpers().GetNumBumpers(), m_simulation.GetNumThreads());
+		break;
+	case PACHINKO_STRESS_RESULT_POOL_FULL:
+		m_stressResultText = Stringf("Stress (X): pool full, still under %.1f ms at %d balls (peak %.1f ms); raise pachinkoMaxBalls", budgetMs, maxBalls, peakMs);
+		break;
+	default:
+		m_stressResultText = Stringf("Stress (X): stopped, %d balls under %.1f ms so far (peak %.1f ms)", maxBalls, budgetMs, peakMs);
+		break;
+	}
+
+	DebuggerPrintf("%s\n", m_stressResultText.c_str());
+	DebuggerPrintf("balls, smoothed frame ms\n");
+	std::vector<PachinkoStressSample> const& samples = m_stressRamp->GetSamples();
+	for (int sampleIndex = 0; sampleIndex < static_cast<int>(samples.size()); ++sampleIndex)
+	{
+		DebuggerPrintf("%d, %.3f\n", samples[sampleIndex].m_numBalls, samples[sampleIndex].m_frameSeconds * 1000.f);
 	}
 }
 
-void Game2DPachinko::SpawnBalls()
+void Game2DPachinko::RunKernelBenchmark()
 {
-	Balls* balls = new Balls();
-	balls->m_discCenter = m_rayCastStart;
-	balls->m_discRadius = g_rng->RollRandomFloatInRange(m_pachinkoMinBallRadius, m_pachinkoMaxBallRadius);
-	balls->m_velocity = m_rayCastEnd - m_rayCastStart;
+	std::vector<BallKernelBenchmarkResult> results = RunBallKernelBenchmark(m_simulation.GetWallElasticity(), static_cast<float>(m_simulation.GetExtraWarpHeight()));
 
-	float colorFraction = g_rng->RollRandomFloatInRange(0.f, 0.9f);
-	balls->m_ballColor = balls->m_ballColor.Rgba8Interpolate(Rgba8::BLUE, Rgba8::WHITE, colorFraction);
+	m_kernelBenchmarkText.clear();
+	m_kernelBenchmarkText.push_back(Stringf("Ball kernel benchmark (M), ns per ball-step, SIMD width %d:", SIMD_WIDTH));
+	for (int resultIndex = 0; resultIndex < static_cast<int>(results.size()); ++resultIndex)
+	{
+		BallKernelBenchmarkResult const& result = results[resultIndex];
+		m_kernelBenchmarkText.push_back(Stringf("%6d balls: AoS scalar %.2f, SoA scalar %.2f, SoA SIMD %.2f (%.1fx)", result.m_numBalls,
+			result.m_aosScalarNsPerBall, result.m_soaScalarNsPerBall, result.m_soaSimdNsPerBall, result.m_aosScalarNsPerBall / result.m_soaSimdNsPerBall));
+	}
 
-	m_balls.push_back(*balls);
+	for (int lineIndex = 0; lineIndex < static_cast<int>(m_kernelBenchmarkText.size()); ++lineIndex)
+	{
+		DebuggerPrintf("%s\n", m_kernelBenchmarkText[lineIndex].c_str());
+	}
+}
+
+void Game2DPachinko::BuildShapeVerts()
+{
+	PachinkoBumpers const& bumpers = m_simulation.GetBumpers();
+	m_shapeVerts.clear();
+
+	// Draw arrow
+	AddVertsForArrow2D(m_shapeVerts, m_rayCastStart, m_rayCastEnd, 20.f, 2.f, Rgba8::LIMEGREEN);
+
+
+	// Draw fixed discs
+	for (int discIndex = 0; discIndex < static_cast<int>(bumpers.m_discs.size()); ++discIndex)
+	{
+		DiscBumper const& disc = bumpers.m_discs[discIndex];
+		AddVertsForDisc2D(m_shapeVerts, disc.m_center, disc.m_radius, disc.m_color);
+	}
+
+	// Draw fixed capsules
+	for (int capsuleIndex = 0; capsuleIndex < static_cast<int>(bumpers.m_capsules.size()); ++capsuleIndex)
+	{
+		CapsuleBumper const& capsule = bumpers.m_capsules[capsuleIndex];
+		AddVertsForCapsule2D(m_shapeVerts, capsule.m_boneStart, capsule.m_boneEnd, capsule.m_radius, capsule.m_color);
+	}
+
+	// Draw fixed OBBs
+	for (int obbIndex = 0; obbIndex < static_cast<int>(bumpers.m_boxes.size()); ++obbIndex)
+	{
+		OBB2Bumper const& box = bumpers.m_boxes[obbIndex];
+		AddVertsForOBB2D(m_shapeVerts, box.m_box, box.m_color);
+	}
 }
 
 void Game2DPachinko::Render() const
@@ -390,21 +490,45 @@ void Game2DPachinko::Render() const
 	g_theRenderer->BeginCamera(m_theApp->m_screenCamera);
 	DrawShapes();
 	GamemodeAndControlsText();
+	if (m_profiler != nullptr)
+	{
+		DrawProfiler();
+	}
 }
 
 void Game2DPachinko::GamemodeAndControlsText() const
 {
+	PachinkoBalls const& balls = m_simulation.GetBalls();
 	std::vector<Vertex_PCU> textVerts;
-	Balls ball;
 
-	std::string controlText = "F8 to Reset; LMB/RMB/ESDF/IJKL to Move; Hold T for slow; space/N = ball (" + std::to_string(m_balls.size()) + ");";
-	std::string timeText = Stringf("Timestep = (%0.3f) (P, [,]),", m_timeStepAmount);
+	std::string controlText = "F8 to Reset; LMB/RMB/ESDF/IJKL to Move; Hold T for slow; space/N = ball, C = remove (" + std::to_string(balls.GetNumBalls()) + ");";
+	std::string timeText = Stringf("Timestep = (%0.3f) (P, [,]),", m_timestepController->GetTargetTimeStep());
+	std::string substepText = Stringf("Substeps = %d / %d, last step = %0.4f, adaptive (A) = %s, time dropped = %.2fs", m_timestepController->GetLastNumSubsteps(), m_timestepController->GetMaxSubsteps(),
+		m_timestepController->GetLastTimeStep(), m_timestepController->IsAdaptive() ? "on" : "off", m_timestepController->GetTotalDroppedSeconds());
 	std::string frameRateText = Stringf("dt = %.4f,", m_theApp->m_gameClock->GetDeltaSeconds());
 	std::string fpsText = Stringf("FPS = %.2f", m_theApp->m_gameClock->GetFrameRate());
+	std::string broadphaseText = Stringf("Ball broadphase (U) = %s, candidate pairs = %d, threads = %d", m_simulation.IsBallGridOn() ? "uniform grid" : "brute force", m_simulation.GetNumCandidateBallPairs(), m_simulation.GetNumThreads());
+	// Ball verts are only timed while the profiler is, so the clock stays unread otherwise
+	std::string ballVertsText = "ball verts = (V to time)";
+	if (m_profiler != nullptr)
+	{
+		ballVertsText = Stringf("ball verts = %.0f us avg", m_profiler->GetRowStats(PACHINKO_PROFILE_ROW_BALL_VERTS).m_avgSeconds * 1000000.0);
+	}
+	std::string poolText = Stringf("Ball pool = %d / %d%s, heap allocs last frame = %llu (spawn + physics = %llu), %s", balls.GetNumBalls(), balls.GetCapacity(),
+		balls.IsFull() ? " FULL" : "", m_numFrameAllocations, m_numSimulationAllocations, ballVertsText.c_str());
+	std::string sleepText = Stringf("Sleeping (Z) = %s, awake balls = %d, sleeping balls = %d; CCD (O) = %s, swept balls = %d, sweep hits = %d", m_simulation.IsSleepingOn() ? "on" : "off",
+		balls.GetNumAwakeBalls(), balls.GetNumSleepingBalls(), m_simulation.IsContinuousCollisionOn() ? "on" : "off", m_simulation.GetNumSweptBalls(), m_simulation.GetNumSweepHits());
+	std::string solverText = Stringf("Contact solver (Q) = %s, iterations = %d, contacts = %d", m_simulation.IsContactSolverOn() ? "on" : "off", m_simulation.GetSolverIterations(),
+		m_simulation.GetNumSolverContacts());
+	std::string recordText = "Record (R) = off";
+	if (m_recorder != nullptr)
+	{
+		recordText = Stringf("Recording (R) %d steps, %lld KB", m_recorder->GetNumSessionSteps(), m_recorder->GetNumBytesWritten() / 1024);
+	}
 	std::string ballText;
-	if (!m_balls.empty())
+	if (balls.GetNumBalls() > 0)
 	{
-		ballText = Stringf("Ball elasticity = %0.02f", m_balls[0].m_ballElasticity);
+		ballText = Stringf("Ball elasticity = %0.02f", balls.m_elasticity[0]);
 	}
 
 	m_font->AddVertsForTextInBox2D(textVerts, "Mode (F6/F7 for Prev/Next): Pachinko Machine (2D)", m_gameSceneCoords, 15.f, Rgba8::GOLD, 0.8f, Vec2(0.f, 0.97f));
@@ -412,21 +536,44 @@ void Game2DPachinko::GamemodeAndControlsText() const
 	m_font->AddVertsForTextInBox2D(textVerts, frameRateText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 1.f, Vec2(0.375f, 0.925f));
 	m_font->AddVertsForTextInBox2D(textVerts, fpsText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 1.f, Vec2(0.515f, 0.925f));
 	m_font->AddVertsForTextInBox2D(textVerts, ballText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 1.f, Vec2(0.f, 0.9f));
+	m_font->AddVertsForTextInBox2D(textVerts, recordText, m_gameSceneCoords, 15.f, (m_recorder != nullptr) ? Rgba8::RED : Rgba8::ALICEBLUE, 1.f, Vec2(0.375f, 0.9f));
+	m_font->AddVertsForTextInBox2D(textVerts, broadphaseText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 1.f, Vec2(0.f, 0.875f));
+	m_font->AddVertsForTextInBox2D(textVerts, poolText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 1.f, Vec2(0.f, 0.85f));
+	m_font->AddVertsForTextInBox2D(textVerts, sleepText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 1.f, Vec2(0.f, 0.825f));
+	m_font->AddVertsForTextInBox2D(textVerts, solverText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 1.f, Vec2(0.f, 0.775f));
+
+	for (int lineIndex = 0; lineIndex < static_cast<int>(m_kernelBenchmarkText.size()); ++lineIndex)
+	{
+		float lineAlignmentY = 0.75f - 0.025f * static_cast<float>(lineIndex);
+		m_font->AddVertsForTextInBox2D(textVerts, m_kernelBenchmarkText[lineIndex], m_gameSceneCoords, 15.f, Rgba8::GOLD, 1.f, Vec2(0.f, lineAlignmentY));
+	}
+
+	if (m_stressRamp->IsRunning())
+	{
+		std::string stressText = Stringf("Stress (X): ramping, %d balls, frame = %.1f / %.1f ms", balls.GetNumBalls(), m_stressRamp->GetSmoothedFrameSeconds() * 1000.f,
+			m_stressRamp->GetFrameBudgetSeconds() * 1000.f);
+		m_font->AddVertsForTextInBox2D(textVerts, stressText, m_gameSceneCoords, 15.f, Rgba8::GOLD, 1.f, Vec2(0.f, 0.f));
+	}
+	else if (!m_stressResultText.empty())
+	{
+		m_font->AddVertsForTextInBox2D(textVerts, m_stressResultText, m_gameSceneCoords, 15.f, Rgba8::LIMEGREEN, 1.f, Vec2(0.f, 0.f));
+	}
 
 	if (m_isFixedTimeStep)
 	{
 		m_font->AddVertsForTextInBox2D(textVerts, timeText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 1.f, Vec2(0.f, 0.925f));
+		m_font->AddVertsForTextInBox2D(textVerts, substepText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 1.f, Vec2(0.f, 0.8f));
 	}
 	if (!m_isFixedTimeStep)
 	{
 		m_font->AddVertsForTextInBox2D(textVerts, "variable timestep (P)", m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 1.f, Vec2(0.f, 0.925f));
 	}
 
-	if (m_isBottomWarpOn)
+	if (m_simulation.IsBottomWarpOn())
 	{
 		m_font->AddVertsForTextInBox2D(textVerts, "B=bottom warp on", m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 1.f, Vec2(0.875f, 0.945f));
 	}
-	if (!m_isBottomWarpOn)
+	if (!m_simulation.IsBottomWarpOn())
 	{
 		m_font->AddVertsForTextInBox2D(textVerts, "B=bottom warp off", m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 1.f, Vec2(0.875f, 0.945f));
 	}
@@ -437,47 +584,69 @@ void Game2DPachinko::GamemodeAndControlsText() const
 
 void Game2DPachinko::DrawShapes() const
 {
-	std::vector<Vertex_PCU> shapeVerts;
+	// Shape verts are built in Update so building them can be profiled
+	g_theRenderer->SetBlendMode(BlendMode::ALPHA);
+	g_theRenderer->SetRasterizerMode(RasterizerMode::SOLID_CULL_NONE);
+	g_theRenderer->SetDepthMode(DepthMode::DISABLED);
+	g_theRenderer->BindTexture(nullptr);
+	g_theRenderer->DrawVertexArray(m_shapeVerts);
 
-	// Draw arrow
-	AddVertsForArrow2D(shapeVerts, m_rayCastStart, m_rayCastEnd, 20.f, 2.f, Rgba8::LIMEGREEN);
+	// Draw BALLS, all in one draw from the buffer built in Update
+	g_theRenderer->DrawVertexArray(m_ballVerts.GetNumVerts(), m_ballVerts.GetVerts());
 
+	// Drawing rings around ray start
+	DebugDrawRing(m_rayCastStart, m_simulation.GetMinBallRadius(), 1.f, Rgba8::SAPPHIRE);
+	DebugDrawRing(m_rayCastStart, m_simulation.GetMaxBallRadius(), 1.f, Rgba8::SAPPHIRE);
+}
 
-	// Draw fixed discs
-	for (int discIndex = 0; discIndex < static_cast<int>(m_shapes.size()); ++discIndex)
-	{
-		Shapes const& shape = m_shapes[discIndex];
-		AddVertsForDisc2D(shapeVerts, shape.m_discCenter, shape.m_discRadius, shape.m_fixedShapeColor);
-	}
+void Game2DPachinko::DrawProfiler() const
+{
+	std::vector<Vertex_PCU> barVerts;
+	std::vector<Vertex_PCU> textVerts;
 
-	// Draw fixed capsules
-	for (int capsuleIndex = 0; capsuleIndex < static_cast<int>(m_shapes.size()); ++capsuleIndex)
-	{
-		Shapes const& shape = m_shapes[capsuleIndex];
-		AddVertsForCapsule2D(shapeVerts, shape.m_capsuleboneStart, shape.m_capsuleboneEnd, shape.m_capsuleRadius, shape.m_fixedShapeColor);
-	}
+	// Table on the right under the FPS line, a row per phase with its bar to the right of the numbers
+	float const rowHeight = 16.f;
+	float const textHeight = 12.f;
+	float const textAspect = 0.8f;
+	float const panelMinX = 1010.f;
+	float const panelMaxY = 715.f;
+	float const barMinX = 1440.f;
+	float const barMaxWidth = 140.f;
+	int numLines = PACHINKO_PROFILE_ROW_COUNT + 2;
 
-	// Draw fixed OBBs
-	for (int obbIndex = 0; obbIndex < static_cast<int>(m_shapes.size()); ++obbIndex)
+	AABB2 panelBounds(Vec2(panelMinX - 5.f, panelMaxY - rowHeight * static_cast<float>(numLines) - 5.f), Vec2(barMinX + barMaxWidth + 5.f, panelMaxY + 5.f));
+	AddVertsForAABB2D(barVerts, panelBounds, Rgba8(0, 0, 0, 180));
+
+	std::string titleText = Stringf("Profiler (V), last %d / %d frames, bar = avg, tick = p99", m_profiler->GetNumFramesRecorded(), m_profiler->GetNumFrames());
+	std::string headerText = Stringf("%-12s %7s %7s %7s %7s", "(us)", "min", "avg", "max", "p99");
+	m_font->AddVertsForText2D(textVerts, Vec2(panelMinX, panelMaxY - rowHeight), textHeight, titleText, Rgba8::GOLD, textAspect);
+	m_font->AddVertsForText2D(textVerts, Vec2(panelMinX, panelMaxY - rowHeight * 2.f), textHeight, headerText, Rgba8::GOLD, textAspect);
+
+	// Every bar shares one scale so the phases can be compared by eye
+	double barScaleSeconds = 0.000001;
+	for (int rowIndex = 0; rowIndex < PACHINKO_PROFILE_ROW_COUNT; ++rowIndex)
 	{
-		Shapes const& shape = m_shapes[obbIndex];
-		AddVertsForOBB2D(shapeVerts, shape.m_orientedBox, shape.m_fixedShapeColor);
+		barScaleSeconds = fmax(barScaleSeconds, m_profiler->GetRowStats(rowIndex).m_p99Seconds);
 	}
 
-	// Draw BALLS
-	for (int ballIndex = 0; ballIndex < static_cast<int>(m_balls.size()); ++ballIndex)
+	for (int rowIndex = 0; rowIndex < PACHINKO_PROFILE_ROW_COUNT; ++rowIndex)
 	{
-		Balls const& ball = m_balls[ballIndex];
-		AddVertsForDisc2D(shapeVerts, ball.m_discCenter, ball.m_discRadius, ball.m_ballColor);
+		PachinkoProfileStats const& stats = m_profiler->GetRowStats(rowIndex);
+		float rowMinY = panelMaxY - rowHeight * static_cast<float>(rowIndex + 3);
+
+		std::string rowText = Stringf("%-12s %7.1f %7.1f %7.1f %7.1f", GetPachinkoProfileRowName(rowIndex), stats.m_minSeconds * 1000000.0, stats.m_avgSeconds * 1000000.0,
+			stats.m_maxSeconds * 1000000.0, stats.m_p99Seconds * 1000000.0);
+		m_font->AddVertsForText2D(textVerts, Vec2(panelMinX, rowMinY), textHeight, rowText, Rgba8::ALICEBLUE, textAspect);
+
+		float avgWidth = barMaxWidth * static_cast<float>(stats.m_avgSeconds / barScaleSeconds);
+		float p99X = barMinX + barMaxWidth * static_cast<float>(stats.m_p99Seconds / barScaleSeconds);
+		AddVertsForAABB2D(barVerts, AABB2(Vec2(barMinX, rowMinY), Vec2(barMinX + barMaxWidth, rowMinY + textHeight)), Rgba8::DARKGRAY);
+		AddVertsForAABB2D(barVerts, AABB2(Vec2(barMinX, rowMinY), Vec2(barMinX + avgWidth, rowMinY + textHeight)), Rgba8::LIMEGREEN);
+		AddVertsForAABB2D(barVerts, AABB2(Vec2(p99X - 1.f, rowMinY - 1.f), Vec2(p99X + 1.f, rowMinY + textHeight + 1.f)), Rgba8::RED);
 	}
 
-	g_theRenderer->SetBlendMode(BlendMode::ALPHA);
-	g_theRenderer->SetRasterizerMode(RasterizerMode::SOLID_CULL_NONE);
-	g_theRenderer->SetDepthMode(DepthMode::DISABLED);
 	g_theRenderer->BindTexture(nullptr);
-	g_theRenderer->DrawVertexArray(shapeVerts);
-
-	// Drawing rings around ray start
-	DebugDrawRing(m_rayCastStart, m_pachinkoMinBallRadius, 1.f, Rgba8::SAPPHIRE);
-	DebugDrawRing(m_rayCastStart, m_pachinkoMaxBallRadius, 1.f, Rgba8::SAPPHIRE);
+	g_theRenderer->DrawVertexArray(barVerts);
+	g_theRenderer->BindTexture(&m_font->GetTexture());
+	g_theRenderer->DrawVertexArray(textVerts);
 }
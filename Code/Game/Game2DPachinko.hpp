@@ -1,105 +1,90 @@
 #pragma once
 #include "Game/Game.h"
 #include "Engine/Math/AABB2.h"
-#include "Engine/Math/OBB2.hpp"
 #include "Engine/Core/Vertex_PCU.h"
+#include "Game/PachinkoSimulation.hpp"
+#include "Game/PachinkoBallVerts.hpp"
+#include <string>
 #include <vector>
 // -----------------------------------------------------------------------------
 class BitmapFont;
-class Timer;
+class PachinkoProfiler;
+class PachinkoRecorder;
+class PachinkoStressRamp;
+class PachinkoTimestepController;
 // -----------------------------------------------------------------------------
-struct Shapes
+// Profiler rows are the simulation phases followed by the per-frame vertex building
+enum PachinkoProfileRow
 {
-	Vec2 m_discCenter = Vec2::ZERO;
-	float m_discRadius = 0.0f;
-
-	Vec2 m_capsuleboneStart = Vec2::ZERO;
-	Vec2 m_capsuleboneEnd = Vec2::ZERO;
-	float m_capsuleRadius = 0.f;
-
-	OBB2 m_orientedBox;
-
-	float m_fixedShapeElasticity = 0.9f;
-	Rgba8 m_fixedShapeColor = Rgba8::WHITE;
-};
-struct Balls
-{
-	Vec2 m_discCenter = Vec2::ZERO;
-	float m_discRadius = 0.0f;
-
-	Vec2 m_velocity = Vec2::ZERO;
-
-	float m_ballElasticity = 0.9f;
-	Rgba8 m_ballColor = Rgba8::WHITE;
+	PACHINKO_PROFILE_ROW_SHAPE_VERTS = PACHINKO_PHASE_COUNT,
+	PACHINKO_PROFILE_ROW_BALL_VERTS,
+	PACHINKO_PROFILE_ROW_COUNT
 };
+// -----------------------------------------------------------------------------
 class Game2DPachinko : public Game
 {
 public:
 	Game2DPachinko(App* owner);
-
-	void InitializeGameConfigElements();
+	~Game2DPachinko();
 
 	void Update(float deltaSeconds) override;
 
 	void AdjustTimeStep();
-
-	// Physics checks
-	void UpdatePhysics(float deltaSeconds);
-	void ApplyGravityAndMoveBalls(float deltaSeconds);
-	void BallsVsBalls();
-	void BallsVsBumpers();
-	void BallsVsWalls();
-
-	void CheckEastAndWestWalls();
-	void CheckNorthAndSouthWalls();
 	void BallSpawning();
 	void AdjustBallElasticity();
-
 	void ArrowMovement();
-	void RandomizeFixedShapes();
 	void SpawnBalls();
+	void StartRecording();
+	void StopRecording();
+	void ToggleProfiler();
+	void ToggleStressRamp();
+	void UpdateStressRamp(float realFrameSeconds);
+	void ReportStressResult();
+	void RunKernelBenchmark();
+	void BuildShapeVerts();
 
 	void Render() const override;
 	void GamemodeAndControlsText() const;
 	void DrawShapes() const;
+	void DrawProfiler() const;
 // -----------------------------------------------------------------------------
 private:
 	App* m_theApp = nullptr;
 	BitmapFont* m_font = nullptr;
 	AABB2 m_gameSceneCoords;
-	std::vector<Shapes> m_shapes;
-	std::vector<Balls>  m_balls;
-	bool m_isBottomWarpOn = true;
+	PachinkoSimulation m_simulation;
 
 	// Time
-	Timer* m_physicsTimer = nullptr;
-	float  m_timeStepAmount = 0.0f;
-	bool   m_isFixedTimeStep = false;
+	PachinkoTimestepController* m_timestepController = nullptr;
+	bool m_isFixedTimeStep = false;
 
 	// Shapes
 	Vec2 m_rayCastStart = Vec2::ZERO;
 	Vec2 m_rayCastEnd = Vec2::ZERO;
 
-	float  m_pachinkoMinBallRadius = 0.f;
-	float  m_pachinkoMaxBallRadius = 0.f;
+	// Heap allocations counted over the last frame, and over just the spawning and physics part of it
+	unsigned long long m_lastFrameAllocationCount = 0;
+	unsigned long long m_numFrameAllocations = 0;
+	unsigned long long m_numSimulationAllocations = 0;
+
+	// Shape and ball rendering
+	std::vector<Vertex_PCU> m_shapeVerts;
+	PachinkoBallVerts m_ballVerts;
 
-	int    m_numFixedDiscs = 0;
-	float  m_fixedDiscMinRadius = 0.f;
-	float  m_fixedDiscMaxRadius = 0.f;
+	// Session recording, appended to m_recordingFilePath while R is on
+	PachinkoRecorder* m_recorder = nullptr;
+	std::string m_recordingFilePath;
+	int m_recordChecksumInterval = 60;
 
-	int    m_numFixedCapsules = 0;
-	float  m_minCapsuleLength = 0.f;
-	float  m_maxCapsuleLength = 0.f;
-	float  m_minCapsuleRadius = 0.f;
-	float  m_maxCapsuleRadius = 0.f;
+	// Per-phase profiler, only allocated while V is on so it costs nothing when off
+	PachinkoProfiler* m_profiler = nullptr;
+	int m_profilerNumFrames = 120;
 
-	int    m_numFixedOBB2s = 0;
-	float  m_minOBBwidth = 0.0f;
-	float  m_maxOBBwidth = 0.0f;
+	// Stress ramp (X), spawning on a real-time rate until frame time passes the budget
+	PachinkoStressRamp* m_stressRamp = nullptr;
+	double m_lastUpdateStartSeconds = 0.0;
+	std::string m_stressResultText;
 
-	// Elasticity
-	float m_wallElasticity = 0.0f;
-	float m_minElasticity = 0.0f;
-	float m_maxElasticity = 0.0f;
-	int   m_extraWarpHeight = 0;
+	// Kernel benchmark results
+	std::vector<std::string> m_kernelBenchmarkText;
 };
\ No newline at end of file
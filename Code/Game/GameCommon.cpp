@@ -4,6 +4,163 @@
 #include "Engine/Math/Vec2.hpp"
 #include <Engine/Core/Vertex_PCU.h>
 #include "Engine/Renderer/Renderer.h"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// Every heap allocation in the game goes through here, so modes can show allocations per frame.
+// That includes the nothrow and over-aligned forms, which SIMD buffers use.
+static std::atomic<unsigned long long> s_numHeapAllocations(0);
+
+static void* AllocateCounted(size_t size)
+{
+	++s_numHeapAllocations;
+	return malloc(size == 0 ? 1 : size);
+}
+
+static void* AllocateCountedAligned(size_t size, std::align_val_t alignment)
+{
+	++s_numHeapAllocations;
+	size = (size == 0) ? 1 : size;
+#if defined(_WIN32)
+	return _aligned_malloc(size, static_cast<size_t>(alignment));
+#else
+	void* memory = nullptr;
+	if (posix_memalign(&memory, static_cast<size_t>(alignment), size) != 0)
+	{
+		return nullptr;
+	}
+	return memory;
+#endif
+}
+
+// Aligned blocks must go back the way they came; _aligned_malloc's can't be passed to free
+static void FreeAligned(void* memory)
+{
+#if defined(_WIN32)
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+}
+
+void* operator new(size_t size)
+{
+	void* memory = AllocateCounted(size);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, std::nothrow_t const&) noexcept
+{
+	return AllocateCounted(size);
+}
+
+void* operator new[](size_t size, std::nothrow_t const&) noexcept
+{
+	return AllocateCounted(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* memory = AllocateCountedAligned(size, alignment);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept
+{
+	return AllocateCountedAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept
+{
+	return AllocateCountedAligned(size, alignment);
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, std::nothrow_t const&) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, std::nothrow_t const&) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, std::nothrow_t const&) noexcept
+{
+	FreeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, std::nothrow_t const&) noexcept
+{
+	FreeAligned(memory);
+}
+
+unsigned long long GetNumHeapAllocations()
+{
+	return s_numHeapAllocations.load(std::memory_order_relaxed);
+}
 
 void DebugDrawRing(Vec2 const& center, float radius, float thickness, Rgba8 const& color)
 {
@@ -8,11 +8,24 @@
 #include "Engine/Math/AABB2.h"
 #include "Engine/Math/OBB2.hpp"
 #include "Engine/Math/MathUtils.h"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include <math.h>
 
 GameNearestPoint::GameNearestPoint(App* owner)
 	:m_theApp(owner)
+	,m_isSDFBakeDone(false)
+	,m_isSDFBakeCancelled(false)
 {
 	m_font = g_theRenderer->CreateOrGetBitmapFont("Data/Fonts/SquirrelFixedFont");
+
+	m_sdfCoarseCellSize = g_gameConfigBlackboard.GetValue("nearestPointSDFCoarseCellSize", SDF_COARSE_CELL_SIZE);
+	m_numSDFFineCellsPerCoarseCell = g_gameConfigBlackboard.GetValue("nearestPointSDFFineCellsPerCoarseCell", SDF_FINE_CELLS_PER_COARSE_CELL);
+	m_sdfRefineTolerance = g_gameConfigBlackboard.GetValue("nearestPointSDFRefineTolerance", SDF_REFINE_TOLERANCE);
+	m_sdfBoundsMargin = g_gameConfigBlackboard.GetValue("nearestPointSDFBoundsMargin", SDF_BOUNDS_MARGIN);
+	m_sdfHeatmapCellSize = g_gameConfigBlackboard.GetValue("nearestPointSDFHeatmapCellSize", SDF_HEATMAP_CELL_SIZE);
+	m_sdfHeatmapMaxError = g_gameConfigBlackboard.GetValue("nearestPointSDFHeatmapMaxError", SDF_HEATMAP_MAX_ERROR);
 	RandomShapes();
 
 	m_playerPoint = Vec2(SCREEN_CENTER_X, SCREEN_CENTER_Y);
@@ -22,6 +35,15 @@ GameNearestPoint::GameNearestPoint(App* owner)
 
 GameNearestPoint::~GameNearestPoint()
 {
+	if (m_sdfBakeThread.joinable())
+	{
+		m_isSDFBakeCancelled = true;
+		m_sdfBakeThread.join();
+	}
+	delete m_bakingSDF;
+	m_bakingSDF = nullptr;
+	delete m_sdf;
+	m_sdf = nullptr;
 }
 
 void GameNearestPoint::Update(float deltaSeconds)
@@ -34,6 +56,17 @@ void GameNearestPoint::Update(float deltaSeconds)
 	{
 		RandomShapes();
 	}
+	UpdateSDFBake();
+
+	// Distance field lookups and error heatmap
+	if (g_theInput->WasKeyJustPressed('B'))
+	{
+		m_isSDFLookupOn = !m_isSDFLookupOn;
+	}
+	if (g_theInput->WasKeyJustPressed('H'))
+	{
+		m_isSDFHeatmapOn = !m_isSDFHeatmapOn;
+	}
 
 	PlayerMovement(deltaSeconds);
 	GetNearestPointCheck();
@@ -79,8 +112,24 @@ void GameNearestPoint::Render() const
 	RenderTriangle();
 	RenderLineSegment();
 	RenderInfiniteLine();
+	if (m_isSDFHeatmapOn)
+	{
+		RenderSDFHeatmap();
+	}
 	RenderPlayerPoint();
 
+	if (m_isSDFLookupOn && m_sdf != nullptr)
+	{
+		// Exact nearest point in orange, under the field's in green
+		RenderNearestPoint(m_analyticClosestPoint, Rgba8(255, 160, 0));
+		RenderNearestPoint(m_closestPointToPlayer, Rgba8(255, 160, 0));
+		LineToPoint(m_closestPointToPlayer);
+
+		GameModeAndControlsText();
+		SDFText();
+		return;
+	}
+
 	// Rendering gold orange nearest Point
 	RenderNearestPoint(m_nearestDiscPoint, Rgba8(255, 160, 0));
 	RenderNearestPoint(m_nearestAABBPoint, Rgba8(255, 160, 0));
@@ -100,13 +149,40 @@ void GameNearestPoint::Render() const
 	LineToPoint(m_nearestInfiniteLinePoint);
 
 	GameModeAndControlsText();
+	SDFText();
 }
 
 void GameNearestPoint::GameModeAndControlsText() const
 {
 	std::vector<Vertex_PCU> textVerts;
 	m_font->AddVertsForTextInBox2D(textVerts, "Mode (F6/F7 for Prev/Next): Nearest Point (2D)", m_gameSceneCoords, 15.f, Rgba8::GOLD, 0.8f, Vec2(0.f, 0.97f));
-	m_font->AddVertsForTextInBox2D(textVerts, "F8 to Randomize; LMB to move dot; ESDF to move dot; Arrows to move dot; Hold T to slow", m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.945f));
+	m_font->AddVertsForTextInBox2D(textVerts, "F8 to Randomize; LMB to move dot; ESDF to move dot; Arrows to move dot; Hold T to slow; B for distance field; H for its error", m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.945f));
+	g_theRenderer->BindTexture(&m_font->GetTexture());
+	g_theRenderer->DrawVertexArray(textVerts);
+}
+
+void GameNearestPoint::SDFText() const
+{
+	std::vector<Vertex_PCU> textVerts;
+	if (m_sdf == nullptr)
+	{
+		m_font->AddVertsForTextInBox2D(textVerts, "Distance field (B) = baking...", m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.92f));
+	}
+	else
+	{
+		std::string bakeText = Stringf("Distance field (B) = %s, heatmap (H) = %s; %d cells of %.0f px, %d refined to %.1f px, %d samples, baked in %.1f ms off the main thread; error mean %.3f, max %.2f px",
+			m_isSDFLookupOn ? "on" : "off", m_isSDFHeatmapOn ? "on" : "off", m_sdf->GetNumCoarseCells(), m_sdf->GetCoarseCellSize(), m_sdf->GetNumFineBlocks(),
+			m_sdf->GetFineCellSize(), m_sdf->GetNumSamples(), m_sdf->GetBakeSeconds() * 1000.0, m_sdf->GetMeanHeatmapError(), m_sdf->GetMaxHeatmapError());
+		m_font->AddVertsForTextInBox2D(textVerts, bakeText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.92f));
+	}
+
+	if (m_isSDFLookupOn && m_sdf != nullptr)
+	{
+		std::string lookupText = Stringf("Field distance = %.2f, exact = %.2f, nearest points %.2f px apart; lookup = %.0f ns vs. seven analytic calls = %.0f ns",
+			GetDistance2D(m_playerPoint, m_closestPointToPlayer), GetDistance2D(m_playerPoint, m_analyticClosestPoint), GetDistance2D(m_closestPointToPlayer, m_analyticClosestPoint),
+			m_sdfLookupSeconds * 1000000000.0, m_analyticLookupSeconds * 1000000000.0);
+		m_font->AddVertsForTextInBox2D(textVerts, lookupText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.895f));
+	}
 	g_theRenderer->BindTexture(&m_font->GetTexture());
 	g_theRenderer->DrawVertexArray(textVerts);
 }
@@ -145,6 +221,16 @@ void GameNearestPoint::LineToPoint(Vec2 const& point) const
 	g_theRenderer->DrawVertexArray(static_cast<int>(verts.size()), verts.data());
 }
 
+void GameNearestPoint::RenderSDFHeatmap() const
+{
+	if (m_sdfHeatmapVerts.empty())
+	{
+		return;
+	}
+	g_theRenderer->BindTexture(nullptr);
+	g_theRenderer->DrawVertexArray(m_sdfHeatmapVerts);
+}
+
 void GameNearestPoint::RandomShapes()
 {
 	// Disc randomizing
@@ -185,10 +271,132 @@ void GameNearestPoint::RandomShapes()
 	m_infiniteStart = Vec2(g_rng->RollRandomFloatInRange(-1000.f, SCREEN_SIZE_X + 1000.f), g_rng->RollRandomFloatInRange(-1000.f, SCREEN_SIZE_Y + 1000.f));
 	m_infiniteEnd = Vec2(g_rng->RollRandomFloatInRange(-1000.f, SCREEN_SIZE_X + 1000.f), g_rng->RollRandomFloatInRange(-1000.f, SCREEN_SIZE_Y + 1000.f));
 	m_infiniteThickness = (g_rng->RollRandomFloatInRange(1.f, 15.f));
+
+	StartSDFBake();
+}
+
+NearestPointShapes2D GameNearestPoint::GetShapes() const
+{
+	NearestPointShapes2D shapes;
+	shapes.m_discCenter = m_discCenter;
+	shapes.m_discRadius = m_discRadius;
+	shapes.m_alignedBox = m_alignedBox;
+	shapes.m_orientedBox = m_orientedBox;
+	shapes.m_boneStart = m_boneStart;
+	shapes.m_boneEnd = m_boneEnd;
+	shapes.m_capsuleRadius = m_capsuleRadius;
+	shapes.m_ccw0 = m_ccw0;
+	shapes.m_ccw1 = m_ccw1;
+	shapes.m_ccw2 = m_ccw2;
+	shapes.m_start = m_start;
+	shapes.m_end = m_end;
+	shapes.m_infiniteStart = m_infiniteStart;
+	shapes.m_infiniteEnd = m_infiniteEnd;
+	return shapes;
+}
+
+void GameNearestPoint::StartSDFBake()
+{
+	// A bake still running has the old shapes; stop it at its next row and throw it away
+	if (m_sdfBakeThread.joinable())
+	{
+		m_isSDFBakeCancelled = true;
+		m_sdfBakeThread.join();
+	}
+	m_isSDFBakeCancelled = false;
+	delete m_bakingSDF;
+	delete m_sdf;
+	m_sdf = nullptr;
+	m_sdfHeatmapVerts.clear();
+
+	m_bakingSDF = new ShapeDistanceField2D();
+	m_isSDFBakeDone = false;
+
+	// The field covers a margin past the screen, where the dot can still be moved
+	NearestPointShapes2D shapes = GetShapes();
+	AABB2 bounds(Vec2(-m_sdfBoundsMargin, -m_sdfBoundsMargin), Vec2(SCREEN_SIZE_X + m_sdfBoundsMargin, SCREEN_SIZE_Y + m_sdfBoundsMargin));
+	Vec2 boundsDims = bounds.GetDimensions();
+	int numHeatmapColumns = static_cast<int>(ceilf(boundsDims.x / m_sdfHeatmapCellSize));
+	int numHeatmapRows = static_cast<int>(ceilf(boundsDims.y / m_sdfHeatmapCellSize));
+
+	// Only m_bakingSDF and the two flags are touched until the thread is joined
+	m_sdfBakeThread = std::thread([this, shapes, bounds, numHeatmapColumns, numHeatmapRows]()
+	{
+		if (!m_bakingSDF->Bake(shapes, bounds, m_sdfCoarseCellSize, m_numSDFFineCellsPerCoarseCell, m_sdfRefineTolerance, &m_isSDFBakeCancelled))
+		{
+			return;
+		}
+		if (!m_bakingSDF->BakeErrorHeatmap(numHeatmapColumns, numHeatmapRows, &m_isSDFBakeCancelled))
+		{
+			return;
+		}
+		m_isSDFBakeDone = true;
+	});
+}
+
+void GameNearestPoint::UpdateSDFBake()
+{
+	if (!m_isSDFBakeDone || !m_sdfBakeThread.joinable())
+	{
+		return;
+	}
+	m_sdfBakeThread.join();
+	m_sdf = m_bakingSDF;
+	m_bakingSDF = nullptr;
+	m_isSDFBakeDone = false;
+
+	RebuildSDFHeatmapVerts();
+}
+
+void GameNearestPoint::RebuildSDFHeatmapVerts()
+{
+	m_sdfHeatmapVerts.clear();
+
+	AABB2 const& bounds = m_sdf->GetBounds();
+	int numColumns = m_sdf->GetNumHeatmapColumns();
+	int numRows = m_sdf->GetNumHeatmapRows();
+	Vec2 boundsDims = bounds.GetDimensions();
+	Vec2 cellDims(boundsDims.x / static_cast<float>(numColumns), boundsDims.y / static_cast<float>(numRows));
+	for (int row = 0; row < numRows; ++row)
+	{
+		for (int column = 0; column < numColumns; ++column)
+		{
+			// Green where the field is exact, red at m_sdfHeatmapMaxError off or worse
+			float errorFraction = GetClampedZeroToOne(m_sdf->GetHeatmapError(column, row) / m_sdfHeatmapMaxError);
+			Rgba8 color(static_cast<unsigned char>(255.f * errorFraction), static_cast<unsigned char>(255.f * (1.f - errorFraction)), 0, 90);
+
+			Vec2 cellMins = bounds.m_mins + Vec2(column * cellDims.x, row * cellDims.y);
+			AddVertsForAABB2D(m_sdfHeatmapVerts, AABB2(cellMins, cellMins + cellDims), color);
+		}
+	}
+}
+
+void GameNearestPoint::GetSDFNearestPoint()
+{
+	double lookupStartSeconds = GetCurrentTimeSeconds();
+	for (int lookupIndex = 0; lookupIndex < SDF_NUM_TIMED_LOOKUPS; ++lookupIndex)
+	{
+		m_sdf->GetDistanceAndNearestPoint(m_playerPoint, m_closestPointToPlayer);
+	}
+	m_sdfLookupSeconds = (GetCurrentTimeSeconds() - lookupStartSeconds) / static_cast<double>(SDF_NUM_TIMED_LOOKUPS);
+
+	NearestPointShapes2D const& shapes = m_sdf->GetShapes();
+	lookupStartSeconds = GetCurrentTimeSeconds();
+	for (int lookupIndex = 0; lookupIndex < SDF_NUM_TIMED_LOOKUPS; ++lookupIndex)
+	{
+		m_analyticClosestPoint = GetNearestPointOnShapes2D(m_playerPoint, shapes);
+	}
+	m_analyticLookupSeconds = (GetCurrentTimeSeconds() - lookupStartSeconds) / static_cast<double>(SDF_NUM_TIMED_LOOKUPS);
 }
 
 void GameNearestPoint::GetNearestPointCheck()
 {
+	if (m_isSDFLookupOn && m_sdf != nullptr)
+	{
+		GetSDFNearestPoint();
+		return;
+	}
+
 	m_nearestDiscPoint = GetNearestPointOnDisc2D(m_playerPoint, m_discCenter, m_discRadius);
 	m_nearestAABBPoint = GetNearestPointOnAABB2D(m_playerPoint, m_alignedBox);
 	m_nearestOBBPoint = GetNearestPointOnOBB2D(m_playerPoint, m_orientedBox);
@@ -1,14 +1,33 @@
 #pragma once
 #include "Game/Game.h"
 #include "Game/GameCommon.h"
+#include "Game/ShapeDistanceField2D.hpp"
 #include "Engine/Math/Vec2.hpp"
 #include "Engine/Math/AABB2.h"
 #include "Engine/Math/OBB2.hpp"
 #include "Engine/Core/Rgba8.h"
+#include "Engine/Core/Vertex_PCU.h"
+#include <atomic>
+#include <thread>
+#include <vector>
 // -----------------------------------------------------------------------------
 class App;
 class BitmapFont;
 // -----------------------------------------------------------------------------
+// Defaults for the nearestPointSDF* config keys
+const float SDF_COARSE_CELL_SIZE = 16.f;
+const int   SDF_FINE_CELLS_PER_COARSE_CELL = 8;
+const float SDF_REFINE_TOLERANCE = 0.25f;
+const float SDF_BOUNDS_MARGIN = 200.f;
+const float SDF_HEATMAP_CELL_SIZE = 8.f;
+const float SDF_HEATMAP_MAX_ERROR = 1.f;
+// Lookups per timing, since one is too quick for the clock
+const int	SDF_NUM_TIMED_LOOKUPS = 1000;
+// -----------------------------------------------------------------------------
+// B swaps the seven analytic nearest points for one lookup in a distance field of the whole
+// shape set, baked on a background thread each time the shapes change. H overlays how far
+// the field's distances are from the exact ones.
+// -----------------------------------------------------------------------------
 class GameNearestPoint : public Game 
 {
 public:
@@ -25,6 +44,13 @@ public:
 	void GetNearestPointCheck();
 	void GetClosestPointToPlayer();
 
+	// The bake started by RandomShapes is picked up by UpdateSDFBake once it is done
+	NearestPointShapes2D GetShapes() const;
+	void StartSDFBake();
+	void UpdateSDFBake();
+	void RebuildSDFHeatmapVerts();
+	void GetSDFNearestPoint();
+
 public:
 	void RenderDisc() const;
 	void RenderAABB2() const;
@@ -37,6 +63,8 @@ public:
 
 	void RenderNearestPoint(Vec2 const& point, Rgba8 color) const;
 	void LineToPoint(Vec2 const& point) const;
+	void RenderSDFHeatmap() const;
+	void SDFText() const;
 
 private:
 	App* m_theApp;
@@ -80,4 +108,29 @@ private:
 	Vec2 m_nearestLineSegmentPoint;
 	Vec2 m_nearestInfiniteLinePoint;
 	AABB2 m_gameSceneCoords;
+
+private:
+	float m_sdfCoarseCellSize = SDF_COARSE_CELL_SIZE;
+	int	  m_numSDFFineCellsPerCoarseCell = SDF_FINE_CELLS_PER_COARSE_CELL;
+	float m_sdfRefineTolerance = SDF_REFINE_TOLERANCE;
+	float m_sdfBoundsMargin = SDF_BOUNDS_MARGIN;
+	float m_sdfHeatmapCellSize = SDF_HEATMAP_CELL_SIZE;
+	float m_sdfHeatmapMaxError = SDF_HEATMAP_MAX_ERROR;
+
+	// m_sdf is null while the current shapes are still baking into m_bakingSDF
+	ShapeDistanceField2D* m_sdf = nullptr;
+	ShapeDistanceField2D* m_bakingSDF = nullptr;
+	std::thread			  m_sdfBakeThread;
+	std::atomic<bool>	  m_isSDFBakeDone;
+	// Set to stop a bake of shapes that have since changed, before it is joined
+	std::atomic<bool>	  m_isSDFBakeCancelled;
+
+	bool m_isSDFLookupOn = false;
+	bool m_isSDFHeatmapOn = false;
+	std::vector<Vertex_PCU> m_sdfHeatmapVerts;
+
+	// This frame's lookup, and the exact answer it is compared to
+	Vec2   m_analyticClosestPoint;
+	double m_sdfLookupSeconds = 0.0;
+	double m_analyticLookupSeconds = 0.0;
 };
\ No newline at end of file
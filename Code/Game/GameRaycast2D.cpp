@@ -0,0 +1,430 @@
+#include "Game/GameRaycast2D.hpp"
+#include "Game/App.h"
+#include "Game/RaycastOcclusion2D.hpp"
+#include "Engine/Renderer/Renderer.h"
+#include "Engine/Input/InputSystem.h"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Math/MathUtils.h"
+
+GameRaycast2D::GameRaycast2D(App* owner, RaycastShapeType viewShapeType)
+	:m_theApp(owner)
+	,m_viewShapeType(viewShapeType)
+{
+	m_font = g_theRenderer->CreateOrGetBitmapFont("Data/Fonts/SquirrelFixedFont");
+	m_rayCastStart = Vec2(SCREEN_CENTER_X, SCREEN_CENTER_Y);
+	m_rayCastEnd = Vec2(900.f, 300.f);
+	m_gameSceneCoords = AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y));
+
+	m_numMixedShapes = g_gameConfigBlackboard.GetValue("raycastMixedSceneNumShapes", MIXED_SCENE_NUM_SHAPES);
+	m_maxMixedShapeSize = g_gameConfigBlackboard.GetValue("raycastMixedSceneMaxShapeSize", MIXED_SCENE_MAX_SHAPE_SIZE);
+	m_driftFraction = g_gameConfigBlackboard.GetValue("raycastDriftFraction", DRIFT_FRACTION);
+	m_driftSpeed = g_gameConfigBlackboard.GetValue("raycastDriftSpeed", DRIFT_SPEED);
+	m_rebuildSAHRatio = g_gameConfigBlackboard.GetValue("raycastRebuildSAHRatio", DRIFT_REBUILD_SAH_RATIO);
+
+	m_numBatchBenchmarkRays = g_gameConfigBlackboard.GetValue("raycastBatchBenchmarkNumRays", BATCH_BENCHMARK_NUM_RAYS);
+	m_batchBenchmarkPattern = GetRaycastBatchPatternFromName(g_gameConfigBlackboard.GetValue("raycastBatchBenchmarkPattern", "grid"));
+	m_batchBenchmarkRayLength = g_gameConfigBlackboard.GetValue("raycastBatchBenchmarkRayLength", BATCH_BENCHMARK_RAY_LENGTH);
+	m_numBatchBenchmarkPasses = g_gameConfigBlackboard.GetValue("raycastBatchBenchmarkNumPasses", 1);
+	m_maxBatchBenchmarkThreads = g_gameConfigBlackboard.GetValue("raycastNumThreads", 0);
+	m_numBatchBenchmarkBruteForceRays = g_gameConfigBlackboard.GetValue("raycastBatchBenchmarkNumBruteForceRays", BATCH_BENCHMARK_NUM_BRUTE_FORCE_RAYS);
+}
+
+void GameRaycast2D::ArrowMovement()
+{
+	// Ray start movement
+	if (g_theInput->IsKeyDown('E'))
+	{
+		m_rayCastStart += Vec2(0.f, 1.f);
+	}
+	if (g_theInput->IsKeyDown('S'))
+	{
+		m_rayCastStart += Vec2(-1.f, 0.f);
+	}
+	if (g_theInput->IsKeyDown('D'))
+	{
+		m_rayCastStart += Vec2(0.f, -1.f);
+	}
+	if (g_theInput->IsKeyDown('F'))
+	{
+		m_rayCastStart += Vec2(1.f, 0.f);
+	}
+
+	// Ray end movement
+	if (g_theInput->IsKeyDown('I'))
+	{
+		m_rayCastEnd += Vec2(0.f, 1.f);
+	}
+	if (g_theInput->IsKeyDown('J'))
+	{
+		m_rayCastEnd += Vec2(-1.f, 0.f);
+	}
+	if (g_theInput->IsKeyDown('K'))
+	{
+		m_rayCastEnd += Vec2(0.f, -1.f);
+	}
+	if (g_theInput->IsKeyDown('L'))
+	{
+		m_rayCastEnd += Vec2(1.f, 0.f);
+	}
+
+	// Full ray movement
+	if (g_theInput->IsKeyDown(KEYCODE_UPARROW))
+	{
+		m_rayCastStart += Vec2(0.f, 1.f);
+		m_rayCastEnd += Vec2(0.f, 1.f);
+	}
+	if (g_theInput->IsKeyDown(KEYCODE_LEFTARROW))
+	{
+		m_rayCastStart += Vec2(-1.f, 0.f);
+		m_rayCastEnd += Vec2(-1.f, 0.f);
+	}
+	if (g_theInput->IsKeyDown(KEYCODE_DOWNARROW))
+	{
+		m_rayCastStart += Vec2(0.f, -1.f);
+		m_rayCastEnd += Vec2(0.f, -1.f);
+	}
+	if (g_theInput->IsKeyDown(KEYCODE_RIGHTARROW))
+	{
+		m_rayCastStart += Vec2(1.f, 0.f);
+		m_rayCastEnd += Vec2(1.f, 0.f);
+	}
+
+	if (g_theInput->IsKeyDown(KEYCODE_LEFT_MOUSE))
+	{
+		Vec2 normalizedMouseUV = g_theInput->GetCursorNormalizedPosition();
+		m_rayCastStart = m_gameSceneCoords.GetPointAtUV(normalizedMouseUV);
+	}
+
+	if (g_theInput->IsKeyDown(KEYCODE_RIGHT_MOUSE))
+	{
+		Vec2 normalizedMouseUV = g_theInput->GetCursorNormalizedPosition();
+		m_rayCastEnd = m_gameSceneCoords.GetPointAtUV(normalizedMouseUV);
+	}
+}
+
+void GameRaycast2D::UpdateMixedSceneToggle()
+{
+	if (g_theInput->WasKeyJustPressed('X'))
+	{
+		m_isMixedSceneOn = !m_isMixedSceneOn;
+		RebuildScene();
+	}
+}
+
+void GameRaycast2D::UpdateDrift(float deltaSeconds)
+{
+	if (g_theInput->WasKeyJustPressed('U'))
+	{
+		m_driftShapes = static_cast<RaycastDriftShapes>((m_driftShapes + 1) % RAYCAST_DRIFT_COUNT);
+		RebuildMixedShapeVerts();
+	}
+
+	m_driftShapeVerts.clear();
+	if (GetDriftShapeMask() == 0 || !m_isMixedSceneOn)
+	{
+		return;
+	}
+
+	for (int shapeType = 0; shapeType < RAYCAST_SHAPE_COUNT; ++shapeType)
+	{
+		int numDriftingShapes = GetNumDriftingShapes(static_cast<RaycastShapeType>(shapeType));
+		int firstClutterShape = GetFirstClutterShape(static_cast<RaycastShapeType>(shapeType));
+		for (int driftIndex = 0; driftIndex < numDriftingShapes; ++driftIndex)
+		{
+			int shapeIndex = firstClutterShape + driftIndex;
+			Vec2& velocity = m_driftVelocities[shapeType][driftIndex];
+			AABB2 bounds = m_scene.GetShapeBounds(static_cast<RaycastShapeType>(shapeType), shapeIndex);
+			if ((bounds.m_mins.x < 0.f && velocity.x < 0.f) || (bounds.m_maxs.x > SCREEN_SIZE_X && velocity.x > 0.f))
+			{
+				velocity.x *= -1.f;
+			}
+			if ((bounds.m_mins.y < 0.f && velocity.y < 0.f) || (bounds.m_maxs.y > SCREEN_SIZE_Y && velocity.y > 0.f))
+			{
+				velocity.y *= -1.f;
+			}
+			m_scene.TranslateShape(static_cast<RaycastShapeType>(shapeType), shapeIndex, velocity * deltaSeconds);
+			m_scene.AddVertsForShape(m_driftShapeVerts, static_cast<RaycastShapeType>(shapeType), shapeIndex, Rgba8(130, 110, 80));
+		}
+	}
+
+	// Refit every frame; rebuild once the refitted tree costs too much more than a fresh one would
+	double refitStartSeconds = GetCurrentTimeSeconds();
+	m_scene.RefitBVH();
+	m_refitSeconds = GetCurrentTimeSeconds() - refitStartSeconds;
+
+	BVH2D const& bvh = m_scene.GetBVH();
+	if (bvh.GetSAHCost() > bvh.GetBuildSAHCost() * m_rebuildSAHRatio)
+	{
+		double buildStartSeconds = GetCurrentTimeSeconds();
+		m_scene.BuildBVH();
+		m_bvhBuildSeconds = GetCurrentTimeSeconds() - buildStartSeconds;
+		++m_numDriftRebuilds;
+	}
+}
+
+void GameRaycast2D::UpdateOcclusion()
+{
+	if (g_theInput->WasKeyJustPressed('Z'))
+	{
+		m_isOcclusionViewOn = !m_isOcclusionViewOn;
+	}
+	if (g_theInput->WasKeyJustPressed('C'))
+	{
+		RunRaycastOcclusionBenchmark();
+	}
+	if (g_theInput->WasKeyJustPressed('R'))
+	{
+		RunBatchBenchmark();
+	}
+	if (!m_isOcclusionViewOn)
+	{
+		return;
+	}
+
+	Vec2 startToEnd = m_rayCastEnd - m_rayCastStart;
+	Vec2 rayCastDirection = startToEnd.GetNormalized();
+	float maxDist = startToEnd.GetLength();
+
+	double queryStartSeconds = GetCurrentTimeSeconds();
+	m_occluderShapeIndex = -1;
+	m_isRayOccluded = m_scene.RaycastAny(m_rayCastStart, rayCastDirection, maxDist, GetViewShapeMask(), m_occluderShapeType, m_occluderShapeIndex, m_anyHitStats);
+	m_anyHitSeconds = GetCurrentTimeSeconds() - queryStartSeconds;
+
+	queryStartSeconds = GetCurrentTimeSeconds();
+	m_scene.RaycastNearest(m_rayCastStart, rayCastDirection, maxDist, GetViewShapeMask(), m_nearestHitStats);
+	m_nearestHitSeconds = GetCurrentTimeSeconds() - queryStartSeconds;
+}
+
+void GameRaycast2D::RunRaycastOcclusionBenchmark()
+{
+	std::vector<OcclusionBenchmarkResult> results = RunOcclusionBenchmark();
+
+	m_sceneBenchmarkText.clear();
+	m_sceneBenchmarkText.push_back("Occlusion benchmark (C), ns per ray, any hit vs. nearest hit on mixed scenes:");
+	for (int resultIndex = 0; resultIndex < static_cast<int>(results.size()); ++resultIndex)
+	{
+		OcclusionBenchmarkResult const& result = results[resultIndex];
+		m_sceneBenchmarkText.push_back(Stringf("%6d shapes: BVH nearest %.0f (%.1f nodes), any %.0f (%.1f nodes) %.1fx; brute force nearest %.0f, any %.0f %.1fx; blocked %.0f%%, mismatches %d",
+			result.m_numShapes, result.m_bvhNearestNsPerRay, result.m_bvhNearestNodesPerRay, result.m_bvhAnyNsPerRay, result.m_bvhAnyNodesPerRay, result.m_bvhNearestNsPerRay / result.m_bvhAnyNsPerRay,
+			result.m_bruteForceNearestNsPerRay, result.m_bruteForceAnyNsPerRay, result.m_bruteForceNearestNsPerRay / result.m_bruteForceAnyNsPerRay, result.m_hitRatio * 100.f, result.m_numMismatches));
+	}
+
+	for (int lineIndex = 0; lineIndex < static_cast<int>(m_sceneBenchmarkText.size()); ++lineIndex)
+	{
+		DebuggerPrintf("%s\n", m_sceneBenchmarkText[lineIndex].c_str());
+	}
+}
+
+void GameRaycast2D::RunBatchBenchmark()
+{
+	std::vector<BVH2DRay> rays;
+	GenerateRaycastBatchRays(rays, m_batchBenchmarkPattern, m_numBatchBenchmarkRays, m_gameSceneCoords, m_batchBenchmarkRayLength, *g_rng);
+	std::vector<RaycastBatchBenchmarkResult> results = RunRaycastBatchBenchmark(m_scene, rays, GetViewShapeMask(), m_maxBatchBenchmarkThreads, m_numBatchBenchmarkPasses,
+		m_numBatchBenchmarkBruteForceRays);
+
+	m_sceneBenchmarkText.clear();
+	m_sceneBenchmarkText.push_back(Stringf("Batch raycast benchmark (R), %d %s rays of length %.0f x %d passes vs. %d shapes:", m_numBatchBenchmarkRays,
+		GetRaycastBatchPatternName(m_batchBenchmarkPattern), m_batchBenchmarkRayLength, m_numBatchBenchmarkPasses, m_scene.GetNumShapes()));
+	for (int resultIndex = 0; resultIndex < static_cast<int>(results.size()); ++resultIndex)
+	{
+		RaycastBatchBenchmarkResult const& result = results[resultIndex];
+		m_sceneBenchmarkText.push_back(Stringf("%2d threads: %.2f M rays/s (%.2fx), %.1f nodes/ray, %.1f shapes/ray, hits %.1f%%, mismatches %d, brute force mismatches %d / %d",
+			result.m_numThreads, result.m_raysPerSecond / 1000000.0, result.m_speedup, result.m_nodesPerRay, result.m_shapesPerRay, result.m_hitRatio * 100.f, result.m_numMismatches,
+			result.m_numBruteForceMismatches, result.m_numBruteForceRays));
+	}
+
+	for (int lineIndex = 0; lineIndex < static_cast<int>(m_sceneBenchmarkText.size()); ++lineIndex)
+	{
+		DebuggerPrintf("%s\n", m_sceneBenchmarkText[lineIndex].c_str());
+	}
+}
+
+void GameRaycast2D::RebuildScene()
+{
+	m_scene.Clear();
+	AddViewShapesToScene();
+	m_numViewShapes = m_scene.GetNumShapes(m_viewShapeType);
+
+	// The clutter cycles through the shape types so each gets about a fifth of it
+	if (m_isMixedSceneOn)
+	{
+		float minShapeSize = m_maxMixedShapeSize * 0.25f;
+		for (int shapeIndex = 0; shapeIndex < m_numMixedShapes; ++shapeIndex)
+		{
+			Vec2 center(g_rng->RollRandomFloatInRange(0.f, SCREEN_SIZE_X), g_rng->RollRandomFloatInRange(0.f, SCREEN_SIZE_Y));
+			float size = g_rng->RollRandomFloatInRange(minShapeSize, m_maxMixedShapeSize);
+			float angle = g_rng->RollRandomFloatInRange(0.f, 360.f);
+			m_scene.AddShape(static_cast<RaycastShapeType>(shapeIndex % RAYCAST_SHAPE_COUNT), center, size, Vec2(CosDegrees(angle), SinDegrees(angle)));
+		}
+	}
+	double buildStartSeconds = GetCurrentTimeSeconds();
+	m_scene.BuildBVH();
+	m_bvhBuildSeconds = GetCurrentTimeSeconds() - buildStartSeconds;
+	m_refitSeconds = 0.0;
+	m_numDriftRebuilds = 0;
+
+	// Every clutter shape gets a velocity, so changing which types drift needs no rolls
+	for (int shapeType = 0; shapeType < RAYCAST_SHAPE_COUNT; ++shapeType)
+	{
+		int numClutterShapes = m_scene.GetNumShapes(static_cast<RaycastShapeType>(shapeType)) - GetFirstClutterShape(static_cast<RaycastShapeType>(shapeType));
+		m_driftVelocities[shapeType].resize(numClutterShapes);
+		for (int driftIndex = 0; driftIndex < numClutterShapes; ++driftIndex)
+		{
+			float angle = g_rng->RollRandomFloatInRange(0.f, 360.f);
+			float speed = g_rng->RollRandomFloatInRange(0.5f, 1.f) * m_driftSpeed;
+			m_driftVelocities[shapeType][driftIndex] = Vec2(CosDegrees(angle), SinDegrees(angle)) * speed;
+		}
+	}
+	RebuildMixedShapeVerts();
+}
+
+void GameRaycast2D::RebuildMixedShapeVerts()
+{
+	// Everything past the mode's own shapes is clutter; unless it drifts it only changes with the scene, so its verts are built once
+	m_mixedShapeVerts.clear();
+	if (!m_isMixedSceneOn)
+	{
+		return;
+	}
+
+	for (int shapeType = 0; shapeType < RAYCAST_SHAPE_COUNT; ++shapeType)
+	{
+		int numShapesOfType = m_scene.GetNumShapes(static_cast<RaycastShapeType>(shapeType));
+		int firstStaticShape = GetFirstClutterShape(static_cast<RaycastShapeType>(shapeType)) + GetNumDriftingShapes(static_cast<RaycastShapeType>(shapeType));
+		for (int shapeIndex = firstStaticShape; shapeIndex < numShapesOfType; ++shapeIndex)
+		{
+			m_scene.AddVertsForShape(m_mixedShapeVerts, static_cast<RaycastShapeType>(shapeType), shapeIndex, Rgba8(90, 90, 120));
+		}
+	}
+}
+
+unsigned int GameRaycast2D::GetViewShapeMask() const
+{
+	return m_isMixedSceneOn ? RAYCAST_SHAPE_MASK_ALL : GetRaycastShapeMask(m_viewShapeType);
+}
+
+unsigned int GameRaycast2D::GetDriftShapeMask() const
+{
+	switch (m_driftShapes)
+	{
+	case RAYCAST_DRIFT_DISCS: return GetRaycastShapeMask(RAYCAST_SHAPE_DISC);
+	case RAYCAST_DRIFT_BOXES: return GetRaycastShapeMask(RAYCAST_SHAPE_AABB2) | GetRaycastShapeMask(RAYCAST_SHAPE_OBB2);
+	case RAYCAST_DRIFT_ALL:	  return RAYCAST_SHAPE_MASK_ALL;
+	default:				  return 0;
+	}
+}
+
+int GameRaycast2D::GetFirstClutterShape(RaycastShapeType shapeType) const
+{
+	return (shapeType == m_viewShapeType) ? m_numViewShapes : 0;
+}
+
+int GameRaycast2D::GetNumDriftingShapes(RaycastShapeType shapeType) const
+{
+	if ((GetDriftShapeMask() & GetRaycastShapeMask(shapeType)) == 0)
+	{
+		return 0;
+	}
+	return static_cast<int>(m_driftFraction * static_cast<float>(m_driftVelocities[shapeType].size()));
+}
+
+void GameRaycast2D::DrawMixedShapes() const
+{
+	g_theRenderer->BindTexture(nullptr);
+	g_theRenderer->DrawVertexArray(m_mixedShapeVerts);
+	g_theRenderer->DrawVertexArray(m_driftShapeVerts);
+}
+
+void GameRaycast2D::DrawNearestHit() const
+{
+	std::vector<Vertex_PCU> arrowVerts;
+	RaycastResult2D const& impact = m_nearestHit.m_result;
+
+	// A line-of-sight check only knows whether the ray is blocked, and by which shape
+	if (m_isOcclusionViewOn)
+	{
+		if (m_isRayOccluded)
+		{
+			std::vector<Vertex_PCU> occluderVerts;
+			m_scene.AddVertsForShape(occluderVerts, m_occluderShapeType, m_occluderShapeIndex, Rgba8::ORANGE);
+			g_theRenderer->BindTexture(nullptr);
+			g_theRenderer->DrawVertexArray(occluderVerts);
+		}
+		AddVertsForArrow2D(arrowVerts, m_rayCastStart, m_rayCastEnd, 20.f, 3.f, m_isRayOccluded ? Rgba8::RED : Rgba8::LIMEGREEN);
+	}
+	else if (m_nearestHit.m_shapeIndex >= 0)
+	{
+		std::vector<Vertex_PCU> impactedShapeVerts;
+
+		AddVertsForArrow2D(arrowVerts, m_rayCastStart, m_rayCastEnd, 20.f, 1.f, Rgba8::DARKGRAY);
+		AddVertsForArrow2D(arrowVerts, m_rayCastStart, impact.m_impactPos, 20.f, 1.f, Rgba8::ORANGE);
+		AddVertsForArrow2D(arrowVerts, impact.m_impactPos, impact.m_impactPos + impact.m_impactNormal * 80.f, 20.f, 1.f, Rgba8::CYAN);
+		AddVertsForDisc2D(arrowVerts, impact.m_impactPos, 4.f, Rgba8::WHITE);
+
+		m_scene.AddVertsForShape(impactedShapeVerts, m_nearestHit.m_shapeType, m_nearestHit.m_shapeIndex, Rgba8::LIGHTBLUE);
+		g_theRenderer->BindTexture(nullptr);
+		g_theRenderer->DrawVertexArray(impactedShapeVerts);
+	}
+	else
+	{
+		AddVertsForArrow2D(arrowVerts, m_rayCastStart, m_rayCastEnd, 20.f, 3.f, Rgba8::WHITE);
+	}
+	g_theRenderer->BindTexture(nullptr);
+	g_theRenderer->DrawVertexArray(arrowVerts);
+}
+
+void GameRaycast2D::AddVertsForSceneText(std::vector<Vertex_PCU>& textVerts) const
+{
+	std::string hitText = "none";
+	if (m_nearestHit.m_shapeIndex >= 0)
+	{
+		hitText = Stringf("%s %d", GetRaycastShapeTypeName(m_nearestHit.m_shapeType), m_nearestHit.m_shapeIndex);
+	}
+	std::string sceneText = Stringf("Mixed scene (X) = %s, scene shapes = %d, BVH nodes = %d, depth = %d, build = %.2f ms, nearest hit = %s", m_isMixedSceneOn ? "on" : "off",
+		m_scene.GetNumShapes(), m_scene.GetBVH().GetNumNodes(), m_scene.GetBVH().GetDepth(), m_bvhBuildSeconds * 1000.0, hitText.c_str());
+	m_font->AddVertsForTextInBox2D(textVerts, sceneText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.02f));
+
+	static char const* const DRIFT_SHAPES_NAMES[RAYCAST_DRIFT_COUNT] = { "off", "discs", "boxes", "all shapes" };
+	std::string driftText = Stringf("Drift (U) = %s", DRIFT_SHAPES_NAMES[m_driftShapes]);
+	if (m_driftShapes != RAYCAST_DRIFT_OFF && !m_isMixedSceneOn)
+	{
+		driftText += ", only the mixed clutter drifts";
+	}
+	else if (m_driftShapes != RAYCAST_DRIFT_OFF)
+	{
+		int numDriftingShapes = 0;
+		for (int shapeType = 0; shapeType < RAYCAST_SHAPE_COUNT; ++shapeType)
+		{
+			numDriftingShapes += GetNumDriftingShapes(static_cast<RaycastShapeType>(shapeType));
+		}
+		BVH2D const& bvh = m_scene.GetBVH();
+		float sahCostRatio = (bvh.GetBuildSAHCost() > 0.f) ? bvh.GetSAHCost() / bvh.GetBuildSAHCost() : 1.f;
+		driftText += Stringf(", %d moving; refit = %.2f ms vs. rebuild = %.2f ms; SAH cost = %.2fx of a fresh build, rebuilt past %.2fx (%d so far)", numDriftingShapes,
+			m_refitSeconds * 1000.0, m_bvhBuildSeconds * 1000.0, sahCostRatio, m_rebuildSAHRatio, m_numDriftRebuilds);
+	}
+	m_font->AddVertsForTextInBox2D(textVerts, driftText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.045f));
+
+	std::string occlusionText = "Occlusion view (Z) = off; C benchmarks any hit vs. nearest hit; R benchmarks a batch of rays on the worker pool";
+	if (m_isOcclusionViewOn)
+	{
+		std::string occluderText = "clear";
+		if (m_isRayOccluded)
+		{
+			occluderText = Stringf("blocked by %s %d", GetRaycastShapeTypeName(m_occluderShapeType), m_occluderShapeIndex);
+		}
+		occlusionText = Stringf("Occlusion view (Z) = %s; any hit = %.2f us, %lld nodes, %lld shapes; nearest hit = %.2f us, %lld nodes, %lld shapes", occluderText.c_str(),
+			m_anyHitSeconds * 1000000.0, m_anyHitStats.m_numNodesVisited, m_anyHitStats.m_numPrimitivesTested,
+			m_nearestHitSeconds * 1000000.0, m_nearestHitStats.m_numNodesVisited, m_nearestHitStats.m_numPrimitivesTested);
+	}
+	m_font->AddVertsForTextInBox2D(textVerts, occlusionText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.07f));
+
+	// Stacked upwards from the occlusion line, header on top
+	int numBenchmarkLines = static_cast<int>(m_sceneBenchmarkText.size());
+	for (int lineIndex = 0; lineIndex < numBenchmarkLines; ++lineIndex)
+	{
+		float lineAlignmentY = 0.095f + 0.025f * static_cast<float>(numBenchmarkLines - 1 - lineIndex);
+		m_font->AddVertsForTextInBox2D(textVerts, m_sceneBenchmarkText[lineIndex], m_gameSceneCoords, 15.f, Rgba8::GOLD, 0.8f, Vec2(0.f, lineAlignmentY));
+	}
+}
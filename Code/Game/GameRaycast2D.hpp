@@ -0,0 +1,118 @@
+#pragma once
+#include "Game/Game.h"
+#include "Game/GameCommon.h"
+#include "Game/RaycastScene2D.hpp"
+#include "Game/RaycastBatchBenchmark.hpp"
+#include "Engine/Math/AABB2.h"
+#include "Engine/Core/Vertex_PCU.h"
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+class BitmapFont;
+// -----------------------------------------------------------------------------
+// Defaults for raycastMixedSceneNumShapes and raycastMixedSceneMaxShapeSize
+const int   MIXED_SCENE_NUM_SHAPES = 100000;
+const float MIXED_SCENE_MAX_SHAPE_SIZE = 10.f;
+// Defaults for raycastDriftFraction, raycastDriftSpeed and raycastRebuildSAHRatio
+const float DRIFT_FRACTION = 0.1f;
+const float DRIFT_SPEED = 40.f;
+const float DRIFT_REBUILD_SAH_RATIO = 1.5f;
+// Defaults for raycastBatchBenchmarkNumRays, raycastBatchBenchmarkRayLength and raycastBatchBenchmarkNumBruteForceRays
+const int	BATCH_BENCHMARK_NUM_RAYS = 100000;
+const float BATCH_BENCHMARK_RAY_LENGTH = 400.f;
+const int	BATCH_BENCHMARK_NUM_BRUTE_FORCE_RAYS = 1000;
+// -----------------------------------------------------------------------------
+enum RaycastDriftShapes
+{
+	RAYCAST_DRIFT_OFF,
+	RAYCAST_DRIFT_DISCS,
+	RAYCAST_DRIFT_BOXES,
+	RAYCAST_DRIFT_ALL,
+	RAYCAST_DRIFT_COUNT
+};
+// -----------------------------------------------------------------------------
+// Shared base of the 2D raycast modes. Each mode is a view of one shape type in a
+// RaycastScene2D: its own shapes go in first, so their scene indices match the mode's, and
+// its queries only see that type. X adds a mixed clutter of every shape type and widens the
+// view to all of them. Z switches the drawn ray to a line-of-sight check, and C benchmarks
+// that check against the nearest-hit query. R fires a large batch of rays at whatever the
+// view sees, on more and more threads. U sets some of the clutter drifting, and the BVH follows
+// it by refitting, rebuilt only once the refits have made it too slow.
+// -----------------------------------------------------------------------------
+class GameRaycast2D : public Game
+{
+public:
+	GameRaycast2D(App* owner, RaycastShapeType viewShapeType);
+
+protected:
+	// Puts the mode's own shapes in m_scene; called by RebuildScene after clearing it
+	virtual void AddViewShapesToScene() = 0;
+
+	void ArrowMovement();
+	void UpdateMixedSceneToggle();
+	void UpdateDrift(float deltaSeconds);
+	// Handles Z and C; runs after the mode's own query, on the same ray
+	void UpdateOcclusion();
+	void RunRaycastOcclusionBenchmark();
+	void RunBatchBenchmark();
+	void RebuildScene();
+	void RebuildMixedShapeVerts();
+	unsigned int GetViewShapeMask() const;
+	unsigned int GetDriftShapeMask() const;
+	int  GetFirstClutterShape(RaycastShapeType shapeType) const;
+	int  GetNumDriftingShapes(RaycastShapeType shapeType) const;
+
+	void DrawMixedShapes() const;
+	void DrawNearestHit() const;
+	void AddVertsForSceneText(std::vector<Vertex_PCU>& textVerts) const;
+
+protected:
+	App* m_theApp = nullptr;
+	BitmapFont* m_font = nullptr;
+	Vec2 m_rayCastStart = Vec2::ZERO;
+	Vec2 m_rayCastEnd = Vec2::ZERO;
+	AABB2 m_gameSceneCoords;
+
+	RaycastShapeType m_viewShapeType = RAYCAST_SHAPE_DISC;
+	RaycastScene2D	 m_scene;
+	int				 m_numViewShapes = 0;
+	double			 m_bvhBuildSeconds = 0.0;
+
+	bool  m_isMixedSceneOn = false;
+	int	  m_numMixedShapes = MIXED_SCENE_NUM_SHAPES;
+	float m_maxMixedShapeSize = MIXED_SCENE_MAX_SHAPE_SIZE;
+	std::vector<Vertex_PCU> m_mixedShapeVerts;
+
+	// The first m_driftFraction of each drifting type's clutter moves every frame, bouncing off the screen edges
+	RaycastDriftShapes m_driftShapes = RAYCAST_DRIFT_OFF;
+	float			   m_driftFraction = DRIFT_FRACTION;
+	float			   m_driftSpeed = DRIFT_SPEED;
+	float			   m_rebuildSAHRatio = DRIFT_REBUILD_SAH_RATIO;
+	std::vector<Vec2>  m_driftVelocities[RAYCAST_SHAPE_COUNT];
+	std::vector<Vertex_PCU> m_driftShapeVerts;
+	double			   m_refitSeconds = 0.0;
+	int				   m_numDriftRebuilds = 0;
+
+	// Nearest hit of this frame's ray, whichever query the mode ran
+	RaycastSceneHit2D m_nearestHit;
+
+	// The occlusion view asks the scene BVH both questions about the ray, to compare their cost
+	bool			 m_isOcclusionViewOn = false;
+	bool			 m_isRayOccluded = false;
+	RaycastShapeType m_occluderShapeType = RAYCAST_SHAPE_DISC;
+	int				 m_occluderShapeIndex = -1;
+	BVH2DQueryStats	 m_anyHitStats;
+	BVH2DQueryStats	 m_nearestHitStats;
+	double			 m_anyHitSeconds = 0.0;
+	double			 m_nearestHitSeconds = 0.0;
+
+	int					m_numBatchBenchmarkRays = BATCH_BENCHMARK_NUM_RAYS;
+	RaycastBatchPattern m_batchBenchmarkPattern = RAYCAST_BATCH_PATTERN_GRID;
+	float				m_batchBenchmarkRayLength = BATCH_BENCHMARK_RAY_LENGTH;
+	int					m_numBatchBenchmarkPasses = 1;
+	int					m_maxBatchBenchmarkThreads = 0;
+	int					m_numBatchBenchmarkBruteForceRays = BATCH_BENCHMARK_NUM_BRUTE_FORCE_RAYS;
+
+	// Lines of whichever of C and R ran last
+	std::vector<std::string> m_sceneBenchmarkText;
+};
@@ -4,15 +4,20 @@
 #include "Engine/Input/InputSystem.h"
 #include "Engine/Core/EngineCommon.h"
 #include "Engine/Math/RaycastUtils.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Game/SimdUtils.hpp"
+#include <math.h>
 
 GameRaycastVsAABB2s::GameRaycastVsAABB2s(App* owner)
-	:m_theApp(owner)
+	:GameRaycast2D(owner, RAYCAST_SHAPE_AABB2)
 {
-	m_font = g_theRenderer->CreateOrGetBitmapFont("Data/Fonts/SquirrelFixedFont");
-	m_rayCastStart = Vec2(SCREEN_CENTER_X, SCREEN_CENTER_Y);
-	m_rayCastEnd = Vec2(900.f, 300.f);
+
+	m_numAABB2s = g_gameConfigBlackboard.GetValue("raycastNumAABB2s", NUM_AABB2S);
+	m_minAABB2Size = g_gameConfigBlackboard.GetValue("raycastMinAABB2Size", AABB2_MIN_SIZE);
+	m_maxAABB2Size = g_gameConfigBlackboard.GetValue("raycastMaxAABB2Size", AABB2_MAX_SIZE);
+	m_gridCellSize = g_gameConfigBlackboard.GetValue("raycastGridCellSize", 0.f);
 	RandomizeAABB2s();
-	m_gameSceneCoords = AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y));
 }
 
 void GameRaycastVsAABB2s::Update(float deltaSeconds)
@@ -23,13 +28,35 @@ void GameRaycastVsAABB2s::Update(float deltaSeconds)
 	{
 		RandomizeAABB2s();
 	}
+	if (g_theInput->WasKeyJustPressed('G'))
+	{
+		m_queryMode = static_cast<AABB2QueryMode>((m_queryMode + 1) % AABB2_QUERY_COUNT);
+	}
+	if (g_theInput->WasKeyJustPressed('M'))
+	{
+		RunRaycastBenchmark();
+	}
+	UpdateMixedSceneToggle();
+	UpdateDrift(deltaSeconds);
 	ArrowMovement();
+	if (g_theInput->WasKeyJustPressed('V'))
+	{
+		m_rayCastEnd.x = m_rayCastStart.x;
+	}
+	if (g_theInput->WasKeyJustPressed('H'))
+	{
+		m_rayCastEnd.y = m_rayCastStart.y;
+	}
+	UpdateRaycast();
+	UpdateOcclusion();
 }
 
 void GameRaycastVsAABB2s::Render() const
 {
 	g_theRenderer->BeginCamera(g_theApp->m_screenCamera);
+	DrawMixedShapes();
 	DrawAABB2s();
+	DrawVisitedCells();
 	DrawRaycast();
 	GameModeAndControlsText();
 }
@@ -37,156 +64,117 @@ void GameRaycastVsAABB2s::Render() const
 void GameRaycastVsAABB2s::RandomizeAABB2s()
 {
 	m_AABB2s.clear();
-	for (int aabb2Index = 0; aabb2Index < NUM_AABB2S; ++aabb2Index)
+	for (int aabb2Index = 0; aabb2Index < m_numAABB2s; ++aabb2Index)
 	{
 		AABB2 newAABB2s;
-		newAABB2s.m_mins = Vec2(g_rng->RollRandomFloatInRange(0.f, SCREEN_SIZE_X - AABB2_MAX_SIZE), g_rng->RollRandomFloatInRange(0.f, SCREEN_SIZE_Y - AABB2_MAX_SIZE));
-		newAABB2s.m_maxs = newAABB2s.m_mins + Vec2(g_rng->RollRandomFloatInRange(AABB2_MIN_SIZE, AABB2_MAX_SIZE), g_rng->RollRandomFloatInRange(AABB2_MIN_SIZE, AABB2_MAX_SIZE));
+		newAABB2s.m_mins = Vec2(g_rng->RollRandomFloatInRange(0.f, SCREEN_SIZE_X - m_maxAABB2Size), g_rng->RollRandomFloatInRange(0.f, SCREEN_SIZE_Y - m_maxAABB2Size));
+		newAABB2s.m_maxs = newAABB2s.m_mins + Vec2(g_rng->RollRandomFloatInRange(m_minAABB2Size, m_maxAABB2Size), g_rng->RollRandomFloatInRange(m_minAABB2Size, m_maxAABB2Size));
 
 		m_AABB2s.push_back(newAABB2s);
 	}
-}
 
-void GameRaycastVsAABB2s::ArrowMovement()
-{
-	// Ray start movement
-	if (g_theInput->IsKeyDown('E'))
+	// Cells about the size of an average box keep each box in a few cells; with few boxes the
+	// cells grow instead so the grid doesn't walk mostly empty cells
+	double buildStartSeconds = GetCurrentTimeSeconds();
+	float cellSize = m_gridCellSize;
+	if (cellSize <= 0.f)
 	{
-		m_rayCastStart += Vec2(0.f, 1.f);
-	}
-	if (g_theInput->IsKeyDown('S'))
-	{
-		m_rayCastStart += Vec2(-1.f, 0.f);
-	}
-	if (g_theInput->IsKeyDown('D'))
-	{
-		m_rayCastStart += Vec2(0.f, -1.f);
-	}
-	if (g_theInput->IsKeyDown('F'))
-	{
-		m_rayCastStart += Vec2(1.f, 0.f);
+		float averageBoxSize = (m_minAABB2Size + m_maxAABB2Size) * 0.5f;
+		float sparseCellSize = sqrtf(SCREEN_SIZE_X * SCREEN_SIZE_Y / static_cast<float>((m_numAABB2s > 1) ? m_numAABB2s : 1));
+		cellSize = (averageBoxSize > sparseCellSize) ? averageBoxSize : sparseCellSize;
 	}
+	m_grid.Build(m_AABB2s, m_gameSceneCoords, cellSize);
+	m_gridBuildSeconds = GetCurrentTimeSeconds() - buildStartSeconds;
+	RebuildScene();
 
-	// Ray end movement
-	if (g_theInput->IsKeyDown('I'))
-	{
-		m_rayCastEnd += Vec2(0.f, 1.f);
-	}
-	if (g_theInput->IsKeyDown('J'))
-	{
-		m_rayCastEnd += Vec2(-1.f, 0.f);
-	}
-	if (g_theInput->IsKeyDown('K'))
-	{
-		m_rayCastEnd += Vec2(0.f, -1.f);
-	}
-	if (g_theInput->IsKeyDown('L'))
+	m_AABB2Batch.Clear();
+	for (int aabb2Index = 0; aabb2Index < (int)m_AABB2s.size(); ++aabb2Index)
 	{
-		m_rayCastEnd += Vec2(1.f, 0.f);
+		m_AABB2Batch.AddBox(m_AABB2s[aabb2Index]);
 	}
 
-	// Full ray movement
-	if (g_theInput->IsKeyDown(KEYCODE_UPARROW))
+	// The boxes only change here, so their verts are built once and drawn in one call
+	m_AABB2Verts.clear();
+	for (int aabb2Index = 0; aabb2Index < (int)m_AABB2s.size(); ++aabb2Index)
 	{
-		m_rayCastStart += Vec2(0.f, 1.f);
-		m_rayCastEnd += Vec2(0.f, 1.f);
+		AddVertsForAABB2D(m_AABB2Verts, m_AABB2s[aabb2Index], Rgba8::SAPPHIRE);
 	}
-	if (g_theInput->IsKeyDown(KEYCODE_LEFTARROW))
+}
+
+void GameRaycastVsAABB2s::UpdateRaycast()
+{
+	Vec2 startToEnd = m_rayCastEnd - m_rayCastStart;
+	Vec2 rayCastDirection = startToEnd.GetNormalized();
+	float maxDist = startToEnd.GetLength();
+
+	double queryStartSeconds = GetCurrentTimeSeconds();
+	m_queryStats = AABB2GridQueryStats();
+	m_bvhQueryStats = BVH2DQueryStats();
+	m_visitedCells.clear();
+	m_nearestHit.m_shapeType = RAYCAST_SHAPE_AABB2;
+	if (m_queryMode == AABB2_QUERY_BVH || m_isMixedSceneOn)
 	{
-		m_rayCastStart += Vec2(-1.f, 0.f);
-		m_rayCastEnd += Vec2(-1.f, 0.f);
+		m_nearestHit = m_scene.RaycastNearest(m_rayCastStart, rayCastDirection, maxDist, GetViewShapeMask(), m_bvhQueryStats);
 	}
-	if (g_theInput->IsKeyDown(KEYCODE_DOWNARROW))
+	else if (m_queryMode == AABB2_QUERY_GRID)
 	{
-		m_rayCastStart += Vec2(0.f, -1.f);
-		m_rayCastEnd += Vec2(0.f, -1.f);
+		m_nearestHit.m_result = m_grid.Raycast(m_rayCastStart, rayCastDirection, maxDist, m_AABB2s, m_nearestHit.m_shapeIndex, m_queryStats, &m_visitedCells);
 	}
-	if (g_theInput->IsKeyDown(KEYCODE_RIGHTARROW))
+	else
 	{
-		m_rayCastStart += Vec2(1.f, 0.f);
-		m_rayCastEnd += Vec2(1.f, 0.f);
+		m_queryStats.m_numBoxesTested = static_cast<int>(m_AABB2s.size());
+		if (m_queryMode == AABB2_QUERY_SIMD)
+		{
+			m_nearestHit.m_result = RaycastVsAABB2Packets2D(m_rayCastStart, rayCastDirection, maxDist, m_AABB2Batch, m_nearestHit.m_shapeIndex);
+		}
+		else
+		{
+			m_nearestHit.m_result = RaycastVsAABB2s2DScalar(m_rayCastStart, rayCastDirection, maxDist, m_AABB2s, m_nearestHit.m_shapeIndex);
+		}
 	}
+	m_querySeconds = GetCurrentTimeSeconds() - queryStartSeconds;
+}
 
-	if (g_theInput->WasKeyJustPressed('V'))
-	{
-		m_rayCastEnd.x = m_rayCastStart.x;
-	}
-	if (g_theInput->WasKeyJustPressed('H'))
-	{
-		m_rayCastEnd.y = m_rayCastStart.y;
-	}
+void GameRaycastVsAABB2s::RunRaycastBenchmark()
+{
+	std::vector<AABB2RaycastBenchmarkResult> results = RunAABB2RaycastBenchmark();
 
-	if (g_theInput->IsKeyDown(KEYCODE_LEFT_MOUSE))
+	m_benchmarkText.clear();
+	m_benchmarkText.push_back(Stringf("AABB2 raycast benchmark (M), ns per ray-box test, SIMD width %d, 1/3 of rays snapped V and 1/3 H:", SIMD_WIDTH));
+	for (int resultIndex = 0; resultIndex < static_cast<int>(results.size()); ++resultIndex)
 	{
-		Vec2 normalizedMouseUV = g_theInput->GetCursorNormalizedPosition();
-		m_rayCastStart = m_gameSceneCoords.GetPointAtUV(normalizedMouseUV);
+		AABB2RaycastBenchmarkResult const& result = results[resultIndex];
+		m_benchmarkText.push_back(Stringf("%d rays x %5d boxes: scalar %.2f, SIMD slabs %.2f (%.1fx), mismatches %d", result.m_numRays, result.m_numBoxes,
+			result.m_scalarNsPerTest, result.m_simdNsPerTest, result.m_scalarNsPerTest / result.m_simdNsPerTest, result.m_numMismatches));
 	}
 
-	if (g_theInput->IsKeyDown(KEYCODE_RIGHT_MOUSE))
+	for (int lineIndex = 0; lineIndex < static_cast<int>(m_benchmarkText.size()); ++lineIndex)
 	{
-		Vec2 normalizedMouseUV = g_theInput->GetCursorNormalizedPosition();
-		m_rayCastEnd = m_gameSceneCoords.GetPointAtUV(normalizedMouseUV);
+		DebuggerPrintf("%s\n", m_benchmarkText[lineIndex].c_str());
 	}
 }
 
 void GameRaycastVsAABB2s::DrawAABB2s() const
 {
-	for (int aabb2Index = 0; aabb2Index < (int)m_AABB2s.size(); ++aabb2Index)
-	{
-		AABB2 const& aabb2 = m_AABB2s[aabb2Index];
-		std::vector<Vertex_PCU> aabb2Verts;
-
-		AddVertsForAABB2D(aabb2Verts, AABB2(aabb2.m_mins, aabb2.m_maxs), Rgba8::SAPPHIRE);
-		g_theRenderer->BindTexture(nullptr);
-		g_theRenderer->DrawVertexArray(aabb2Verts);
-	}
+	g_theRenderer->BindTexture(nullptr);
+	g_theRenderer->DrawVertexArray(m_AABB2Verts);
 }
 
-void GameRaycastVsAABB2s::DrawRaycast() const
+void GameRaycastVsAABB2s::DrawVisitedCells() const
 {
-	Vec2 startToEnd = m_rayCastEnd - m_rayCastStart;
-	Vec2 rayCastDirection = startToEnd.GetNormalized();
-	float maxDist = startToEnd.GetLength();
-
-	std::vector<Vertex_PCU> arrowVerts;
-	bool didRaycasthitAABB2 = false;
-	RaycastResult2D nearestImpact;
-	int nearestAABB2 = 0;
-
-	for (int aabb2Index = 0; aabb2Index < (int)m_AABB2s.size(); ++aabb2Index)
-	{
-		RaycastResult2D raycastResult = RaycastVsAABB2D(m_rayCastStart, rayCastDirection, maxDist, AABB2(m_AABB2s[aabb2Index].m_mins, m_AABB2s[aabb2Index].m_maxs));
-
-		if (raycastResult.m_didImpact)
-		{
-			if (didRaycasthitAABB2 == false || raycastResult.m_impactDist < nearestImpact.m_impactDist)
-			{
-				nearestImpact = raycastResult;
-				nearestAABB2 = aabb2Index;
-				didRaycasthitAABB2 = true;
-			}
-		}
-	}
-
-	if (didRaycasthitAABB2)
+	std::vector<Vertex_PCU> cellVerts;
+	for (int cellIndex = 0; cellIndex < static_cast<int>(m_visitedCells.size()); ++cellIndex)
 	{
-		std::vector<Vertex_PCU> impactedAABB2Verts;
-
-		AddVertsForArrow2D(arrowVerts, m_rayCastStart, m_rayCastEnd, 20.f, 1.f, Rgba8::DARKGRAY);
-		AddVertsForArrow2D(arrowVerts, m_rayCastStart, nearestImpact.m_impactPos, 20.f, 1.f, Rgba8::ORANGE);
-		AddVertsForArrow2D(arrowVerts, nearestImpact.m_impactPos, nearestImpact.m_impactPos + nearestImpact.m_impactNormal * 80.f, 20.f, 1.f, Rgba8::CYAN);
-		AddVertsForDisc2D(arrowVerts, nearestImpact.m_impactPos, 4.f, Rgba8::WHITE);
-
-		AddVertsForAABB2D(impactedAABB2Verts, AABB2(m_AABB2s[nearestAABB2].m_mins, m_AABB2s[nearestAABB2].m_maxs), Rgba8::LIGHTBLUE);
-		g_theRenderer->BindTexture(nullptr);
-		g_theRenderer->DrawVertexArray(impactedAABB2Verts);
-	}
-	else
-	{
-		AddVertsForArrow2D(arrowVerts, m_rayCastStart, m_rayCastEnd, 20.f, 3.f, Rgba8::WHITE);
+		AABB2 cellBounds = m_grid.GetCellBounds(m_visitedCells[cellIndex]);
+		AddVertsForAABB2D(cellVerts, cellBounds, Rgba8(255, 200, 0, 40));
 	}
 	g_theRenderer->BindTexture(nullptr);
-	g_theRenderer->DrawVertexArray(arrowVerts);
+	g_theRenderer->DrawVertexArray(cellVerts);
+}
+
+void GameRaycastVsAABB2s::DrawRaycast() const
+{
+	DrawNearestHit();
 }
 
 void GameRaycastVsAABB2s::GameModeAndControlsText() const
@@ -194,6 +182,32 @@ void GameRaycastVsAABB2s::GameModeAndControlsText() const
 	std::vector<Vertex_PCU> textVerts;
 	m_font->AddVertsForTextInBox2D(textVerts, "Mode (F6/F7 for Prev/Next): Raycast vs. AABB2s (2D)", m_gameSceneCoords, 15.f, Rgba8::GOLD, 0.8f, Vec2(0.f, 0.97f));
 	m_font->AddVertsForTextInBox2D(textVerts, "F8 to Randomize; LMB/RMB set ray start/end; ESDF move start; IJKL move end; Arrows move ray; Hold T for slow; Press V to snap vertically; Press H to snap Horizontally", m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.945f));
+
+	static char const* const QUERY_MODE_NAMES[AABB2_QUERY_COUNT] = { "grid DDA", "brute force scalar", "brute force SIMD", "scene BVH" };
+	std::string queryText = Stringf("Query (G) = %s, boxes = %d, cells visited = %d, boxes tested = %d, query = %.2f us", QUERY_MODE_NAMES[m_queryMode], static_cast<int>(m_AABB2s.size()),
+		m_queryStats.m_numCellsVisited, m_queryStats.m_numBoxesTested, m_querySeconds * 1000000.0);
+	if (m_queryMode == AABB2_QUERY_BVH || m_isMixedSceneOn)
+	{
+		queryText = Stringf("Query (G) = scene BVH, boxes = %d, nodes visited = %lld, shapes tested = %lld, query = %.2f us", static_cast<int>(m_AABB2s.size()),
+			m_bvhQueryStats.m_numNodesVisited, m_bvhQueryStats.m_numPrimitivesTested, m_querySeconds * 1000000.0);
+	}
+	std::string gridText = Stringf("Grid = %d x %d cells of %.1f, entries = %d, build = %.2f ms", m_grid.GetNumCellsX(), m_grid.GetNumCellsY(), m_grid.GetCellSize(), m_grid.GetNumEntries(), m_gridBuildSeconds * 1000.0);
+	m_font->AddVertsForTextInBox2D(textVerts, queryText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.92f));
+	m_font->AddVertsForTextInBox2D(textVerts, gridText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.895f));
+	for (int lineIndex = 0; lineIndex < static_cast<int>(m_benchmarkText.size()); ++lineIndex)
+	{
+		float lineAlignmentY = 0.87f - 0.025f * static_cast<float>(lineIndex);
+		m_font->AddVertsForTextInBox2D(textVerts, m_benchmarkText[lineIndex], m_gameSceneCoords, 15.f, Rgba8::GOLD, 0.8f, Vec2(0.f, lineAlignmentY));
+	}
+	AddVertsForSceneText(textVerts);
 	g_theRenderer->BindTexture(&m_font->GetTexture());
 	g_theRenderer->DrawVertexArray(textVerts);
 }
+
+void GameRaycastVsAABB2s::AddViewShapesToScene()
+{
+	for (int aabb2Index = 0; aabb2Index < (int)m_AABB2s.size(); ++aabb2Index)
+	{
+		m_scene.AddAABB2(m_AABB2s[aabb2Index]);
+	}
+}
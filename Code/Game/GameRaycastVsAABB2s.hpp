@@ -1,15 +1,27 @@
 #pragma once
-#include "Game/Game.h"
+#include "Game/GameRaycast2D.hpp"
+#include "Game/AABB2Grid.hpp"
+#include "Game/AABB2RaycastPackets.hpp"
 #include "Engine/Math/AABB2.h"
+#include "Engine/Core/Vertex_PCU.h"
+#include <string>
 #include <vector>
 // -----------------------------------------------------------------------------
-class BitmapFont;
-// -----------------------------------------------------------------------------
+// Defaults for raycastNumAABB2s, raycastMinAABB2Size and raycastMaxAABB2Size
 const int   NUM_AABB2S = 10;
 const float AABB2_MIN_SIZE = 20.f;
 const float AABB2_MAX_SIZE = 200.f;
 // -----------------------------------------------------------------------------
-class GameRaycastVsAABB2s : public Game
+enum AABB2QueryMode
+{
+	AABB2_QUERY_GRID,
+	AABB2_QUERY_SCALAR,
+	AABB2_QUERY_SIMD,
+	AABB2_QUERY_BVH,
+	AABB2_QUERY_COUNT
+};
+// -----------------------------------------------------------------------------
+class GameRaycastVsAABB2s : public GameRaycast2D
 {
 public:
 	GameRaycastVsAABB2s(App* owner);
@@ -18,18 +30,36 @@ public:
 	void Render() const override;
 
 private:
+	void AddViewShapesToScene() override;
+	void UpdateRaycast();
+	void RunRaycastBenchmark();
 	void DrawAABB2s() const;
+	void DrawVisitedCells() const;
 	void DrawRaycast() const;
 	void GameModeAndControlsText() const;
 
 	void RandomizeAABB2s();
-	void ArrowMovement();
 
 private:
-	App* m_theApp;
-	BitmapFont* m_font = nullptr;
-	Vec2 m_rayCastStart = Vec2::ZERO;
-	Vec2 m_rayCastEnd = Vec2::ZERO;
-	AABB2 m_gameSceneCoords;
 	std::vector<AABB2> m_AABB2s;
+	int	  m_numAABB2s = NUM_AABB2S;
+	float m_minAABB2Size = AABB2_MIN_SIZE;
+	float m_maxAABB2Size = AABB2_MAX_SIZE;
+	std::vector<Vertex_PCU> m_AABB2Verts;
+
+	// Rebuilt with the boxes; 0 from raycastGridCellSize sizes cells to the boxes.
+	// G cycles between the grid, testing every box one at a time or SIMD_WIDTH at a time, and
+	// the scene BVH. Only the BVH sees the mixed scene, so X forces it.
+	AABB2Grid	   m_grid;
+	AABB2Batch2D   m_AABB2Batch;
+	float		   m_gridCellSize = 0.f;
+	AABB2QueryMode m_queryMode = AABB2_QUERY_GRID;
+	double		   m_gridBuildSeconds = 0.0;
+	std::vector<std::string> m_benchmarkText;
+
+	// Stats of this frame's nearest-hit query, and the cells the grid walked to find it
+	AABB2GridQueryStats	 m_queryStats;
+	BVH2DQueryStats		 m_bvhQueryStats;
+	double				 m_querySeconds = 0.0;
+	std::vector<IntVec2> m_visitedCells;
 };
\ No newline at end of file
@@ -4,15 +4,37 @@
 #include "Engine/Input/InputSystem.h"
 #include "Engine/Core/EngineCommon.h"
 #include "Engine/Math/RaycastUtils.hpp"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Game/WorkerPool.hpp"
+#include <math.h>
 
 GameRaycastVsLinesegments::GameRaycastVsLinesegments(App* owner)
-	:m_theApp(owner)
+	:GameRaycast2D(owner, RAYCAST_SHAPE_LINE_SEGMENT)
 {
-	m_font = g_theRenderer->CreateOrGetBitmapFont("Data/Fonts/SquirrelFixedFont");
-	m_rayCastStart = Vec2(SCREEN_CENTER_X, SCREEN_CENTER_Y);
-	m_rayCastEnd = Vec2(900.f, 300.f);
+	m_numLineSegments = g_gameConfigBlackboard.GetValue("raycastNumLineSegments", NUM_LINES);
+	m_maxLineSegmentLength = g_gameConfigBlackboard.GetValue("raycastMaxLineSegmentLength", LINE_MAX_LENGTH);
+	m_numBatchRays = g_gameConfigBlackboard.GetValue("raycastBatchNumRays", 4096);
+
+	// Threads, 0 means one per hardware thread
+	int numThreads = g_gameConfigBlackboard.GetValue("raycastNumThreads", 0);
+	if (numThreads <= 0)
+	{
+		numThreads = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	if (numThreads <= 0)
+	{
+		numThreads = 1;
+	}
+	m_workerPool = new WorkerPool(numThreads);
+
 	RandomizeLineSegments();
-	m_gameSceneCoords = AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y));
+}
+
+GameRaycastVsLinesegments::~GameRaycastVsLinesegments()
+{
+	delete m_workerPool;
+	m_workerPool = nullptr;
 }
 
 void GameRaycastVsLinesegments::Update(float deltaSeconds)
@@ -22,12 +44,46 @@ void GameRaycastVsLinesegments::Update(float deltaSeconds)
 	{
 		RandomizeLineSegments();
 	}
+
+	// Segment and batch ray counts halve/double; new segment counts are rebuilt right away
+	if (g_theInput->WasKeyJustPressed(KEYCODE_LEFTBRACKET) && m_numLineSegments > 1)
+	{
+		m_numLineSegments /= 2;
+		RandomizeLineSegments();
+	}
+	if (g_theInput->WasKeyJustPressed(KEYCODE_RIGHTBRACKET) && m_numLineSegments < 1000000)
+	{
+		m_numLineSegments *= 2;
+		RandomizeLineSegments();
+	}
+	if (g_theInput->WasKeyJustPressed('O') && m_numBatchRays > 1)
+	{
+		m_numBatchRays /= 2;
+	}
+	if (g_theInput->WasKeyJustPressed('P') && m_numBatchRays < 1000000)
+	{
+		m_numBatchRays *= 2;
+	}
+	if (g_theInput->WasKeyJustPressed('B'))
+	{
+		m_isBVHOn = !m_isBVHOn;
+	}
+	if (g_theInput->WasKeyJustPressed('N'))
+	{
+		m_isBatchOn = !m_isBatchOn;
+	}
+	UpdateMixedSceneToggle();
+	UpdateDrift(deltaSeconds);
 	ArrowMovement();
+	UpdateRaycast();
+	UpdateOcclusion();
+	UpdateRayBatch();
 }
 
 void GameRaycastVsLinesegments::Render() const
 {
 	g_theRenderer->BeginCamera(g_theApp->m_screenCamera);
+	DrawMixedShapes();
 	DrawLineSegments();
 	DrawRaycast();
 	GameModeAndControlsText();
@@ -37,7 +93,7 @@ void GameRaycastVsLinesegments::RandomizeLineSegments()
 {
 	m_lineSegments.clear();
 
-	for (int lineSegmentIndex = 0; lineSegmentIndex < NUM_LINES; ++lineSegmentIndex)
+	for (int lineSegmentIndex = 0; lineSegmentIndex < m_numLineSegments; ++lineSegmentIndex)
 	{
 		LineSegment newLineSegments;
 		newLineSegments.m_lineStart = Vec2(g_rng->RollRandomFloatInRange(0.f, SCREEN_SIZE_X), g_rng->RollRandomFloatInRange(0.f, SCREEN_SIZE_Y));
@@ -46,154 +102,136 @@ void GameRaycastVsLinesegments::RandomizeLineSegments()
 		Vec2 lineDirection = newLineSegments.m_lineEnd - newLineSegments.m_lineStart;
 		float lineLength = lineDirection.GetLength();
 
-		if (lineLength > LINE_MAX_LENGTH)
+		if (lineLength > m_maxLineSegmentLength)
 		{
 			lineDirection.Normalize();
-			lineDirection *= LINE_MAX_LENGTH;
+			lineDirection *= m_maxLineSegmentLength;
 			newLineSegments.m_lineEnd = newLineSegments.m_lineStart + lineDirection;
 		}
 		m_lineSegments.push_back(newLineSegments);
 	}
-}
 
-void GameRaycastVsLinesegments::GameModeAndControlsText() const
-{
-	std::vector<Vertex_PCU> textVerts;
-	m_font->AddVertsForTextInBox2D(textVerts, "Mode (F6/F7 for Prev/Next): Raycast vs. Line Segments (2D)", m_gameSceneCoords, 15.f, Rgba8::GOLD, 0.8f, Vec2(0.f, 0.97f));
-	m_font->AddVertsForTextInBox2D(textVerts, "F8 to Randomize; LMB/RMB set ray start/end; ESDF move start; IJKL move end; Arrows move ray; Hold T for slow", m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.945f));
-	g_theRenderer->BindTexture(&m_font->GetTexture());
-	g_theRenderer->DrawVertexArray(textVerts);
-}
+	RebuildScene();
 
-void GameRaycastVsLinesegments::DrawLineSegments() const
-{
+	// The segments only change here, so their verts are built once and drawn in one call
+	m_lineSegmentVerts.clear();
 	for (int lineSegmentIndex = 0; lineSegmentIndex < (int)m_lineSegments.size(); ++lineSegmentIndex)
 	{
-		LineSegment const& lineSegment = m_lineSegments[lineSegmentIndex];
-		std::vector<Vertex_PCU> lineSegmentVerts;
-
-		AddVertsForLineSegment2D(lineSegmentVerts, lineSegment.m_lineStart, lineSegment.m_lineEnd, 3.f, Rgba8::SAPPHIRE);
-		g_theRenderer->BindTexture(nullptr);
-		g_theRenderer->DrawVertexArray(lineSegmentVerts);
+		AddVertsForLineSegment2D(m_lineSegmentVerts, m_lineSegments[lineSegmentIndex].m_lineStart, m_lineSegments[lineSegmentIndex].m_lineEnd, 3.f, Rgba8::SAPPHIRE);
 	}
 }
 
-void GameRaycastVsLinesegments::DrawRaycast() const
+void GameRaycastVsLinesegments::UpdateRaycast()
 {
 	Vec2 startToEnd = m_rayCastEnd - m_rayCastStart;
 	Vec2 rayCastDirection = startToEnd.GetNormalized();
 	float maxDist = startToEnd.GetLength();
 
-	std::vector<Vertex_PCU> arrowVerts;
-	bool didRaycasthitLine = false;
-	RaycastResult2D nearestImpact;
-	int nearestLine = 0;
-
-	for (int lineIndex = 0; lineIndex < (int)m_lineSegments.size(); ++lineIndex)
-	{
-		RaycastResult2D raycastResult = RaycastVsLineSegment2D(m_rayCastStart, rayCastDirection, maxDist, m_lineSegments[lineIndex].m_lineStart, m_lineSegments[lineIndex].m_lineEnd);
-
-		if (raycastResult.m_didImpact)
-		{
-			if (didRaycasthitLine == false || raycastResult.m_impactDist < nearestImpact.m_impactDist)
-			{
-				nearestImpact = raycastResult;
-				nearestLine = lineIndex;
-				didRaycasthitLine = true;
-			}
-		}
-	}
-
-	if (didRaycasthitLine)
+	double queryStartSeconds = GetCurrentTimeSeconds();
+	if (m_isBVHOn)
 	{
-		std::vector<Vertex_PCU> impactedLineVerts;
-
-		AddVertsForArrow2D(arrowVerts, m_rayCastStart, m_rayCastEnd, 20.f, 1.f, Rgba8::DARKGRAY);
-		AddVertsForArrow2D(arrowVerts, m_rayCastStart, nearestImpact.m_impactPos, 20.f, 1.f, Rgba8::ORANGE);
-		AddVertsForArrow2D(arrowVerts, nearestImpact.m_impactPos, nearestImpact.m_impactPos + nearestImpact.m_impactNormal * 80.f, 20.f, 1.f, Rgba8::CYAN);
-		AddVertsForDisc2D(arrowVerts, nearestImpact.m_impactPos, 4.f, Rgba8::WHITE);
-
-		AddVertsForLineSegment2D(impactedLineVerts, m_lineSegments[nearestLine].m_lineStart, m_lineSegments[nearestLine].m_lineEnd, 3.f, Rgba8::LIGHTBLUE);
-		g_theRenderer->BindTexture(nullptr);
-		g_theRenderer->DrawVertexArray(impactedLineVerts);
+		m_nearestHit = m_scene.RaycastNearest(m_rayCastStart, rayCastDirection, maxDist, GetViewShapeMask(), m_queryStats);
 	}
 	else
 	{
-		AddVertsForArrow2D(arrowVerts, m_rayCastStart, m_rayCastEnd, 20.f, 3.f, Rgba8::WHITE);
+		m_nearestHit = m_scene.RaycastNearestBruteForce(m_rayCastStart, rayCastDirection, maxDist, GetViewShapeMask(), m_queryStats);
 	}
-	g_theRenderer->BindTexture(nullptr);
-	g_theRenderer->DrawVertexArray(arrowVerts);
+	m_querySeconds = GetCurrentTimeSeconds() - queryStartSeconds;
 }
 
-void GameRaycastVsLinesegments::ArrowMovement()
+void GameRaycastVsLinesegments::UpdateRayBatch()
 {
-	// Ray start movement
-	if (g_theInput->IsKeyDown('E'))
+	m_batchVerts.clear();
+	if (!m_isBatchOn)
 	{
-		m_rayCastStart += Vec2(0.f, 1.f);
-	}
-	if (g_theInput->IsKeyDown('S'))
-	{
-		m_rayCastStart += Vec2(-1.f, 0.f);
-	}
-	if (g_theInput->IsKeyDown('D'))
-	{
-		m_rayCastStart += Vec2(0.f, -1.f);
-	}
-	if (g_theInput->IsKeyDown('F'))
-	{
-		m_rayCastStart += Vec2(1.f, 0.f);
+		return;
 	}
 
-	// Ray end movement
-	if (g_theInput->IsKeyDown('I'))
+	float batchLength = (m_rayCastEnd - m_rayCastStart).GetLength();
+	m_batchRays.resize(m_numBatchRays);
+	for (int rayIndex = 0; rayIndex < m_numBatchRays; ++rayIndex)
 	{
-		m_rayCastEnd += Vec2(0.f, 1.f);
-	}
-	if (g_theInput->IsKeyDown('J'))
-	{
-		m_rayCastEnd += Vec2(-1.f, 0.f);
-	}
-	if (g_theInput->IsKeyDown('K'))
-	{
-		m_rayCastEnd += Vec2(0.f, -1.f);
-	}
-	if (g_theInput->IsKeyDown('L'))
-	{
-		m_rayCastEnd += Vec2(1.f, 0.f);
+		float angleRadians = 6.2831853f * static_cast<float>(rayIndex) / static_cast<float>(m_numBatchRays);
+		m_batchRays[rayIndex].m_start = m_rayCastStart;
+		m_batchRays[rayIndex].m_fwdNormal = Vec2(cosf(angleRadians), sinf(angleRadians));
+		m_batchRays[rayIndex].m_maxLength = batchLength;
 	}
 
-	// Full ray movement
-	if (g_theInput->IsKeyDown(KEYCODE_UPARROW))
-	{
-		m_rayCastStart += Vec2(0.f, 1.f);
-		m_rayCastEnd += Vec2(0.f, 1.f);
-	}
-	if (g_theInput->IsKeyDown(KEYCODE_LEFTARROW))
-	{
-		m_rayCastStart += Vec2(-1.f, 0.f);
-		m_rayCastEnd += Vec2(-1.f, 0.f);
-	}
-	if (g_theInput->IsKeyDown(KEYCODE_DOWNARROW))
+	double batchStartSeconds = GetCurrentTimeSeconds();
+	m_scene.RaycastNearestBatch(*m_workerPool, m_batchRays, GetViewShapeMask(), m_batchHits, m_batchStats);
+	m_batchSeconds = GetCurrentTimeSeconds() - batchStartSeconds;
+
+	m_numBatchHits = 0;
+	int drawStride = (m_numBatchRays + MAX_DRAWN_BATCH_RAYS - 1) / MAX_DRAWN_BATCH_RAYS;
+	for (int rayIndex = 0; rayIndex < m_numBatchRays; ++rayIndex)
 	{
-		m_rayCastStart += Vec2(0.f, -1.f);
-		m_rayCastEnd += Vec2(0.f, -1.f);
+		RaycastResult2D const& result = m_batchHits[rayIndex].m_result;
+		if (result.m_didImpact)
+		{
+			++m_numBatchHits;
+		}
+		if (rayIndex % drawStride != 0)
+		{
+			continue;
+		}
+		if (result.m_didImpact)
+		{
+			AddVertsForLineSegment2D(m_batchVerts, m_rayCastStart, result.m_impactPos, 1.f, Rgba8::ORANGE);
+		}
+		else
+		{
+			Vec2 rayEnd = m_rayCastStart + m_batchRays[rayIndex].m_fwdNormal * batchLength;
+			AddVertsForLineSegment2D(m_batchVerts, m_rayCastStart, rayEnd, 1.f, Rgba8::DARKGRAY);
+		}
 	}
-	if (g_theInput->IsKeyDown(KEYCODE_RIGHTARROW))
+}
+
+void GameRaycastVsLinesegments::GameModeAndControlsText() const
+{
+	std::vector<Vertex_PCU> textVerts;
+	m_font->AddVertsForTextInBox2D(textVerts, "Mode (F6/F7 for Prev/Next): Raycast vs. Line Segments (2D)", m_gameSceneCoords, 15.f, Rgba8::GOLD, 0.8f, Vec2(0.f, 0.97f));
+	m_font->AddVertsForTextInBox2D(textVerts, "F8 to Randomize; LMB/RMB set ray start/end; ESDF move start; IJKL move end; Arrows move ray; Hold T for slow", m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.945f));
+
+	std::string queryText = Stringf("Query (B) = %s, segments ([/]) = %d, nodes visited = %lld, shapes tested = %lld, query = %.2f us", m_isBVHOn ? "BVH" : "brute force",
+		static_cast<int>(m_lineSegments.size()), m_queryStats.m_numNodesVisited, m_queryStats.m_numPrimitivesTested, m_querySeconds * 1000000.0);
+	m_font->AddVertsForTextInBox2D(textVerts, queryText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.92f));
+
+	std::string batchText = Stringf("Ray batch (N) = off, rays (O/P) = %d", m_numBatchRays);
+	if (m_isBatchOn)
 	{
-		m_rayCastStart += Vec2(1.f, 0.f);
-		m_rayCastEnd += Vec2(1.f, 0.f);
+		double raysPerSecond = (m_batchSeconds > 0.0) ? static_cast<double>(m_numBatchRays) / m_batchSeconds : 0.0;
+		float nodesPerRay = static_cast<float>(m_batchStats.m_numNodesVisited) / static_cast<float>(m_numBatchRays);
+		float shapesPerRay = static_cast<float>(m_batchStats.m_numPrimitivesTested) / static_cast<float>(m_numBatchRays);
+		batchText = Stringf("Ray batch (N) = on, rays (O/P) = %d, threads = %d, hits = %d, batch = %.3f ms, %.2f M rays/sec, nodes/ray = %.1f, shapes/ray = %.1f",
+			m_numBatchRays, m_workerPool->GetNumThreads(), m_numBatchHits, m_batchSeconds * 1000.0, raysPerSecond / 1000000.0, nodesPerRay, shapesPerRay);
 	}
+	m_font->AddVertsForTextInBox2D(textVerts, batchText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.895f));
+	AddVertsForSceneText(textVerts);
+	g_theRenderer->BindTexture(&m_font->GetTexture());
+	g_theRenderer->DrawVertexArray(textVerts);
+}
 
-	if (g_theInput->IsKeyDown(KEYCODE_LEFT_MOUSE))
+void GameRaycastVsLinesegments::DrawLineSegments() const
+{
+	g_theRenderer->BindTexture(nullptr);
+	g_theRenderer->DrawVertexArray(m_lineSegmentVerts);
+}
+
+void GameRaycastVsLinesegments::DrawRaycast() const
+{
+	if (m_isBatchOn)
 	{
-		Vec2 normalizedMouseUV = g_theInput->GetCursorNormalizedPosition();
-		m_rayCastStart = m_gameSceneCoords.GetPointAtUV(normalizedMouseUV);
+		g_theRenderer->BindTexture(nullptr);
+		g_theRenderer->DrawVertexArray(m_batchVerts);
 	}
 
-	if (g_theInput->IsKeyDown(KEYCODE_RIGHT_MOUSE))
+	DrawNearestHit();
+}
+
+void GameRaycastVsLinesegments::AddViewShapesToScene()
+{
+	for (int lineSegmentIndex = 0; lineSegmentIndex < (int)m_lineSegments.size(); ++lineSegmentIndex)
 	{
-		Vec2 normalizedMouseUV = g_theInput->GetCursorNormalizedPosition();
-		m_rayCastEnd = m_gameSceneCoords.GetPointAtUV(normalizedMouseUV);
+		m_scene.AddLineSegment(m_lineSegments[lineSegmentIndex].m_lineStart, m_lineSegments[lineSegmentIndex].m_lineEnd);
 	}
 }
@@ -1,9 +1,9 @@
 #pragma once
-#include "Game/Game.h"
-#include "Engine/Math/AABB2.h"
+#include "Game/GameRaycast2D.hpp"
+#include "Engine/Core/Vertex_PCU.h"
 #include <vector>
 // -----------------------------------------------------------------------------
-class BitmapFont;
+class WorkerPool;
 // -----------------------------------------------------------------------------
 struct LineSegment
 {
@@ -13,29 +13,51 @@ struct LineSegment
 // -----------------------------------------------------------------------------
 static const int NUM_LINES = 10;
 const float LINE_MAX_LENGTH = 200.f;
+
+// Batches bigger than this draw every Nth ray so the verts stay bounded
+const int MAX_DRAWN_BATCH_RAYS = 2048;
 // -----------------------------------------------------------------------------
-class GameRaycastVsLinesegments : public Game
+class GameRaycastVsLinesegments : public GameRaycast2D
 {
 public:
 	GameRaycastVsLinesegments(App* owner);
+	~GameRaycastVsLinesegments();
 
 	void Update(float deltaSeconds) override;
 	void Render() const override;
 
 private:
+	void AddViewShapesToScene() override;
 	void RandomizeLineSegments();
-	void ArrowMovement();
+	void UpdateRaycast();
+	void UpdateRayBatch();
 
 	void GameModeAndControlsText() const;
 	void DrawLineSegments() const;
 	void DrawRaycast() const;
 
 private:
-	App* m_theApp = nullptr;
-	BitmapFont* m_font = nullptr;
-	Vec2 m_rayCastStart = Vec2::ZERO;
-	Vec2 m_rayCastEnd = Vec2::ZERO;
-	AABB2 m_gameSceneCoords;
-
 	std::vector<LineSegment> m_lineSegments;
+	int	  m_numLineSegments = NUM_LINES;
+	float m_maxLineSegmentLength = LINE_MAX_LENGTH;
+
+	// The scene BVH is rebuilt with the segments; B switches the query back to testing every segment for comparison
+	bool   m_isBVHOn = true;
+	std::vector<Vertex_PCU> m_lineSegmentVerts;
+
+	// Stats of this frame's nearest-hit query
+	BVH2DQueryStats m_queryStats;
+	double			m_querySeconds = 0.0;
+
+	// N fires m_numBatchRays rays all around the ray start, out to the ray's length, through one
+	// RaycastNearestBatch over the worker pool
+	bool		 m_isBatchOn = false;
+	int			 m_numBatchRays = 4096;
+	WorkerPool*	 m_workerPool = nullptr;
+	std::vector<BVH2DRay>		   m_batchRays;
+	std::vector<RaycastSceneHit2D> m_batchHits;
+	std::vector<Vertex_PCU>		   m_batchVerts;
+	BVH2DQueryStats m_batchStats;
+	double			m_batchSeconds = 0.0;
+	int				m_numBatchHits = 0;
 };
\ No newline at end of file
@@ -7,169 +7,160 @@
 #include "Engine/Renderer/Renderer.h"
 #include "Engine/Input/InputSystem.h"
 #include "Engine/Math/RaycastUtils.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/StringUtils.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Game/SimdUtils.hpp"
+#include <math.h>
 
 GameRaycastVsDiscs::GameRaycastVsDiscs(App* owner)
-	:m_theApp(owner)
+	:GameRaycast2D(owner, RAYCAST_SHAPE_DISC)
 {
-	m_font = g_theRenderer->CreateOrGetBitmapFont("Data/Fonts/SquirrelFixedFont");
-
+	m_numDiscs = g_gameConfigBlackboard.GetValue("raycastNumDiscs", 10);
+	m_minDiscRadius = g_gameConfigBlackboard.GetValue("raycastMinDiscRadius", 10.f);
+	m_maxDiscRadius = g_gameConfigBlackboard.GetValue("raycastMaxDiscRadius", 170.f);
+	m_numFanRays = g_gameConfigBlackboard.GetValue("raycastFanNumRays", 2048);
 
 	RandomizeDiscs();
-	m_gameSceneCoords = AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y));
 }
 
 void GameRaycastVsDiscs::Update(float deltaSeconds)
 {
-	m_rayCastStart = Vec2(SCREEN_CENTER_X, SCREEN_CENTER_Y);
-	m_rayCastEnd = Vec2(900.f, 300.f);
 	AdjustForPauseAndTimeDistortion(deltaSeconds);
 	// Disc randomizing
 	if (g_theInput->WasKeyJustPressed(KEYCODE_F8))
 	{
 		RandomizeDiscs();
 	}
+	if (g_theInput->WasKeyJustPressed('B'))
+	{
+		m_isBVHOn = !m_isBVHOn;
+	}
+	if (g_theInput->WasKeyJustPressed('N'))
+	{
+		m_isFanOn = !m_isFanOn;
+	}
+	if (g_theInput->WasKeyJustPressed('P'))
+	{
+		m_fanKernel = static_cast<DiscFanKernel>((m_fanKernel + 1) % DISC_FAN_KERNEL_COUNT);
+	}
+	if (g_theInput->WasKeyJustPressed('M'))
+	{
+		RunRaycastBenchmark();
+	}
+	UpdateMixedSceneToggle();
+	UpdateDrift(deltaSeconds);
 	ArrowMovement();
+	UpdateRaycast();
+	UpdateOcclusion();
+	UpdateRayFan();
 }
 
 void GameRaycastVsDiscs::Render() const
 {
 	g_theRenderer->BeginCamera(g_theApp->m_screenCamera);
+	DrawMixedShapes();
 	DrawDiscs();
 	DrawRaycast();
 	GameModeAndControlsText();
 }
 
-void GameRaycastVsDiscs::ArrowMovement()
+void GameRaycastVsDiscs::UpdateRaycast()
 {
-	// Ray start movement
-	if (g_theInput->IsKeyDown('E'))
-	{
-		m_rayCastStart += Vec2(0.f, 1.f);
-	}
-	if (g_theInput->IsKeyDown('S'))
-	{
-		m_rayCastStart += Vec2(-1.f, 0.f);
-	}
-	if (g_theInput->IsKeyDown('D'))
-	{
-		m_rayCastStart += Vec2(0.f, -1.f);
-	}
-	if (g_theInput->IsKeyDown('F'))
-	{
-		m_rayCastStart += Vec2(1.f, 0.f);
-	}
+	Vec2 startToEnd = m_rayCastEnd - m_rayCastStart;
+	Vec2 rayCastDirection = startToEnd.GetNormalized();
+	float maxDist = startToEnd.GetLength();
 
-	// Ray end movement
-	if (g_theInput->IsKeyDown('I'))
+	double queryStartSeconds = GetCurrentTimeSeconds();
+	if (m_isBVHOn)
 	{
-		m_rayCastEnd += Vec2(0.f, 1.f);
+		m_nearestHit = m_scene.RaycastNearest(m_rayCastStart, rayCastDirection, maxDist, GetViewShapeMask(), m_queryStats);
 	}
-	if (g_theInput->IsKeyDown('J'))
-	{
-		m_rayCastEnd += Vec2(-1.f, 0.f);
-	}
-	if (g_theInput->IsKeyDown('K'))
-	{
-		m_rayCastEnd += Vec2(0.f, -1.f);
-	}
-	if (g_theInput->IsKeyDown('L'))
+	else
 	{
-		m_rayCastEnd += Vec2(1.f, 0.f);
+		m_nearestHit = m_scene.RaycastNearestBruteForce(m_rayCastStart, rayCastDirection, maxDist, GetViewShapeMask(), m_queryStats);
 	}
+	m_querySeconds = GetCurrentTimeSeconds() - queryStartSeconds;
+}
 
-	// Full ray movement
-	if (g_theInput->IsKeyDown(KEYCODE_UPARROW))
+void GameRaycastVsDiscs::UpdateRayFan()
+{
+	m_fanVerts.clear();
+	if (!m_isFanOn)
 	{
-		m_rayCastStart += Vec2(0.f, 1.f);
-		m_rayCastEnd += Vec2(0.f, 1.f);
+		return;
 	}
-	if (g_theInput->IsKeyDown(KEYCODE_LEFTARROW))
+
+	float fanLength = (m_rayCastEnd - m_rayCastStart).GetLength();
+	m_fanRays.Resize(m_numFanRays);
+	for (int rayIndex = 0; rayIndex < m_numFanRays; ++rayIndex)
 	{
-		m_rayCastStart += Vec2(-1.f, 0.f);
-		m_rayCastEnd += Vec2(-1.f, 0.f);
+		float angleRadians = 6.2831853f * static_cast<float>(rayIndex) / static_cast<float>(m_numFanRays);
+		m_fanRays.SetRay(rayIndex, m_rayCastStart, Vec2(cosf(angleRadians), sinf(angleRadians)), fanLength);
 	}
-	if (g_theInput->IsKeyDown(KEYCODE_DOWNARROW))
+
+	double fanStartSeconds = GetCurrentTimeSeconds();
+	switch (m_fanKernel)
 	{
-		m_rayCastStart += Vec2(0.f, -1.f);
-		m_rayCastEnd += Vec2(0.f, -1.f);
+	case DISC_FAN_KERNEL_SCALAR:		RaycastRaysVsDiscs2DScalar(m_fanRays, m_discBatch, m_fanResults, m_fanDiscIndices); break;
+	case DISC_FAN_KERNEL_RAY_PACKETS:	RaycastRayPacketsVsDiscs2D(m_fanRays, m_discBatch, m_fanResults, m_fanDiscIndices); break;
+	case DISC_FAN_KERNEL_DISC_PACKETS:	RaycastRaysVsDiscPackets2D(m_fanRays, m_discBatch, m_fanResults, m_fanDiscIndices); break;
+	default: break;
 	}
-	if (g_theInput->IsKeyDown(KEYCODE_RIGHTARROW))
+	m_fanSeconds = GetCurrentTimeSeconds() - fanStartSeconds;
+
+	m_numFanHits = 0;
+	for (int rayIndex = 0; rayIndex < m_numFanRays; ++rayIndex)
 	{
-		m_rayCastStart += Vec2(1.f, 0.f);
-		m_rayCastEnd += Vec2(1.f, 0.f);
+		RaycastResult2D const& result = m_fanResults[rayIndex];
+		if (result.m_didImpact)
+		{
+			AddVertsForLineSegment2D(m_fanVerts, m_rayCastStart, result.m_impactPos, 1.f, Rgba8::ORANGE);
+			++m_numFanHits;
+		}
+		else
+		{
+			Vec2 rayEnd = m_rayCastStart + Vec2(m_fanRays.m_fwdX[rayIndex], m_fanRays.m_fwdY[rayIndex]) * fanLength;
+			AddVertsForLineSegment2D(m_fanVerts, m_rayCastStart, rayEnd, 1.f, Rgba8::DARKGRAY);
+		}
 	}
+}
+
+void GameRaycastVsDiscs::RunRaycastBenchmark()
+{
+	std::vector<DiscRaycastBenchmarkResult> results = RunDiscRaycastBenchmark();
 
-	if (g_theInput->IsKeyDown(KEYCODE_LEFT_MOUSE))
+	m_benchmarkText.clear();
+	m_benchmarkText.push_back(Stringf("Disc raycast benchmark (M), ns per ray-disc test, SIMD width %d:", SIMD_WIDTH));
+	for (int resultIndex = 0; resultIndex < static_cast<int>(results.size()); ++resultIndex)
 	{
-		Vec2 normalizedMouseUV = g_theInput->GetCursorNormalizedPosition();
-		m_rayCastStart = m_gameSceneCoords.GetPointAtUV(normalizedMouseUV);
+		DiscRaycastBenchmarkResult const& result = results[resultIndex];
+		m_benchmarkText.push_back(Stringf("%d rays x %5d discs: scalar %.2f, ray packets %.2f (%.1fx), disc packets %.2f (%.1fx), mismatches %d", result.m_numRays, result.m_numDiscs,
+			result.m_scalarNsPerTest, result.m_rayPacketNsPerTest, result.m_scalarNsPerTest / result.m_rayPacketNsPerTest,
+			result.m_discPacketNsPerTest, result.m_scalarNsPerTest / result.m_discPacketNsPerTest, result.m_numMismatches));
 	}
 
-	if (g_theInput->IsKeyDown(KEYCODE_RIGHT_MOUSE))
+	for (int lineIndex = 0; lineIndex < static_cast<int>(m_benchmarkText.size()); ++lineIndex)
 	{
-		Vec2 normalizedMouseUV = g_theInput->GetCursorNormalizedPosition();
-		m_rayCastEnd = m_gameSceneCoords.GetPointAtUV(normalizedMouseUV);
+		DebuggerPrintf("%s\n", m_benchmarkText[lineIndex].c_str());
 	}
 }
 
 void GameRaycastVsDiscs::DrawDiscs() const
 {
-	for (int discIndex = 0; discIndex < (int)m_discs.size(); ++discIndex)
-	{
-		Disc const& disc = m_discs[discIndex];
-		std::vector<Vertex_PCU> discVerts;
-
-		AddVertsForDisc2D(discVerts, disc.m_discCenter, disc.m_discRadius, Rgba8::SAPPHIRE);
-		g_theRenderer->BindTexture(nullptr);
-		g_theRenderer->DrawVertexArray(discVerts);
-	}
+	g_theRenderer->BindTexture(nullptr);
+	g_theRenderer->DrawVertexArray(m_discVerts);
 }
 
 void GameRaycastVsDiscs::DrawRaycast() const
 {
-	Vec2 startToEnd = m_rayCastEnd - m_rayCastStart;
-	Vec2 rayCastDirection = startToEnd.GetNormalized();
-	float maxDist = startToEnd.GetLength();
-
-	std::vector<Vertex_PCU> arrowVerts;
-	bool didRayHitDisc = false;
-	RaycastResult2D nearestImpact;
-	int nearestDisc = 0;
-
-	for (int discIndex = 0; discIndex < (int)m_discs.size(); ++discIndex)
+	if (m_isFanOn)
 	{
-		RaycastResult2D rayCastResult = RaycastVsDisc2D(m_rayCastStart, rayCastDirection, maxDist, m_discs[discIndex].m_discCenter, m_discs[discIndex].m_discRadius);
-
-		if (rayCastResult.m_didImpact)
-		{
-			if (didRayHitDisc == false || rayCastResult.m_impactDist < nearestImpact.m_impactDist)
-			{
-				nearestImpact = rayCastResult;
-				nearestDisc = discIndex;
-				didRayHitDisc = true;
-			}
-		}
-	}
-
-	if (didRayHitDisc)
-	{
-		std::vector<Vertex_PCU> impactedDiscVerts;
-
-		AddVertsForArrow2D(arrowVerts, m_rayCastStart, m_rayCastEnd, 20.f, 1.f, Rgba8::DARKGRAY);
-		AddVertsForArrow2D(arrowVerts, m_rayCastStart, nearestImpact.m_impactPos, 20.f, 1.f, Rgba8::ORANGE);
-		AddVertsForArrow2D(arrowVerts, nearestImpact.m_impactPos, nearestImpact.m_impactPos + nearestImpact.m_impactNormal * 100.f, 20.f, 1.f, Rgba8::CYAN);
-		AddVertsForDisc2D(arrowVerts, nearestImpact.m_impactPos, 4.f, Rgba8::WHITE);
-
-		AddVertsForDisc2D(impactedDiscVerts, m_discs[nearestDisc].m_discCenter, m_discs[nearestDisc].m_discRadius, Rgba8::LIGHTBLUE);
 		g_theRenderer->BindTexture(nullptr);
-		g_theRenderer->DrawVertexArray(impactedDiscVerts);
+		g_theRenderer->DrawVertexArray(m_fanVerts);
 	}
-	else
-	{
-		AddVertsForArrow2D(arrowVerts, m_rayCastStart, m_rayCastEnd, 20.f, 3.f, Rgba8::WHITE);
-	}
-	g_theRenderer->BindTexture(nullptr);
-	g_theRenderer->DrawVertexArray(arrowVerts);
+
+	DrawNearestHit();
 }
 
 void GameRaycastVsDiscs::GameModeAndControlsText() const
@@ -177,6 +168,24 @@ void GameRaycastVsDiscs::GameModeAndControlsText() const
 	std::vector<Vertex_PCU> textVerts;
 	m_font->AddVertsForTextInBox2D(textVerts, "Mode (F6/F7 for Prev/Next): Raycast vs. Discs (2D)", m_gameSceneCoords, 15.f, Rgba8::GOLD, 0.8f, Vec2(0.f, 0.97f));
 	m_font->AddVertsForTextInBox2D(textVerts, "F8 to Randomize; LMB/RMB set ray start/end; ESDF move start; IJKL move end; Arrows move ray; Hold T for slow", m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.945f));
+
+	std::string queryText = Stringf("Query (B) = %s, discs = %d, nodes visited = %lld, shapes tested = %lld, query = %.2f us", m_isBVHOn ? "BVH" : "brute force", static_cast<int>(m_discs.size()),
+		m_queryStats.m_numNodesVisited, m_queryStats.m_numPrimitivesTested, m_querySeconds * 1000000.0);
+	m_font->AddVertsForTextInBox2D(textVerts, queryText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.92f));
+
+	static char const* const FAN_KERNEL_NAMES[DISC_FAN_KERNEL_COUNT] = { "scalar", "ray packets", "disc packets" };
+	std::string fanText = "Ray fan (N) = off";
+	if (m_isFanOn)
+	{
+		fanText = Stringf("Ray fan (N) = %d rays, kernel (P) = %s, hits = %d, fan = %.3f ms", m_numFanRays, FAN_KERNEL_NAMES[m_fanKernel], m_numFanHits, m_fanSeconds * 1000.0);
+	}
+	m_font->AddVertsForTextInBox2D(textVerts, fanText, m_gameSceneCoords, 15.f, Rgba8::ALICEBLUE, 0.8f, Vec2(0.f, 0.895f));
+	for (int lineIndex = 0; lineIndex < static_cast<int>(m_benchmarkText.size()); ++lineIndex)
+	{
+		float lineAlignmentY = 0.87f - 0.025f * static_cast<float>(lineIndex);
+		m_font->AddVertsForTextInBox2D(textVerts, m_benchmarkText[lineIndex], m_gameSceneCoords, 15.f, Rgba8::GOLD, 0.8f, Vec2(0.f, lineAlignmentY));
+	}
+	AddVertsForSceneText(textVerts);
 	g_theRenderer->BindTexture(&m_font->GetTexture());
 	g_theRenderer->DrawVertexArray(textVerts);
 }
@@ -184,11 +193,33 @@ void GameRaycastVsDiscs::GameModeAndControlsText() const
 void GameRaycastVsDiscs::RandomizeDiscs()
 {
 	m_discs.clear();
-	for (int discsIndex = 0; discsIndex < NUM_DISCS; ++discsIndex)
+	for (int discsIndex = 0; discsIndex < m_numDiscs; ++discsIndex)
 	{
 		Disc newDiscs;
 		newDiscs.m_discCenter = Vec2(g_rng->RollRandomFloatInRange(0.f, SCREEN_SIZE_X), g_rng->RollRandomFloatInRange(0.f, SCREEN_SIZE_Y));
-		newDiscs.m_discRadius = g_rng->RollRandomFloatInRange(10.f, 170.f);
+		newDiscs.m_discRadius = g_rng->RollRandomFloatInRange(m_minDiscRadius, m_maxDiscRadius);
 		m_discs.push_back(newDiscs);
 	}
+	RebuildScene();
+
+	m_discBatch.Clear();
+	for (int discIndex = 0; discIndex < (int)m_discs.size(); ++discIndex)
+	{
+		m_discBatch.AddDisc(m_discs[discIndex].m_discCenter, m_discs[discIndex].m_discRadius);
+	}
+
+	// The discs only change here, so their verts are built once and drawn in one call
+	m_discVerts.clear();
+	for (int discIndex = 0; discIndex < (int)m_discs.size(); ++discIndex)
+	{
+		AddVertsForDisc2D(m_discVerts, m_discs[discIndex].m_discCenter, m_discs[discIndex].m_discRadius, Rgba8::SAPPHIRE);
+	}
+}
+
+void GameRaycastVsDiscs::AddViewShapesToScene()
+{
+	for (int discIndex = 0; discIndex < (int)m_discs.size(); ++discIndex)
+	{
+		m_scene.AddDisc(m_discs[discIndex].m_discCenter, m_discs[discIndex].m_discRadius);
+	}
 }
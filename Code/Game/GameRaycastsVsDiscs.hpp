@@ -1,38 +1,66 @@
 #pragma once
-#include "Game/Game.h"
-#include "Game/GameCommon.h"
-#include "Engine/Math/AABB2.h"
+#include "Game/GameRaycast2D.hpp"
+#include "Game/DiscRaycastPackets.hpp"
+#include "Engine/Core/Vertex_PCU.h"
+#include <string>
 #include <vector>
 // -----------------------------------------------------------------------------
-class BitmapFont;
-// -----------------------------------------------------------------------------
 struct Disc
 {
 	Vec2 m_discCenter = Vec2::ZERO;
 	float m_discRadius = 0.0f;
 };
 // -----------------------------------------------------------------------------
-class GameRaycastVsDiscs : public Game
+enum DiscFanKernel
+{
+	DISC_FAN_KERNEL_SCALAR,
+	DISC_FAN_KERNEL_RAY_PACKETS,
+	DISC_FAN_KERNEL_DISC_PACKETS,
+	DISC_FAN_KERNEL_COUNT
+};
+// -----------------------------------------------------------------------------
+class GameRaycastVsDiscs : public GameRaycast2D
 {
 public:
 	GameRaycastVsDiscs(App* owner);
 
 	void Update(float deltaSeconds) override;
 	void Render() const override;
-	void ArrowMovement();
 
 private:
+	void AddViewShapesToScene() override;
 	void RandomizeDiscs();
+	void UpdateRaycast();
+	void UpdateRayFan();
+	void RunRaycastBenchmark();
 	void DrawDiscs() const;
 	void DrawRaycast() const;
 	void GameModeAndControlsText() const;
 
 private:
-	App* m_theApp;
-	BitmapFont* m_font = nullptr;
-	static const int NUM_DISCS = 10;
-	Vec2 m_rayCastStart = Vec2::ZERO;
-	Vec2 m_rayCastEnd = Vec2::ZERO;
-	AABB2 m_gameSceneCoords;
+	int	  m_numDiscs = 10;
+	float m_minDiscRadius = 10.f;
+	float m_maxDiscRadius = 170.f;
 	std::vector<Disc> m_discs;
+
+	// The scene BVH is rebuilt with the discs; B switches the query back to testing every disc for comparison
+	bool   m_isBVHOn = true;
+	std::vector<Vertex_PCU> m_discVerts;
+
+	// Stats of this frame's nearest-hit query
+	BVH2DQueryStats m_queryStats;
+	double			m_querySeconds = 0.0;
+
+	// N fires m_numFanRays rays all around the ray start, out to the ray's length, through the kernel P picks
+	bool		  m_isFanOn = false;
+	int			  m_numFanRays = 2048;
+	DiscFanKernel m_fanKernel = DISC_FAN_KERNEL_RAY_PACKETS;
+	DiscBatch2D	  m_discBatch;
+	RayBatch2D	  m_fanRays;
+	std::vector<RaycastResult2D> m_fanResults;
+	std::vector<int>			 m_fanDiscIndices;
+	std::vector<Vertex_PCU>		 m_fanVerts;
+	double		  m_fanSeconds = 0.0;
+	int			  m_numFanHits = 0;
+	std::vector<std::string> m_benchmarkText;
 };
\ No newline at end of file
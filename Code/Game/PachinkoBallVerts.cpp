@@ -0,0 +1,108 @@
+#include "Game/PachinkoBallVerts.hpp"
+#include "Game/PachinkoBalls.hpp"
+#include "Game/GameCommon.h"
+#include "Game/SimdUtils.hpp"
+#include "Engine/Math/MathUtils.h"
+#include <math.h>
+
+void PachinkoBallVerts::Initialize(int capacity)
+{
+	// One triangle per slice, fanned around the center the same way AddVertsForDisc2D builds them
+	m_unitDiscXY.resize(BALL_DISC_NUM_VERTS * 2);
+	float degreesPerSlice = 360.f / static_cast<float>(BALL_DISC_NUM_SLICES);
+	for (int sliceIndex = 0; sliceIndex < BALL_DISC_NUM_SLICES; ++sliceIndex)
+	{
+		float startDegrees = degreesPerSlice * static_cast<float>(sliceIndex);
+		float endDegrees = degreesPerSlice * static_cast<float>(sliceIndex + 1);
+
+		float* triangleXY = &m_unitDiscXY[sliceIndex * 6];
+		triangleXY[0] = 0.f;
+		triangleXY[1] = 0.f;
+		triangleXY[2] = CosDegrees(startDegrees);
+		triangleXY[3] = SinDegrees(startDegrees);
+		triangleXY[4] = CosDegrees(endDegrees);
+		triangleXY[5] = SinDegrees(endDegrees);
+	}
+
+	// z and uvs never change, so they are written once here and only positions and colors are touched per frame
+	m_drawCenterX.resize(capacity);
+	m_drawCenterY.resize(capacity);
+	m_verts.assign(capacity * BALL_DISC_NUM_VERTS, Vertex_PCU(Vec3(0.f, 0.f, 0.f), Rgba8::WHITE, Vec2(0.f, 0.f)));
+	m_numVerts = 0;
+}
+
+void PachinkoBallVerts::UpdateVerts(PachinkoBalls const& balls, float interpolationFraction)
+{
+	UpdateDrawCenters(balls, interpolationFraction);
+
+	float const* unitDiscXY = m_unitDiscXY.data();
+	float discXY[BALL_DISC_NUM_VERTS * 2];
+	float centerXY[SIMD_WIDTH];
+
+	for (int ballIndex = 0; ballIndex < balls.GetNumBalls(); ++ballIndex)
+	{
+		for (int laneIndex = 0; laneIndex < SIMD_WIDTH; laneIndex += 2)
+		{
+			centerXY[laneIndex] = m_drawCenterX[ballIndex];
+			centerXY[laneIndex + 1] = m_drawCenterY[ballIndex];
+		}
+		SimdFloat center = SimdLoad(centerXY);
+		SimdFloat radius = SimdSet(balls.m_radius[ballIndex]);
+
+		for (int floatIndex = 0; floatIndex < BALL_DISC_NUM_VERTS * 2; floatIndex += SIMD_WIDTH)
+		{
+			SimdStore(discXY + floatIndex, SimdAdd(center, SimdMul(radius, SimdLoad(unitDiscXY + floatIndex))));
+		}
+
+		Rgba8 color = balls.m_color[ballIndex];
+		Vertex_PCU* ballVerts = &m_verts[ballIndex * BALL_DISC_NUM_VERTS];
+		for (int vertIndex = 0; vertIndex < BALL_DISC_NUM_VERTS; ++vertIndex)
+		{
+			ballVerts[vertIndex].m_position.x = discXY[vertIndex * 2];
+			ballVerts[vertIndex].m_position.y = discXY[vertIndex * 2 + 1];
+			ballVerts[vertIndex].m_color = color;
+		}
+	}
+
+	m_numVerts = balls.GetNumBalls() * BALL_DISC_NUM_VERTS;
+}
+
+void PachinkoBallVerts::UpdateDrawCenters(PachinkoBalls const& balls, float interpolationFraction)
+{
+	float const* positionX = balls.m_positionX.data();
+	float const* positionY = balls.m_positionY.data();
+	float const* previousPositionX = balls.m_previousPositionX.data();
+	float const* previousPositionY = balls.m_previousPositionY.data();
+	float* drawCenterX = m_drawCenterX.data();
+	float* drawCenterY = m_drawCenterY.data();
+
+	// A ball that just warped from the floor to the top would otherwise be drawn halfway between
+	SimdFloat zero = SimdSet(0.f);
+	SimdFloat fraction = SimdSet(interpolationFraction);
+	SimdFloat maxBlendDistanceY = SimdSet(SCREEN_CENTER_Y);
+
+	int ballIndex = 0;
+	for (; ballIndex + SIMD_WIDTH <= balls.GetNumBalls(); ballIndex += SIMD_WIDTH)
+	{
+		SimdFloat posX = SimdLoad(positionX + ballIndex);
+		SimdFloat posY = SimdLoad(positionY + ballIndex);
+		SimdFloat prevX = SimdLoad(previousPositionX + ballIndex);
+		SimdFloat prevY = SimdLoad(previousPositionY + ballIndex);
+
+		SimdFloat deltaY = SimdSub(posY, prevY);
+		SimdFloat isBlended = SimdLessThan(SimdMax(deltaY, SimdSub(zero, deltaY)), maxBlendDistanceY);
+		SimdStore(drawCenterX + ballIndex, SimdSelect(isBlended, SimdAdd(prevX, SimdMul(SimdSub(posX, prevX), fraction)), posX));
+		SimdStore(drawCenterY + ballIndex, SimdSelect(isBlended, SimdAdd(prevY, SimdMul(deltaY, fraction)), posY));
+	}
+
+	for (; ballIndex < balls.GetNumBalls(); ++ballIndex)
+	{
+		drawCenterX[ballIndex] = positionX[ballIndex];
+		drawCenterY[ballIndex] = positionY[ballIndex];
+		if (fabsf(positionY[ballIndex] - previousPositionY[ballIndex]) < SCREEN_CENTER_Y)
+		{
+			drawCenterX[ballIndex] = previousPositionX[ballIndex] + (positionX[ballIndex] - previousPositionX[ballIndex]) * interpolationFraction;
+			drawCenterY[ballIndex] = previousPositionY[ballIndex] + (positionY[ballIndex] - previousPositionY[ballIndex]) * interpolationFraction;
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Engine/Core/Vertex_PCU.h"
+#include <vector>
+// -----------------------------------------------------------------------------
+struct PachinkoBalls;
+// -----------------------------------------------------------------------------
+// Balls are only a few pixels across, so a coarser disc than AddVertsForDisc2D is plenty.
+// Twice the vert count must stay a multiple of SIMD_WIDTH for the transform kernel.
+const int BALL_DISC_NUM_SLICES = 16;
+const int BALL_DISC_NUM_VERTS = 3 * BALL_DISC_NUM_SLICES;
+// -----------------------------------------------------------------------------
+// Vertex buffer for every ball in the pool, sized for the pool's capacity up front.
+// A unit disc is built once; each frame it is scaled and moved onto every ball with
+// SIMD, so drawing the balls costs no trig and no allocation.
+// -----------------------------------------------------------------------------
+class PachinkoBallVerts
+{
+public:
+	void Initialize(int capacity);
+
+	// Blends balls between their previous and current positions by interpolationFraction
+	void UpdateVerts(PachinkoBalls const& balls, float interpolationFraction);
+
+	int				  GetNumVerts() const	{ return m_numVerts; }
+	Vertex_PCU const* GetVerts() const		{ return m_verts.data(); }
+
+private:
+	void UpdateDrawCenters(PachinkoBalls const& balls, float interpolationFraction);
+
+private:
+	// Unit disc as interleaved x, y pairs
+	std::vector<float> m_unitDiscXY;
+
+	std::vector<float> m_drawCenterX;
+	std::vector<float> m_drawCenterY;
+	std::vector<Vertex_PCU> m_verts;
+	int m_numVerts = 0;
+};
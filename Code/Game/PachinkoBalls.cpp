@@ -0,0 +1,501 @@
+#include "Game/PachinkoBalls.hpp"
+#include "Game/GameCommon.h"
+#include "Game/SimdUtils.hpp"
+#include "Engine/Math/MathUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+
+// -----------------------------------------------------------------------------
+// std::chrono rather than the engine clock, so the headless benchmark links without the platform layer
+static double GetBenchmarkTimeSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// -----------------------------------------------------------------------------
+// The array-of-structs layout balls used before PachinkoBalls, kept as the benchmark baseline
+struct Balls
+{
+	Vec2 m_discCenter = Vec2::ZERO;
+	float m_discRadius = 0.0f;
+
+	Vec2 m_velocity = Vec2::ZERO;
+
+	float m_ballElasticity = 0.9f;
+	Rgba8 m_ballColor = Rgba8::WHITE;
+};
+
+void PachinkoBalls::Initialize(int capacity)
+{
+	m_capacity = capacity;
+	m_numBalls = 0;
+	m_numAwakeBalls = 0;
+
+	m_positionX.resize(capacity);
+	m_positionY.resize(capacity);
+	m_previousPositionX.resize(capacity);
+	m_previousPositionY.resize(capacity);
+	m_velocityX.resize(capacity);
+	m_velocityY.resize(capacity);
+	m_radius.resize(capacity);
+	m_elasticity.resize(capacity);
+	m_color.resize(capacity);
+	m_numRestingSteps.resize(capacity);
+	m_islandId.resize(capacity);
+
+	// Ids ride along with SwapBalls, so a spawn picks up whichever id the last despawn left in the free slot
+	m_ballId.resize(capacity);
+	for (int ballIndex = 0; ballIndex < capacity; ++ballIndex)
+	{
+		m_ballId[ballIndex] = ballIndex;
+	}
+}
+
+bool PachinkoBalls::AddBall(Vec2 const& center, float radius, Vec2 const& velocity, float elasticity, Rgba8 const& color)
+{
+	if (IsFull())
+	{
+		return false;
+	}
+
+	int ballIndex = m_numBalls;
+	m_positionX[ballIndex] = center.x;
+	m_positionY[ballIndex] = center.y;
+	m_previousPositionX[ballIndex] = center.x;
+	m_previousPositionY[ballIndex] = center.y;
+	m_velocityX[ballIndex] = velocity.x;
+	m_velocityY[ballIndex] = velocity.y;
+	m_radius[ballIndex] = radius;
+	m_elasticity[ballIndex] = elasticity;
+	m_color[ballIndex] = color;
+	m_numRestingSteps[ballIndex] = 0;
+	m_islandId[ballIndex] = -1;
+	++m_numBalls;
+
+	// New balls start awake, so trade places with the first sleeping ball
+	SwapBalls(ballIndex, m_numAwakeBalls);
+	++m_numAwakeBalls;
+	return true;
+}
+
+void PachinkoBalls::RemoveBall(int ballIndex)
+{
+	// Fill the hole from the end of its own range, then fill that from the end of the pool,
+	// so both the awake prefix and the live range stay packed for the kernels
+	if (IsBallAwake(ballIndex))
+	{
+		--m_numAwakeBalls;
+		SwapBalls(ballIndex, m_numAwakeBalls);
+		ballIndex = m_numAwakeBalls;
+	}
+
+	--m_numBalls;
+	SwapBalls(ballIndex, m_numBalls);
+}
+
+void PachinkoBalls::SwapBalls(int ballIndexA, int ballIndexB)
+{
+	if (ballIndexA == ballIndexB)
+	{
+		return;
+	}
+
+	std::swap(m_positionX[ballIndexA], m_positionX[ballIndexB]);
+	std::swap(m_positionY[ballIndexA], m_positionY[ballIndexB]);
+	std::swap(m_previousPositionX[ballIndexA], m_previousPositionX[ballIndexB]);
+	std::swap(m_previousPositionY[ballIndexA], m_previousPositionY[ballIndexB]);
+	std::swap(m_velocityX[ballIndexA], m_velocityX[ballIndexB]);
+	std::swap(m_velocityY[ballIndexA], m_velocityY[ballIndexB]);
+	std::swap(m_radius[ballIndexA], m_radius[ballIndexB]);
+	std::swap(m_elasticity[ballIndexA], m_elasticity[ballIndexB]);
+	std::swap(m_color[ballIndexA], m_color[ballIndexB]);
+	std::swap(m_numRestingSteps[ballIndexA], m_numRestingSteps[ballIndexB]);
+	std::swap(m_islandId[ballIndexA], m_islandId[ballIndexB]);
+	std::swap(m_ballId[ballIndexA], m_ballId[ballIndexB]);
+}
+
+void PachinkoBalls::PutBallToSleep(int ballIndex, int islandId)
+{
+	m_velocityX[ballIndex] = 0.f;
+	m_velocityY[ballIndex] = 0.f;
+	m_previousPositionX[ballIndex] = m_positionX[ballIndex];
+	m_previousPositionY[ballIndex] = m_positionY[ballIndex];
+	m_islandId[ballIndex] = islandId;
+
+	--m_numAwakeBalls;
+	SwapBalls(ballIndex, m_numAwakeBalls);
+}
+
+void PachinkoBalls::WakeBall(int ballIndex)
+{
+	m_numRestingSteps[ballIndex] = 0;
+	m_islandId[ballIndex] = -1;
+
+	SwapBalls(ballIndex, m_numAwakeBalls);
+	++m_numAwakeBalls;
+}
+
+void PachinkoBalls::WakeAllBalls()
+{
+	for (int ballIndex = m_numAwakeBalls; ballIndex < m_numBalls; ++ballIndex)
+	{
+		m_numRestingSteps[ballIndex] = 0;
+		m_islandId[ballIndex] = -1;
+	}
+	m_numAwakeBalls = m_numBalls;
+}
+
+void PachinkoBalls::Clear()
+{
+	m_numBalls = 0;
+	m_numAwakeBalls = 0;
+	for (int ballIndex = 0; ballIndex < m_capacity; ++ballIndex)
+	{
+		m_ballId[ballIndex] = ballIndex;
+	}
+}
+
+void IntegrateBalls(PachinkoBalls& balls, int firstBall, int lastBall, float gravityY, float deltaSeconds)
+{
+	float* positionX = balls.m_positionX.data();
+	float* positionY = balls.m_positionY.data();
+	float* velocityX = balls.m_velocityX.data();
+	float* velocityY = balls.m_velocityY.data();
+
+	SimdFloat deltaVelocityY = SimdSet(gravityY * deltaSeconds);
+	SimdFloat deltaTime = SimdSet(deltaSeconds);
+
+	int ballIndex = firstBall;
+	for (; ballIndex + SIMD_WIDTH <= lastBall; ballIndex += SIMD_WIDTH)
+	{
+		SimdFloat velX = SimdLoad(velocityX + ballIndex);
+		SimdFloat velY = SimdAdd(SimdLoad(velocityY + ballIndex), deltaVelocityY);
+		SimdStore(velocityY + ballIndex, velY);
+		SimdStore(positionX + ballIndex, SimdAdd(SimdLoad(positionX + ballIndex), SimdMul(velX, deltaTime)));
+		SimdStore(positionY + ballIndex, SimdAdd(SimdLoad(positionY + ballIndex), SimdMul(velY, deltaTime)));
+	}
+
+	IntegrateBallsScalar(balls, ballIndex, lastBall, gravityY, deltaSeconds);
+}
+
+void BounceBallsOffSideWalls(PachinkoBalls& balls, int firstBall, int lastBall, float minX, float maxX, float wallElasticity)
+{
+	float* positionX = balls.m_positionX.data();
+	float* velocityX = balls.m_velocityX.data();
+	float const* radius = balls.m_radius.data();
+	float const* elasticity = balls.m_elasticity.data();
+
+	SimdFloat zero = SimdSet(0.f);
+	SimdFloat wallMinX = SimdSet(minX);
+	SimdFloat wallMaxX = SimdSet(maxX);
+	SimdFloat wallBounce = SimdSet(wallElasticity);
+
+	int ballIndex = firstBall;
+	for (; ballIndex + SIMD_WIDTH <= lastBall; ballIndex += SIMD_WIDTH)
+	{
+		SimdFloat posX = SimdLoad(positionX + ballIndex);
+		SimdFloat velX = SimdLoad(velocityX + ballIndex);
+		SimdFloat ballRadius = SimdLoad(radius + ballIndex);
+		SimdFloat ballElasticity = SimdLoad(elasticity + ballIndex);
+
+		SimdFloat westLimit = SimdAdd(wallMinX, ballRadius);
+		SimdFloat eastLimit = SimdSub(wallMaxX, ballRadius);
+		SimdFloat isPastWest = SimdLessThan(posX, westLimit);
+		SimdFloat isPastEast = SimdAndNot(isPastWest, SimdGreaterThan(posX, eastLimit));
+
+		// Push out of the wall, then reflect only the balls still moving into it
+		posX = SimdSelect(isPastWest, westLimit, posX);
+		posX = SimdSelect(isPastEast, eastLimit, posX);
+
+		SimdFloat isMovingWest = SimdAnd(isPastWest, SimdLessThan(velX, zero));
+		SimdFloat isMovingEast = SimdAnd(isPastEast, SimdGreaterThan(velX, zero));
+		SimdFloat bouncedVelX = SimdSub(zero, SimdMul(velX, SimdMul(ballElasticity, wallBounce)));
+		velX = SimdSelect(SimdOr(isMovingWest, isMovingEast), bouncedVelX, velX);
+
+		SimdStore(positionX + ballIndex, posX);
+		SimdStore(velocityX + ballIndex, velX);
+	}
+
+	BounceBallsOffSideWallsScalar(balls, ballIndex, lastBall, minX, maxX, wallElasticity);
+}
+
+void BounceBallsOffFloorOrWarp(PachinkoBalls& balls, int firstBall, int lastBall, float floorY, float warpY, float wallElasticity, bool isBottomWarpOn)
+{
+	float* positionY = balls.m_positionY.data();
+	float* velocityY = balls.m_velocityY.data();
+	float const* radius = balls.m_radius.data();
+	float const* elasticity = balls.m_elasticity.data();
+
+	SimdFloat zero = SimdSet(0.f);
+	SimdFloat wallFloorY = SimdSet(floorY);
+	SimdFloat wallWarpY = SimdSet(warpY);
+	SimdFloat wallBounce = SimdSet(wallElasticity);
+
+	int ballIndex = firstBall;
+	for (; ballIndex + SIMD_WIDTH <= lastBall; ballIndex += SIMD_WIDTH)
+	{
+		SimdFloat posY = SimdLoad(positionY + ballIndex);
+		SimdFloat ballRadius = SimdLoad(radius + ballIndex);
+
+		if (isBottomWarpOn)
+		{
+			SimdFloat isBelowFloor = SimdLessThan(posY, SimdSub(wallFloorY, ballRadius));
+			posY = SimdSelect(isBelowFloor, SimdAdd(wallWarpY, ballRadius), posY);
+		}
+		else
+		{
+			SimdFloat velY = SimdLoad(velocityY + ballIndex);
+			SimdFloat ballElasticity = SimdLoad(elasticity + ballIndex);
+
+			SimdFloat floorLimit = SimdAdd(wallFloorY, ballRadius);
+			SimdFloat isPastFloor = SimdLessThan(posY, floorLimit);
+			posY = SimdSelect(isPastFloor, floorLimit, posY);
+
+			SimdFloat isMovingDown = SimdAnd(isPastFloor, SimdLessThan(velY, zero));
+			SimdFloat bouncedVelY = SimdSub(zero, SimdMul(velY, SimdMul(ballElasticity, wallBounce)));
+			velY = SimdSelect(isMovingDown, bouncedVelY, velY);
+			SimdStore(velocityY + ballIndex, velY);
+		}
+
+		SimdStore(positionY + ballIndex, posY);
+	}
+
+	BounceBallsOffFloorOrWarpScalar(balls, ballIndex, lastBall, floorY, warpY, wallElasticity, isBottomWarpOn);
+}
+
+void SaveBallPreviousPositions(PachinkoBalls& balls, int firstBall, int lastBall)
+{
+	std::copy(balls.m_positionX.begin() + firstBall, balls.m_positionX.begin() + lastBall, balls.m_previousPositionX.begin() + firstBall);
+	std::copy(balls.m_positionY.begin() + firstBall, balls.m_positionY.begin() + lastBall, balls.m_previousPositionY.begin() + firstBall);
+}
+
+float GetMaxBallSpeedSquared(PachinkoBalls const& balls, int firstBall, int lastBall)
+{
+	float const* velocityX = balls.m_velocityX.data();
+	float const* velocityY = balls.m_velocityY.data();
+
+	SimdFloat maxSpeedSquared = SimdSet(0.f);
+	int ballIndex = firstBall;
+	for (; ballIndex + SIMD_WIDTH <= lastBall; ballIndex += SIMD_WIDTH)
+	{
+		SimdFloat velX = SimdLoad(velocityX + ballIndex);
+		SimdFloat velY = SimdLoad(velocityY + ballIndex);
+		maxSpeedSquared = SimdMax(maxSpeedSquared, SimdAdd(SimdMul(velX, velX), SimdMul(velY, velY)));
+	}
+
+	float laneMaxSpeedSquared[SIMD_WIDTH];
+	SimdStore(laneMaxSpeedSquared, maxSpeedSquared);
+	float result = 0.f;
+	for (int lane = 0; lane < SIMD_WIDTH; ++lane)
+	{
+		result = fmaxf(result, laneMaxSpeedSquared[lane]);
+	}
+
+	for (; ballIndex < lastBall; ++ballIndex)
+	{
+		result = fmaxf(result, velocityX[ballIndex] * velocityX[ballIndex] + velocityY[ballIndex] * velocityY[ballIndex]);
+	}
+	return result;
+}
+
+int UpdateBallRestingSteps(PachinkoBalls& balls, int firstBall, int lastBall, float sleepSpeed, int numStepsToSleep)
+{
+	float sleepSpeedSquared = sleepSpeed * sleepSpeed;
+	int numReadyToSleep = 0;
+
+	for (int ballIndex = firstBall; ballIndex < lastBall; ++ballIndex)
+	{
+		float velX = balls.m_velocityX[ballIndex];
+		float velY = balls.m_velocityY[ballIndex];
+		if (velX * velX + velY * velY < sleepSpeedSquared)
+		{
+			++balls.m_numRestingSteps[ballIndex];
+		}
+		else
+		{
+			balls.m_numRestingSteps[ballIndex] = 0;
+		}
+
+		if (balls.m_numRestingSteps[ballIndex] >= numStepsToSleep)
+		{
+			++numReadyToSleep;
+		}
+	}
+
+	return numReadyToSleep;
+}
+
+void IntegrateBallsScalar(PachinkoBalls& balls, int firstBall, int lastBall, float gravityY, float deltaSeconds)
+{
+	float deltaVelocityY = gravityY * deltaSeconds;
+
+	for (int ballIndex = firstBall; ballIndex < lastBall; ++ballIndex)
+	{
+		balls.m_velocityY[ballIndex] += deltaVelocityY;
+		balls.m_positionX[ballIndex] += balls.m_velocityX[ballIndex] * deltaSeconds;
+		balls.m_positionY[ballIndex] += balls.m_velocityY[ballIndex] * deltaSeconds;
+	}
+}
+
+void BounceBallsOffSideWallsScalar(PachinkoBalls& balls, int firstBall, int lastBall, float minX, float maxX, float wallElasticity)
+{
+	for (int ballIndex = firstBall; ballIndex < lastBall; ++ballIndex)
+	{
+		float& posX = balls.m_positionX[ballIndex];
+		float& velX = balls.m_velocityX[ballIndex];
+		float bounce = balls.m_elasticity[ballIndex] * wallElasticity;
+
+		float westLimit = minX + balls.m_radius[ballIndex];
+		float eastLimit = maxX - balls.m_radius[ballIndex];
+
+		if (posX < westLimit)
+		{
+			posX = westLimit;
+			if (velX < 0.f)
+			{
+				velX = 0.f - velX * bounce;
+			}
+		}
+		else if (posX > eastLimit)
+		{
+			posX = eastLimit;
+			if (velX > 0.f)
+			{
+				velX = 0.f - velX * bounce;
+			}
+		}
+	}
+}
+
+void BounceBallsOffFloorOrWarpScalar(PachinkoBalls& balls, int firstBall, int lastBall, float floorY, float warpY, float wallElasticity, bool isBottomWarpOn)
+{
+	for (int ballIndex = firstBall; ballIndex < lastBall; ++ballIndex)
+	{
+		float& posY = balls.m_positionY[ballIndex];
+		float ballRadius = balls.m_radius[ballIndex];
+
+		if (isBottomWarpOn)
+		{
+			if (posY < floorY - ballRadius)
+			{
+				posY = warpY + ballRadius;
+			}
+		}
+		else if (posY < floorY + ballRadius)
+		{
+			posY = floorY + ballRadius;
+
+			float& velY = balls.m_velocityY[ballIndex];
+			if (velY < 0.f)
+			{
+				velY = 0.f - velY * (balls.m_elasticity[ballIndex] * wallElasticity);
+			}
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Benchmark: one "step" is gravity integration plus both wall passes with bottom warp on,
+// timed for the old AoS loops, the SoA loops, and the SoA SIMD kernels
+// -----------------------------------------------------------------------------
+static void StepAoSBalls(std::vector<Balls>& balls, float deltaSeconds, float wallElasticity, float warpHeight)
+{
+	Vec2 downwardAcceleration = Vec2(0.f, -1.f) * 100.f;
+
+	for (int ballIndex = 0; ballIndex < static_cast<int>(balls.size()); ++ballIndex)
+	{
+		balls[ballIndex].m_velocity += downwardAcceleration * deltaSeconds;
+		balls[ballIndex].m_discCenter += balls[ballIndex].m_velocity * deltaSeconds;
+	}
+
+	for (int ballIndex = 0; ballIndex < static_cast<int>(balls.size()); ++ballIndex)
+	{
+		Balls& ball = balls[ballIndex];
+		if (ball.m_discCenter.y < -ball.m_discRadius)
+		{
+			ball.m_discCenter.y = SCREEN_SIZE_Y + ball.m_discRadius + warpHeight;
+		}
+	}
+
+	for (int ballIndex = 0; ballIndex < static_cast<int>(balls.size()); ++ballIndex)
+	{
+		Balls& ball = balls[ballIndex];
+		if (ball.m_discCenter.x < ball.m_discRadius)
+		{
+			BounceDiscOffFixedPoint(ball.m_discCenter, ball.m_discRadius, ball.m_velocity, ball.m_ballElasticity, Vec2(0.f, ball.m_discCenter.y), wallElasticity);
+		}
+		else if (ball.m_discCenter.x > SCREEN_SIZE_X - ball.m_discRadius)
+		{
+			BounceDiscOffFixedPoint(ball.m_discCenter, ball.m_discRadius, ball.m_velocity, ball.m_ballElasticity, Vec2(SCREEN_SIZE_X, ball.m_discCenter.y), wallElasticity);
+		}
+	}
+}
+
+std::vector<BallKernelBenchmarkResult> RunBallKernelBenchmark(float wallElasticity, float warpHeight)
+{
+	constexpr int NUM_BALL_COUNTS = 3;
+	constexpr int BALL_COUNTS[NUM_BALL_COUNTS] = { 1000, 10000, 100000 };
+	constexpr int BALL_STEPS_PER_RUN = 2000000;
+	constexpr float DELTA_SECONDS = 1.f / 240.f;
+	constexpr float GRAVITY_Y = -100.f;
+	float warpY = SCREEN_SIZE_Y + warpHeight;
+
+	std::vector<BallKernelBenchmarkResult> results;
+
+	for (int countIndex = 0; countIndex < NUM_BALL_COUNTS; ++countIndex)
+	{
+		int numBalls = BALL_COUNTS[countIndex];
+		int numSteps = BALL_STEPS_PER_RUN / numBalls;
+
+		// Fill both layouts with the same spread of balls; no RNG so the game's random stream is untouched
+		std::vector<Balls> aosBalls(numBalls);
+		PachinkoBalls soaBalls;
+		soaBalls.Initialize(numBalls);
+		for (int ballIndex = 0; ballIndex < numBalls; ++ballIndex)
+		{
+			float fraction = static_cast<float>(ballIndex);
+			Balls& ball = aosBalls[ballIndex];
+			ball.m_discRadius = 5.f + fmodf(fraction * 0.37f, 20.f);
+			ball.m_discCenter = Vec2(ball.m_discRadius + fmodf(fraction * 7.31f, SCREEN_SIZE_X - 2.f * ball.m_discRadius), fmodf(fraction * 3.71f, SCREEN_SIZE_Y));
+			ball.m_velocity = Vec2(fmodf(fraction * 13.1f, 200.f) - 100.f, 0.f);
+			soaBalls.AddBall(ball.m_discCenter, ball.m_discRadius, ball.m_velocity, ball.m_ballElasticity, ball.m_ballColor);
+		}
+		PachinkoBalls soaSimdBalls = soaBalls;
+
+		double startTime = GetBenchmarkTimeSeconds();
+		for (int stepIndex = 0; stepIndex < numSteps; ++stepIndex)
+		{
+			StepAoSBalls(aosBalls, DELTA_SECONDS, wallElasticity, warpHeight);
+		}
+		double aosSeconds = GetBenchmarkTimeSeconds() - startTime;
+
+		startTime = GetBenchmarkTimeSeconds();
+		for (int stepIndex = 0; stepIndex < numSteps; ++stepIndex)
+		{
+			IntegrateBallsScalar(soaBalls, 0, numBalls, GRAVITY_Y, DELTA_SECONDS);
+			BounceBallsOffFloorOrWarpScalar(soaBalls, 0, numBalls, 0.f, warpY, wallElasticity, true);
+			BounceBallsOffSideWallsScalar(soaBalls, 0, numBalls, 0.f, SCREEN_SIZE_X, wallElasticity);
+		}
+		double soaScalarSeconds = GetBenchmarkTimeSeconds() - startTime;
+
+		startTime = GetBenchmarkTimeSeconds();
+		for (int stepIndex = 0; stepIndex < numSteps; ++stepIndex)
+		{
+			IntegrateBalls(soaSimdBalls, 0, numBalls, GRAVITY_Y, DELTA_SECONDS);
+			BounceBallsOffFloorOrWarp(soaSimdBalls, 0, numBalls, 0.f, warpY, wallElasticity, true);
+			BounceBallsOffSideWalls(soaSimdBalls, 0, numBalls, 0.f, SCREEN_SIZE_X, wallElasticity);
+		}
+		double soaSimdSeconds = GetBenchmarkTimeSeconds() - startTime;
+
+		double ballStepsRun = static_cast<double>(numSteps) * static_cast<double>(numBalls);
+		BallKernelBenchmarkResult result;
+		result.m_numBalls = numBalls;
+		result.m_aosScalarNsPerBall = aosSeconds * 1.0e9 / ballStepsRun;
+		result.m_soaScalarNsPerBall = soaScalarSeconds * 1.0e9 / ballStepsRun;
+		result.m_soaSimdNsPerBall = soaSimdSeconds * 1.0e9 / ballStepsRun;
+		results.push_back(result);
+	}
+
+	return results;
+}
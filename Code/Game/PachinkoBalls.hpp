@@ -0,0 +1,79 @@
+#pragma once
+#include "Engine/Math/Vec2.hpp"
+#include "Engine/Core/Rgba8.h"
+#include <vector>
+// -----------------------------------------------------------------------------
+// Fixed-capacity structure-of-arrays ball pool, so the physics kernels only stream
+// the fields they actually touch and can process SIMD_WIDTH balls at a time.
+// Live balls are packed into [0, m_numBalls) and the slots past the end are the
+// free list, so spawning and despawning are O(1) and never touch the heap.
+// Awake balls come first, in [0, m_numAwakeBalls), so the kernels can skip the
+// sleeping ones by running over that prefix only.
+// -----------------------------------------------------------------------------
+struct PachinkoBalls
+{
+public:
+	void Initialize(int capacity);
+	bool AddBall(Vec2 const& center, float radius, Vec2 const& velocity, float elasticity, Rgba8 const& color);
+	void RemoveBall(int ballIndex);
+	void Clear();
+	int  GetNumBalls() const { return m_numBalls; }
+	int  GetCapacity() const { return m_capacity; }
+	bool IsFull() const		 { return m_numBalls >= m_capacity; }
+
+	// Sleeping and waking swap the ball across the awake/sleeping boundary, so its index changes
+	int  GetNumAwakeBalls() const	 { return m_numAwakeBalls; }
+	int  GetNumSleepingBalls() const { return m_numBalls - m_numAwakeBalls; }
+	bool IsBallAwake(int ballIndex) const { return ballIndex < m_numAwakeBalls; }
+	void SwapBalls(int ballIndexA, int ballIndexB);
+	void PutBallToSleep(int ballIndex, int islandId);
+	void WakeBall(int ballIndex);
+	void WakeAllBalls();
+
+public:
+	int m_numBalls = 0;
+	int m_numAwakeBalls = 0;
+	int m_capacity = 0;
+
+	std::vector<float> m_positionX;
+	std::vector<float> m_positionY;
+	std::vector<float> m_previousPositionX;
+	std::vector<float> m_previousPositionY;
+	std::vector<float> m_velocityX;
+	std::vector<float> m_velocityY;
+	std::vector<float> m_radius;
+	std::vector<float> m_elasticity;
+	std::vector<Rgba8> m_color;
+
+	std::vector<int> m_numRestingSteps;
+	std::vector<int> m_islandId;
+
+	// Stays with a ball whatever index it moves to; every slot holds one of [0, capacity), so ids are reused
+	std::vector<int> m_ballId;
+};
+// -----------------------------------------------------------------------------
+struct BallKernelBenchmarkResult
+{
+	int	   m_numBalls = 0;
+	double m_aosScalarNsPerBall = 0.0;
+	double m_soaScalarNsPerBall = 0.0;
+	double m_soaSimdNsPerBall = 0.0;
+};
+// -----------------------------------------------------------------------------
+// Kernels operate on balls [firstBall, lastBall)
+void IntegrateBalls(PachinkoBalls& balls, int firstBall, int lastBall, float gravityY, float deltaSeconds);
+void BounceBallsOffSideWalls(PachinkoBalls& balls, int firstBall, int lastBall, float minX, float maxX, float wallElasticity);
+void BounceBallsOffFloorOrWarp(PachinkoBalls& balls, int firstBall, int lastBall, float floorY, float warpY, float wallElasticity, bool isBottomWarpOn);
+
+// Where each ball was before the last step, so rendering can interpolate between steps
+void SaveBallPreviousPositions(PachinkoBalls& balls, int firstBall, int lastBall);
+float GetMaxBallSpeedSquared(PachinkoBalls const& balls, int firstBall, int lastBall);
+
+// Counts up the steps each ball has moved slower than sleepSpeed; returns how many have reached numStepsToSleep
+int  UpdateBallRestingSteps(PachinkoBalls& balls, int firstBall, int lastBall, float sleepSpeed, int numStepsToSleep);
+
+void IntegrateBallsScalar(PachinkoBalls& balls, int firstBall, int lastBall, float gravityY, float deltaSeconds);
+void BounceBallsOffSideWallsScalar(PachinkoBalls& balls, int firstBall, int lastBall, float minX, float maxX, float wallElasticity);
+void BounceBallsOffFloorOrWarpScalar(PachinkoBalls& balls, int firstBall, int lastBall, float floorY, float warpY, float wallElasticity, bool isBottomWarpOn);
+
+std::vector<BallKernelBenchmarkResult> RunBallKernelBenchmark(float wallElasticity, float warpHeight);
@@ -0,0 +1,373 @@
+#include "Game/PachinkoContactSolver.hpp"
+#include "Game/PachinkoBalls.hpp"
+#include <math.h>
+
+void PachinkoContactList::Clear()
+{
+	m_ballContacts.clear();
+	m_fixedContacts.clear();
+}
+
+// -----------------------------------------------------------------------------
+void PachinkoContactSolver::Initialize(int capacity)
+{
+	m_startVelocityX.resize(capacity);
+	m_startVelocityY.resize(capacity);
+	m_pseudoVelocityX.resize(capacity);
+	m_pseudoVelocityY.resize(capacity);
+
+	m_cachedStepIndex.assign(capacity, -1);
+	m_numCachedContacts.assign(capacity, 0);
+	m_cachedOtherIds.assign(capacity * SOLVER_MAX_CACHED_CONTACTS, -1);
+	m_cachedImpulses.assign(capacity * SOLVER_MAX_CACHED_CONTACTS, 0.f);
+}
+
+void PachinkoContactSolver::SetNumIterations(int numIterations)
+{
+	m_numIterations = (numIterations > 1) ? numIterations : 1;
+}
+
+void PachinkoContactSolver::ForgetBall(int ballId)
+{
+	m_cachedStepIndex[ballId] = -1;
+}
+
+void PachinkoContactSolver::ForgetAllBalls()
+{
+	for (int ballId = 0; ballId < static_cast<int>(m_cachedStepIndex.size()); ++ballId)
+	{
+		ForgetBall(ballId);
+	}
+}
+
+void PachinkoContactSolver::SetWalls(float wallMinX, float wallMaxX, float floorY, bool isFloorOn, float wallElasticity)
+{
+	m_wallMinX = wallMinX;
+	m_wallMaxX = wallMaxX;
+	m_floorY = floorY;
+	m_isFloorOn = isFloorOn;
+	m_wallElasticity = wallElasticity;
+}
+
+void PachinkoContactSolver::BeginStep(PachinkoBalls const& balls, float deltaSeconds)
+{
+	// Impulses scale with the step, so last step's are rescaled when an adaptive step changes length
+	m_warmStartScale = (m_deltaSeconds > 0.f) ? deltaSeconds / m_deltaSeconds : 1.f;
+	m_deltaSeconds = deltaSeconds;
+	++m_stepIndex;
+
+	for (int ballIndex = 0; ballIndex < balls.GetNumAwakeBalls(); ++ballIndex)
+	{
+		m_startVelocityX[ballIndex] = balls.m_velocityX[ballIndex];
+		m_startVelocityY[ballIndex] = balls.m_velocityY[ballIndex];
+		m_pseudoVelocityX[ballIndex] = 0.f;
+		m_pseudoVelocityY[ballIndex] = 0.f;
+	}
+}
+
+bool PachinkoContactSolver::AddContact(PachinkoContactList& contacts, PachinkoBalls const& balls, int ballIndexA, int ballIndexB, bool isBallBAsleep) const
+{
+	float deltaX = balls.m_positionX[ballIndexB] - balls.m_positionX[ballIndexA];
+	float deltaY = balls.m_positionY[ballIndexB] - balls.m_positionY[ballIndexA];
+	float radiusSum = balls.m_radius[ballIndexA] + balls.m_radius[ballIndexB];
+	float distanceSquared = deltaX * deltaX + deltaY * deltaY;
+	if (distanceSquared >= radiusSum * radiusSum)
+	{
+		return false;
+	}
+
+	PachinkoBallContact contact;
+	contact.m_ballIndexA = ballIndexA;
+	contact.m_ballIndexB = ballIndexB;
+	contact.m_inverseMassB = isBallBAsleep ? 0.f : 1.f;
+	contact.m_normalMass = 1.f / (1.f + contact.m_inverseMassB);
+
+	// Balls on the same spot are pushed apart straight up, the same way every time
+	float distance = sqrtf(distanceSquared);
+	contact.m_normal = (distance > 0.f) ? Vec2(deltaX / distance, deltaY / distance) : Vec2(0.f, 1.f);
+	contact.m_penetration = radiusSum - distance;
+
+	// Either ball may have stored the pair last step, depending on which one was ball A then
+	int ballIdA = balls.m_ballId[ballIndexA];
+	int ballIdB = balls.m_ballId[ballIndexB];
+	float cachedImpulse = GetCachedImpulse(ballIdA, ballIdB);
+	if (cachedImpulse == 0.f)
+	{
+		cachedImpulse = GetCachedImpulse(ballIdB, ballIdA);
+	}
+	contact.m_normalImpulse = cachedImpulse * m_warmStartScale;
+
+	float relativeVelocityX = balls.m_velocityX[ballIndexB] - balls.m_velocityX[ballIndexA];
+	float relativeVelocityY = balls.m_velocityY[ballIndexB] - balls.m_velocityY[ballIndexA];
+	float normalSpeed = relativeVelocityX * contact.m_normal.x + relativeVelocityY * contact.m_normal.y;
+
+	// A pair that was already pushing last step is resting, not hitting, so it doesn't bounce
+	if (cachedImpulse == 0.f && normalSpeed < -SOLVER_MIN_BOUNCE_SPEED)
+	{
+		contact.m_bounceSpeed = -normalSpeed * balls.m_elasticity[ballIndexA] * balls.m_elasticity[ballIndexB];
+	}
+
+	contacts.m_ballContacts.push_back(contact);
+	return true;
+}
+
+void PachinkoContactSolver::AddWallContacts(PachinkoContactList& contacts, PachinkoBalls const& balls, int ballIndex) const
+{
+	float radius = balls.m_radius[ballIndex];
+	float positionX = balls.m_positionX[ballIndex];
+	float positionY = balls.m_positionY[ballIndex];
+
+	if (m_isFloorOn && positionY - radius < m_floorY)
+	{
+		AddFixedContact(contacts, balls, ballIndex, 0, Vec2(0.f, 1.f), m_floorY - (positionY - radius), m_wallElasticity);
+	}
+	if (positionX - radius < m_wallMinX)
+	{
+		AddFixedContact(contacts, balls, ballIndex, 1, Vec2(1.f, 0.f), m_wallMinX - (positionX - radius), m_wallElasticity);
+	}
+	if (positionX + radius > m_wallMaxX)
+	{
+		AddFixedContact(contacts, balls, ballIndex, 2, Vec2(-1.f, 0.f), positionX + radius - m_wallMaxX, m_wallElasticity);
+	}
+}
+
+void PachinkoContactSolver::AddBumperContact(PachinkoContactList& contacts, PachinkoBalls const& balls, int ballIndex, int bumperIndex, Vec2 const& normal, float penetration, float bumperElasticity) const
+{
+	AddFixedContact(contacts, balls, ballIndex, SOLVER_NUM_WALLS + bumperIndex, normal, penetration, bumperElasticity);
+}
+
+void PachinkoContactSolver::AddFixedContact(PachinkoContactList& contacts, PachinkoBalls const& balls, int ballIndex, int fixedIndex, Vec2 const& normal, float penetration, float fixedElasticity) const
+{
+	PachinkoFixedContact contact;
+	contact.m_ballIndex = ballIndex;
+	contact.m_fixedIndex = fixedIndex;
+	contact.m_normal = normal;
+	contact.m_penetration = penetration;
+
+	// Bounces scale by both elasticities, as the wall kernels and bumper bounces do
+	float cachedImpulse = GetCachedImpulse(balls.m_ballId[ballIndex], -1 - fixedIndex);
+	contact.m_normalImpulse = cachedImpulse * m_warmStartScale;
+
+	float normalSpeed = balls.m_velocityX[ballIndex] * normal.x + balls.m_velocityY[ballIndex] * normal.y;
+	if (cachedImpulse == 0.f && normalSpeed < -SOLVER_MIN_BOUNCE_SPEED)
+	{
+		contact.m_bounceSpeed = -normalSpeed * balls.m_elasticity[ballIndex] * fixedElasticity;
+	}
+
+	contacts.m_fixedContacts.push_back(contact);
+}
+
+float PachinkoContactSolver::GetCachedImpulse(int ballId, int otherId) const
+{
+	if (m_cachedStepIndex[ballId] != m_stepIndex - 1)
+	{
+		return 0.f;
+	}
+
+	int firstEntry = ballId * SOLVER_MAX_CACHED_CONTACTS;
+	for (int entryIndex = firstEntry; entryIndex < firstEntry + m_numCachedContacts[ballId]; ++entryIndex)
+	{
+		if (m_cachedOtherIds[entryIndex] == otherId)
+		{
+			return m_cachedImpulses[entryIndex];
+		}
+	}
+	return 0.f;
+}
+
+void PachinkoContactSolver::WarmStart(PachinkoContactList& contacts, PachinkoBalls& balls) const
+{
+	for (int contactIndex = 0; contactIndex < static_cast<int>(contacts.m_fixedContacts.size()); ++contactIndex)
+	{
+		PachinkoFixedContact const& contact = contacts.m_fixedContacts[contactIndex];
+		balls.m_velocityX[contact.m_ballIndex] += contact.m_normal.x * contact.m_normalImpulse;
+		balls.m_velocityY[contact.m_ballIndex] += contact.m_normal.y * contact.m_normalImpulse;
+	}
+
+	for (int contactIndex = 0; contactIndex < static_cast<int>(contacts.m_ballContacts.size()); ++contactIndex)
+	{
+		PachinkoBallContact const& contact = contacts.m_ballContacts[contactIndex];
+		float impulseX = contact.m_normal.x * contact.m_normalImpulse;
+		float impulseY = contact.m_normal.y * contact.m_normalImpulse;
+		balls.m_velocityX[contact.m_ballIndexA] -= impulseX;
+		balls.m_velocityY[contact.m_ballIndexA] -= impulseY;
+		if (contact.IsBallBAwake())
+		{
+			balls.m_velocityX[contact.m_ballIndexB] += impulseX;
+			balls.m_velocityY[contact.m_ballIndexB] += impulseY;
+		}
+	}
+}
+
+void PachinkoContactSolver::SolveVelocities(PachinkoContactList& contacts, PachinkoBalls& balls) const
+{
+	for (int contactIndex = 0; contactIndex < static_cast<int>(contacts.m_fixedContacts.size()); ++contactIndex)
+	{
+		SolveFixedContactVelocity(contacts.m_fixedContacts[contactIndex], balls, 0.f);
+	}
+	for (int contactIndex = 0; contactIndex < static_cast<int>(contacts.m_ballContacts.size()); ++contactIndex)
+	{
+		SolveBallContactVelocity(contacts.m_ballContacts[contactIndex], balls, 0.f);
+	}
+}
+
+void PachinkoContactSolver::ApplyBounces(PachinkoContactList& contacts, PachinkoBalls& balls) const
+{
+	// Only contacts that ended up pushing bounce; the rest were already moving apart
+	for (int contactIndex = 0; contactIndex < static_cast<int>(contacts.m_fixedContacts.size()); ++contactIndex)
+	{
+		PachinkoFixedContact& contact = contacts.m_fixedContacts[contactIndex];
+		if (contact.m_bounceSpeed > 0.f && contact.m_normalImpulse > 0.f)
+		{
+			SolveFixedContactVelocity(contact, balls, contact.m_bounceSpeed);
+		}
+	}
+	for (int contactIndex = 0; contactIndex < static_cast<int>(contacts.m_ballContacts.size()); ++contactIndex)
+	{
+		PachinkoBallContact& contact = contacts.m_ballContacts[contactIndex];
+		if (contact.m_bounceSpeed > 0.f && contact.m_normalImpulse > 0.f)
+		{
+			SolveBallContactVelocity(contact, balls, contact.m_bounceSpeed);
+		}
+	}
+}
+
+// Contacts can only push, so each contact's total impulse is clamped rather than each increment
+void PachinkoContactSolver::SolveFixedContactVelocity(PachinkoFixedContact& contact, PachinkoBalls& balls, float targetSpeed) const
+{
+	int ballIndex = contact.m_ballIndex;
+
+	float normalSpeed = balls.m_velocityX[ballIndex] * contact.m_normal.x + balls.m_velocityY[ballIndex] * contact.m_normal.y;
+	float impulse = targetSpeed - normalSpeed;
+	float totalImpulse = fmaxf(contact.m_normalImpulse + impulse, 0.f);
+	impulse = totalImpulse - contact.m_normalImpulse;
+	contact.m_normalImpulse = totalImpulse;
+
+	balls.m_velocityX[ballIndex] += contact.m_normal.x * impulse;
+	balls.m_velocityY[ballIndex] += contact.m_normal.y * impulse;
+}
+
+void PachinkoContactSolver::SolveBallContactVelocity(PachinkoBallContact& contact, PachinkoBalls& balls, float targetSpeed) const
+{
+	int ballIndexA = contact.m_ballIndexA;
+	int ballIndexB = contact.m_ballIndexB;
+
+	// A sleeping ball B is fixed: it reads as still, and only ball A is written
+	bool isBallBAwake = contact.IsBallBAwake();
+	float velocityBX = isBallBAwake ? balls.m_velocityX[ballIndexB] : 0.f;
+	float velocityBY = isBallBAwake ? balls.m_velocityY[ballIndexB] : 0.f;
+	float relativeVelocityX = velocityBX - balls.m_velocityX[ballIndexA];
+	float relativeVelocityY = velocityBY - balls.m_velocityY[ballIndexA];
+	float normalSpeed = relativeVelocityX * contact.m_normal.x + relativeVelocityY * contact.m_normal.y;
+
+	float impulse = contact.m_normalMass * (targetSpeed - normalSpeed);
+	float totalImpulse = fmaxf(contact.m_normalImpulse + impulse, 0.f);
+	impulse = totalImpulse - contact.m_normalImpulse;
+	contact.m_normalImpulse = totalImpulse;
+
+	float impulseX = contact.m_normal.x * impulse;
+	float impulseY = contact.m_normal.y * impulse;
+	balls.m_velocityX[ballIndexA] -= impulseX;
+	balls.m_velocityY[ballIndexA] -= impulseY;
+	if (isBallBAwake)
+	{
+		balls.m_velocityX[ballIndexB] += impulseX;
+		balls.m_velocityY[ballIndexB] += impulseY;
+	}
+}
+
+void PachinkoContactSolver::SolvePositions(PachinkoContactList& contacts)
+{
+	float correctionPerSecond = SOLVER_POSITION_CORRECTION / m_deltaSeconds;
+
+	for (int contactIndex = 0; contactIndex < static_cast<int>(contacts.m_fixedContacts.size()); ++contactIndex)
+	{
+		PachinkoFixedContact& contact = contacts.m_fixedContacts[contactIndex];
+		int ballIndex = contact.m_ballIndex;
+
+		float normalSpeed = m_pseudoVelocityX[ballIndex] * contact.m_normal.x + m_pseudoVelocityY[ballIndex] * contact.m_normal.y;
+		float targetSpeed = correctionPerSecond * fmaxf(contact.m_penetration - SOLVER_PENETRATION_SLOP, 0.f);
+		float impulse = targetSpeed - normalSpeed;
+		float totalImpulse = fmaxf(contact.m_positionImpulse + impulse, 0.f);
+		impulse = totalImpulse - contact.m_positionImpulse;
+		contact.m_positionImpulse = totalImpulse;
+
+		m_pseudoVelocityX[ballIndex] += contact.m_normal.x * impulse;
+		m_pseudoVelocityY[ballIndex] += contact.m_normal.y * impulse;
+	}
+
+	for (int contactIndex = 0; contactIndex < static_cast<int>(contacts.m_ballContacts.size()); ++contactIndex)
+	{
+		PachinkoBallContact& contact = contacts.m_ballContacts[contactIndex];
+		int ballIndexA = contact.m_ballIndexA;
+		int ballIndexB = contact.m_ballIndexB;
+
+		// Pseudo-velocities are only reset for awake balls, so a sleeping ball B's slot is stale
+		bool isBallBAwake = contact.IsBallBAwake();
+		float pseudoVelocityBX = isBallBAwake ? m_pseudoVelocityX[ballIndexB] : 0.f;
+		float pseudoVelocityBY = isBallBAwake ? m_pseudoVelocityY[ballIndexB] : 0.f;
+		float relativeVelocityX = pseudoVelocityBX - m_pseudoVelocityX[ballIndexA];
+		float relativeVelocityY = pseudoVelocityBY - m_pseudoVelocityY[ballIndexA];
+		float normalSpeed = relativeVelocityX * contact.m_normal.x + relativeVelocityY * contact.m_normal.y;
+		float targetSpeed = correctionPerSecond * fmaxf(contact.m_penetration - SOLVER_PENETRATION_SLOP, 0.f);
+
+		float impulse = contact.m_normalMass * (targetSpeed - normalSpeed);
+		float totalImpulse = fmaxf(contact.m_positionImpulse + impulse, 0.f);
+		impulse = totalImpulse - contact.m_positionImpulse;
+		contact.m_positionImpulse = totalImpulse;
+
+		float impulseX = contact.m_normal.x * impulse;
+		float impulseY = contact.m_normal.y * impulse;
+		m_pseudoVelocityX[ballIndexA] -= impulseX;
+		m_pseudoVelocityY[ballIndexA] -= impulseY;
+		if (isBallBAwake)
+		{
+			m_pseudoVelocityX[ballIndexB] += impulseX;
+			m_pseudoVelocityY[ballIndexB] += impulseY;
+		}
+	}
+}
+
+void PachinkoContactSolver::StoreImpulses(PachinkoContactList const& contacts, PachinkoBalls const& balls)
+{
+	for (int contactIndex = 0; contactIndex < static_cast<int>(contacts.m_fixedContacts.size()); ++contactIndex)
+	{
+		PachinkoFixedContact const& contact = contacts.m_fixedContacts[contactIndex];
+		StoreImpulse(balls.m_ballId[contact.m_ballIndex], -1 - contact.m_fixedIndex, contact.m_normalImpulse);
+	}
+
+	for (int contactIndex = 0; contactIndex < static_cast<int>(contacts.m_ballContacts.size()); ++contactIndex)
+	{
+		PachinkoBallContact const& contact = contacts.m_ballContacts[contactIndex];
+		StoreImpulse(balls.m_ballId[contact.m_ballIndexA], balls.m_ballId[contact.m_ballIndexB], contact.m_normalImpulse);
+	}
+}
+
+void PachinkoContactSolver::StoreImpulse(int ballId, int otherId, float normalImpulse)
+{
+	if (m_cachedStepIndex[ballId] != m_stepIndex)
+	{
+		m_cachedStepIndex[ballId] = m_stepIndex;
+		m_numCachedContacts[ballId] = 0;
+	}
+
+	int& numCachedContacts = m_numCachedContacts[ballId];
+	if (numCachedContacts < SOLVER_MAX_CACHED_CONTACTS)
+	{
+		int entryIndex = ballId * SOLVER_MAX_CACHED_CONTACTS + numCachedContacts;
+		m_cachedOtherIds[entryIndex] = otherId;
+		m_cachedImpulses[entryIndex] = normalImpulse;
+		++numCachedContacts;
+	}
+}
+
+void PachinkoContactSolver::ApplyPositionCorrections(PachinkoBalls& balls, int firstBall, int lastBall) const
+{
+	for (int ballIndex = firstBall; ballIndex < lastBall; ++ballIndex)
+	{
+		float deltaVelocityX = balls.m_velocityX[ballIndex] - m_startVelocityX[ballIndex];
+		float deltaVelocityY = balls.m_velocityY[ballIndex] - m_startVelocityY[ballIndex];
+		balls.m_positionX[ballIndex] += (deltaVelocityX + m_pseudoVelocityX[ballIndex]) * m_deltaSeconds;
+		balls.m_positionY[ballIndex] += (deltaVelocityY + m_pseudoVelocityY[ballIndex]) * m_deltaSeconds;
+	}
+}
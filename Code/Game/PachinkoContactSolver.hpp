@@ -0,0 +1,142 @@
+#pragma once
+#include "Engine/Math/Vec2.hpp"
+#include <vector>
+// -----------------------------------------------------------------------------
+struct PachinkoBalls;
+// -----------------------------------------------------------------------------
+// Each ball remembers the impulses of at most this many of its contacts for warm starting,
+// fixed contacts first
+const int SOLVER_MAX_CACHED_CONTACTS = 12;
+
+// Floor, then west and east walls; bumpers are numbered after them
+const int SOLVER_NUM_WALLS = 3;
+
+// Overlap left alone so resting contacts persist from step to step, and the fraction of the
+// rest pushed out per step. Tuned on PachinkoBenchmark piles at 4-8x the legacy step: a firmer
+// correction pushes deep piles apart faster than the velocity solve can settle them.
+const float SOLVER_PENETRATION_SLOP = 1.f;
+const float SOLVER_POSITION_CORRECTION = 0.2f;
+
+// Contacts closing slower than this don't bounce, so resting piles don't keep hopping
+const float SOLVER_MIN_BOUNCE_SPEED = 10.f;
+// -----------------------------------------------------------------------------
+// A touching ball pair, with ball B counted as fixed when it is asleep. A sleeping ball B can
+// touch balls in several lists solved at once, so the solver never reads or writes its velocities.
+struct PachinkoBallContact
+{
+	bool IsBallBAwake() const { return m_inverseMassB > 0.f; }
+
+	int	  m_ballIndexA = 0;
+	int	  m_ballIndexB = 0;
+	Vec2  m_normal = Vec2::ZERO;
+	float m_penetration = 0.f;
+	float m_inverseMassB = 1.f;
+	float m_normalMass = 0.f;
+	float m_bounceSpeed = 0.f;
+	float m_normalImpulse = 0.f;
+	float m_positionImpulse = 0.f;
+};
+
+// A ball touching the floor, a side wall or a bumper, with the normal pointing into the ball
+struct PachinkoFixedContact
+{
+	int	  m_ballIndex = 0;
+	int	  m_fixedIndex = 0;
+	Vec2  m_normal = Vec2::ZERO;
+	float m_penetration = 0.f;
+	float m_bounceSpeed = 0.f;
+	float m_normalImpulse = 0.f;
+	float m_positionImpulse = 0.f;
+};
+
+// Contacts solved together; the balls in one list are never in another list of the same parity
+struct PachinkoContactList
+{
+	void Clear();
+	int  GetNumContacts() const { return static_cast<int>(m_ballContacts.size() + m_fixedContacts.size()); }
+
+	std::vector<PachinkoBallContact>  m_ballContacts;
+	std::vector<PachinkoFixedContact> m_fixedContacts;
+};
+// -----------------------------------------------------------------------------
+// Sequential-impulse solver for ball contacts. Every ball has the same mass.
+// Velocities are solved with accumulated, clamped impulses, seeded with the impulse the
+// same pair ended the last step with. Overlap is pushed out by separate pseudo-velocities
+// that move positions only, so correcting it never adds bounce.
+//
+// Bounces are applied in one pass after the velocity iterations, and only by contacts that
+// are new this step. Iterating them with the rest lets a packed pile bounce itself apart.
+//
+// The floor, side walls and bumpers are solved as contacts too, so a pile's weight rests on
+// them instead of being bounced back up every step.
+//
+// Contacts are found at the integrated positions, then each ball is moved by its velocity
+// change times the step, which puts it where it would be had the solve run before the move.
+// Contact lists are solved one at a time; lists that share no awake balls can be solved at once.
+// -----------------------------------------------------------------------------
+class PachinkoContactSolver
+{
+public:
+	void Initialize(int capacity);
+
+	void SetNumIterations(int numIterations);
+	int  GetNumIterations() const				{ return m_numIterations; }
+
+	// Drops any cached impulses for a ball id that is about to be reused, or for every ball
+	void ForgetBall(int ballId);
+	void ForgetAllBalls();
+
+	// The floor is left out while balls warp from the bottom to the top
+	void SetWalls(float wallMinX, float wallMaxX, float floorY, bool isFloorOn, float wallElasticity);
+
+	// Saves awake ball velocities so the position correction knows how much the solve changed them
+	void BeginStep(PachinkoBalls const& balls, float deltaSeconds);
+
+	// Append contacts that touch; safe to call from several threads into different lists
+	bool AddContact(PachinkoContactList& contacts, PachinkoBalls const& balls, int ballIndexA, int ballIndexB, bool isBallBAsleep) const;
+	void AddWallContacts(PachinkoContactList& contacts, PachinkoBalls const& balls, int ballIndex) const;
+	void AddBumperContact(PachinkoContactList& contacts, PachinkoBalls const& balls, int ballIndex, int bumperIndex, Vec2 const& normal, float penetration, float bumperElasticity) const;
+
+	void WarmStart(PachinkoContactList& contacts, PachinkoBalls& balls) const;
+	void SolveVelocities(PachinkoContactList& contacts, PachinkoBalls& balls) const;
+	void ApplyBounces(PachinkoContactList& contacts, PachinkoBalls& balls) const;
+	void SolvePositions(PachinkoContactList& contacts);
+
+	// Impulses are stored under ball A's id, or the ball's own for fixed contacts, so lists with
+	// different A balls can store at once
+	void StoreImpulses(PachinkoContactList const& contacts, PachinkoBalls const& balls);
+
+	// Moves awake balls [firstBall, lastBall) by their velocity change and pseudo-velocity
+	void ApplyPositionCorrections(PachinkoBalls& balls, int firstBall, int lastBall) const;
+
+private:
+	float GetCachedImpulse(int ballId, int otherId) const;
+	void  StoreImpulse(int ballId, int otherId, float normalImpulse);
+	void  SolveFixedContactVelocity(PachinkoFixedContact& contact, PachinkoBalls& balls, float targetSpeed) const;
+	void  SolveBallContactVelocity(PachinkoBallContact& contact, PachinkoBalls& balls, float targetSpeed) const;
+	void  AddFixedContact(PachinkoContactList& contacts, PachinkoBalls const& balls, int ballIndex, int fixedIndex, Vec2 const& normal, float penetration, float fixedElasticity) const;
+
+private:
+	int	  m_numIterations = 8;
+	int	  m_stepIndex = 0;
+	float m_deltaSeconds = 0.f;
+	float m_warmStartScale = 1.f;
+	float m_wallMinX = 0.f;
+	float m_wallMaxX = 0.f;
+	float m_floorY = 0.f;
+	bool  m_isFloorOn = true;
+	float m_wallElasticity = 1.f;
+
+	// Indexed by ball index, valid for the current step only
+	std::vector<float> m_startVelocityX;
+	std::vector<float> m_startVelocityY;
+	std::vector<float> m_pseudoVelocityX;
+	std::vector<float> m_pseudoVelocityY;
+
+	// Indexed by ball id; a ball's entries only count if they were stored in the previous step.
+	// Fixed contacts are cached under the id -1 - fixedIndex, which no ball has.
+	std::vector<int>   m_cachedStepIndex;
+	std::vector<int>   m_numCachedContacts;
+	std::vector<int>   m_cachedOtherIds;
+	std::vector<float> m_cachedImpulses;
+};
@@ -0,0 +1,86 @@
+#include "Game/PachinkoProfiler.hpp"
+#include "Engine/Core/Time.hpp"
+#include <algorithm>
+
+PachinkoProfiler::PachinkoProfiler(int numRows, int numFrames)
+	:m_numRows(numRows)
+	,m_numFrames(numFrames > 0 ? numFrames : 1)
+{
+	m_frameSeconds.assign(m_numFrames * m_numRows, 0.0);
+	m_rowStats.resize(m_numRows);
+	m_sortedSeconds.reserve(m_numFrames);
+}
+
+void PachinkoProfiler::BeginFrame()
+{
+	double* frameSeconds = &m_frameSeconds[m_currentFrameIndex * m_numRows];
+	for (int rowIndex = 0; rowIndex < m_numRows; ++rowIndex)
+	{
+		frameSeconds[rowIndex] = 0.0;
+	}
+}
+
+void PachinkoProfiler::AddSample(int rowIndex, double seconds)
+{
+	m_frameSeconds[m_currentFrameIndex * m_numRows + rowIndex] += seconds;
+}
+
+void PachinkoProfiler::EndFrame()
+{
+	if (m_numFramesRecorded < m_numFrames)
+	{
+		++m_numFramesRecorded;
+	}
+	m_currentFrameIndex = (m_currentFrameIndex + 1) % m_numFrames;
+
+	for (int rowIndex = 0; rowIndex < m_numRows; ++rowIndex)
+	{
+		UpdateRowStats(rowIndex);
+	}
+}
+
+void PachinkoProfiler::UpdateRowStats(int rowIndex)
+{
+	// Until the ring fills, the recorded frames are the first numFramesRecorded slots
+	m_sortedSeconds.clear();
+	for (int frameIndex = 0; frameIndex < m_numFramesRecorded; ++frameIndex)
+	{
+		m_sortedSeconds.push_back(m_frameSeconds[frameIndex * m_numRows + rowIndex]);
+	}
+	std::sort(m_sortedSeconds.begin(), m_sortedSeconds.end());
+
+	double totalSeconds = 0.0;
+	for (int sampleIndex = 0; sampleIndex < static_cast<int>(m_sortedSeconds.size()); ++sampleIndex)
+	{
+		totalSeconds += m_sortedSeconds[sampleIndex];
+	}
+
+	// Nearest-rank p99, which is the max until there are over a hundred frames
+	int numSamples = static_cast<int>(m_sortedSeconds.size());
+	int p99Index = (numSamples * 99 + 99) / 100 - 1;
+
+	PachinkoProfileStats& stats = m_rowStats[rowIndex];
+	stats.m_minSeconds = m_sortedSeconds.front();
+	stats.m_maxSeconds = m_sortedSeconds.back();
+	stats.m_avgSeconds = totalSeconds / static_cast<double>(numSamples);
+	stats.m_p99Seconds = m_sortedSeconds[p99Index];
+}
+
+// -----------------------------------------------------------------------------
+PachinkoProfileScope::PachinkoProfileScope(PachinkoProfiler* profiler, int rowIndex)
+	:m_profiler(profiler)
+	,m_rowIndex(rowIndex)
+{
+	if (m_profiler != nullptr)
+	{
+		m_startSeconds = GetCurrentTimeSeconds();
+	}
+}
+
+PachinkoProfileScope::~PachinkoProfileScope()
+{
+	if (m_profiler != nullptr)
+	{
+		m_profiler->AddSample(m_rowIndex, GetCurrentTimeSeconds() - m_startSeconds);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+// -----------------------------------------------------------------------------
+struct PachinkoProfileStats
+{
+	double m_minSeconds = 0.0;
+	double m_avgSeconds = 0.0;
+	double m_maxSeconds = 0.0;
+	double m_p99Seconds = 0.0;
+};
+// -----------------------------------------------------------------------------
+// Keeps the time each row took over the last numFrames frames in a ring and
+// refreshes min/avg/max/p99 per row at the end of every frame. Samples added to
+// the same row within one frame are summed, so a row can cover several substeps.
+// -----------------------------------------------------------------------------
+class PachinkoProfiler
+{
+public:
+	PachinkoProfiler(int numRows, int numFrames);
+
+	void BeginFrame();
+	void AddSample(int rowIndex, double seconds);
+	void EndFrame();
+
+	int  GetNumRows() const			{ return m_numRows; }
+	int  GetNumFrames() const		{ return m_numFrames; }
+	int  GetNumFramesRecorded() const { return m_numFramesRecorded; }
+	PachinkoProfileStats const& GetRowStats(int rowIndex) const { return m_rowStats[rowIndex]; }
+
+private:
+	void UpdateRowStats(int rowIndex);
+
+private:
+	int m_numRows = 0;
+	int m_numFrames = 0;
+	int m_numFramesRecorded = 0;
+	int m_currentFrameIndex = 0;
+
+	// Frame-major ring of samples, numFrames * numRows
+	std::vector<double> m_frameSeconds;
+	std::vector<PachinkoProfileStats> m_rowStats;
+
+	// Reused for the p99 so EndFrame never allocates
+	std::vector<double> m_sortedSeconds;
+};
+// -----------------------------------------------------------------------------
+// Times its own lifetime into a profiler row. A null profiler reads no clock at all.
+// -----------------------------------------------------------------------------
+class PachinkoProfileScope
+{
+public:
+	PachinkoProfileScope(PachinkoProfiler* profiler, int rowIndex);
+	~PachinkoProfileScope();
+
+private:
+	PachinkoProfiler* m_profiler = nullptr;
+	int    m_rowIndex = 0;
+	double m_startSeconds = 0.0;
+};
@@ -0,0 +1,487 @@
+#include "Game/PachinkoRecording.hpp"
+#include "Game/PachinkoSimulation.hpp"
+#include "Game/GameCommon.h"
+#include <stdlib.h>
+
+// Session flags, one bit per PachinkoToggle
+static unsigned char GetToggleFlags(PachinkoSimulation const& simulation)
+{
+	unsigned char toggleFlags = 0;
+	toggleFlags |= simulation.IsBottomWarpOn() ? (1 << PACHINKO_TOGGLE_BOTTOM_WARP) : 0;
+	toggleFlags |= simulation.IsBallGridOn() ? (1 << PACHINKO_TOGGLE_BALL_GRID) : 0;
+	toggleFlags |= simulation.IsSleepingOn() ? (1 << PACHINKO_TOGGLE_SLEEPING) : 0;
+	toggleFlags |= simulation.IsContinuousCollisionOn() ? (1 << PACHINKO_TOGGLE_CONTINUOUS_COLLISION) : 0;
+	toggleFlags |= simulation.IsContactSolverOn() ? (1 << PACHINKO_TOGGLE_CONTACT_SOLVER) : 0;
+	return toggleFlags;
+}
+
+static bool IsToggleOn(PachinkoSimulation const& simulation, PachinkoToggle toggle)
+{
+	return (GetToggleFlags(simulation) & (1 << toggle)) != 0;
+}
+
+static void ApplyToggle(PachinkoSimulation& simulation, PachinkoToggle toggle)
+{
+	switch (toggle)
+	{
+	case PACHINKO_TOGGLE_BOTTOM_WARP:			 simulation.ToggleBottomWarp();			 break;
+	case PACHINKO_TOGGLE_BALL_GRID:				 simulation.ToggleBallGrid();			 break;
+	case PACHINKO_TOGGLE_SLEEPING:				 simulation.ToggleSleeping();			 break;
+	case PACHINKO_TOGGLE_CONTINUOUS_COLLISION:	 simulation.ToggleContinuousCollision(); break;
+	case PACHINKO_TOGGLE_CONTACT_SOLVER:		 simulation.ToggleContactSolver();		 break;
+	default:																			 break;
+	}
+}
+
+// -----------------------------------------------------------------------------
+PachinkoRecorder::PachinkoRecorder(int checksumInterval)
+	:m_checksumInterval(checksumInterval)
+{
+	if (m_checksumInterval < 1)
+	{
+		m_checksumInterval = 1;
+	}
+}
+
+PachinkoRecorder::~PachinkoRecorder()
+{
+	Close();
+}
+
+bool PachinkoRecorder::Open(char const* filePath)
+{
+	Close();
+	m_file = fopen(filePath, "ab");
+	return m_file != nullptr;
+}
+
+void PachinkoRecorder::Close()
+{
+	if (m_file != nullptr)
+	{
+		fclose(m_file);
+		m_file = nullptr;
+	}
+}
+
+void PachinkoRecorder::BeginSession(unsigned int seed, PachinkoSimulation const& simulation)
+{
+	m_numSessionSteps = 0;
+
+	WriteRecordType(PACHINKO_RECORD_SESSION);
+	Write(PACHINKO_RECORDING_MAGIC);
+	Write(PACHINKO_RECORDING_VERSION);
+	Write(seed);
+	Write(GetToggleFlags(simulation));
+	Write(simulation.GetSolverIterations());
+
+	PachinkoStepConfig stepConfig = simulation.GetStepConfig();
+	Write(stepConfig.m_maxNumBalls);
+	Write(stepConfig.m_maxBallRadius);
+	Write(stepConfig.m_wallElasticity);
+	Write(stepConfig.m_extraWarpHeight);
+	Write(stepConfig.m_sleepSpeed);
+	Write(stepConfig.m_numStepsToSleep);
+}
+
+void PachinkoRecorder::RecordBumpers(PachinkoBumpers const& bumpers)
+{
+	// Each type's count, then its bumpers; bounds are rebuilt from the shapes on replay
+	WriteRecordType(PACHINKO_RECORD_BUMPERS);
+
+	Write(static_cast<int>(bumpers.m_discs.size()));
+	for (int discIndex = 0; discIndex < static_cast<int>(bumpers.m_discs.size()); ++discIndex)
+	{
+		DiscBumper const& disc = bumpers.m_discs[discIndex];
+		Write(disc.m_center);
+		Write(disc.m_radius);
+		Write(disc.m_elasticity);
+		Write(disc.m_color);
+	}
+
+	Write(static_cast<int>(bumpers.m_capsules.size()));
+	for (int capsuleIndex = 0; capsuleIndex < static_cast<int>(bumpers.m_capsules.size()); ++capsuleIndex)
+	{
+		CapsuleBumper const& capsule = bumpers.m_capsules[capsuleIndex];
+		Write(capsule.m_boneStart);
+		Write(capsule.m_boneEnd);
+		Write(capsule.m_radius);
+		Write(capsule.m_elasticity);
+		Write(capsule.m_color);
+	}
+
+	Write(static_cast<int>(bumpers.m_boxes.size()));
+	for (int boxIndex = 0; boxIndex < static_cast<int>(bumpers.m_boxes.size()); ++boxIndex)
+	{
+		OBB2Bumper const& box = bumpers.m_boxes[boxIndex];
+		Write(box.m_box.m_center);
+		Write(box.m_box.m_iBasisNormal);
+		Write(box.m_box.m_halfDimensions);
+		Write(box.m_elasticity);
+		Write(box.m_color);
+	}
+}
+
+void PachinkoRecorder::RecordStep(float deltaSeconds, PachinkoSimulation const& simulation)
+{
+	WriteRecordType(PACHINKO_RECORD_STEP);
+	Write(deltaSeconds);
+	++m_numSessionSteps;
+
+	if (m_numSessionSteps % m_checksumInterval == 0)
+	{
+		WriteRecordType(PACHINKO_RECORD_CHECKSUM);
+		Write(m_numSessionSteps);
+		Write(simulation.GetBallStateChecksum());
+		fflush(m_file);
+	}
+}
+
+void PachinkoRecorder::RecordSpawn(Vec2 const& center, float radius, Vec2 const& velocity, float elasticity, Rgba8 const& color)
+{
+	WriteRecordType(PACHINKO_RECORD_SPAWN);
+	Write(center);
+	Write(radius);
+	Write(velocity);
+	Write(elasticity);
+	Write(color);
+}
+
+void PachinkoRecorder::RecordDespawn(int ballIndex)
+{
+	WriteRecordType(PACHINKO_RECORD_DESPAWN);
+	Write(ballIndex);
+}
+
+void PachinkoRecorder::RecordToggle(PachinkoToggle toggle)
+{
+	WriteRecordType(PACHINKO_RECORD_TOGGLE);
+	Write(static_cast<unsigned char>(toggle));
+}
+
+void PachinkoRecorder::RecordElasticityChange(float deltaElasticity)
+{
+	WriteRecordType(PACHINKO_RECORD_ELASTICITY);
+	Write(deltaElasticity);
+}
+
+void PachinkoRecorder::RecordSolverIterations(int numIterations)
+{
+	WriteRecordType(PACHINKO_RECORD_SOLVER_ITERATIONS);
+	Write(numIterations);
+}
+
+void PachinkoRecorder::WriteRecordType(PachinkoRecordType recordType)
+{
+	Write(static_cast<unsigned char>(recordType));
+}
+
+void PachinkoRecorder::WriteBytes(void const* data, size_t numBytes)
+{
+	if (m_file == nullptr)
+	{
+		return;
+	}
+
+	fwrite(data, 1, numBytes, m_file);
+	m_numBytesWritten += static_cast<long long>(numBytes);
+}
+
+// -----------------------------------------------------------------------------
+PachinkoReplayer::~PachinkoReplayer()
+{
+	Close();
+}
+
+bool PachinkoReplayer::Open(char const* filePath)
+{
+	Close();
+	m_file = fopen(filePath, "rb");
+	return m_file != nullptr;
+}
+
+void PachinkoReplayer::Close()
+{
+	if (m_file != nullptr)
+	{
+		fclose(m_file);
+		m_file = nullptr;
+	}
+}
+
+bool PachinkoReplayer::ReplayNextStep(PachinkoSimulation& simulation)
+{
+	if (m_file == nullptr || m_isInvalid)
+	{
+		return false;
+	}
+
+	// Running out of file between records is the normal end of a recording
+	unsigned char recordType = 0;
+	while (fread(&recordType, 1, 1, m_file) == 1)
+	{
+		switch (recordType)
+		{
+		case PACHINKO_RECORD_SESSION:
+		{
+			if (!ReadSession(simulation))
+			{
+				return false;
+			}
+			break;
+		}
+		case PACHINKO_RECORD_BUMPERS:
+		{
+			if (!ReadBumpers(simulation))
+			{
+				return false;
+			}
+			break;
+		}
+		case PACHINKO_RECORD_STEP:
+		{
+			float deltaSeconds = 0.f;
+			if (!Read(deltaSeconds))
+			{
+				return false;
+			}
+			simulation.Step(deltaSeconds);
+			++m_numStepsReplayed;
+			++m_numSessionSteps;
+			return true;
+		}
+		case PACHINKO_RECORD_SPAWN:
+		{
+			Vec2 center;
+			float radius = 0.f;
+			Vec2 velocity;
+			float elasticity = 0.f;
+			Rgba8 color;
+			if (!Read(center) || !Read(radius) || !Read(velocity) || !Read(elasticity) || !Read(color))
+			{
+				return false;
+			}
+			simulation.SpawnBall(center, radius, velocity, elasticity, color);
+			break;
+		}
+		case PACHINKO_RECORD_DESPAWN:
+		{
+			int ballIndex = 0;
+			if (!Read(ballIndex))
+			{
+				return false;
+			}
+			if (ballIndex < 0 || ballIndex >= simulation.GetBalls().GetNumBalls())
+			{
+				m_isInvalid = true;
+				return false;
+			}
+			simulation.DespawnBall(ballIndex);
+			break;
+		}
+		case PACHINKO_RECORD_TOGGLE:
+		{
+			unsigned char toggle = 0;
+			if (!Read(toggle))
+			{
+				return false;
+			}
+			ApplyToggle(simulation, static_cast<PachinkoToggle>(toggle));
+			break;
+		}
+		case PACHINKO_RECORD_ELASTICITY:
+		{
+			float deltaElasticity = 0.f;
+			if (!Read(deltaElasticity))
+			{
+				return false;
+			}
+			simulation.AdjustBallElasticity(deltaElasticity);
+			break;
+		}
+		case PACHINKO_RECORD_SOLVER_ITERATIONS:
+		{
+			int numIterations = 0;
+			if (!Read(numIterations))
+			{
+				return false;
+			}
+			simulation.SetSolverIterations(numIterations);
+			break;
+		}
+		case PACHINKO_RECORD_CHECKSUM:
+		{
+			int sessionStep = 0;
+			unsigned long long checksum = 0;
+			if (!Read(sessionStep) || !Read(checksum))
+			{
+				return false;
+			}
+			CheckChecksum(sessionStep, checksum, simulation);
+			break;
+		}
+		default:
+		{
+			m_isInvalid = true;
+			return false;
+		}
+		}
+	}
+
+	return false;
+}
+
+bool PachinkoReplayer::ReadSession(PachinkoSimulation& simulation)
+{
+	unsigned int magic = 0;
+	unsigned short version = 0;
+	unsigned int seed = 0;
+	unsigned char toggleFlags = 0;
+	int solverIterations = 0;
+	if (!Read(magic) || !Read(version) || !Read(seed) || !Read(toggleFlags) || !Read(solverIterations))
+	{
+		return false;
+	}
+	if (magic != PACHINKO_RECORDING_MAGIC || version != PACHINKO_RECORDING_VERSION)
+	{
+		m_isInvalid = true;
+		return false;
+	}
+
+	PachinkoStepConfig stepConfig;
+	if (!ReadStepConfig(stepConfig))
+	{
+		return false;
+	}
+
+	// The seed only matters to anything that rolls the C runtime generator; spawns are recorded outright
+	srand(seed);
+	simulation.SetStepConfig(stepConfig);
+	simulation.SetSolverIterations(solverIterations);
+	for (int toggleIndex = 0; toggleIndex < PACHINKO_TOGGLE_COUNT; ++toggleIndex)
+	{
+		PachinkoToggle toggle = static_cast<PachinkoToggle>(toggleIndex);
+		if (IsToggleOn(simulation, toggle) != ((toggleFlags & (1 << toggle)) != 0))
+		{
+			ApplyToggle(simulation, toggle);
+		}
+	}
+
+	++m_numSessions;
+	m_numSessionSteps = 0;
+	return true;
+}
+
+bool PachinkoReplayer::ReadStepConfig(PachinkoStepConfig& out_stepConfig)
+{
+	if (!Read(out_stepConfig.m_maxNumBalls) || !Read(out_stepConfig.m_maxBallRadius) || !Read(out_stepConfig.m_wallElasticity)
+		|| !Read(out_stepConfig.m_extraWarpHeight) || !Read(out_stepConfig.m_sleepSpeed) || !Read(out_stepConfig.m_numStepsToSleep))
+	{
+		return false;
+	}
+
+	// The pool and grids are sized from these, so a corrupt value must not reach them. The ball
+	// grid's cells are one max diameter wide, falling back to 1 for a zero radius, so no smaller.
+	bool isPoolSizeValid = out_stepConfig.m_maxNumBalls >= 0 && out_stepConfig.m_maxNumBalls <= PACHINKO_RECORDING_MAX_BALLS;
+	bool isWarpHeightValid = out_stepConfig.m_extraWarpHeight >= 0 && out_stepConfig.m_extraWarpHeight <= PACHINKO_RECORDING_MAX_WARP_HEIGHT;
+	bool isRadiusValid = out_stepConfig.m_maxBallRadius == 0.f || (out_stepConfig.m_maxBallRadius >= 0.5f && out_stepConfig.m_maxBallRadius <= SCREEN_SIZE_X);
+	if (!isPoolSizeValid || !isWarpHeightValid || !isRadiusValid)
+	{
+		m_isInvalid = true;
+		return false;
+	}
+	return true;
+}
+
+bool PachinkoReplayer::ReadBumpers(PachinkoSimulation& simulation)
+{
+	PachinkoBumpers bumpers;
+
+	int numDiscs = 0;
+	if (!ReadBumperCount(numDiscs))
+	{
+		return false;
+	}
+	bumpers.m_discs.resize(numDiscs);
+	for (int discIndex = 0; discIndex < numDiscs; ++discIndex)
+	{
+		DiscBumper& disc = bumpers.m_discs[discIndex];
+		if (!Read(disc.m_center) || !Read(disc.m_radius) || !Read(disc.m_elasticity) || !Read(disc.m_color))
+		{
+			return false;
+		}
+	}
+
+	int numCapsules = 0;
+	if (!ReadBumperCount(numCapsules))
+	{
+		return false;
+	}
+	bumpers.m_capsules.resize(numCapsules);
+	for (int capsuleIndex = 0; capsuleIndex < numCapsules; ++capsuleIndex)
+	{
+		CapsuleBumper& capsule = bumpers.m_capsules[capsuleIndex];
+		if (!Read(capsule.m_boneStart) || !Read(capsule.m_boneEnd) || !Read(capsule.m_radius) || !Read(capsule.m_elasticity) || !Read(capsule.m_color))
+		{
+			return false;
+		}
+	}
+
+	int numBoxes = 0;
+	if (!ReadBumperCount(numBoxes))
+	{
+		return false;
+	}
+	bumpers.m_boxes.resize(numBoxes);
+	for (int boxIndex = 0; boxIndex < numBoxes; ++boxIndex)
+	{
+		OBB2Bumper& box = bumpers.m_boxes[boxIndex];
+		if (!Read(box.m_box.m_center) || !Read(box.m_box.m_iBasisNormal) || !Read(box.m_box.m_halfDimensions) || !Read(box.m_elasticity) || !Read(box.m_color))
+		{
+			return false;
+		}
+	}
+
+	simulation.SetBumpers(bumpers);
+	return true;
+}
+
+bool PachinkoReplayer::ReadBumperCount(int& out_numBumpers)
+{
+	if (!Read(out_numBumpers))
+	{
+		return false;
+	}
+	if (out_numBumpers < 0 || out_numBumpers > PACHINKO_RECORDING_MAX_BUMPERS_PER_TYPE)
+	{
+		m_isInvalid = true;
+		return false;
+	}
+	return true;
+}
+
+void PachinkoReplayer::CheckChecksum(int sessionStep, unsigned long long checksum, PachinkoSimulation const& simulation)
+{
+	if (sessionStep == m_numSessionSteps && checksum == simulation.GetBallStateChecksum())
+	{
+		++m_numChecksumsVerified;
+		return;
+	}
+
+	++m_numChecksumMismatches;
+	if (m_firstMismatchStep < 0)
+	{
+		m_firstMismatchStep = m_numStepsReplayed;
+	}
+}
+
+bool PachinkoReplayer::ReadBytes(void* data, size_t numBytes)
+{
+	// A recording cut off mid-record, say by a crash, just ends early
+	if (fread(data, 1, numBytes, m_file) != numBytes)
+	{
+		m_isTruncated = true;
+		return false;
+	}
+	return true;
+}
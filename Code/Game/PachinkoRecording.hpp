@@ -0,0 +1,125 @@
+#pragma once
+#include "Engine/Core/Rgba8.h"
+#include "Engine/Math/Vec2.hpp"
+#include <stdio.h>
+// -----------------------------------------------------------------------------
+class PachinkoSimulation;
+struct PachinkoBumpers;
+struct PachinkoStepConfig;
+// -----------------------------------------------------------------------------
+// A pachinko recording is a flat stream of records, each a one byte type followed by a fixed
+// payload. A session record starts each run and carries the seed, toggles, solver iterations and
+// PachinkoStepConfig, then everything done to the simulation follows in order. New sessions are
+// appended to the end of the file.
+// -----------------------------------------------------------------------------
+const unsigned int PACHINKO_RECORDING_MAGIC = 0x4B484350; // "PCHK"
+const unsigned short PACHINKO_RECORDING_VERSION = 4;
+// Counts and sizes past these are taken for a corrupt record rather than allocated for
+const int PACHINKO_RECORDING_MAX_BUMPERS_PER_TYPE = 65536;
+const int PACHINKO_RECORDING_MAX_BALLS = 4194304;
+const int PACHINKO_RECORDING_MAX_WARP_HEIGHT = 65536;
+// -----------------------------------------------------------------------------
+enum PachinkoRecordType
+{
+	PACHINKO_RECORD_SESSION,
+	PACHINKO_RECORD_BUMPERS,
+	PACHINKO_RECORD_STEP,
+	PACHINKO_RECORD_SPAWN,
+	PACHINKO_RECORD_DESPAWN,
+	PACHINKO_RECORD_TOGGLE,
+	PACHINKO_RECORD_ELASTICITY,
+	PACHINKO_RECORD_CHECKSUM,
+	PACHINKO_RECORD_SOLVER_ITERATIONS,
+	PACHINKO_RECORD_COUNT
+};
+// -----------------------------------------------------------------------------
+enum PachinkoToggle
+{
+	PACHINKO_TOGGLE_BOTTOM_WARP,
+	PACHINKO_TOGGLE_BALL_GRID,
+	PACHINKO_TOGGLE_SLEEPING,
+	PACHINKO_TOGGLE_CONTINUOUS_COLLISION,
+	PACHINKO_TOGGLE_CONTACT_SOLVER,
+	PACHINKO_TOGGLE_COUNT
+};
+// -----------------------------------------------------------------------------
+// Writes straight through a FILE so nothing but the stdio buffer is held in memory.
+// The file is flushed with every checksum, so a crash loses at most one interval.
+// -----------------------------------------------------------------------------
+class PachinkoRecorder
+{
+public:
+	PachinkoRecorder(int checksumInterval);
+	~PachinkoRecorder();
+
+	bool Open(char const* filePath);
+	void Close();
+	bool IsOpen() const							{ return m_file != nullptr; }
+
+	void BeginSession(unsigned int seed, PachinkoSimulation const& simulation);
+	void RecordBumpers(PachinkoBumpers const& bumpers);
+	void RecordStep(float deltaSeconds, PachinkoSimulation const& simulation);
+	void RecordSpawn(Vec2 const& center, float radius, Vec2 const& velocity, float elasticity, Rgba8 const& color);
+	void RecordDespawn(int ballIndex);
+	void RecordToggle(PachinkoToggle toggle);
+	void RecordElasticityChange(float deltaElasticity);
+	void RecordSolverIterations(int numIterations);
+
+	int  GetNumSessionSteps() const				{ return m_numSessionSteps; }
+	long long GetNumBytesWritten() const		{ return m_numBytesWritten; }
+
+private:
+	void WriteRecordType(PachinkoRecordType recordType);
+	void WriteBytes(void const* data, size_t numBytes);
+	template <typename T> void Write(T const& value) { WriteBytes(&value, sizeof(T)); }
+
+private:
+	FILE*	  m_file = nullptr;
+	int		  m_checksumInterval = 60;
+	int		  m_numSessionSteps = 0;
+	long long m_numBytesWritten = 0;
+};
+// -----------------------------------------------------------------------------
+// Reads a recording back one record at a time and applies it to a simulation,
+// checking every recorded checksum against the replayed ball state.
+// -----------------------------------------------------------------------------
+class PachinkoReplayer
+{
+public:
+	~PachinkoReplayer();
+
+	bool Open(char const* filePath);
+	void Close();
+
+	// Applies records up to and including the next step; false once the stream ends or is bad
+	bool ReplayNextStep(PachinkoSimulation& simulation);
+
+	int  GetNumSessions() const					{ return m_numSessions; }
+	int  GetNumStepsReplayed() const			{ return m_numStepsReplayed; }
+	int  GetSessionStepIndex() const			{ return m_numSessionSteps; }
+	int  GetNumChecksumsVerified() const		{ return m_numChecksumsVerified; }
+	int  GetNumChecksumMismatches() const		{ return m_numChecksumMismatches; }
+	int  GetFirstMismatchStep() const			{ return m_firstMismatchStep; }
+	bool IsTruncated() const					{ return m_isTruncated; }
+	bool IsInvalid() const						{ return m_isInvalid; }
+
+private:
+	bool ReadSession(PachinkoSimulation& simulation);
+	bool ReadStepConfig(PachinkoStepConfig& out_stepConfig);
+	bool ReadBumpers(PachinkoSimulation& simulation);
+	bool ReadBumperCount(int& out_numBumpers);
+	void CheckChecksum(int sessionStep, unsigned long long checksum, PachinkoSimulation const& simulation);
+	bool ReadBytes(void* data, size_t numBytes);
+	template <typename T> bool Read(T& out_value) { return ReadBytes(&out_value, sizeof(T)); }
+
+private:
+	FILE* m_file = nullptr;
+	int   m_numSessions = 0;
+	int   m_numStepsReplayed = 0;
+	int   m_numSessionSteps = 0;
+	int   m_numChecksumsVerified = 0;
+	int   m_numChecksumMismatches = 0;
+	int   m_firstMismatchStep = -1;
+	bool  m_isTruncated = false;
+	bool  m_isInvalid = false;
+};
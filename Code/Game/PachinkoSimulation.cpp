@@ -0,0 +1,1491 @@
+#include "Game/PachinkoSimulation.hpp"
+#include "Game/GameCommon.h"
+#include "Game/PachinkoRecording.hpp"
+#include "Game/SimdUtils.hpp"
+#include "Game/WorkerPool.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Math/MathUtils.h"
+#include "Engine/Math/RaycastUtils.hpp"
+#include "Engine/Math/RandomNumberGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+
+static int GetClampedGridCoord(float coord, float gridMin, float cellSize, int numCells)
+{
+	int cellCoord = static_cast<int>(floorf((coord - gridMin) / cellSize));
+	if (cellCoord < 0)
+	{
+		return 0;
+	}
+	if (cellCoord > numCells - 1)
+	{
+		return numCells - 1;
+	}
+	return cellCoord;
+}
+
+static void KeepNearerImpact(RaycastResult2D& nearestImpact, RaycastResult2D const& impact)
+{
+	if (impact.m_didImpact && (!nearestImpact.m_didImpact || impact.m_impactDist < nearestImpact.m_impactDist))
+	{
+		nearestImpact = impact;
+	}
+}
+
+// Sweeping a disc against a bumper is a raycast against the bumper grown by the disc radius.
+// Starts already touching the bumper are left to the overlap pass, so they report no impact.
+static RaycastResult2D SweepDiscVsDiscBumper(Vec2 const& start, Vec2 const& direction, float distance, float ballRadius, DiscBumper const& disc)
+{
+	float grownRadius = disc.m_radius + ballRadius;
+	if (GetDistanceSquared2D(start, disc.m_center) <= grownRadius * grownRadius)
+	{
+		return RaycastResult2D();
+	}
+	return RaycastVsDisc2D(start, direction, distance, disc.m_center, grownRadius);
+}
+
+static RaycastResult2D SweepDiscVsCapsuleBumper(Vec2 const& start, Vec2 const& direction, float distance, float ballRadius, CapsuleBumper const& capsule)
+{
+	// Two end caps plus the two sides of the bone pushed out by the grown radius
+	RaycastResult2D nearestImpact;
+	float grownRadius = capsule.m_radius + ballRadius;
+	Vec2 nearestPointOnBone = GetNearestPointOnLineSegment2D(start, capsule.m_boneStart, capsule.m_boneEnd);
+	if (GetDistanceSquared2D(start, nearestPointOnBone) <= grownRadius * grownRadius)
+	{
+		return nearestImpact;
+	}
+
+	Vec2 sideOffset = (capsule.m_boneEnd - capsule.m_boneStart).GetNormalized().GetRotated90Degrees() * grownRadius;
+	KeepNearerImpact(nearestImpact, RaycastVsDisc2D(start, direction, distance, capsule.m_boneStart, grownRadius));
+	KeepNearerImpact(nearestImpact, RaycastVsDisc2D(start, direction, distance, capsule.m_boneEnd, grownRadius));
+	KeepNearerImpact(nearestImpact, RaycastVsLineSegment2D(start, direction, distance, capsule.m_boneStart + sideOffset, capsule.m_boneEnd + sideOffset));
+	KeepNearerImpact(nearestImpact, RaycastVsLineSegment2D(start, direction, distance, capsule.m_boneStart - sideOffset, capsule.m_boneEnd - sideOffset));
+	return nearestImpact;
+}
+
+static RaycastResult2D SweepDiscVsOBB2Bumper(Vec2 const& start, Vec2 const& direction, float distance, float ballRadius, OBB2Bumper const& bumper)
+{
+	// In the box's own frame the grown box is two crossed AABB2s plus a disc on each corner
+	RaycastResult2D nearestImpact;
+	OBB2 const& box = bumper.m_box;
+	if (GetDistanceSquared2D(start, GetNearestPointOnOBB2D(start, box)) <= ballRadius * ballRadius)
+	{
+		return nearestImpact;
+	}
+
+	Vec2 iBasis = box.m_iBasisNormal;
+	Vec2 jBasis = iBasis.GetRotated90Degrees();
+	Vec2 localStart(DotProduct2D(start - box.m_center, iBasis), DotProduct2D(start - box.m_center, jBasis));
+	Vec2 localDirection(DotProduct2D(direction, iBasis), DotProduct2D(direction, jBasis));
+	Vec2 halfDimensions = box.m_halfDimensions;
+
+	RaycastResult2D localImpact;
+	KeepNearerImpact(localImpact, RaycastVsAABB2D(localStart, localDirection, distance, AABB2(-halfDimensions.x - ballRadius, -halfDimensions.y, halfDimensions.x + ballRadius, halfDimensions.y)));
+	KeepNearerImpact(localImpact, RaycastVsAABB2D(localStart, localDirection, distance, AABB2(-halfDimensions.x, -halfDimensions.y - ballRadius, halfDimensions.x, halfDimensions.y + ballRadius)));
+	KeepNearerImpact(localImpact, RaycastVsDisc2D(localStart, localDirection, distance, Vec2(-halfDimensions.x, -halfDimensions.y), ballRadius));
+	KeepNearerImpact(localImpact, RaycastVsDisc2D(localStart, localDirection, distance, Vec2(halfDimensions.x, -halfDimensions.y), ballRadius));
+	KeepNearerImpact(localImpact, RaycastVsDisc2D(localStart, localDirection, distance, Vec2(-halfDimensions.x, halfDimensions.y), ballRadius));
+	KeepNearerImpact(localImpact, RaycastVsDisc2D(localStart, localDirection, distance, Vec2(halfDimensions.x, halfDimensions.y), ballRadius));
+
+	if (localImpact.m_didImpact)
+	{
+		nearestImpact = localImpact;
+		nearestImpact.m_impactPos = start + direction * localImpact.m_impactDist;
+		nearestImpact.m_impactNormal = iBasis * localImpact.m_impactNormal.x + jBasis * localImpact.m_impactNormal.y;
+	}
+	return nearestImpact;
+}
+
+// Same-parity stripes share no awake balls, so every list of one parity runs at once, evens then odds
+template <typename ContactListFunction>
+static void RunContactListsByParity(WorkerPool& workerPool, int numContactLists, ContactListFunction const& contactListFunction)
+{
+	for (int parity = 0; parity < 2; ++parity)
+	{
+		int numParityLists = (numContactLists - parity + 1) / 2;
+		workerPool.ParallelFor(numParityLists, [parity, &contactListFunction](int taskIndex)
+		{
+			contactListFunction(parity + 2 * taskIndex);
+		});
+	}
+}
+
+// Phase timings read std::chrono directly so the simulation has no platform dependency
+static double GetPhaseClockSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void PachinkoBumpers::Clear()
+{
+	m_discs.clear();
+	m_capsules.clear();
+	m_boxes.clear();
+}
+
+AABB2 GetDiscBumperBounds(DiscBumper const& disc)
+{
+	return AABB2(disc.m_center - Vec2(disc.m_radius, disc.m_radius), disc.m_center + Vec2(disc.m_radius, disc.m_radius));
+}
+
+AABB2 GetCapsuleBumperBounds(CapsuleBumper const& capsule)
+{
+	Vec2 boneMins(fminf(capsule.m_boneStart.x, capsule.m_boneEnd.x), fminf(capsule.m_boneStart.y, capsule.m_boneEnd.y));
+	Vec2 boneMaxs(fmaxf(capsule.m_boneStart.x, capsule.m_boneEnd.x), fmaxf(capsule.m_boneStart.y, capsule.m_boneEnd.y));
+	return AABB2(boneMins - Vec2(capsule.m_radius, capsule.m_radius), boneMaxs + Vec2(capsule.m_radius, capsule.m_radius));
+}
+
+AABB2 GetOBB2BumperBounds(OBB2Bumper const& box)
+{
+	Vec2 iBasisNormal = box.m_box.m_iBasisNormal;
+	Vec2 halfDimensions = box.m_box.m_halfDimensions;
+	Vec2 boxHalfExtents(fabsf(iBasisNormal.x) * halfDimensions.x + fabsf(iBasisNormal.y) * halfDimensions.y, fabsf(iBasisNormal.y) * halfDimensions.x + fabsf(iBasisNormal.x) * halfDimensions.y);
+	return AABB2(box.m_box.m_center - boxHalfExtents, box.m_box.m_center + boxHalfExtents);
+}
+
+char const* GetPachinkoPhaseName(PachinkoPhase phase)
+{
+	switch (phase)
+	{
+	case PACHINKO_PHASE_INTEGRATE:		  return "integrate";
+	case PACHINKO_PHASE_BALLS_VS_BALLS:	  return "ballVsBall";
+	case PACHINKO_PHASE_BALLS_VS_BUMPERS: return "ballVsBumper";
+	case PACHINKO_PHASE_WALLS:			  return "walls";
+	case PACHINKO_PHASE_SLEEP:			  return "sleep";
+	default:							  return "unknown";
+	}
+}
+
+PachinkoSimulation::PachinkoSimulation()
+{
+	InitializeGameConfigElements();
+	InitializeBallGrid();
+}
+
+PachinkoSimulation::~PachinkoSimulation()
+{
+	delete m_workerPool;
+	m_workerPool = nullptr;
+}
+
+void PachinkoSimulation::InitializeGameConfigElements()
+{
+	// Balls
+	m_pachinkoMinBallRadius = g_gameConfigBlackboard.GetValue("pachinkoMinBallRadius", 0.0f);
+	m_pachinkoMaxBallRadius = g_gameConfigBlackboard.GetValue("pachinkoMaxBallRadius", 0.0f);
+	m_maxNumBalls = g_gameConfigBlackboard.GetValue("pachinkoMaxBalls", 10000);
+	m_balls.Initialize(m_maxNumBalls);
+	m_contactSolver.Initialize(m_maxNumBalls);
+
+	// Contact solver
+	m_isContactSolverOn = g_gameConfigBlackboard.GetValue("pachinkoContactSolver", false);
+	m_contactSolver.SetNumIterations(g_gameConfigBlackboard.GetValue("pachinkoSolverIterations", 8));
+
+	// Sleeping
+	m_sleepSpeed = g_gameConfigBlackboard.GetValue("pachinkoSleepSpeed", 10.0f);
+	m_numStepsToSleep = g_gameConfigBlackboard.GetValue("pachinkoSleepSteps", 60);
+
+	// Discs
+	m_numFixedDiscs = g_gameConfigBlackboard.GetValue("pachinkoNumDiscBumpers", 0);
+	m_fixedDiscMinRadius = g_gameConfigBlackboard.GetValue("pachinkoMinDiscBumperRadius", 0.0f);
+	m_fixedDiscMaxRadius = g_gameConfigBlackboard.GetValue("pachinkoMaxDiscBumperRadius", 0.0f);
+
+	// Capsules
+	m_numFixedCapsules = g_gameConfigBlackboard.GetValue("pachinkoNumCapsuleBumpers", 0);
+	m_minCapsuleLength = g_gameConfigBlackboard.GetValue("pachinkoMinCapsuleBumperLength", 0.0f);
+	m_maxCapsuleLength = g_gameConfigBlackboard.GetValue("pachinkoMaxCapsuleBumperLength", 0.0f);
+	m_minCapsuleRadius = g_gameConfigBlackboard.GetValue("pachinkoMinCapsuleBumperRadius", 0.0f);
+	m_maxCapsuleRadius = g_gameConfigBlackboard.GetValue("pachinkoMaxCapsuleBumperRadius", 0.0f);
+
+	// Obb2s
+	m_numFixedOBB2s = g_gameConfigBlackboard.GetValue("pachinkoNumObbBumpers", 0);
+	m_minOBBwidth = g_gameConfigBlackboard.GetValue("pachinkoMinObbBumperWidth", 0.0f);
+	m_maxOBBwidth = g_gameConfigBlackboard.GetValue("pachinkoMaxObbBumperWidth", 0.0f);
+
+	// Elasticity
+	m_wallElasticity = g_gameConfigBlackboard.GetValue("pachinkoWallElasticity", 0.0f);
+	m_minElasticity = g_gameConfigBlackboard.GetValue("pachinkoMinBumperElasticity", 0.0f);
+	m_maxElasticity = g_gameConfigBlackboard.GetValue("pachinkoMaxBumperElasticity", 0.0f);
+	m_extraWarpHeight = g_gameConfigBlackboard.GetValue("pachinkoExtraWarpHeight", 0);
+
+	// Continuous collision
+	m_isContinuousCollisionOn = g_gameConfigBlackboard.GetValue("pachinkoContinuousCollision", true);
+
+	// Threads, 0 means one per hardware thread
+	int numThreads = g_gameConfigBlackboard.GetValue("pachinkoNumThreads", 0);
+	if (numThreads <= 0)
+	{
+		numThreads = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	if (numThreads <= 0)
+	{
+		numThreads = 1;
+	}
+	m_workerPool = new WorkerPool(numThreads);
+}
+
+
+int PachinkoSimulation::GetNumThreads() const
+{
+	return m_workerPool->GetNumThreads();
+}
+
+float PachinkoSimulation::GetMaxAwakeBallSpeed() const
+{
+	return sqrtf(GetMaxBallSpeedSquared(m_balls, 0, m_balls.GetNumAwakeBalls()));
+}
+
+unsigned long long PachinkoSimulation::GetBallStateChecksum() const
+{
+	// FNV-1a over the exact bits of every ball's position and velocity, in pool order
+	unsigned long long checksum = 14695981039346656037ULL;
+	std::vector<float> const* ballArrays[] = { &m_balls.m_positionX, &m_balls.m_positionY, &m_balls.m_velocityX, &m_balls.m_velocityY };
+	for (int arrayIndex = 0; arrayIndex < 4; ++arrayIndex)
+	{
+		unsigned char const* bytes = reinterpret_cast<unsigned char const*>(ballArrays[arrayIndex]->data());
+		int numBytes = m_balls.GetNumBalls() * static_cast<int>(sizeof(float));
+		for (int byteIndex = 0; byteIndex < numBytes; ++byteIndex)
+		{
+			checksum ^= bytes[byteIndex];
+			checksum *= 1099511628211ULL;
+		}
+	}
+	return checksum;
+}
+
+void PachinkoSimulation::SetRecorder(PachinkoRecorder* recorder)
+{
+	m_recorder = recorder;
+}
+
+bool PachinkoSimulation::SpawnBall(Vec2 const& center, float radius, Vec2 const& velocity, float elasticity, Rgba8 const& color)
+{
+	if (m_recorder != nullptr)
+	{
+		m_recorder->RecordSpawn(center, radius, velocity, elasticity, color);
+	}
+
+	if (!m_balls.AddBall(center, radius, velocity, elasticity, color))
+	{
+		return false;
+	}
+
+	// The new ball lands at the end of the awake range, with an id a despawned ball may have cached contacts under
+	m_contactSolver.ForgetBall(m_balls.m_ballId[m_balls.GetNumAwakeBalls() - 1]);
+
+	if (m_balls.GetNumSleepingBalls() > 0)
+	{
+		m_isSleepingGridDirty = true;
+	}
+	return true;
+}
+
+void PachinkoSimulation::SetSolverIterations(int numIterations)
+{
+	if (m_recorder != nullptr)
+	{
+		m_recorder->RecordSolverIterations(numIterations);
+	}
+	m_contactSolver.SetNumIterations(numIterations);
+}
+
+PachinkoStepConfig PachinkoSimulation::GetStepConfig() const
+{
+	PachinkoStepConfig stepConfig;
+	stepConfig.m_maxNumBalls = m_maxNumBalls;
+	stepConfig.m_maxBallRadius = m_pachinkoMaxBallRadius;
+	stepConfig.m_wallElasticity = m_wallElasticity;
+	stepConfig.m_extraWarpHeight = m_extraWarpHeight;
+	stepConfig.m_sleepSpeed = m_sleepSpeed;
+	stepConfig.m_numStepsToSleep = m_numStepsToSleep;
+	return stepConfig;
+}
+
+void PachinkoSimulation::SetStepConfig(PachinkoStepConfig const& stepConfig)
+{
+	m_wallElasticity = stepConfig.m_wallElasticity;
+	m_sleepSpeed = stepConfig.m_sleepSpeed;
+	m_numStepsToSleep = stepConfig.m_numStepsToSleep;
+
+	// The ball grid is sized from the max radius and warp height, and the bumper grid shares its cells
+	ClearBalls();
+	if (stepConfig.m_maxNumBalls != m_maxNumBalls)
+	{
+		m_maxNumBalls = stepConfig.m_maxNumBalls;
+		m_balls.Initialize(m_maxNumBalls);
+		m_contactSolver.Initialize(m_maxNumBalls);
+	}
+	m_pachinkoMaxBallRadius = stepConfig.m_maxBallRadius;
+	m_extraWarpHeight = stepConfig.m_extraWarpHeight;
+	InitializeBallGrid();
+	BuildBumperGrid();
+}
+
+void PachinkoSimulation::AdjustBallElasticity(float deltaElasticity)
+{
+	if (m_recorder != nullptr)
+	{
+		m_recorder->RecordElasticityChange(deltaElasticity);
+	}
+
+	for (int ballIndex = 0; ballIndex < m_balls.GetNumBalls(); ++ballIndex)
+	{
+		m_balls.m_elasticity[ballIndex] = GetClamped(m_balls.m_elasticity[ballIndex] + deltaElasticity, 0.f, 1.f);
+	}
+}
+
+void PachinkoSimulation::ToggleBottomWarp()
+{
+	if (m_recorder != nullptr)
+	{
+		m_recorder->RecordToggle(PACHINKO_TOGGLE_BOTTOM_WARP);
+	}
+
+	// The floor just changed under any settled pile
+	m_isBottomWarpOn = !m_isBottomWarpOn;
+	m_balls.WakeAllBalls();
+	m_isSleepingGridDirty = true;
+}
+
+void PachinkoSimulation::ToggleBallGrid()
+{
+	if (m_recorder != nullptr)
+	{
+		m_recorder->RecordToggle(PACHINKO_TOGGLE_BALL_GRID);
+	}
+	m_isBallGridOn = !m_isBallGridOn;
+}
+
+void PachinkoSimulation::ToggleContinuousCollision()
+{
+	if (m_recorder != nullptr)
+	{
+		m_recorder->RecordToggle(PACHINKO_TOGGLE_CONTINUOUS_COLLISION);
+	}
+	m_isContinuousCollisionOn = !m_isContinuousCollisionOn;
+}
+
+void PachinkoSimulation::ToggleContactSolver()
+{
+	if (m_recorder != nullptr)
+	{
+		m_recorder->RecordToggle(PACHINKO_TOGGLE_CONTACT_SOLVER);
+	}
+	m_isContactSolverOn = !m_isContactSolverOn;
+}
+
+void PachinkoSimulation::ToggleSleeping()
+{
+	if (m_recorder != nullptr)
+	{
+		m_recorder->RecordToggle(PACHINKO_TOGGLE_SLEEPING);
+	}
+
+	m_isSleepingOn = !m_isSleepingOn;
+	m_balls.WakeAllBalls();
+	m_isSleepingGridDirty = true;
+}
+
+void PachinkoSimulation::Step(float deltaSeconds)
+{
+	double phaseStartSeconds = m_isPhaseTimingOn ? GetPhaseClockSeconds() : 0.0;
+
+	ApplyGravityAndMoveBalls(deltaSeconds);
+	EndPhase(PACHINKO_PHASE_INTEGRATE, phaseStartSeconds);
+
+	BallsVsBalls(deltaSeconds);
+	WakeTouchedIslands();
+	EndPhase(PACHINKO_PHASE_BALLS_VS_BALLS, phaseStartSeconds);
+
+	BallsVsBumpers();
+	EndPhase(PACHINKO_PHASE_BALLS_VS_BUMPERS, phaseStartSeconds);
+
+	BallsVsWalls();
+	EndPhase(PACHINKO_PHASE_WALLS, phaseStartSeconds);
+
+	PutRestingIslandsToSleep();
+	EndPhase(PACHINKO_PHASE_SLEEP, phaseStartSeconds);
+
+	if (m_recorder != nullptr)
+	{
+		m_recorder->RecordStep(deltaSeconds, *this);
+	}
+}
+
+void PachinkoSimulation::EndPhase(PachinkoPhase phase, double& phaseStartSeconds)
+{
+	if (!m_isPhaseTimingOn)
+	{
+		return;
+	}
+
+	double phaseEndSeconds = GetPhaseClockSeconds();
+	m_lastStepPhaseSeconds[phase] = phaseEndSeconds - phaseStartSeconds;
+	m_accumulatedPhaseSeconds[phase] += m_lastStepPhaseSeconds[phase];
+	phaseStartSeconds = phaseEndSeconds;
+}
+
+void PachinkoSimulation::ResetAccumulatedPhaseSeconds()
+{
+	for (int phaseIndex = 0; phaseIndex < PACHINKO_PHASE_COUNT; ++phaseIndex)
+	{
+		m_accumulatedPhaseSeconds[phaseIndex] = 0.0;
+	}
+}
+
+void PachinkoSimulation::ApplyGravityAndMoveBalls(float deltaSeconds)
+{
+	int numTasks = m_workerPool->GetNumThreads();
+	m_workerPool->ParallelFor(numTasks, [this, numTasks, deltaSeconds](int taskIndex)
+	{
+		int firstBall = 0;
+		int lastBall = 0;
+		GetBallTaskRange(taskIndex, numTasks, firstBall, lastBall);
+		SaveBallPreviousPositions(m_balls, firstBall, lastBall);
+		IntegrateBalls(m_balls, firstBall, lastBall, -100.f, deltaSeconds);
+	});
+}
+
+void PachinkoSimulation::BallsVsBalls(float deltaSeconds)
+{
+	if (m_isContactSolverOn)
+	{
+		m_contactSolver.SetWalls(0.f, SCREEN_SIZE_X, 0.f, !m_isBottomWarpOn, m_wallElasticity);
+		m_contactSolver.BeginStep(m_balls, deltaSeconds);
+		for (int listIndex = 0; listIndex < static_cast<int>(m_stripeSolverContacts.size()); ++listIndex)
+		{
+			m_stripeSolverContacts[listIndex].Clear();
+		}
+	}
+
+	if (m_isBallGridOn)
+	{
+		BallsVsBallsUniformGrid();
+	}
+	else
+	{
+		BallsVsBallsBruteForce();
+	}
+
+	if (m_isContactSolverOn)
+	{
+		SolveBallContacts(static_cast<int>(m_stripeSolverContacts.size()));
+	}
+}
+
+void PachinkoSimulation::BallsVsBallsBruteForce()
+{
+	int numBalls = m_balls.GetNumBalls();
+	int numAwakeBalls = m_balls.GetNumAwakeBalls();
+	m_numCandidateBallPairs = (numAwakeBalls * (numAwakeBalls - 1)) / 2 + numAwakeBalls * (numBalls - numAwakeBalls);
+
+	// Runs on this thread only, so everything goes through the first stripe's lists
+	if (m_stripeBallContacts.empty())
+	{
+		m_stripeBallContacts.resize(1);
+		m_stripeSleeperContacts.resize(1);
+		m_stripeWakeIslandIds.resize(1);
+		m_stripeSolverContacts.resize(1);
+		m_stripeCandidateBumperIndices.resize(1);
+	}
+
+	for (int i = 0; i < numAwakeBalls; ++i)
+	{
+		if (m_isContactSolverOn)
+		{
+			m_contactSolver.AddWallContacts(m_stripeSolverContacts[0], m_balls, i);
+			AddBumperContacts(i, 0);
+		}
+		for (int j = i + 1; j < numAwakeBalls; ++j)
+		{
+			if (BounceBallsOffEachOther(i, j, 0) && m_isSleepingOn)
+			{
+				m_stripeBallContacts[0].push_back(i);
+				m_stripeBallContacts[0].push_back(j);
+			}
+		}
+		for (int j = numAwakeBalls; j < numBalls; ++j)
+		{
+			TouchSleepingBall(i, j, 0);
+		}
+	}
+}
+
+void PachinkoSimulation::BallsVsBallsUniformGrid()
+{
+	int numAwakeBalls = m_balls.GetNumAwakeBalls();
+	BuildBallGrid(0, numAwakeBalls, m_ballGridCellStarts, m_ballGridBallIndices);
+	if (m_isSleepingGridDirty)
+	{
+		BuildBallGrid(numAwakeBalls, m_balls.GetNumBalls(), m_sleepingGridCellStarts, m_sleepingGridBallIndices);
+		m_isSleepingGridDirty = false;
+	}
+
+	// Each stripe writes only balls binned in its own columns or one column either side, so every
+	// even stripe can run at once, then every odd one. The order is fixed by the grid, not the thread count.
+	int numStripes = (m_ballGridNumCellsX + BALL_GRID_STRIPE_WIDTH - 1) / BALL_GRID_STRIPE_WIDTH;
+	if (static_cast<int>(m_stripeCandidateBallIndices.size()) < numStripes)
+	{
+		m_stripeCandidateBallIndices.resize(numStripes);
+		m_stripeCandidatePairCounts.resize(numStripes);
+		m_stripeBallContacts.resize(numStripes);
+		m_stripeSleeperContacts.resize(numStripes);
+		m_stripeWakeIslandIds.resize(numStripes);
+		m_stripeSolverContacts.resize(numStripes);
+		m_stripeCandidateBumperIndices.resize(numStripes);
+	}
+
+	for (int parity = 0; parity < 2; ++parity)
+	{
+		int numParityStripes = (numStripes - parity + 1) / 2;
+		m_workerPool->ParallelFor(numParityStripes, [this, parity](int taskIndex)
+		{
+			ResolveBallGridStripe(parity + 2 * taskIndex);
+		});
+	}
+
+	m_numCandidateBallPairs = 0;
+	for (int stripeIndex = 0; stripeIndex < numStripes; ++stripeIndex)
+	{
+		m_numCandidateBallPairs += m_stripeCandidatePairCounts[stripeIndex];
+	}
+}
+
+void PachinkoSimulation::ResolveBallGridStripe(int stripeIndex)
+{
+	std::vector<int>& candidateBallIndices = m_stripeCandidateBallIndices[stripeIndex];
+	std::vector<int>& ballContacts = m_stripeBallContacts[stripeIndex];
+	bool hasSleepingBalls = m_balls.GetNumSleepingBalls() > 0;
+	int firstCellX = stripeIndex * BALL_GRID_STRIPE_WIDTH;
+	int lastCellX = std::min(firstCellX + BALL_GRID_STRIPE_WIDTH, m_ballGridNumCellsX);
+	int numCandidatePairs = 0;
+
+	for (int cellY = 0; cellY < m_ballGridNumCellsY; ++cellY)
+	{
+		for (int cellX = firstCellX; cellX < lastCellX; ++cellX)
+		{
+			int ballCellIndex = cellX + cellY * m_ballGridNumCellsX;
+			for (int cellBall = m_ballGridCellStarts[ballCellIndex]; cellBall < m_ballGridCellStarts[ballCellIndex + 1]; ++cellBall)
+			{
+				// Gather every higher-indexed ball from the 3x3 block of cells around ball i
+				int i = m_ballGridBallIndices[cellBall];
+				candidateBallIndices.clear();
+				if (m_isContactSolverOn)
+				{
+					m_contactSolver.AddWallContacts(m_stripeSolverContacts[stripeIndex], m_balls, i);
+					AddBumperContacts(i, stripeIndex);
+				}
+
+				for (int neighborY = cellY - 1; neighborY <= cellY + 1; ++neighborY)
+				{
+					if (neighborY < 0 || neighborY >= m_ballGridNumCellsY)
+					{
+						continue;
+					}
+					for (int neighborX = cellX - 1; neighborX <= cellX + 1; ++neighborX)
+					{
+						if (neighborX < 0 || neighborX >= m_ballGridNumCellsX)
+						{
+							continue;
+						}
+						int cellIndex = neighborX + neighborY * m_ballGridNumCellsX;
+						for (int neighborBall = m_ballGridCellStarts[cellIndex]; neighborBall < m_ballGridCellStarts[cellIndex + 1]; ++neighborBall)
+						{
+							int j = m_ballGridBallIndices[neighborBall];
+							if (j > i)
+							{
+								candidateBallIndices.push_back(j);
+							}
+						}
+					}
+				}
+
+				// Resolve in ascending order, so each ball bounces off its higher-indexed neighbors lowest first
+				std::sort(candidateBallIndices.begin(), candidateBallIndices.end());
+				numCandidatePairs += static_cast<int>(candidateBallIndices.size());
+
+				for (int candidateIndex = 0; candidateIndex < static_cast<int>(candidateBallIndices.size()); ++candidateIndex)
+				{
+					int j = candidateBallIndices[candidateIndex];
+					if (BounceBallsOffEachOther(i, j, stripeIndex) && m_isSleepingOn)
+					{
+						ballContacts.push_back(i);
+						ballContacts.push_back(j);
+					}
+				}
+
+				if (hasSleepingBalls)
+				{
+					TouchSleepingBallsNearBall(i, cellX, cellY, stripeIndex);
+				}
+			}
+		}
+	}
+
+	m_stripeCandidatePairCounts[stripeIndex] = numCandidatePairs;
+}
+
+bool PachinkoSimulation::BounceBallsOffEachOther(int ballIndexA, int ballIndexB, int stripeIndex)
+{
+	if (m_isContactSolverOn)
+	{
+		return m_contactSolver.AddContact(m_stripeSolverContacts[stripeIndex], m_balls, ballIndexA, ballIndexB, false);
+	}
+
+	// Reject on the SoA arrays first so only overlapping pairs pay for the gather and scatter
+	float deltaX = m_balls.m_positionX[ballIndexB] - m_balls.m_positionX[ballIndexA];
+	float deltaY = m_balls.m_positionY[ballIndexB] - m_balls.m_positionY[ballIndexA];
+	float radiusSum = m_balls.m_radius[ballIndexA] + m_balls.m_radius[ballIndexB];
+	if (deltaX * deltaX + deltaY * deltaY >= radiusSum * radiusSum)
+	{
+		return false;
+	}
+
+	Vec2 centerA(m_balls.m_positionX[ballIndexA], m_balls.m_positionY[ballIndexA]);
+	Vec2 centerB(m_balls.m_positionX[ballIndexB], m_balls.m_positionY[ballIndexB]);
+	Vec2 velocityA(m_balls.m_velocityX[ballIndexA], m_balls.m_velocityY[ballIndexA]);
+	Vec2 velocityB(m_balls.m_velocityX[ballIndexB], m_balls.m_velocityY[ballIndexB]);
+
+	BounceDiscsOffEachOther2D(centerA,   centerB,   m_balls.m_radius[ballIndexA],     m_balls.m_radius[ballIndexB],
+							  velocityA, velocityB, m_balls.m_elasticity[ballIndexA], m_balls.m_elasticity[ballIndexB]);
+
+	m_balls.m_positionX[ballIndexA] = centerA.x;
+	m_balls.m_positionY[ballIndexA] = centerA.y;
+	m_balls.m_positionX[ballIndexB] = centerB.x;
+	m_balls.m_positionY[ballIndexB] = centerB.y;
+	m_balls.m_velocityX[ballIndexA] = velocityA.x;
+	m_balls.m_velocityY[ballIndexA] = velocityA.y;
+	m_balls.m_velocityX[ballIndexB] = velocityB.x;
+	m_balls.m_velocityY[ballIndexB] = velocityB.y;
+	return true;
+}
+
+void PachinkoSimulation::SolveBallContacts(int numContactLists)
+{
+	m_numSolverContacts = 0;
+	for (int listIndex = 0; listIndex < numContactLists; ++listIndex)
+	{
+		m_numSolverContacts += m_stripeSolverContacts[listIndex].GetNumContacts();
+	}
+
+	RunContactListsByParity(*m_workerPool, numContactLists, [this](int listIndex)
+	{
+		m_contactSolver.WarmStart(m_stripeSolverContacts[listIndex], m_balls);
+	});
+	for (int iteration = 0; iteration < m_contactSolver.GetNumIterations(); ++iteration)
+	{
+		RunContactListsByParity(*m_workerPool, numContactLists, [this](int listIndex)
+		{
+			m_contactSolver.SolveVelocities(m_stripeSolverContacts[listIndex], m_balls);
+		});
+	}
+	RunContactListsByParity(*m_workerPool, numContactLists, [this](int listIndex)
+	{
+		m_contactSolver.ApplyBounces(m_stripeSolverContacts[listIndex], m_balls);
+	});
+	for (int iteration = 0; iteration < m_contactSolver.GetNumIterations(); ++iteration)
+	{
+		RunContactListsByParity(*m_workerPool, numContactLists, [this](int listIndex)
+		{
+			m_contactSolver.SolvePositions(m_stripeSolverContacts[listIndex]);
+		});
+	}
+
+	// Every contact's ball A is binned in its own stripe, so no two lists store under the same ball
+	m_workerPool->ParallelFor(numContactLists, [this](int listIndex)
+	{
+		m_contactSolver.StoreImpulses(m_stripeSolverContacts[listIndex], m_balls);
+	});
+
+	int numTasks = m_workerPool->GetNumThreads();
+	m_workerPool->ParallelFor(numTasks, [this, numTasks](int taskIndex)
+	{
+		int firstBall = 0;
+		int lastBall = 0;
+		GetBallTaskRange(taskIndex, numTasks, firstBall, lastBall);
+		m_contactSolver.ApplyPositionCorrections(m_balls, firstBall, lastBall);
+	});
+}
+
+void PachinkoSimulation::TouchSleepingBallsNearBall(int ballIndex, int cellX, int cellY, int stripeIndex)
+{
+	for (int neighborY = cellY - 1; neighborY <= cellY + 1; ++neighborY)
+	{
+		if (neighborY < 0 || neighborY >= m_ballGridNumCellsY)
+		{
+			continue;
+		}
+		for (int neighborX = cellX - 1; neighborX <= cellX + 1; ++neighborX)
+		{
+			if (neighborX < 0 || neighborX >= m_ballGridNumCellsX)
+			{
+				continue;
+			}
+			int cellIndex = neighborX + neighborY * m_ballGridNumCellsX;
+			for (int cellBall = m_sleepingGridCellStarts[cellIndex]; cellBall < m_sleepingGridCellStarts[cellIndex + 1]; ++cellBall)
+			{
+				TouchSleepingBall(ballIndex, m_sleepingGridBallIndices[cellBall], stripeIndex);
+			}
+		}
+	}
+}
+
+void PachinkoSimulation::TouchSleepingBall(int awakeBallIndex, int sleepingBallIndex, int stripeIndex)
+{
+	float deltaX = m_balls.m_positionX[sleepingBallIndex] - m_balls.m_positionX[awakeBallIndex];
+	float deltaY = m_balls.m_positionY[sleepingBallIndex] - m_balls.m_positionY[awakeBallIndex];
+	float radiusSum = m_balls.m_radius[awakeBallIndex] + m_balls.m_radius[sleepingBallIndex];
+	if (deltaX * deltaX + deltaY * deltaY >= radiusSum * radiusSum)
+	{
+		return;
+	}
+
+	// The sleeper stays put this step and acts like a fixed disc, so only the awake ball is written
+	Vec2 center(m_balls.m_positionX[awakeBallIndex], m_balls.m_positionY[awakeBallIndex]);
+	Vec2 velocity(m_balls.m_velocityX[awakeBallIndex], m_balls.m_velocityY[awakeBallIndex]);
+	Vec2 sleeperCenter(m_balls.m_positionX[sleepingBallIndex], m_balls.m_positionY[sleepingBallIndex]);
+	bool isMoving = velocity.GetLengthSquared() >= m_sleepSpeed * m_sleepSpeed;
+
+	if (m_isContactSolverOn)
+	{
+		m_contactSolver.AddContact(m_stripeSolverContacts[stripeIndex], m_balls, awakeBallIndex, sleepingBallIndex, true);
+	}
+	else
+	{
+		BounceDiscOffFixedDisc2D(center, m_balls.m_radius[awakeBallIndex], velocity, m_balls.m_elasticity[awakeBallIndex],
+								 sleeperCenter, m_balls.m_radius[sleepingBallIndex], m_balls.m_elasticity[sleepingBallIndex]);
+
+		m_balls.m_positionX[awakeBallIndex] = center.x;
+		m_balls.m_positionY[awakeBallIndex] = center.y;
+		m_balls.m_velocityX[awakeBallIndex] = velocity.x;
+		m_balls.m_velocityY[awakeBallIndex] = velocity.y;
+	}
+
+	// A moving ball wakes the sleeper's whole island; a resting one just leans on it and may join it
+	int islandId = m_balls.m_islandId[sleepingBallIndex];
+	if (isMoving)
+	{
+		m_stripeWakeIslandIds[stripeIndex].push_back(islandId);
+	}
+	else
+	{
+		m_stripeSleeperContacts[stripeIndex].push_back(awakeBallIndex);
+		m_stripeSleeperContacts[stripeIndex].push_back(islandId);
+	}
+}
+
+void PachinkoSimulation::AddBumperContacts(int ballIndex, int stripeIndex)
+{
+	Vec2 ballCenter(m_balls.m_positionX[ballIndex], m_balls.m_positionY[ballIndex]);
+	float ballRadius = m_balls.m_radius[ballIndex];
+	std::vector<int>& candidateBumperIndices = m_stripeCandidateBumperIndices[stripeIndex];
+	GatherCandidateBumpers(ballCenter - Vec2(ballRadius, ballRadius), ballCenter + Vec2(ballRadius, ballRadius), candidateBumperIndices);
+
+	int firstCapsule = static_cast<int>(m_bumpers.m_discs.size());
+	int firstBox = firstCapsule + static_cast<int>(m_bumpers.m_capsules.size());
+	for (int candidateIndex = 0; candidateIndex < static_cast<int>(candidateBumperIndices.size()); ++candidateIndex)
+	{
+		// Discs and capsules push out along the line from their center or bone, like a ball pair
+		int bumperIndex = candidateBumperIndices[candidateIndex];
+		Vec2 nearestPoint;
+		float radiusSum = ballRadius;
+		float bumperElasticity = 0.f;
+		if (bumperIndex < firstCapsule)
+		{
+			DiscBumper const& disc = m_bumpers.m_discs[bumperIndex];
+			nearestPoint = disc.m_center;
+			radiusSum += disc.m_radius;
+			bumperElasticity = disc.m_elasticity;
+		}
+		else if (bumperIndex < firstBox)
+		{
+			CapsuleBumper const& capsule = m_bumpers.m_capsules[bumperIndex - firstCapsule];
+			nearestPoint = GetNearestPointOnLineSegment2D(ballCenter, capsule.m_boneStart, capsule.m_boneEnd);
+			radiusSum += capsule.m_radius;
+			bumperElasticity = capsule.m_elasticity;
+		}
+		else
+		{
+			OBB2Bumper const& box = m_bumpers.m_boxes[bumperIndex - firstBox];
+			nearestPoint = GetNearestPointOnOBB2D(ballCenter, box.m_box);
+			bumperElasticity = box.m_elasticity;
+
+			// A center inside the box leaves through the nearest face
+			if (IsPointInsideOBB2D(ballCenter, box.m_box))
+			{
+				Vec2 iBasis = box.m_box.m_iBasisNormal;
+				Vec2 jBasis = iBasis.GetRotated90Degrees();
+				Vec2 localCenter(DotProduct2D(ballCenter - box.m_box.m_center, iBasis), DotProduct2D(ballCenter - box.m_box.m_center, jBasis));
+				Vec2 faceDistances(box.m_box.m_halfDimensions.x - fabsf(localCenter.x), box.m_box.m_halfDimensions.y - fabsf(localCenter.y));
+				Vec2 normal = (faceDistances.x < faceDistances.y) ? iBasis * ((localCenter.x < 0.f) ? -1.f : 1.f) : jBasis * ((localCenter.y < 0.f) ? -1.f : 1.f);
+				float penetration = ballRadius + fminf(faceDistances.x, faceDistances.y);
+				m_contactSolver.AddBumperContact(m_stripeSolverContacts[stripeIndex], m_balls, ballIndex, bumperIndex, normal, penetration, bumperElasticity);
+				continue;
+			}
+		}
+
+		Vec2 delta = ballCenter - nearestPoint;
+		float distanceSquared = delta.GetLengthSquared();
+		if (distanceSquared >= radiusSum * radiusSum)
+		{
+			continue;
+		}
+		float distance = sqrtf(distanceSquared);
+		Vec2 normal = (distance > 0.f) ? delta * (1.f / distance) : Vec2(0.f, 1.f);
+		m_contactSolver.AddBumperContact(m_stripeSolverContacts[stripeIndex], m_balls, ballIndex, bumperIndex, normal, radiusSum - distance, bumperElasticity);
+	}
+}
+
+void PachinkoSimulation::BallsVsBumpers()
+{
+	int numTasks = m_workerPool->GetNumThreads();
+	if (static_cast<int>(m_taskCandidateBumperIndices.size()) < numTasks)
+	{
+		m_taskCandidateBumperIndices.resize(numTasks);
+		m_taskNumSweptBalls.resize(numTasks);
+		m_taskNumSweepHits.resize(numTasks);
+	}
+
+	m_workerPool->ParallelFor(numTasks, [this, numTasks](int taskIndex)
+	{
+		int firstBall = 0;
+		int lastBall = 0;
+		GetBallTaskRange(taskIndex, numTasks, firstBall, lastBall);
+		BallsVsBumpersInRange(firstBall, lastBall, m_taskCandidateBumperIndices[taskIndex], m_taskNumSweptBalls[taskIndex], m_taskNumSweepHits[taskIndex]);
+	});
+
+	m_numSweptBalls = 0;
+	m_numSweepHits = 0;
+	for (int taskIndex = 0; taskIndex < numTasks; ++taskIndex)
+	{
+		m_numSweptBalls += m_taskNumSweptBalls[taskIndex];
+		m_numSweepHits += m_taskNumSweepHits[taskIndex];
+	}
+}
+
+void PachinkoSimulation::BallsVsBumpersInRange(int firstBall, int lastBall, std::vector<int>& candidateBumperIndices, int& out_numSweptBalls, int& out_numSweepHits)
+{
+	out_numSweptBalls = 0;
+	out_numSweepHits = 0;
+
+	for (int ballIndex = firstBall; ballIndex < lastBall; ++ballIndex)
+	{
+		Vec2 ballCenter(m_balls.m_positionX[ballIndex], m_balls.m_positionY[ballIndex]);
+		Vec2 ballVelocity(m_balls.m_velocityX[ballIndex], m_balls.m_velocityY[ballIndex]);
+		float ballRadius = m_balls.m_radius[ballIndex];
+		float ballElasticity = m_balls.m_elasticity[ballIndex];
+
+		// A ball that moved far enough this step to skip over a thin bumper is swept from where it started
+		Vec2 previousBallCenter(m_balls.m_previousPositionX[ballIndex], m_balls.m_previousPositionY[ballIndex]);
+		float minSweepDistance = CCD_MIN_TRAVEL_PER_RADIUS * ballRadius;
+		if (m_isContinuousCollisionOn && GetDistanceSquared2D(previousBallCenter, ballCenter) > minSweepDistance * minSweepDistance)
+		{
+			++out_numSweptBalls;
+			if (SweepBallVsBumpers(previousBallCenter, ballCenter, ballRadius, ballVelocity, ballElasticity, candidateBumperIndices))
+			{
+				++out_numSweepHits;
+			}
+		}
+
+		// The solver already pushed the ball out of any bumper it was resting on
+		if (!m_isContactSolverOn)
+		{
+			BounceBallOffBumpers(ballCenter, ballRadius, ballVelocity, ballElasticity, candidateBumperIndices);
+		}
+
+		m_balls.m_positionX[ballIndex] = ballCenter.x;
+		m_balls.m_positionY[ballIndex] = ballCenter.y;
+		m_balls.m_velocityX[ballIndex] = ballVelocity.x;
+		m_balls.m_velocityY[ballIndex] = ballVelocity.y;
+	}
+}
+
+void PachinkoSimulation::GatherCandidateBumpers(Vec2 const& queryMins, Vec2 const& queryMaxs, std::vector<int>& out_candidateBumperIndices) const
+{
+	// Gather the bumpers whose cells and bounds overlap the query box; a bumper spanning several cells is listed more than once
+	out_candidateBumperIndices.clear();
+
+	int minCellX = GetClampedGridCoord(queryMins.x, m_ballGridMins.x, m_ballGridCellSize, m_ballGridNumCellsX);
+	int maxCellX = GetClampedGridCoord(queryMaxs.x, m_ballGridMins.x, m_ballGridCellSize, m_ballGridNumCellsX);
+	int minCellY = GetClampedGridCoord(queryMins.y, m_ballGridMins.y, m_ballGridCellSize, m_ballGridNumCellsY);
+	int maxCellY = GetClampedGridCoord(queryMaxs.y, m_ballGridMins.y, m_ballGridCellSize, m_ballGridNumCellsY);
+
+	for (int cellY = minCellY; cellY <= maxCellY; ++cellY)
+	{
+		for (int cellX = minCellX; cellX <= maxCellX; ++cellX)
+		{
+			int cellIndex = cellX + cellY * m_ballGridNumCellsX;
+			for (int cellBumper = m_bumperGridCellStarts[cellIndex]; cellBumper < m_bumperGridCellStarts[cellIndex + 1]; ++cellBumper)
+			{
+				int bumperIndex = m_bumperGridBumperIndices[cellBumper];
+				AABB2 const& bounds = m_bumperBounds[bumperIndex];
+				if (queryMaxs.x < bounds.m_mins.x || queryMins.x > bounds.m_maxs.x || queryMaxs.y < bounds.m_mins.y || queryMins.y > bounds.m_maxs.y)
+				{
+					continue;
+				}
+				out_candidateBumperIndices.push_back(bumperIndex);
+			}
+		}
+	}
+
+	// Drop the repeats and keep bumper order, which also leaves the candidates grouped by type
+	std::sort(out_candidateBumperIndices.begin(), out_candidateBumperIndices.end());
+	out_candidateBumperIndices.erase(std::unique(out_candidateBumperIndices.begin(), out_candidateBumperIndices.end()), out_candidateBumperIndices.end());
+}
+
+bool PachinkoSimulation::SweepBallVsBumpers(Vec2 const& sweepStart, Vec2& ballCenter, float ballRadius, Vec2& ballVelocity, float ballElasticity, std::vector<int>& candidateBumperIndices) const
+{
+	Vec2 sweepDisplacement = ballCenter - sweepStart;
+	float sweepDistance = sweepDisplacement.GetLength();
+	Vec2 sweepDirection = sweepDisplacement / sweepDistance;
+
+	Vec2 sweepMins(fminf(sweepStart.x, ballCenter.x) - ballRadius, fminf(sweepStart.y, ballCenter.y) - ballRadius);
+	Vec2 sweepMaxs(fmaxf(sweepStart.x, ballCenter.x) + ballRadius, fmaxf(sweepStart.y, ballCenter.y) + ballRadius);
+
+	// Time of impact is the first hit along the path against each bumper grown by the ball radius
+	RaycastResult2D firstImpact;
+	float firstImpactElasticity = 0.f;
+
+	GatherCandidateBumpers(sweepMins, sweepMaxs, candidateBumperIndices);
+	int numCandidates = static_cast<int>(candidateBumperIndices.size());
+	int firstCapsule = static_cast<int>(m_bumpers.m_discs.size());
+	int firstBox = firstCapsule + static_cast<int>(m_bumpers.m_capsules.size());
+	int candidateIndex = 0;
+
+	for (; candidateIndex < numCandidates && candidateBumperIndices[candidateIndex] < firstCapsule; ++candidateIndex)
+	{
+		DiscBumper const& disc = m_bumpers.m_discs[candidateBumperIndices[candidateIndex]];
+		RaycastResult2D impact = SweepDiscVsDiscBumper(sweepStart, sweepDirection, sweepDistance, ballRadius, disc);
+		if (impact.m_didImpact && (!firstImpact.m_didImpact || impact.m_impactDist < firstImpact.m_impactDist))
+		{
+			firstImpact = impact;
+			firstImpactElasticity = disc.m_elasticity;
+		}
+	}
+
+	for (; candidateIndex < numCandidates && candidateBumperIndices[candidateIndex] < firstBox; ++candidateIndex)
+	{
+		CapsuleBumper const& capsule = m_bumpers.m_capsules[candidateBumperIndices[candidateIndex] - firstCapsule];
+		RaycastResult2D impact = SweepDiscVsCapsuleBumper(sweepStart, sweepDirection, sweepDistance, ballRadius, capsule);
+		if (impact.m_didImpact && (!firstImpact.m_didImpact || impact.m_impactDist < firstImpact.m_impactDist))
+		{
+			firstImpact = impact;
+			firstImpactElasticity = capsule.m_elasticity;
+		}
+	}
+
+	for (; candidateIndex < numCandidates; ++candidateIndex)
+	{
+		OBB2Bumper const& box = m_bumpers.m_boxes[candidateBumperIndices[candidateIndex] - firstBox];
+		RaycastResult2D impact = SweepDiscVsOBB2Bumper(sweepStart, sweepDirection, sweepDistance, ballRadius, box);
+		if (impact.m_didImpact && (!firstImpact.m_didImpact || impact.m_impactDist < firstImpact.m_impactDist))
+		{
+			firstImpact = impact;
+			firstImpactElasticity = box.m_elasticity;
+		}
+	}
+
+	if (!firstImpact.m_didImpact)
+	{
+		return false;
+	}
+
+	// Stop the ball just short of the contact and reflect it there; the overlap pass handles the rest of the contact
+	Vec2 impactNormal = firstImpact.m_impactNormal;
+	if (DotProduct2D(impactNormal, sweepDirection) > 0.f)
+	{
+		impactNormal = -impactNormal;
+	}
+	ballCenter = sweepStart + sweepDirection * fmaxf(firstImpact.m_impactDist - CCD_CONTACT_SKIN, 0.f);
+
+	float normalSpeed = DotProduct2D(ballVelocity, impactNormal);
+	if (normalSpeed < 0.f)
+	{
+		float elasticity = ballElasticity * firstImpactElasticity;
+		ballVelocity -= impactNormal * ((1.f + elasticity) * normalSpeed);
+	}
+	return true;
+}
+
+void PachinkoSimulation::BounceBallOffBumpers(Vec2& ballCenter, float ballRadius, Vec2& ballVelocity, float ballElasticity, std::vector<int>& candidateBumperIndices) const
+{
+	Vec2 ballMins = ballCenter - Vec2(ballRadius, ballRadius);
+	Vec2 ballMaxs = ballCenter + Vec2(ballRadius, ballRadius);
+
+	GatherCandidateBumpers(ballMins, ballMaxs, candidateBumperIndices);
+	int numCandidates = static_cast<int>(candidateBumperIndices.size());
+	int firstCapsule = static_cast<int>(m_bumpers.m_discs.size());
+	int firstBox = firstCapsule + static_cast<int>(m_bumpers.m_capsules.size());
+	int candidateIndex = 0;
+
+	// Candidates come sorted, so each type is one run and gets its own loop
+	for (; candidateIndex < numCandidates && candidateBumperIndices[candidateIndex] < firstCapsule; ++candidateIndex)
+	{
+		DiscBumper const& disc = m_bumpers.m_discs[candidateBumperIndices[candidateIndex]];
+		BounceDiscOffFixedDisc2D(ballCenter, ballRadius, ballVelocity, ballElasticity, disc.m_center, disc.m_radius, disc.m_elasticity);
+	}
+
+	for (; candidateIndex < numCandidates && candidateBumperIndices[candidateIndex] < firstBox; ++candidateIndex)
+	{
+		CapsuleBumper const& capsule = m_bumpers.m_capsules[candidateBumperIndices[candidateIndex] - firstCapsule];
+		Vec2 nearestPointOnCapsule = GetNearestPointOnCapsule2D(ballCenter, capsule.m_boneStart, capsule.m_boneEnd, capsule.m_radius);
+		float radiusSum = ballRadius + capsule.m_radius;
+		float radiusSumSquared = radiusSum * radiusSum;
+		float distanceSquaredCapsule = GetDistanceSquared2D(ballCenter, nearestPointOnCapsule);
+
+		if (distanceSquaredCapsule < radiusSumSquared)
+		{
+			BounceDiscOffFixedPoint(ballCenter, ballRadius, ballVelocity, ballElasticity, nearestPointOnCapsule, capsule.m_elasticity);
+		}
+	}
+
+	for (; candidateIndex < numCandidates; ++candidateIndex)
+	{
+		OBB2Bumper const& box = m_bumpers.m_boxes[candidateBumperIndices[candidateIndex] - firstBox];
+		Vec2 nearestPointOnOBB = GetNearestPointOnOBB2D(ballCenter, box.m_box);
+		float distanceSquared = GetDistanceSquared2D(ballCenter, nearestPointOnOBB);
+		float ballRadiusSquared = ballRadius * ballRadius;
+
+		if (distanceSquared < ballRadiusSquared)
+		{
+			BounceDiscOffFixedPoint(ballCenter, ballRadius, ballVelocity, ballElasticity, nearestPointOnOBB, box.m_elasticity);
+		}
+	}
+}
+
+void PachinkoSimulation::BallsVsWalls()
+{
+	// The solver already holds balls off the floor and side walls, and clamping them here too would
+	// undo its resting overlap every step and set piles jittering. Only the bottom warp is left.
+	if (m_isContactSolverOn && !m_isBottomWarpOn)
+	{
+		return;
+	}
+
+	int numTasks = m_workerPool->GetNumThreads();
+	m_workerPool->ParallelFor(numTasks, [this, numTasks](int taskIndex)
+	{
+		int firstBall = 0;
+		int lastBall = 0;
+		GetBallTaskRange(taskIndex, numTasks, firstBall, lastBall);
+		CheckNorthAndSouthWalls(firstBall, lastBall);
+		if (!m_isContactSolverOn)
+		{
+			CheckEastAndWestWalls(firstBall, lastBall);
+		}
+	});
+}
+
+void PachinkoSimulation::CheckEastAndWestWalls(int firstBall, int lastBall)
+{
+	BounceBallsOffSideWalls(m_balls, firstBall, lastBall, 0.f, SCREEN_SIZE_X, m_wallElasticity);
+}
+
+void PachinkoSimulation::CheckNorthAndSouthWalls(int firstBall, int lastBall)
+{
+	float warpY = SCREEN_SIZE_Y + static_cast<float>(m_extraWarpHeight);
+	BounceBallsOffFloorOrWarp(m_balls, firstBall, lastBall, 0.f, warpY, m_wallElasticity, m_isBottomWarpOn);
+}
+
+void PachinkoSimulation::WakeTouchedIslands()
+{
+	m_wakeIslandIds.clear();
+	for (int stripeIndex = 0; stripeIndex < static_cast<int>(m_stripeWakeIslandIds.size()); ++stripeIndex)
+	{
+		std::vector<int>& stripeWakeIslandIds = m_stripeWakeIslandIds[stripeIndex];
+		m_wakeIslandIds.insert(m_wakeIslandIds.end(), stripeWakeIslandIds.begin(), stripeWakeIslandIds.end());
+		stripeWakeIslandIds.clear();
+	}
+
+	WakeIslands();
+}
+
+void PachinkoSimulation::WakeIslands()
+{
+	if (m_wakeIslandIds.empty())
+	{
+		return;
+	}
+
+	std::sort(m_wakeIslandIds.begin(), m_wakeIslandIds.end());
+	m_wakeIslandIds.erase(std::unique(m_wakeIslandIds.begin(), m_wakeIslandIds.end()), m_wakeIslandIds.end());
+
+	// Waking swaps the ball with the first sleeper, which is never past it, so walking upwards visits every sleeper once
+	for (int ballIndex = m_balls.GetNumAwakeBalls(); ballIndex < m_balls.GetNumBalls(); ++ballIndex)
+	{
+		if (std::binary_search(m_wakeIslandIds.begin(), m_wakeIslandIds.end(), m_balls.m_islandId[ballIndex]))
+		{
+			m_balls.WakeBall(ballIndex);
+		}
+	}
+
+	m_isSleepingGridDirty = true;
+}
+
+void PachinkoSimulation::PutRestingIslandsToSleep()
+{
+	if (!m_isSleepingOn)
+	{
+		return;
+	}
+
+	int numAwakeBalls = m_balls.GetNumAwakeBalls();
+	int numTasks = m_workerPool->GetNumThreads();
+	m_taskNumReadyToSleep.resize(numTasks);
+	m_workerPool->ParallelFor(numTasks, [this, numTasks](int taskIndex)
+	{
+		int firstBall = 0;
+		int lastBall = 0;
+		GetBallTaskRange(taskIndex, numTasks, firstBall, lastBall);
+		m_taskNumReadyToSleep[taskIndex] = UpdateBallRestingSteps(m_balls, firstBall, lastBall, m_sleepSpeed, m_numStepsToSleep);
+	});
+
+	int numReadyToSleep = 0;
+	for (int taskIndex = 0; taskIndex < numTasks; ++taskIndex)
+	{
+		numReadyToSleep += m_taskNumReadyToSleep[taskIndex];
+	}
+
+	if (numReadyToSleep > 0)
+	{
+		// Join touching awake balls into islands
+		for (int ballIndex = 0; ballIndex < numAwakeBalls; ++ballIndex)
+		{
+			m_islandParents[ballIndex] = ballIndex;
+			m_islandIsResting[ballIndex] = 1;
+			m_islandSleepIds[ballIndex] = -1;
+		}
+		for (int stripeIndex = 0; stripeIndex < static_cast<int>(m_stripeBallContacts.size()); ++stripeIndex)
+		{
+			std::vector<int> const& ballContacts = m_stripeBallContacts[stripeIndex];
+			for (int contactIndex = 0; contactIndex < static_cast<int>(ballContacts.size()); contactIndex += 2)
+			{
+				int rootA = FindIslandRoot(ballContacts[contactIndex]);
+				int rootB = FindIslandRoot(ballContacts[contactIndex + 1]);
+				m_islandParents[std::max(rootA, rootB)] = std::min(rootA, rootB);
+			}
+		}
+
+		// An island rests only if every ball in it does
+		for (int ballIndex = 0; ballIndex < numAwakeBalls; ++ballIndex)
+		{
+			if (m_balls.m_numRestingSteps[ballIndex] < m_numStepsToSleep)
+			{
+				m_islandIsResting[FindIslandRoot(ballIndex)] = 0;
+			}
+		}
+
+		// Islands leaning on a sleeping island join it, unless that island was just woken
+		for (int stripeIndex = 0; stripeIndex < static_cast<int>(m_stripeSleeperContacts.size()); ++stripeIndex)
+		{
+			std::vector<int> const& sleeperContacts = m_stripeSleeperContacts[stripeIndex];
+			for (int contactIndex = 0; contactIndex < static_cast<int>(sleeperContacts.size()); contactIndex += 2)
+			{
+				int islandId = sleeperContacts[contactIndex + 1];
+				if (!std::binary_search(m_wakeIslandIds.begin(), m_wakeIslandIds.end(), islandId))
+				{
+					m_islandSleepIds[FindIslandRoot(sleeperContacts[contactIndex])] = islandId;
+				}
+			}
+		}
+
+		m_ballsToSleep.clear();
+		for (int ballIndex = 0; ballIndex < numAwakeBalls; ++ballIndex)
+		{
+			int root = FindIslandRoot(ballIndex);
+			if (m_islandIsResting[root] == 0)
+			{
+				continue;
+			}
+			if (m_islandSleepIds[root] < 0)
+			{
+				m_islandSleepIds[root] = m_nextIslandId;
+				++m_nextIslandId;
+			}
+			m_ballsToSleep.push_back(ballIndex);
+		}
+
+		// Sleeping swaps the ball with the last awake one, which is never before it, so go downwards
+		for (int sleepIndex = static_cast<int>(m_ballsToSleep.size()) - 1; sleepIndex >= 0; --sleepIndex)
+		{
+			int ballIndex = m_ballsToSleep[sleepIndex];
+			m_balls.PutBallToSleep(ballIndex, m_islandSleepIds[FindIslandRoot(ballIndex)]);
+		}
+
+		if (!m_ballsToSleep.empty())
+		{
+			m_isSleepingGridDirty = true;
+		}
+	}
+
+	for (int stripeIndex = 0; stripeIndex < static_cast<int>(m_stripeBallContacts.size()); ++stripeIndex)
+	{
+		m_stripeBallContacts[stripeIndex].clear();
+		m_stripeSleeperContacts[stripeIndex].clear();
+	}
+}
+
+int PachinkoSimulation::FindIslandRoot(int ballIndex)
+{
+	while (m_islandParents[ballIndex] != ballIndex)
+	{
+		m_islandParents[ballIndex] = m_islandParents[m_islandParents[ballIndex]];
+		ballIndex = m_islandParents[ballIndex];
+	}
+	return ballIndex;
+}
+
+void PachinkoSimulation::GetBallTaskRange(int taskIndex, int numTasks, int& out_firstBall, int& out_lastBall) const
+{
+	// Split the awake balls on SIMD_WIDTH boundaries so every ball takes the same kernel path whatever the thread count
+	int numBalls = m_balls.GetNumAwakeBalls();
+	int numBlocks = (numBalls + SIMD_WIDTH - 1) / SIMD_WIDTH;
+	out_firstBall = std::min(numBalls, (numBlocks * taskIndex / numTasks) * SIMD_WIDTH);
+	out_lastBall = std::min(numBalls, (numBlocks * (taskIndex + 1) / numTasks) * SIMD_WIDTH);
+}
+
+void PachinkoSimulation::InitializeBallGrid()
+{
+	// Cells are one max ball diameter wide, so any two touching balls sit in the same or adjacent cells
+	m_ballGridCellSize = 2.f * m_pachinkoMaxBallRadius;
+	if (m_ballGridCellSize <= 0.f)
+	{
+		m_ballGridCellSize = 1.f;
+	}
+
+	// Cover the screen plus the warp zone above it; anything outside is clamped into the border cells
+	m_ballGridMins = Vec2::ZERO;
+	float gridHeight = SCREEN_SIZE_Y + m_pachinkoMaxBallRadius + static_cast<float>(m_extraWarpHeight);
+	m_ballGridNumCellsX = static_cast<int>(ceilf(SCREEN_SIZE_X / m_ballGridCellSize));
+	m_ballGridNumCellsY = static_cast<int>(ceilf(gridHeight / m_ballGridCellSize));
+
+	int numCells = m_ballGridNumCellsX * m_ballGridNumCellsY;
+	m_ballGridCellStarts.resize(numCells + 1);
+	m_ballGridCellCursors.resize(numCells);
+
+	m_sleepingGridCellStarts.resize(numCells + 1);
+
+	// Sized for a full ball pool up front so rebuilding the grids or islands never allocates
+	int capacity = m_balls.GetCapacity();
+	m_ballCellIndices.resize(capacity);
+	m_ballGridBallIndices.resize(capacity);
+	m_sleepingGridBallIndices.resize(capacity);
+	m_islandParents.resize(capacity);
+	m_islandIsResting.resize(capacity);
+	m_islandSleepIds.resize(capacity);
+	m_ballsToSleep.reserve(capacity);
+}
+
+void PachinkoSimulation::BuildBallGrid(int firstBall, int lastBall, std::vector<int>& cellStarts, std::vector<int>& cellBallIndices)
+{
+	int numCells = m_ballGridNumCellsX * m_ballGridNumCellsY;
+
+	std::fill(cellStarts.begin(), cellStarts.end(), 0);
+
+	// Count balls per cell
+	for (int ballIndex = firstBall; ballIndex < lastBall; ++ballIndex)
+	{
+		int cellIndex = GetBallGridCellIndex(Vec2(m_balls.m_positionX[ballIndex], m_balls.m_positionY[ballIndex]));
+		m_ballCellIndices[ballIndex - firstBall] = cellIndex;
+		++cellStarts[cellIndex + 1];
+	}
+
+	// Prefix sum into start offsets
+	for (int cellIndex = 0; cellIndex < numCells; ++cellIndex)
+	{
+		cellStarts[cellIndex + 1] += cellStarts[cellIndex];
+		m_ballGridCellCursors[cellIndex] = cellStarts[cellIndex];
+	}
+
+	// Scatter ball indices, keeping them ascending within each cell
+	for (int ballIndex = firstBall; ballIndex < lastBall; ++ballIndex)
+	{
+		int cellIndex = m_ballCellIndices[ballIndex - firstBall];
+		cellBallIndices[m_ballGridCellCursors[cellIndex]] = ballIndex;
+		++m_ballGridCellCursors[cellIndex];
+	}
+}
+
+int PachinkoSimulation::GetBallGridCellIndex(Vec2 const& position) const
+{
+	int cellX = GetClampedGridCoord(position.x, m_ballGridMins.x, m_ballGridCellSize, m_ballGridNumCellsX);
+	int cellY = GetClampedGridCoord(position.y, m_ballGridMins.y, m_ballGridCellSize, m_ballGridNumCellsY);
+	return cellX + cellY * m_ballGridNumCellsX;
+}
+
+void PachinkoSimulation::RandomizeFixedShapes(RandomNumberGenerator& rng)
+{
+	m_bumpers.Clear();
+	ClearBalls();
+
+	// Randomizing Discs
+	for (int discsIndex = 0; discsIndex < m_numFixedDiscs; ++discsIndex)
+	{
+		DiscBumper newDisc;
+		newDisc.m_center = Vec2(rng.RollRandomFloatInRange(0.f, SCREEN_SIZE_X), rng.RollRandomFloatInRange(0.f, SCREEN_SIZE_Y));
+		newDisc.m_radius = rng.RollRandomFloatInRange(m_fixedDiscMinRadius, m_fixedDiscMaxRadius);
+
+		newDisc.m_elasticity = rng.RollRandomFloatInRange(m_minElasticity, m_maxElasticity);
+		float elasticityAmount = RangeMap(newDisc.m_elasticity, m_minElasticity, m_maxElasticity, 0.f, 1.f);
+		newDisc.m_color = newDisc.m_color.Rgba8Interpolate(Rgba8::RED, Rgba8::GREEN, elasticityAmount);
+
+		m_bumpers.m_discs.push_back(newDisc);
+	}
+
+	// Randomizing Capsules
+	for (int capsulesIndex = 0; capsulesIndex < m_numFixedCapsules; ++capsulesIndex)
+	{
+		CapsuleBumper newCapsule;
+		Vec2 center = Vec2(rng.RollRandomFloatInRange(50.f, SCREEN_SIZE_X - 50.f),
+			rng.RollRandomFloatInRange(50.f, SCREEN_SIZE_Y - 50.f));
+
+		float angleDegrees = rng.RollRandomFloatInRange(0.f, 360.f);
+		float length = rng.RollRandomFloatInRange(m_minCapsuleLength, m_maxCapsuleLength);
+		float halfLength = length * 0.5f;
+		Vec2 direction = Vec2::MakeFromPolarDegrees(angleDegrees);
+
+		newCapsule.m_boneStart = center - direction * halfLength;
+		newCapsule.m_boneEnd = center + direction * halfLength;
+		newCapsule.m_radius = rng.RollRandomFloatInRange(m_minCapsuleRadius, m_maxCapsuleRadius);
+
+		newCapsule.m_elasticity = rng.RollRandomFloatInRange(m_minElasticity, m_maxElasticity);
+		float elasticityAmount = RangeMap(newCapsule.m_elasticity, m_minElasticity, m_maxElasticity, 0.f, 1.f);
+		newCapsule.m_color = newCapsule.m_color.Rgba8Interpolate(Rgba8::RED, Rgba8::GREEN, elasticityAmount);
+
+		m_bumpers.m_capsules.push_back(newCapsule);
+	}
+
+	// Randomizing OBB2s
+	for (int obbIndex = 0; obbIndex < m_numFixedOBB2s; ++obbIndex)
+	{
+		OBB2Bumper newOBB;
+
+		float halfWidth = rng.RollRandomFloatInRange(m_minOBBwidth, m_maxOBBwidth);
+		float halfHeight = rng.RollRandomFloatInRange(m_minOBBwidth, m_maxOBBwidth);
+		Vec2 boxCenter(rng.RollRandomFloatInRange(50.f + halfWidth, SCREEN_SIZE_X - 50.f - halfWidth), rng.RollRandomFloatInRange(50.f + halfHeight, SCREEN_SIZE_Y - 50.f - halfHeight));
+		float angle = rng.RollRandomFloatInRange(0.f, 360.f);
+		Vec2 iBasisNormal(CosDegrees(angle), SinDegrees(angle));
+		newOBB.m_box = OBB2(boxCenter, iBasisNormal, Vec2(halfWidth, halfHeight));
+
+		newOBB.m_elasticity = rng.RollRandomFloatInRange(m_minElasticity, m_maxElasticity);
+		float elasticityAmount = RangeMap(newOBB.m_elasticity, m_minElasticity, m_maxElasticity, 0.f, 1.f);
+		newOBB.m_color = newOBB.m_color.Rgba8Interpolate(Rgba8::RED, Rgba8::GREEN, elasticityAmount);
+
+		m_bumpers.m_boxes.push_back(newOBB);
+	}
+
+	BuildBumperGrid();
+	if (m_recorder != nullptr)
+	{
+		m_recorder->RecordBumpers(m_bumpers);
+	}
+}
+
+void PachinkoSimulation::SetBumpers(PachinkoBumpers const& bumpers)
+{
+	ClearBalls();
+	m_bumpers = bumpers;
+
+	BuildBumperGrid();
+	if (m_recorder != nullptr)
+	{
+		m_recorder->RecordBumpers(m_bumpers);
+	}
+}
+
+void PachinkoSimulation::ClearBalls()
+{
+	// A new layout starts from the same state as a freshly made simulation, so replays line up
+	m_balls.Clear();
+	m_contactSolver.ForgetAllBalls();
+	m_nextIslandId = 0;
+	m_isSleepingGridDirty = true;
+}
+
+void PachinkoSimulation::BuildBumperGrid()
+{
+	// One bounds array over every bumper, discs then capsules then boxes
+	m_bumperBounds.clear();
+	for (int discIndex = 0; discIndex < static_cast<int>(m_bumpers.m_discs.size()); ++discIndex)
+	{
+		m_bumperBounds.push_back(GetDiscBumperBounds(m_bumpers.m_discs[discIndex]));
+	}
+	for (int capsuleIndex = 0; capsuleIndex < static_cast<int>(m_bumpers.m_capsules.size()); ++capsuleIndex)
+	{
+		m_bumperBounds.push_back(GetCapsuleBumperBounds(m_bumpers.m_capsules[capsuleIndex]));
+	}
+	for (int boxIndex = 0; boxIndex < static_cast<int>(m_bumpers.m_boxes.size()); ++boxIndex)
+	{
+		m_bumperBounds.push_back(GetOBB2BumperBounds(m_bumpers.m_boxes[boxIndex]));
+	}
+
+	// Bumpers share the ball grid's cell layout; each one is listed in every cell its bounds touch
+	int numCells = m_ballGridNumCellsX * m_ballGridNumCellsY;
+	m_bumperGridCellStarts.assign(numCells + 1, 0);
+
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		std::vector<int> cellCursors(m_bumperGridCellStarts.begin(), m_bumperGridCellStarts.end() - 1);
+
+		for (int bumperIndex = 0; bumperIndex < static_cast<int>(m_bumperBounds.size()); ++bumperIndex)
+		{
+			AABB2 const& bounds = m_bumperBounds[bumperIndex];
+			int minCellX = GetClampedGridCoord(bounds.m_mins.x, m_ballGridMins.x, m_ballGridCellSize, m_ballGridNumCellsX);
+			int maxCellX = GetClampedGridCoord(bounds.m_maxs.x, m_ballGridMins.x, m_ballGridCellSize, m_ballGridNumCellsX);
+			int minCellY = GetClampedGridCoord(bounds.m_mins.y, m_ballGridMins.y, m_ballGridCellSize, m_ballGridNumCellsY);
+			int maxCellY = GetClampedGridCoord(bounds.m_maxs.y, m_ballGridMins.y, m_ballGridCellSize, m_ballGridNumCellsY);
+
+			for (int cellY = minCellY; cellY <= maxCellY; ++cellY)
+			{
+				for (int cellX = minCellX; cellX <= maxCellX; ++cellX)
+				{
+					int cellIndex = cellX + cellY * m_ballGridNumCellsX;
+					if (pass == 0)
+					{
+						++m_bumperGridCellStarts[cellIndex + 1];
+					}
+					else
+					{
+						m_bumperGridBumperIndices[cellCursors[cellIndex]] = bumperIndex;
+						++cellCursors[cellIndex];
+					}
+				}
+			}
+		}
+
+		// After counting, turn the per-cell counts into start offsets
+		if (pass == 0)
+		{
+			for (int cellIndex = 0; cellIndex < numCells; ++cellIndex)
+			{
+				m_bumperGridCellStarts[cellIndex + 1] += m_bumperGridCellStarts[cellIndex];
+			}
+			m_bumperGridBumperIndices.resize(m_bumperGridCellStarts[numCells]);
+		}
+	}
+}
+
+void PachinkoSimulation::DespawnBall(int ballIndex)
+{
+	if (m_recorder != nullptr)
+	{
+		m_recorder->RecordDespawn(ballIndex);
+	}
+
+	// Anything resting on a sleeping ball may have just lost its support
+	int islandId = m_balls.m_islandId[ballIndex];
+	bool wasAwake = m_balls.IsBallAwake(ballIndex);
+	m_balls.RemoveBall(ballIndex);
+
+	if (!wasAwake)
+	{
+		m_wakeIslandIds.clear();
+		m_wakeIslandIds.push_back(islandId);
+		WakeIslands();
+	}
+	if (m_balls.GetNumSleepingBalls() > 0)
+	{
+		m_isSleepingGridDirty = true;
+	}
+}
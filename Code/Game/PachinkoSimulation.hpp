@@ -0,0 +1,279 @@
+#pragma once
+#include "Engine/Math/AABB2.h"
+#include "Engine/Math/OBB2.hpp"
+#include "Engine/Core/Rgba8.h"
+#include "Game/PachinkoBalls.hpp"
+#include "Game/PachinkoContactSolver.hpp"
+#include <vector>
+// -----------------------------------------------------------------------------
+class PachinkoRecorder;
+class RandomNumberGenerator;
+class WorkerPool;
+// -----------------------------------------------------------------------------
+// Ball grid columns are resolved in stripes this many cells wide; must be at least 2
+// so that same-parity stripes never touch the same column
+const int BALL_GRID_STRIPE_WIDTH = 2;
+
+// Balls that move further than this many radii in a step are swept against the bumpers,
+// and a swept ball is stopped this far short of the surface it hits
+const float CCD_MIN_TRAVEL_PER_RADIUS = 0.5f;
+const float CCD_CONTACT_SKIN = 0.01f;
+// -----------------------------------------------------------------------------
+enum PachinkoPhase
+{
+	PACHINKO_PHASE_INTEGRATE,
+	PACHINKO_PHASE_BALLS_VS_BALLS,
+	PACHINKO_PHASE_BALLS_VS_BUMPERS,
+	PACHINKO_PHASE_WALLS,
+	PACHINKO_PHASE_SLEEP,
+	PACHINKO_PHASE_COUNT
+};
+
+char const* GetPachinkoPhaseName(PachinkoPhase phase);
+// -----------------------------------------------------------------------------
+struct DiscBumper
+{
+	Vec2  m_center = Vec2::ZERO;
+	float m_radius = 0.f;
+
+	float m_elasticity = 0.9f;
+	Rgba8 m_color = Rgba8::WHITE;
+};
+
+struct CapsuleBumper
+{
+	Vec2  m_boneStart = Vec2::ZERO;
+	Vec2  m_boneEnd = Vec2::ZERO;
+	float m_radius = 0.f;
+
+	float m_elasticity = 0.9f;
+	Rgba8 m_color = Rgba8::WHITE;
+};
+
+struct OBB2Bumper
+{
+	OBB2  m_box;
+
+	float m_elasticity = 0.9f;
+	Rgba8 m_color = Rgba8::WHITE;
+};
+
+// Each bumper type lives in its own contiguous array, so collision and drawing
+// loop over only the bumpers that really are that type. Where one index has to
+// cover every bumper, discs come first, then capsules, then boxes.
+struct PachinkoBumpers
+{
+	int  GetNumBumpers() const { return static_cast<int>(m_discs.size() + m_capsules.size() + m_boxes.size()); }
+	void Clear();
+
+	std::vector<DiscBumper>	   m_discs;
+	std::vector<CapsuleBumper> m_capsules;
+	std::vector<OBB2Bumper>	   m_boxes;
+};
+
+AABB2 GetDiscBumperBounds(DiscBumper const& disc);
+AABB2 GetCapsuleBumperBounds(CapsuleBumper const& capsule);
+AABB2 GetOBB2BumperBounds(OBB2Bumper const& box);
+// -----------------------------------------------------------------------------
+// The config values Step depends on, which a recording carries so its replay steps the same
+// whatever config it is run under
+struct PachinkoStepConfig
+{
+	int	  m_maxNumBalls = 0;
+	float m_maxBallRadius = 0.f;
+	float m_wallElasticity = 0.f;
+	int	  m_extraWarpHeight = 0;
+	float m_sleepSpeed = 0.f;
+	int	  m_numStepsToSleep = 0;
+};
+// -----------------------------------------------------------------------------
+// The pachinko physics on their own, with no Renderer, Window or Input, so the same
+// step runs in Game2DPachinko and in the headless benchmark. Settings are read from
+// g_gameConfigBlackboard when constructed.
+// -----------------------------------------------------------------------------
+class PachinkoSimulation
+{
+public:
+	PachinkoSimulation();
+	~PachinkoSimulation();
+
+	void InitializeGameConfigElements();
+
+	void RandomizeFixedShapes(RandomNumberGenerator& rng);
+	void SetBumpers(PachinkoBumpers const& bumpers);
+	bool SpawnBall(Vec2 const& center, float radius, Vec2 const& velocity, float elasticity, Rgba8 const& color);
+	void DespawnBall(int ballIndex);
+	void AdjustBallElasticity(float deltaElasticity);
+	void Step(float deltaSeconds);
+
+	// Everything done to the simulation through the calls above is written to the recorder while one is set
+	void SetRecorder(PachinkoRecorder* recorder);
+	unsigned long long GetBallStateChecksum() const;
+
+	void ToggleBottomWarp();
+	void ToggleBallGrid();
+	void ToggleSleeping();
+	void ToggleContinuousCollision();
+	void ToggleContactSolver();
+	void SetSolverIterations(int numIterations);
+
+	// A different pool size or ball grid empties the pool, so this belongs before any spawns
+	PachinkoStepConfig GetStepConfig() const;
+	void SetStepConfig(PachinkoStepConfig const& stepConfig);
+	bool IsBottomWarpOn() const { return m_isBottomWarpOn; }
+	bool IsBallGridOn() const	{ return m_isBallGridOn; }
+	bool IsSleepingOn() const	{ return m_isSleepingOn; }
+	bool IsContinuousCollisionOn() const { return m_isContinuousCollisionOn; }
+	bool IsContactSolverOn() const		{ return m_isContactSolverOn; }
+	int  GetSolverIterations() const	{ return m_contactSolver.GetNumIterations(); }
+
+	PachinkoBalls&		 GetBalls()				  { return m_balls; }
+	PachinkoBalls const& GetBalls() const		  { return m_balls; }
+	PachinkoBumpers const& GetBumpers() const	  { return m_bumpers; }
+	float  GetMinBallRadius() const			  { return m_pachinkoMinBallRadius; }
+	float  GetMaxBallRadius() const			  { return m_pachinkoMaxBallRadius; }
+	float  GetWallElasticity() const		  { return m_wallElasticity; }
+	int	   GetExtraWarpHeight() const		  { return m_extraWarpHeight; }
+	int	   GetNumCandidateBallPairs() const	  { return m_numCandidateBallPairs; }
+	int	   GetNumSweptBalls() const			  { return m_numSweptBalls; }
+	int	   GetNumSweepHits() const			  { return m_numSweepHits; }
+	int	   GetNumSolverContacts() const		  { return m_numSolverContacts; }
+	int	   GetNumThreads() const;
+	float  GetMaxAwakeBallSpeed() const;
+	double GetLastStepPhaseSeconds(PachinkoPhase phase) const { return m_lastStepPhaseSeconds[phase]; }
+
+	// Phase timing can be switched off so Step reads no clocks; the accumulated times sum every Step since the last reset
+	void SetPhaseTimingOn(bool isPhaseTimingOn) { m_isPhaseTimingOn = isPhaseTimingOn; }
+	bool IsPhaseTimingOn() const				{ return m_isPhaseTimingOn; }
+	void ResetAccumulatedPhaseSeconds();
+	double GetAccumulatedPhaseSeconds(PachinkoPhase phase) const { return m_accumulatedPhaseSeconds[phase]; }
+
+private:
+	// Physics checks
+	void ApplyGravityAndMoveBalls(float deltaSeconds);
+	void BallsVsBalls(float deltaSeconds);
+	void BallsVsBallsBruteForce();
+	void BallsVsBallsUniformGrid();
+	void ResolveBallGridStripe(int stripeIndex);
+	bool BounceBallsOffEachOther(int ballIndexA, int ballIndexB, int stripeIndex);
+	void SolveBallContacts(int numContactLists);
+	void TouchSleepingBallsNearBall(int ballIndex, int cellX, int cellY, int stripeIndex);
+	void TouchSleepingBall(int awakeBallIndex, int sleepingBallIndex, int stripeIndex);
+	void AddBumperContacts(int ballIndex, int stripeIndex);
+	void BallsVsBumpers();
+	void BallsVsBumpersInRange(int firstBall, int lastBall, std::vector<int>& candidateBumperIndices, int& out_numSweptBalls, int& out_numSweepHits);
+	void GatherCandidateBumpers(Vec2 const& queryMins, Vec2 const& queryMaxs, std::vector<int>& out_candidateBumperIndices) const;
+	bool SweepBallVsBumpers(Vec2 const& sweepStart, Vec2& ballCenter, float ballRadius, Vec2& ballVelocity, float ballElasticity, std::vector<int>& candidateBumperIndices) const;
+	void BounceBallOffBumpers(Vec2& ballCenter, float ballRadius, Vec2& ballVelocity, float ballElasticity, std::vector<int>& candidateBumperIndices) const;
+	void BallsVsWalls();
+	void WakeTouchedIslands();
+	void WakeIslands();
+	void PutRestingIslandsToSleep();
+	int  FindIslandRoot(int ballIndex);
+
+	void CheckEastAndWestWalls(int firstBall, int lastBall);
+	void CheckNorthAndSouthWalls(int firstBall, int lastBall);
+	void GetBallTaskRange(int taskIndex, int numTasks, int& out_firstBall, int& out_lastBall) const;
+	void EndPhase(PachinkoPhase phase, double& phaseStartSeconds);
+
+	void ClearBalls();
+
+	void InitializeBallGrid();
+	void BuildBallGrid(int firstBall, int lastBall, std::vector<int>& cellStarts, std::vector<int>& cellBallIndices);
+	int  GetBallGridCellIndex(Vec2 const& position) const;
+	void BuildBumperGrid();
+// -----------------------------------------------------------------------------
+private:
+	PachinkoBumpers m_bumpers;
+	PachinkoBalls m_balls;
+	bool m_isBottomWarpOn = true;
+
+	float  m_pachinkoMinBallRadius = 0.f;
+	float  m_pachinkoMaxBallRadius = 0.f;
+	int    m_maxNumBalls = 0;
+
+	// Ball broadphase
+	bool  m_isBallGridOn = true;
+	float m_ballGridCellSize = 0.f;
+	Vec2  m_ballGridMins = Vec2::ZERO;
+	int   m_ballGridNumCellsX = 0;
+	int   m_ballGridNumCellsY = 0;
+	int   m_numCandidateBallPairs = 0;
+	std::vector<int> m_ballGridCellStarts;
+	std::vector<int> m_ballGridCellCursors;
+	std::vector<int> m_ballGridBallIndices;
+	std::vector<int> m_ballCellIndices;
+	std::vector<std::vector<int>> m_stripeCandidateBallIndices;
+	std::vector<int> m_stripeCandidatePairCounts;
+
+	// Sleeping balls only collide with awake ones, through their own grid that is rebuilt only when the sleeping set changes.
+	// Balls that touch are put to sleep together as an island and woken together when a moving ball hits any of them.
+	bool  m_isSleepingOn = true;
+	float m_sleepSpeed = 0.f;
+	int   m_numStepsToSleep = 0;
+	int   m_nextIslandId = 0;
+	bool  m_isSleepingGridDirty = true;
+	std::vector<int> m_sleepingGridCellStarts;
+	std::vector<int> m_sleepingGridBallIndices;
+	std::vector<std::vector<int>> m_stripeBallContacts;
+	std::vector<std::vector<int>> m_stripeSleeperContacts;
+	std::vector<std::vector<int>> m_stripeWakeIslandIds;
+	std::vector<int> m_taskNumReadyToSleep;
+	std::vector<int> m_wakeIslandIds;
+	std::vector<int> m_islandParents;
+	std::vector<int> m_islandIsResting;
+	std::vector<int> m_islandSleepIds;
+	std::vector<int> m_ballsToSleep;
+
+	// Ball-ball, ball-wall and ball-bumper contacts go through the sequential-impulse solver instead of bouncing pair by pair.
+	// Contacts are listed per stripe, so the solve can run stripes of one parity at a time like the bounce.
+	bool m_isContactSolverOn = false;
+	int  m_numSolverContacts = 0;
+	PachinkoContactSolver m_contactSolver;
+	std::vector<PachinkoContactList> m_stripeSolverContacts;
+	std::vector<std::vector<int>> m_stripeCandidateBumperIndices;
+
+	// Bumper acceleration grid over all bumper types, rebuilt only when the bumpers change
+	std::vector<AABB2> m_bumperBounds;
+	std::vector<int> m_bumperGridCellStarts;
+	std::vector<int> m_bumperGridBumperIndices;
+	std::vector<std::vector<int>> m_taskCandidateBumperIndices;
+
+	// Swept-disc continuous collision against the bumpers, for balls fast enough to tunnel
+	bool m_isContinuousCollisionOn = true;
+	int  m_numSweptBalls = 0;
+	int  m_numSweepHits = 0;
+	std::vector<int> m_taskNumSweptBalls;
+	std::vector<int> m_taskNumSweepHits;
+
+	// Recording, not owned
+	PachinkoRecorder* m_recorder = nullptr;
+
+	// Threading
+	WorkerPool* m_workerPool = nullptr;
+
+	// Wall-clock time each phase took in the last Step, and in every Step since the last reset
+	bool   m_isPhaseTimingOn = true;
+	double m_lastStepPhaseSeconds[PACHINKO_PHASE_COUNT] = {};
+	double m_accumulatedPhaseSeconds[PACHINKO_PHASE_COUNT] = {};
+
+	int    m_numFixedDiscs = 0;
+	float  m_fixedDiscMinRadius = 0.f;
+	float  m_fixedDiscMaxRadius = 0.f;
+
+	int    m_numFixedCapsules = 0;
+	float  m_minCapsuleLength = 0.f;
+	float  m_maxCapsuleLength = 0.f;
+	float  m_minCapsuleRadius = 0.f;
+	float  m_maxCapsuleRadius = 0.f;
+
+	int    m_numFixedOBB2s = 0;
+	float  m_minOBBwidth = 0.0f;
+	float  m_maxOBBwidth = 0.0f;
+
+	// Elasticity
+	float m_wallElasticity = 0.0f;
+	float m_minElasticity = 0.0f;
+	float m_maxElasticity = 0.0f;
+	int   m_extraWarpHeight = 0;
+};
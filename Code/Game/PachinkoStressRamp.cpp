@@ -0,0 +1,107 @@
+#include "Game/PachinkoStressRamp.hpp"
+
+// Frame times are smoothed with this much of each new frame so single hitches don't end the ramp
+const float STRESS_FRAME_SMOOTHING = 0.1f;
+
+// A hitch can't turn into a burst of spawns bigger than this much time's worth
+const float STRESS_MAX_SPAWN_SECONDS = 0.1f;
+
+PachinkoStressRamp::PachinkoStressRamp(float spawnsPerSecond, float frameBudgetSeconds, int numOverBudgetFrames, int sampleBallInterval)
+	:m_spawnsPerSecond(spawnsPerSecond)
+	,m_frameBudgetSeconds(frameBudgetSeconds)
+	,m_numOverBudgetFrames(numOverBudgetFrames)
+	,m_sampleBallInterval(sampleBallInterval)
+{
+	if (m_numOverBudgetFrames < 1)
+	{
+		m_numOverBudgetFrames = 1;
+	}
+	if (m_sampleBallInterval < 1)
+	{
+		m_sampleBallInterval = 1;
+	}
+}
+
+void PachinkoStressRamp::Start(int numBalls)
+{
+	m_isRunning = true;
+	m_result = PACHINKO_STRESS_RESULT_NONE;
+	m_spawnDebt = 0.f;
+	m_smoothedFrameSeconds = 0.f;
+	m_peakFrameSeconds = 0.f;
+	m_numFramesOverBudget = 0;
+	m_maxSustainableBalls = numBalls;
+	m_nextSampleNumBalls = numBalls;
+	m_samples.clear();
+}
+
+void PachinkoStressRamp::Stop()
+{
+	if (m_isRunning)
+	{
+		Finish(PACHINKO_STRESS_RESULT_STOPPED);
+	}
+}
+
+int PachinkoStressRamp::Update(float frameSeconds, int numBalls, bool isPoolFull)
+{
+	if (!m_isRunning)
+	{
+		return 0;
+	}
+
+	if (m_smoothedFrameSeconds == 0.f)
+	{
+		m_smoothedFrameSeconds = frameSeconds;
+	}
+	m_smoothedFrameSeconds += (frameSeconds - m_smoothedFrameSeconds) * STRESS_FRAME_SMOOTHING;
+	if (m_smoothedFrameSeconds > m_peakFrameSeconds)
+	{
+		m_peakFrameSeconds = m_smoothedFrameSeconds;
+	}
+
+	if (numBalls >= m_nextSampleNumBalls)
+	{
+		PachinkoStressSample sample;
+		sample.m_numBalls = numBalls;
+		sample.m_frameSeconds = m_smoothedFrameSeconds;
+		m_samples.push_back(sample);
+		m_nextSampleNumBalls = numBalls + m_sampleBallInterval;
+	}
+
+	if (m_smoothedFrameSeconds > m_frameBudgetSeconds)
+	{
+		++m_numFramesOverBudget;
+		if (m_numFramesOverBudget >= m_numOverBudgetFrames)
+		{
+			Finish(PACHINKO_STRESS_RESULT_OVER_BUDGET);
+			return 0;
+		}
+	}
+	else
+	{
+		m_numFramesOverBudget = 0;
+		if (numBalls > m_maxSustainableBalls)
+		{
+			m_maxSustainableBalls = numBalls;
+		}
+	}
+
+	if (isPoolFull)
+	{
+		Finish(PACHINKO_STRESS_RESULT_POOL_FULL);
+		return 0;
+	}
+
+	float spawnSeconds = (frameSeconds < STRESS_MAX_SPAWN_SECONDS) ? frameSeconds : STRESS_MAX_SPAWN_SECONDS;
+	m_spawnDebt += m_spawnsPerSecond * spawnSeconds;
+	int numSpawns = static_cast<int>(m_spawnDebt);
+	m_spawnDebt -= static_cast<float>(numSpawns);
+	return numSpawns;
+}
+
+void PachinkoStressRamp::Finish(PachinkoStressResult result)
+{
+	m_isRunning = false;
+	m_result = result;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+// -----------------------------------------------------------------------------
+struct PachinkoStressSample
+{
+	int	  m_numBalls = 0;
+	float m_frameSeconds = 0.f;
+};
+// -----------------------------------------------------------------------------
+enum PachinkoStressResult
+{
+	PACHINKO_STRESS_RESULT_NONE,
+	PACHINKO_STRESS_RESULT_OVER_BUDGET,
+	PACHINKO_STRESS_RESULT_POOL_FULL,
+	PACHINKO_STRESS_RESULT_STOPPED
+};
+// -----------------------------------------------------------------------------
+// Ramps the ball count up at a fixed rate of real time and watches a smoothed frame
+// time. Once that stays over the budget for m_numOverBudgetFrames frames in a row the
+// ramp ends, and the most balls seen while still under budget is the scaling number.
+// -----------------------------------------------------------------------------
+class PachinkoStressRamp
+{
+public:
+	PachinkoStressRamp(float spawnsPerSecond, float frameBudgetSeconds, int numOverBudgetFrames, int sampleBallInterval);
+
+	void Start(int numBalls);
+	void Stop();
+
+	// Takes the real time the last frame took and returns how many balls to spawn this frame
+	int  Update(float frameSeconds, int numBalls, bool isPoolFull);
+
+	bool  IsRunning() const						{ return m_isRunning; }
+	PachinkoStressResult GetResult() const		{ return m_result; }
+	int   GetMaxSustainableBalls() const		{ return m_maxSustainableBalls; }
+	float GetSmoothedFrameSeconds() const		{ return m_smoothedFrameSeconds; }
+	float GetPeakFrameSeconds() const			{ return m_peakFrameSeconds; }
+	float GetFrameBudgetSeconds() const			{ return m_frameBudgetSeconds; }
+	std::vector<PachinkoStressSample> const& GetSamples() const { return m_samples; }
+
+private:
+	void Finish(PachinkoStressResult result);
+
+private:
+	float m_spawnsPerSecond = 1000.f;
+	float m_frameBudgetSeconds = 0.0166f;
+	int	  m_numOverBudgetFrames = 30;
+	int	  m_sampleBallInterval = 250;
+
+	bool  m_isRunning = false;
+	PachinkoStressResult m_result = PACHINKO_STRESS_RESULT_NONE;
+	float m_spawnDebt = 0.f;
+	float m_smoothedFrameSeconds = 0.f;
+	float m_peakFrameSeconds = 0.f;
+	int	  m_numFramesOverBudget = 0;
+	int	  m_maxSustainableBalls = 0;
+	int	  m_nextSampleNumBalls = 0;
+
+	// Smoothed frame time each time the ball count passes another m_sampleBallInterval
+	std::vector<PachinkoStressSample> m_samples;
+};
@@ -0,0 +1,72 @@
+#include "Game/PachinkoTimestepController.hpp"
+#include "Game/PachinkoSimulation.hpp"
+#include <math.h>
+
+// Adaptive steps keep the fastest ball from moving more than this fraction of the smallest radius per step
+const float ADAPTIVE_MAX_TRAVEL_PER_RADIUS = 0.5f;
+
+// and never shrink below this fraction of the target, so the substep cap still covers a useful slice of time
+const float ADAPTIVE_MIN_STEP_FRACTION = 0.125f;
+
+PachinkoTimestepController::PachinkoTimestepController(float targetTimeStep, int maxSubsteps, bool isAdaptive)
+	:m_maxSubsteps(maxSubsteps)
+	,m_isAdaptive(isAdaptive)
+{
+	SetTargetTimeStep(targetTimeStep);
+	if (m_maxSubsteps < 1)
+	{
+		m_maxSubsteps = 1;
+	}
+}
+
+void PachinkoTimestepController::SetTargetTimeStep(float targetTimeStep)
+{
+	m_targetTimeStep = targetTimeStep;
+	m_nextTimeStep = targetTimeStep;
+	m_lastTimeStep = targetTimeStep;
+}
+
+int PachinkoTimestepController::Advance(PachinkoSimulation& simulation, float frameSeconds)
+{
+	m_accumulatedSeconds += frameSeconds;
+	m_lastNumSubsteps = 0;
+
+	m_nextTimeStep = GetNextTimeStep(simulation);
+	while (m_accumulatedSeconds >= m_nextTimeStep && m_lastNumSubsteps < m_maxSubsteps)
+	{
+		simulation.Step(m_nextTimeStep);
+		m_accumulatedSeconds -= m_nextTimeStep;
+		m_lastTimeStep = m_nextTimeStep;
+		++m_lastNumSubsteps;
+
+		m_nextTimeStep = GetNextTimeStep(simulation);
+	}
+
+	// Out of budget: let the simulation fall behind real time instead of carrying the debt into the next frame
+	if (m_accumulatedSeconds >= m_nextTimeStep)
+	{
+		float droppedSeconds = m_accumulatedSeconds - fmodf(m_accumulatedSeconds, m_nextTimeStep);
+		m_totalDroppedSeconds += static_cast<double>(droppedSeconds);
+		m_accumulatedSeconds -= droppedSeconds;
+	}
+
+	m_interpolationFraction = m_accumulatedSeconds / m_nextTimeStep;
+	return m_lastNumSubsteps;
+}
+
+float PachinkoTimestepController::GetNextTimeStep(PachinkoSimulation const& simulation) const
+{
+	if (!m_isAdaptive || simulation.GetMinBallRadius() <= 0.f)
+	{
+		return m_targetTimeStep;
+	}
+
+	float maxSpeed = simulation.GetMaxAwakeBallSpeed();
+	float maxTravel = ADAPTIVE_MAX_TRAVEL_PER_RADIUS * simulation.GetMinBallRadius();
+	if (maxSpeed * m_targetTimeStep <= maxTravel)
+	{
+		return m_targetTimeStep;
+	}
+
+	return fmaxf(maxTravel / maxSpeed, ADAPTIVE_MIN_STEP_FRACTION * m_targetTimeStep);
+}
@@ -0,0 +1,42 @@
+#pragma once
+// -----------------------------------------------------------------------------
+class PachinkoSimulation;
+// -----------------------------------------------------------------------------
+// Turns frame time into fixed physics steps. At most m_maxSubsteps run per frame and
+// any time left over past that is dropped, so a slow frame can't make the next one
+// slower. The fraction of a step left in the accumulator is what rendering should
+// interpolate ball positions by.
+// -----------------------------------------------------------------------------
+class PachinkoTimestepController
+{
+public:
+	PachinkoTimestepController(float targetTimeStep, int maxSubsteps, bool isAdaptive);
+
+	// Runs as many steps as frameSeconds covers, up to the substep cap; returns how many ran
+	int   Advance(PachinkoSimulation& simulation, float frameSeconds);
+
+	void  SetTargetTimeStep(float targetTimeStep);
+	void  ToggleAdaptive()						{ m_isAdaptive = !m_isAdaptive; }
+	float GetTargetTimeStep() const				{ return m_targetTimeStep; }
+	bool  IsAdaptive() const					{ return m_isAdaptive; }
+	int   GetMaxSubsteps() const				{ return m_maxSubsteps; }
+	int   GetLastNumSubsteps() const			{ return m_lastNumSubsteps; }
+	float GetLastTimeStep() const				{ return m_lastTimeStep; }
+	float GetInterpolationFraction() const		{ return m_interpolationFraction; }
+	double GetTotalDroppedSeconds() const		{ return m_totalDroppedSeconds; }
+
+private:
+	float GetNextTimeStep(PachinkoSimulation const& simulation) const;
+
+private:
+	float  m_targetTimeStep = 0.005f;
+	int	   m_maxSubsteps = 8;
+	bool   m_isAdaptive = false;
+
+	float  m_accumulatedSeconds = 0.f;
+	float  m_nextTimeStep = 0.005f;
+	float  m_lastTimeStep = 0.005f;
+	int	   m_lastNumSubsteps = 0;
+	float  m_interpolationFraction = 1.f;
+	double m_totalDroppedSeconds = 0.0;
+};
@@ -0,0 +1,180 @@
+#include "Game/RaycastBatchBenchmark.hpp"
+#include "Game/WorkerPool.hpp"
+#include "Engine/Math/MathUtils.h"
+#include "Engine/Math/RandomNumberGenerator.h"
+#include <chrono>
+#include <math.h>
+#include <thread>
+
+static double GetBenchmarkTimeSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::vector<int> GetBenchmarkThreadCounts(int maxNumThreads)
+{
+	if (maxNumThreads <= 0)
+	{
+		maxNumThreads = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	if (maxNumThreads <= 0)
+	{
+		maxNumThreads = 1;
+	}
+
+	std::vector<int> threadCounts;
+	for (int numThreads = 1; numThreads < maxNumThreads; numThreads *= 2)
+	{
+		threadCounts.push_back(numThreads);
+	}
+	threadCounts.push_back(maxNumThreads);
+	return threadCounts;
+}
+
+// -----------------------------------------------------------------------------
+char const* GetRaycastBatchPatternName(RaycastBatchPattern pattern)
+{
+	switch (pattern)
+	{
+	case RAYCAST_BATCH_PATTERN_GRID:	return "grid";
+	case RAYCAST_BATCH_PATTERN_RANDOM:	return "random";
+	default:							return "unknown";
+	}
+}
+
+RaycastBatchPattern GetRaycastBatchPatternFromName(std::string const& patternName)
+{
+	for (int patternIndex = 0; patternIndex < RAYCAST_BATCH_PATTERN_COUNT; ++patternIndex)
+	{
+		if (patternName == GetRaycastBatchPatternName(static_cast<RaycastBatchPattern>(patternIndex)))
+		{
+			return static_cast<RaycastBatchPattern>(patternIndex);
+		}
+	}
+	return RAYCAST_BATCH_PATTERN_GRID;
+}
+
+void GenerateRaycastBatchRays(std::vector<BVH2DRay>& out_rays, RaycastBatchPattern pattern, int numRays, AABB2 const& bounds, float rayLength, RandomNumberGenerator& rng)
+{
+	out_rays.resize(numRays);
+	if (numRays <= 0)
+	{
+		return;
+	}
+
+	Vec2 boundsSize = bounds.m_maxs - bounds.m_mins;
+	if (pattern == RAYCAST_BATCH_PATTERN_RANDOM)
+	{
+		for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+		{
+			float angle = rng.RollRandomFloatInRange(0.f, 360.f);
+			out_rays[rayIndex].m_start = Vec2(rng.RollRandomFloatInRange(bounds.m_mins.x, bounds.m_maxs.x), rng.RollRandomFloatInRange(bounds.m_mins.y, bounds.m_maxs.y));
+			out_rays[rayIndex].m_fwdNormal = Vec2(CosDegrees(angle), SinDegrees(angle));
+			out_rays[rayIndex].m_maxLength = rayLength;
+		}
+		return;
+	}
+
+	int numColumns = static_cast<int>(ceilf(sqrtf(static_cast<float>(numRays) * boundsSize.x / boundsSize.y)));
+	if (numColumns < 1)
+	{
+		numColumns = 1;
+	}
+	int numRows = (numRays + numColumns - 1) / numColumns;
+	Vec2 cellSize(boundsSize.x / static_cast<float>(numColumns), boundsSize.y / static_cast<float>(numRows));
+	for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+	{
+		float angle = fmodf(static_cast<float>(rayIndex) * 137.50776f, 360.f);
+		Vec2 cellCoords(static_cast<float>(rayIndex % numColumns) + 0.5f, static_cast<float>(rayIndex / numColumns) + 0.5f);
+		out_rays[rayIndex].m_start = bounds.m_mins + Vec2(cellCoords.x * cellSize.x, cellCoords.y * cellSize.y);
+		out_rays[rayIndex].m_fwdNormal = Vec2(CosDegrees(angle), SinDegrees(angle));
+		out_rays[rayIndex].m_maxLength = rayLength;
+	}
+}
+
+std::vector<RaycastBatchBenchmarkResult> RunRaycastBatchBenchmark(RaycastScene2D const& scene, std::vector<BVH2DRay> const& rays, unsigned int shapeTypeMask,
+	int maxNumThreads, int numPasses, int numBruteForceRays)
+{
+	std::vector<RaycastBatchBenchmarkResult> results;
+	std::vector<int> threadCounts = GetBenchmarkThreadCounts(maxNumThreads);
+	int numRays = static_cast<int>(rays.size());
+	if (numPasses < 1)
+	{
+		numPasses = 1;
+	}
+
+	// The expected answers for the checked rays, every shape tested once each; not timed
+	numBruteForceRays = (numBruteForceRays < numRays) ? numBruteForceRays : numRays;
+	numBruteForceRays = (numBruteForceRays > 0) ? numBruteForceRays : 0;
+	std::vector<int> bruteForceRayIndices(numBruteForceRays);
+	std::vector<RaycastSceneHit2D> bruteForceHits(numBruteForceRays);
+	for (int checkIndex = 0; checkIndex < numBruteForceRays; ++checkIndex)
+	{
+		int rayIndex = static_cast<int>(static_cast<long long>(checkIndex) * numRays / numBruteForceRays);
+		BVH2DRay const& ray = rays[rayIndex];
+		BVH2DQueryStats bruteForceStats;
+		bruteForceRayIndices[checkIndex] = rayIndex;
+		bruteForceHits[checkIndex] = scene.RaycastNearestBruteForce(ray.m_start, ray.m_fwdNormal, ray.m_maxLength, shapeTypeMask, bruteForceStats);
+	}
+
+	std::vector<RaycastSceneHit2D> singleThreadHits;
+	std::vector<RaycastSceneHit2D> hits;
+	for (int countIndex = 0; countIndex < static_cast<int>(threadCounts.size()); ++countIndex)
+	{
+		// A fresh pool per thread count; spinning its threads up isn't timed
+		WorkerPool workerPool(threadCounts[countIndex]);
+		std::vector<RaycastSceneHit2D>& passHits = (countIndex == 0) ? singleThreadHits : hits;
+
+		BVH2DQueryStats stats;
+		double startTime = GetBenchmarkTimeSeconds();
+		for (int passIndex = 0; passIndex < numPasses; ++passIndex)
+		{
+			scene.RaycastNearestBatch(workerPool, rays, shapeTypeMask, passHits, stats);
+		}
+		double seconds = GetBenchmarkTimeSeconds() - startTime;
+
+		RaycastBatchBenchmarkResult result;
+		result.m_numThreads = workerPool.GetNumThreads();
+		result.m_numRays = numRays;
+		result.m_numPasses = numPasses;
+		result.m_raysPerSecond = (seconds > 0.0) ? static_cast<double>(numRays) * static_cast<double>(numPasses) / seconds : 0.0;
+		if (!results.empty() && results[0].m_raysPerSecond > 0.0)
+		{
+			result.m_speedup = result.m_raysPerSecond / results[0].m_raysPerSecond;
+		}
+		if (numRays > 0)
+		{
+			result.m_nodesPerRay = static_cast<double>(stats.m_numNodesVisited) / static_cast<double>(numRays);
+			result.m_shapesPerRay = static_cast<double>(stats.m_numPrimitivesTested) / static_cast<double>(numRays);
+		}
+
+		int numHits = 0;
+		for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+		{
+			RaycastSceneHit2D const& hit = passHits[rayIndex];
+			RaycastSceneHit2D const& singleThreadHit = singleThreadHits[rayIndex];
+			numHits += (hit.m_shapeIndex >= 0) ? 1 : 0;
+			if (hit.m_shapeIndex != singleThreadHit.m_shapeIndex || (hit.m_shapeIndex >= 0 && hit.m_shapeType != singleThreadHit.m_shapeType))
+			{
+				++result.m_numMismatches;
+			}
+		}
+		result.m_hitRatio = (numRays > 0) ? static_cast<float>(numHits) / static_cast<float>(numRays) : 0.f;
+
+		// Both sides run the same per-shape raycasts, so the nearest distance must match exactly
+		result.m_numBruteForceRays = numBruteForceRays;
+		for (int checkIndex = 0; checkIndex < numBruteForceRays; ++checkIndex)
+		{
+			RaycastResult2D const& batchResult = passHits[bruteForceRayIndices[checkIndex]].m_result;
+			RaycastResult2D const& bruteForceResult = bruteForceHits[checkIndex].m_result;
+			if (batchResult.m_didImpact != bruteForceResult.m_didImpact || (batchResult.m_didImpact && batchResult.m_impactDist != bruteForceResult.m_impactDist))
+			{
+				++result.m_numBruteForceMismatches;
+			}
+		}
+
+		results.push_back(result);
+	}
+
+	return results;
+}
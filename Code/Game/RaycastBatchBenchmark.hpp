@@ -0,0 +1,45 @@
+#pragma once
+#include "Game/RaycastScene2D.hpp"
+#include "Engine/Math/AABB2.h"
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+class RandomNumberGenerator;
+// -----------------------------------------------------------------------------
+enum RaycastBatchPattern
+{
+	RAYCAST_BATCH_PATTERN_GRID,
+	RAYCAST_BATCH_PATTERN_RANDOM,
+	RAYCAST_BATCH_PATTERN_COUNT
+};
+
+char const*			GetRaycastBatchPatternName(RaycastBatchPattern pattern);
+RaycastBatchPattern GetRaycastBatchPatternFromName(std::string const& patternName);
+// -----------------------------------------------------------------------------
+struct RaycastBatchBenchmarkResult
+{
+	int	   m_numThreads = 1;
+	int	   m_numRays = 0;
+	int	   m_numPasses = 0;
+	double m_raysPerSecond = 0.0;
+	double m_speedup = 1.0;
+	double m_nodesPerRay = 0.0;
+	double m_shapesPerRay = 0.0;
+	float  m_hitRatio = 0.f;
+	int	   m_numMismatches = 0;
+	int	   m_numBruteForceRays = 0;
+	int	   m_numBruteForceMismatches = 0;
+};
+// -----------------------------------------------------------------------------
+// numRays rays of rayLength inside bounds. The grid pattern puts one start in each cell of a
+// grid as square as bounds allow, and turns each ray a golden angle from the one before so
+// every direction is covered; the random pattern rolls starts and directions from rng.
+void GenerateRaycastBatchRays(std::vector<BVH2DRay>& out_rays, RaycastBatchPattern pattern, int numRays, AABB2 const& bounds, float rayLength, RandomNumberGenerator& rng);
+
+// Nearest hit of every ray through the scene BVH on 1, 2, 4... threads up to maxNumThreads
+// (0 uses one per hardware thread), numPasses times each. Speedup is over the 1-thread run,
+// and mismatches count rays that hit a different shape than they did on 1 thread. Brute force
+// mismatches count rays, of numBruteForceRays spread evenly through the batch, whose hit or
+// impact distance differs from RaycastNearestBruteForce's; ties may still pick another shape.
+std::vector<RaycastBatchBenchmarkResult> RunRaycastBatchBenchmark(RaycastScene2D const& scene, std::vector<BVH2DRay> const& rays, unsigned int shapeTypeMask,
+	int maxNumThreads, int numPasses, int numBruteForceRays);
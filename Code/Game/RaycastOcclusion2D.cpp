@@ -0,0 +1,247 @@
+#include "Game/RaycastOcclusion2D.hpp"
+#include "Game/RaycastScene2D.hpp"
+#include "Engine/Math/MathUtils.h"
+#include <chrono>
+#include <math.h>
+
+static double GetBenchmarkTimeSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool DoesRayHitSlabs2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, Vec2 const& mins, Vec2 const& maxs)
+{
+	float entryDist = 0.f;
+	float exitDist = rayMaxLength;
+	for (int axis = 0; axis < 2; ++axis)
+	{
+		float start = (axis == 0) ? rayStart.x : rayStart.y;
+		float fwd = (axis == 0) ? rayFwdNormal.x : rayFwdNormal.y;
+		float slabMin = (axis == 0) ? mins.x : mins.y;
+		float slabMax = (axis == 0) ? maxs.x : maxs.y;
+
+		// A ray along the slab only hits if it already runs between its sides
+		if (fabsf(fwd) < 1.0e-9f)
+		{
+			if (start < slabMin || start > slabMax)
+			{
+				return false;
+			}
+			continue;
+		}
+
+		float oneOverFwd = 1.f / fwd;
+		float slabEntryDist = (slabMin - start) * oneOverFwd;
+		float slabExitDist = (slabMax - start) * oneOverFwd;
+		if (slabEntryDist > slabExitDist)
+		{
+			float swapDist = slabEntryDist;
+			slabEntryDist = slabExitDist;
+			slabExitDist = swapDist;
+		}
+		entryDist = fmaxf(entryDist, slabEntryDist);
+		exitDist = fminf(exitDist, slabExitDist);
+		if (entryDist > exitDist)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool DoesRayHitDisc2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, Vec2 const& discCenter, float discRadius)
+{
+	Vec2 startToCenter = discCenter - rayStart;
+	float startToCenterLengthSquared = startToCenter.GetLengthSquared();
+	float radiusSquared = discRadius * discRadius;
+	if (startToCenterLengthSquared < radiusSquared)
+	{
+		return true;
+	}
+
+	// Heading away from a disc the ray starts outside of
+	float centerAlongRay = DotProduct2D(startToCenter, rayFwdNormal);
+	if (centerAlongRay < 0.f)
+	{
+		return false;
+	}
+
+	float centerOffRaySquared = startToCenterLengthSquared - centerAlongRay * centerAlongRay;
+	if (centerOffRaySquared >= radiusSquared)
+	{
+		return false;
+	}
+
+	// The ray enters the disc at centerAlongRay - sqrt(radiusSquared - centerOffRaySquared); squared, to skip the sqrt
+	if (centerAlongRay <= rayMaxLength)
+	{
+		return true;
+	}
+	float centerPastRayEnd = centerAlongRay - rayMaxLength;
+	return centerPastRayEnd * centerPastRayEnd <= radiusSquared - centerOffRaySquared;
+}
+
+bool DoesRayHitLineSegment2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, Vec2 const& lineStart, Vec2 const& lineEnd)
+{
+	// The crossing's distance along the ray and fraction along the line, both still scaled by the denominator
+	Vec2 lineDisplacement = lineEnd - lineStart;
+	float denominator = rayFwdNormal.x * lineDisplacement.y - rayFwdNormal.y * lineDisplacement.x;
+	if (fabsf(denominator) < 1.0e-9f)
+	{
+		return false;
+	}
+
+	Vec2 rayStartToLineStart = lineStart - rayStart;
+	float scaledImpactDist = rayStartToLineStart.x * lineDisplacement.y - rayStartToLineStart.y * lineDisplacement.x;
+	float scaledLineFraction = rayStartToLineStart.x * rayFwdNormal.y - rayStartToLineStart.y * rayFwdNormal.x;
+	if (denominator < 0.f)
+	{
+		denominator = -denominator;
+		scaledImpactDist = -scaledImpactDist;
+		scaledLineFraction = -scaledLineFraction;
+	}
+	return scaledImpactDist >= 0.f && scaledImpactDist <= rayMaxLength * denominator && scaledLineFraction >= 0.f && scaledLineFraction <= denominator;
+}
+
+bool DoesRayHitAABB2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, AABB2 const& box)
+{
+	return DoesRayHitSlabs2D(rayStart, rayFwdNormal, rayMaxLength, box.m_mins, box.m_maxs);
+}
+
+bool DoesRayHitOBB2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, OBB2 const& box)
+{
+	Vec2 iBasis = box.m_iBasisNormal;
+	Vec2 jBasis = iBasis.GetRotated90Degrees();
+	Vec2 localStart(DotProduct2D(rayStart - box.m_center, iBasis), DotProduct2D(rayStart - box.m_center, jBasis));
+	Vec2 localFwdNormal(DotProduct2D(rayFwdNormal, iBasis), DotProduct2D(rayFwdNormal, jBasis));
+	Vec2 halfDimensions = box.m_halfDimensions;
+	return DoesRayHitSlabs2D(localStart, localFwdNormal, rayMaxLength, Vec2(-halfDimensions.x, -halfDimensions.y), halfDimensions);
+}
+
+bool DoesRayHitCapsule2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, Vec2 const& boneStart, Vec2 const& boneEnd, float radius)
+{
+	Vec2 nearestPointOnBone = GetNearestPointOnLineSegment2D(rayStart, boneStart, boneEnd);
+	if (GetDistanceSquared2D(rayStart, nearestPointOnBone) <= radius * radius)
+	{
+		return true;
+	}
+
+	// Same four parts as RaycastVsCapsule2D, but any one of them will do
+	Vec2 sideOffset = (boneEnd - boneStart).GetNormalized().GetRotated90Degrees() * radius;
+	return DoesRayHitLineSegment2D(rayStart, rayFwdNormal, rayMaxLength, boneStart + sideOffset, boneEnd + sideOffset)
+		|| DoesRayHitLineSegment2D(rayStart, rayFwdNormal, rayMaxLength, boneStart - sideOffset, boneEnd - sideOffset)
+		|| DoesRayHitDisc2D(rayStart, rayFwdNormal, rayMaxLength, boneStart, radius)
+		|| DoesRayHitDisc2D(rayStart, rayFwdNormal, rayMaxLength, boneEnd, radius);
+}
+
+// -----------------------------------------------------------------------------
+static void AddBenchmarkShapes(RaycastScene2D& scene, int numShapes)
+{
+	// Same mix and sizes as the raycast modes' mixed clutter; no RNG so the game's random stream is untouched
+	for (int shapeIndex = 0; shapeIndex < numShapes; ++shapeIndex)
+	{
+		float fraction = static_cast<float>(shapeIndex);
+		Vec2 center(fmodf(fraction * 7.31f + 13.f, 1600.f), fmodf(fraction * 3.77f + 7.f, 800.f));
+		float size = 2.5f + fmodf(fraction * 0.37f, 7.5f);
+		float angle = fmodf(fraction * 37.3f, 360.f);
+		scene.AddShape(static_cast<RaycastShapeType>(shapeIndex % RAYCAST_SHAPE_COUNT), center, size, Vec2(CosDegrees(angle), SinDegrees(angle)));
+	}
+	scene.BuildBVH();
+}
+
+std::vector<OcclusionBenchmarkResult> RunOcclusionBenchmark()
+{
+	constexpr int NUM_RAYS = 1024;
+	constexpr int NUM_BRUTE_FORCE_RAYS = 64;
+	constexpr int NUM_SHAPE_COUNTS = 3;
+	constexpr int SHAPE_COUNTS[NUM_SHAPE_COUNTS] = { 1000, 10000, 100000 };
+	constexpr int RAYS_PER_RUN = 16384;
+
+	// Line-of-sight checks between scattered points, 100 to 500 units long
+	std::vector<Vec2> rayStarts;
+	std::vector<Vec2> rayFwdNormals;
+	std::vector<float> rayLengths;
+	for (int rayIndex = 0; rayIndex < NUM_RAYS; ++rayIndex)
+	{
+		float fraction = static_cast<float>(rayIndex);
+		float angle = fmodf(fraction * 137.5f, 360.f);
+		rayStarts.push_back(Vec2(fmodf(fraction * 97.3f + 11.f, 1600.f), fmodf(fraction * 53.9f + 5.f, 800.f)));
+		rayFwdNormals.push_back(Vec2(CosDegrees(angle), SinDegrees(angle)));
+		rayLengths.push_back(100.f + fmodf(fraction * 41.7f, 400.f));
+	}
+
+	std::vector<OcclusionBenchmarkResult> results;
+	std::vector<bool> isRayBlocked(NUM_RAYS, false);
+	for (int countIndex = 0; countIndex < NUM_SHAPE_COUNTS; ++countIndex)
+	{
+		RaycastScene2D scene;
+		AddBenchmarkShapes(scene, SHAPE_COUNTS[countIndex]);
+
+		OcclusionBenchmarkResult result;
+		result.m_numShapes = SHAPE_COUNTS[countIndex];
+		result.m_numRays = NUM_RAYS;
+		result.m_numBruteForceRays = NUM_BRUTE_FORCE_RAYS;
+		int numPasses = RAYS_PER_RUN / NUM_RAYS;
+		double numQueries = static_cast<double>(NUM_RAYS) * static_cast<double>(numPasses);
+		BVH2DQueryStats stats;
+		RaycastShapeType shapeType = RAYCAST_SHAPE_DISC;
+		int shapeIndex = -1;
+
+		// Nearest hit through the BVH, which also sets the expected answer for every ray
+		long long numNodesVisited = 0;
+		int numBlockedRays = 0;
+		double startTime = GetBenchmarkTimeSeconds();
+		for (int passIndex = 0; passIndex < numPasses; ++passIndex)
+		{
+			numNodesVisited = 0;
+			numBlockedRays = 0;
+			for (int rayIndex = 0; rayIndex < NUM_RAYS; ++rayIndex)
+			{
+				RaycastSceneHit2D hit = scene.RaycastNearest(rayStarts[rayIndex], rayFwdNormals[rayIndex], rayLengths[rayIndex], RAYCAST_SHAPE_MASK_ALL, stats);
+				isRayBlocked[rayIndex] = hit.m_result.m_didImpact;
+				numNodesVisited += stats.m_numNodesVisited;
+				numBlockedRays += hit.m_result.m_didImpact ? 1 : 0;
+			}
+		}
+		result.m_bvhNearestNsPerRay = (GetBenchmarkTimeSeconds() - startTime) * 1.0e9 / numQueries;
+		result.m_bvhNearestNodesPerRay = static_cast<double>(numNodesVisited) / static_cast<double>(NUM_RAYS);
+		result.m_hitRatio = static_cast<float>(numBlockedRays) / static_cast<float>(NUM_RAYS);
+
+		// Any hit through the BVH
+		startTime = GetBenchmarkTimeSeconds();
+		for (int passIndex = 0; passIndex < numPasses; ++passIndex)
+		{
+			numNodesVisited = 0;
+			result.m_numMismatches = 0;
+			for (int rayIndex = 0; rayIndex < NUM_RAYS; ++rayIndex)
+			{
+				bool isBlocked = scene.RaycastAny(rayStarts[rayIndex], rayFwdNormals[rayIndex], rayLengths[rayIndex], RAYCAST_SHAPE_MASK_ALL, shapeType, shapeIndex, stats);
+				numNodesVisited += stats.m_numNodesVisited;
+				result.m_numMismatches += (isBlocked != isRayBlocked[rayIndex]) ? 1 : 0;
+			}
+		}
+		result.m_bvhAnyNsPerRay = (GetBenchmarkTimeSeconds() - startTime) * 1.0e9 / numQueries;
+		result.m_bvhAnyNodesPerRay = static_cast<double>(numNodesVisited) / static_cast<double>(NUM_RAYS);
+
+		// Every shape against a few of the rays, once each
+		startTime = GetBenchmarkTimeSeconds();
+		for (int rayIndex = 0; rayIndex < NUM_BRUTE_FORCE_RAYS; ++rayIndex)
+		{
+			RaycastSceneHit2D hit = scene.RaycastNearestBruteForce(rayStarts[rayIndex], rayFwdNormals[rayIndex], rayLengths[rayIndex], RAYCAST_SHAPE_MASK_ALL, stats);
+			result.m_numMismatches += (hit.m_result.m_didImpact != isRayBlocked[rayIndex]) ? 1 : 0;
+		}
+		result.m_bruteForceNearestNsPerRay = (GetBenchmarkTimeSeconds() - startTime) * 1.0e9 / static_cast<double>(NUM_BRUTE_FORCE_RAYS);
+
+		startTime = GetBenchmarkTimeSeconds();
+		for (int rayIndex = 0; rayIndex < NUM_BRUTE_FORCE_RAYS; ++rayIndex)
+		{
+			bool isBlocked = scene.RaycastAnyBruteForce(rayStarts[rayIndex], rayFwdNormals[rayIndex], rayLengths[rayIndex], RAYCAST_SHAPE_MASK_ALL, shapeType, shapeIndex, stats);
+			result.m_numMismatches += (isBlocked != isRayBlocked[rayIndex]) ? 1 : 0;
+		}
+		result.m_bruteForceAnyNsPerRay = (GetBenchmarkTimeSeconds() - startTime) * 1.0e9 / static_cast<double>(NUM_BRUTE_FORCE_RAYS);
+
+		results.push_back(result);
+	}
+
+	return results;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "Engine/Math/AABB2.h"
+#include "Engine/Math/OBB2.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include <vector>
+// -----------------------------------------------------------------------------
+// Yes/no versions of the 2D raycasts for line-of-sight checks. Each one answers exactly
+// when the matching RaycastVs* would report m_didImpact, a ray starting inside a shape
+// included, but never works out where or with what normal, and returns on the first
+// part of a shape that blocks the ray.
+// -----------------------------------------------------------------------------
+bool DoesRayHitDisc2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, Vec2 const& discCenter, float discRadius);
+bool DoesRayHitLineSegment2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, Vec2 const& lineStart, Vec2 const& lineEnd);
+bool DoesRayHitAABB2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, AABB2 const& box);
+bool DoesRayHitOBB2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, OBB2 const& box);
+bool DoesRayHitCapsule2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, Vec2 const& boneStart, Vec2 const& boneEnd, float radius);
+// -----------------------------------------------------------------------------
+struct OcclusionBenchmarkResult
+{
+	int	   m_numShapes = 0;
+	int	   m_numRays = 0;
+	double m_bvhNearestNsPerRay = 0.0;
+	double m_bvhAnyNsPerRay = 0.0;
+	double m_bvhNearestNodesPerRay = 0.0;
+	double m_bvhAnyNodesPerRay = 0.0;
+	int	   m_numBruteForceRays = 0;
+	double m_bruteForceNearestNsPerRay = 0.0;
+	double m_bruteForceAnyNsPerRay = 0.0;
+	float  m_hitRatio = 0.f;
+	int	   m_numMismatches = 0;
+};
+// -----------------------------------------------------------------------------
+// ns per ray for nearest-hit and any-hit queries on dense mixed scenes, through the scene BVH
+// and by testing every shape, and how many rays the two queries disagreed on being blocked
+std::vector<OcclusionBenchmarkResult> RunOcclusionBenchmark();
@@ -0,0 +1,501 @@
+#include "Game/RaycastScene2D.hpp"
+#include "Game/RaycastOcclusion2D.hpp"
+#include "Game/WorkerPool.hpp"
+#include "Engine/Math/MathUtils.h"
+#include "Engine/Core/VertexUtils.h"
+#include <math.h>
+
+static void KeepNearerImpact(RaycastResult2D& nearestImpact, RaycastResult2D const& impact)
+{
+	if (impact.m_didImpact && (!nearestImpact.m_didImpact || impact.m_impactDist < nearestImpact.m_impactDist))
+	{
+		nearestImpact = impact;
+	}
+}
+
+static RaycastResult2D GetRayStartImpact(Vec2 const& rayStart, Vec2 const& rayFwdNormal)
+{
+	RaycastResult2D impact;
+	impact.m_didImpact = true;
+	impact.m_impactDist = 0.f;
+	impact.m_impactPos = rayStart;
+	impact.m_impactNormal = rayFwdNormal * -1.f;
+	return impact;
+}
+
+unsigned int GetRaycastShapeMask(RaycastShapeType shapeType)
+{
+	return 1u << static_cast<unsigned int>(shapeType);
+}
+
+char const* GetRaycastShapeTypeName(RaycastShapeType shapeType)
+{
+	switch (shapeType)
+	{
+	case RAYCAST_SHAPE_DISC:		 return "disc";
+	case RAYCAST_SHAPE_LINE_SEGMENT: return "line segment";
+	case RAYCAST_SHAPE_AABB2:		 return "AABB2";
+	case RAYCAST_SHAPE_OBB2:		 return "OBB2";
+	case RAYCAST_SHAPE_CAPSULE:		 return "capsule";
+	default:						 return "unknown";
+	}
+}
+
+RaycastResult2D RaycastVsOBB2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, OBB2 const& box)
+{
+	// Raycast the box as an AABB2 in its own frame, then turn the impact back
+	Vec2 iBasis = box.m_iBasisNormal;
+	Vec2 jBasis = iBasis.GetRotated90Degrees();
+	Vec2 localStart(DotProduct2D(rayStart - box.m_center, iBasis), DotProduct2D(rayStart - box.m_center, jBasis));
+	Vec2 halfDimensions = box.m_halfDimensions;
+	if (fabsf(localStart.x) <= halfDimensions.x && fabsf(localStart.y) <= halfDimensions.y)
+	{
+		return GetRayStartImpact(rayStart, rayFwdNormal);
+	}
+
+	Vec2 localFwdNormal(DotProduct2D(rayFwdNormal, iBasis), DotProduct2D(rayFwdNormal, jBasis));
+	RaycastResult2D impact = RaycastVsAABB2D(localStart, localFwdNormal, rayMaxLength, AABB2(-halfDimensions.x, -halfDimensions.y, halfDimensions.x, halfDimensions.y));
+	if (impact.m_didImpact)
+	{
+		impact.m_impactPos = rayStart + rayFwdNormal * impact.m_impactDist;
+		impact.m_impactNormal = iBasis * impact.m_impactNormal.x + jBasis * impact.m_impactNormal.y;
+	}
+	return impact;
+}
+
+RaycastResult2D RaycastVsCapsule2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, Vec2 const& boneStart, Vec2 const& boneEnd, float radius)
+{
+	Vec2 nearestPointOnBone = GetNearestPointOnLineSegment2D(rayStart, boneStart, boneEnd);
+	if (GetDistanceSquared2D(rayStart, nearestPointOnBone) <= radius * radius)
+	{
+		return GetRayStartImpact(rayStart, rayFwdNormal);
+	}
+
+	// Two end caps plus the two sides of the bone pushed out by the radius
+	RaycastResult2D nearestImpact;
+	Vec2 sideOffset = (boneEnd - boneStart).GetNormalized().GetRotated90Degrees() * radius;
+	KeepNearerImpact(nearestImpact, RaycastVsDisc2D(rayStart, rayFwdNormal, rayMaxLength, boneStart, radius));
+	KeepNearerImpact(nearestImpact, RaycastVsDisc2D(rayStart, rayFwdNormal, rayMaxLength, boneEnd, radius));
+	KeepNearerImpact(nearestImpact, RaycastVsLineSegment2D(rayStart, rayFwdNormal, rayMaxLength, boneStart + sideOffset, boneEnd + sideOffset));
+	KeepNearerImpact(nearestImpact, RaycastVsLineSegment2D(rayStart, rayFwdNormal, rayMaxLength, boneStart - sideOffset, boneEnd - sideOffset));
+
+	// A side's own normal may face either way, so the normal is taken from the bone instead
+	if (nearestImpact.m_didImpact)
+	{
+		Vec2 nearestPointOnBoneToImpact = GetNearestPointOnLineSegment2D(nearestImpact.m_impactPos, boneStart, boneEnd);
+		nearestImpact.m_impactNormal = (nearestImpact.m_impactPos - nearestPointOnBoneToImpact).GetNormalized();
+	}
+	return nearestImpact;
+}
+
+// -----------------------------------------------------------------------------
+void RaycastScene2D::Clear()
+{
+	m_discCenters.clear();
+	m_discRadii.clear();
+	m_lineSegmentStarts.clear();
+	m_lineSegmentEnds.clear();
+	m_AABB2s.clear();
+	m_OBB2Centers.clear();
+	m_OBB2IBasisNormals.clear();
+	m_OBB2HalfDimensions.clear();
+	m_capsuleBoneStarts.clear();
+	m_capsuleBoneEnds.clear();
+	m_capsuleRadii.clear();
+
+	m_bvh.Clear();
+	m_primitiveShapeTypes.clear();
+	m_primitiveShapeIndices.clear();
+	m_primitiveBounds.clear();
+}
+
+int RaycastScene2D::AddDisc(Vec2 const& center, float radius)
+{
+	m_discCenters.push_back(center);
+	m_discRadii.push_back(radius);
+	return static_cast<int>(m_discCenters.size()) - 1;
+}
+
+int RaycastScene2D::AddLineSegment(Vec2 const& start, Vec2 const& end)
+{
+	m_lineSegmentStarts.push_back(start);
+	m_lineSegmentEnds.push_back(end);
+	return static_cast<int>(m_lineSegmentStarts.size()) - 1;
+}
+
+int RaycastScene2D::AddAABB2(AABB2 const& box)
+{
+	m_AABB2s.push_back(box);
+	return static_cast<int>(m_AABB2s.size()) - 1;
+}
+
+int RaycastScene2D::AddOBB2(OBB2 const& box)
+{
+	m_OBB2Centers.push_back(box.m_center);
+	m_OBB2IBasisNormals.push_back(box.m_iBasisNormal);
+	m_OBB2HalfDimensions.push_back(box.m_halfDimensions);
+	return static_cast<int>(m_OBB2Centers.size()) - 1;
+}
+
+int RaycastScene2D::AddCapsule(Vec2 const& boneStart, Vec2 const& boneEnd, float radius)
+{
+	m_capsuleBoneStarts.push_back(boneStart);
+	m_capsuleBoneEnds.push_back(boneEnd);
+	m_capsuleRadii.push_back(radius);
+	return static_cast<int>(m_capsuleBoneStarts.size()) - 1;
+}
+
+int RaycastScene2D::AddShape(RaycastShapeType shapeType, Vec2 const& center, float size, Vec2 const& direction)
+{
+	switch (shapeType)
+	{
+	case RAYCAST_SHAPE_DISC:		 return AddDisc(center, size * 0.5f);
+	case RAYCAST_SHAPE_LINE_SEGMENT: return AddLineSegment(center - direction * size, center + direction * size);
+	case RAYCAST_SHAPE_AABB2:		 return AddAABB2(AABB2(center - Vec2(size, size) * 0.5f, center + Vec2(size, size) * 0.5f));
+	case RAYCAST_SHAPE_OBB2:		 return AddOBB2(OBB2(center, direction, Vec2(size, size * 0.5f) * 0.5f));
+	case RAYCAST_SHAPE_CAPSULE:		 return AddCapsule(center - direction * size * 0.5f, center + direction * size * 0.5f, size * 0.25f);
+	default:						 return -1;
+	}
+}
+
+void RaycastScene2D::TranslateShape(RaycastShapeType shapeType, int shapeIndex, Vec2 const& displacement)
+{
+	switch (shapeType)
+	{
+	case RAYCAST_SHAPE_DISC:
+		m_discCenters[shapeIndex] += displacement;
+		break;
+	case RAYCAST_SHAPE_LINE_SEGMENT:
+		m_lineSegmentStarts[shapeIndex] += displacement;
+		m_lineSegmentEnds[shapeIndex] += displacement;
+		break;
+	case RAYCAST_SHAPE_AABB2:
+		m_AABB2s[shapeIndex].m_mins += displacement;
+		m_AABB2s[shapeIndex].m_maxs += displacement;
+		break;
+	case RAYCAST_SHAPE_OBB2:
+		m_OBB2Centers[shapeIndex] += displacement;
+		break;
+	case RAYCAST_SHAPE_CAPSULE:
+		m_capsuleBoneStarts[shapeIndex] += displacement;
+		m_capsuleBoneEnds[shapeIndex] += displacement;
+		break;
+	default:
+		break;
+	}
+}
+
+int RaycastScene2D::GetNumShapes() const
+{
+	int numShapes = 0;
+	for (int shapeType = 0; shapeType < RAYCAST_SHAPE_COUNT; ++shapeType)
+	{
+		numShapes += GetNumShapes(static_cast<RaycastShapeType>(shapeType));
+	}
+	return numShapes;
+}
+
+int RaycastScene2D::GetNumShapes(RaycastShapeType shapeType) const
+{
+	switch (shapeType)
+	{
+	case RAYCAST_SHAPE_DISC:		 return static_cast<int>(m_discCenters.size());
+	case RAYCAST_SHAPE_LINE_SEGMENT: return static_cast<int>(m_lineSegmentStarts.size());
+	case RAYCAST_SHAPE_AABB2:		 return static_cast<int>(m_AABB2s.size());
+	case RAYCAST_SHAPE_OBB2:		 return static_cast<int>(m_OBB2Centers.size());
+	case RAYCAST_SHAPE_CAPSULE:		 return static_cast<int>(m_capsuleBoneStarts.size());
+	default:						 return 0;
+	}
+}
+
+AABB2 RaycastScene2D::GetShapeBounds(RaycastShapeType shapeType, int shapeIndex) const
+{
+	switch (shapeType)
+	{
+	case RAYCAST_SHAPE_DISC:
+	{
+		Vec2 radiusOffset(m_discRadii[shapeIndex], m_discRadii[shapeIndex]);
+		return AABB2(m_discCenters[shapeIndex] - radiusOffset, m_discCenters[shapeIndex] + radiusOffset);
+	}
+	case RAYCAST_SHAPE_LINE_SEGMENT:
+	{
+		Vec2 const& start = m_lineSegmentStarts[shapeIndex];
+		Vec2 const& end = m_lineSegmentEnds[shapeIndex];
+		return AABB2(Vec2(fminf(start.x, end.x), fminf(start.y, end.y)), Vec2(fmaxf(start.x, end.x), fmaxf(start.y, end.y)));
+	}
+	case RAYCAST_SHAPE_AABB2:
+	{
+		return m_AABB2s[shapeIndex];
+	}
+	case RAYCAST_SHAPE_OBB2:
+	{
+		Vec2 iBasisNormal = m_OBB2IBasisNormals[shapeIndex];
+		Vec2 halfDimensions = m_OBB2HalfDimensions[shapeIndex];
+		Vec2 boxHalfExtents(fabsf(iBasisNormal.x) * halfDimensions.x + fabsf(iBasisNormal.y) * halfDimensions.y, fabsf(iBasisNormal.y) * halfDimensions.x + fabsf(iBasisNormal.x) * halfDimensions.y);
+		return AABB2(m_OBB2Centers[shapeIndex] - boxHalfExtents, m_OBB2Centers[shapeIndex] + boxHalfExtents);
+	}
+	case RAYCAST_SHAPE_CAPSULE:
+	{
+		Vec2 const& boneStart = m_capsuleBoneStarts[shapeIndex];
+		Vec2 const& boneEnd = m_capsuleBoneEnds[shapeIndex];
+		Vec2 radiusOffset(m_capsuleRadii[shapeIndex], m_capsuleRadii[shapeIndex]);
+		Vec2 boneMins(fminf(boneStart.x, boneEnd.x), fminf(boneStart.y, boneEnd.y));
+		Vec2 boneMaxs(fmaxf(boneStart.x, boneEnd.x), fmaxf(boneStart.y, boneEnd.y));
+		return AABB2(boneMins - radiusOffset, boneMaxs + radiusOffset);
+	}
+	default:
+		return AABB2();
+	}
+}
+
+void RaycastScene2D::BuildBVH()
+{
+	int numShapes = GetNumShapes();
+	m_primitiveShapeTypes.clear();
+	m_primitiveShapeIndices.clear();
+	m_primitiveShapeTypes.reserve(numShapes);
+	m_primitiveShapeIndices.reserve(numShapes);
+	for (int shapeType = 0; shapeType < RAYCAST_SHAPE_COUNT; ++shapeType)
+	{
+		int numShapesOfType = GetNumShapes(static_cast<RaycastShapeType>(shapeType));
+		for (int shapeIndex = 0; shapeIndex < numShapesOfType; ++shapeIndex)
+		{
+			m_primitiveShapeTypes.push_back(static_cast<unsigned char>(shapeType));
+			m_primitiveShapeIndices.push_back(shapeIndex);
+		}
+	}
+	UpdatePrimitiveBounds();
+	m_bvh.Build(m_primitiveBounds);
+}
+
+void RaycastScene2D::RefitBVH()
+{
+	UpdatePrimitiveBounds();
+	m_bvh.Refit(m_primitiveBounds);
+}
+
+void RaycastScene2D::UpdatePrimitiveBounds()
+{
+	int numPrimitives = static_cast<int>(m_primitiveShapeIndices.size());
+	m_primitiveBounds.resize(numPrimitives);
+	for (int primitiveIndex = 0; primitiveIndex < numPrimitives; ++primitiveIndex)
+	{
+		m_primitiveBounds[primitiveIndex] = GetShapeBounds(static_cast<RaycastShapeType>(m_primitiveShapeTypes[primitiveIndex]), m_primitiveShapeIndices[primitiveIndex]);
+	}
+}
+
+RaycastResult2D RaycastScene2D::RaycastShape(RaycastShapeType shapeType, int shapeIndex, Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength) const
+{
+	switch (shapeType)
+	{
+	case RAYCAST_SHAPE_DISC:
+		return RaycastVsDisc2D(rayStart, rayFwdNormal, rayMaxLength, m_discCenters[shapeIndex], m_discRadii[shapeIndex]);
+	case RAYCAST_SHAPE_LINE_SEGMENT:
+		return RaycastVsLineSegment2D(rayStart, rayFwdNormal, rayMaxLength, m_lineSegmentStarts[shapeIndex], m_lineSegmentEnds[shapeIndex]);
+	case RAYCAST_SHAPE_AABB2:
+		return RaycastVsAABB2D(rayStart, rayFwdNormal, rayMaxLength, m_AABB2s[shapeIndex]);
+	case RAYCAST_SHAPE_OBB2:
+		return RaycastVsOBB2D(rayStart, rayFwdNormal, rayMaxLength, OBB2(m_OBB2Centers[shapeIndex], m_OBB2IBasisNormals[shapeIndex], m_OBB2HalfDimensions[shapeIndex]));
+	case RAYCAST_SHAPE_CAPSULE:
+		return RaycastVsCapsule2D(rayStart, rayFwdNormal, rayMaxLength, m_capsuleBoneStarts[shapeIndex], m_capsuleBoneEnds[shapeIndex], m_capsuleRadii[shapeIndex]);
+	default:
+		return RaycastResult2D();
+	}
+}
+
+bool RaycastScene2D::DoesRayHitShape(RaycastShapeType shapeType, int shapeIndex, Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength) const
+{
+	switch (shapeType)
+	{
+	case RAYCAST_SHAPE_DISC:
+		return DoesRayHitDisc2D(rayStart, rayFwdNormal, rayMaxLength, m_discCenters[shapeIndex], m_discRadii[shapeIndex]);
+	case RAYCAST_SHAPE_LINE_SEGMENT:
+		return DoesRayHitLineSegment2D(rayStart, rayFwdNormal, rayMaxLength, m_lineSegmentStarts[shapeIndex], m_lineSegmentEnds[shapeIndex]);
+	case RAYCAST_SHAPE_AABB2:
+		return DoesRayHitAABB2D(rayStart, rayFwdNormal, rayMaxLength, m_AABB2s[shapeIndex]);
+	case RAYCAST_SHAPE_OBB2:
+		return DoesRayHitOBB2D(rayStart, rayFwdNormal, rayMaxLength, OBB2(m_OBB2Centers[shapeIndex], m_OBB2IBasisNormals[shapeIndex], m_OBB2HalfDimensions[shapeIndex]));
+	case RAYCAST_SHAPE_CAPSULE:
+		return DoesRayHitCapsule2D(rayStart, rayFwdNormal, rayMaxLength, m_capsuleBoneStarts[shapeIndex], m_capsuleBoneEnds[shapeIndex], m_capsuleRadii[shapeIndex]);
+	default:
+		return false;
+	}
+}
+
+RaycastResult2D RaycastScene2D::RaycastPrimitive(int primitiveIndex, Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, unsigned int shapeTypeMask) const
+{
+	RaycastShapeType shapeType = static_cast<RaycastShapeType>(m_primitiveShapeTypes[primitiveIndex]);
+	if ((GetRaycastShapeMask(shapeType) & shapeTypeMask) == 0)
+	{
+		return RaycastResult2D();
+	}
+	return RaycastShape(shapeType, m_primitiveShapeIndices[primitiveIndex], rayStart, rayFwdNormal, rayMaxLength);
+}
+
+bool RaycastScene2D::DoesRayHitPrimitive(int primitiveIndex, Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, unsigned int shapeTypeMask) const
+{
+	RaycastShapeType shapeType = static_cast<RaycastShapeType>(m_primitiveShapeTypes[primitiveIndex]);
+	if ((GetRaycastShapeMask(shapeType) & shapeTypeMask) == 0)
+	{
+		return false;
+	}
+	return DoesRayHitShape(shapeType, m_primitiveShapeIndices[primitiveIndex], rayStart, rayFwdNormal, rayMaxLength);
+}
+
+void RaycastScene2D::SetHitShape(RaycastSceneHit2D& hit, int primitiveIndex) const
+{
+	if (primitiveIndex < 0)
+	{
+		hit.m_shapeIndex = -1;
+		return;
+	}
+	hit.m_shapeType = static_cast<RaycastShapeType>(m_primitiveShapeTypes[primitiveIndex]);
+	hit.m_shapeIndex = m_primitiveShapeIndices[primitiveIndex];
+}
+
+RaycastSceneHit2D RaycastScene2D::RaycastNearest(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, unsigned int shapeTypeMask, BVH2DQueryStats& out_stats) const
+{
+	RaycastSceneHit2D hit;
+	int primitiveIndex = -1;
+	hit.m_result = m_bvh.RaycastNearest(rayStart, rayFwdNormal, rayMaxLength,
+		[this, &rayStart, &rayFwdNormal, rayMaxLength, shapeTypeMask](int primitiveIndex)
+		{
+			return RaycastPrimitive(primitiveIndex, rayStart, rayFwdNormal, rayMaxLength, shapeTypeMask);
+		},
+		primitiveIndex, out_stats);
+	SetHitShape(hit, primitiveIndex);
+	return hit;
+}
+
+RaycastSceneHit2D RaycastScene2D::RaycastNearestBruteForce(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, unsigned int shapeTypeMask, BVH2DQueryStats& out_stats) const
+{
+	RaycastSceneHit2D hit;
+	out_stats = BVH2DQueryStats();
+	for (int shapeType = 0; shapeType < RAYCAST_SHAPE_COUNT; ++shapeType)
+	{
+		if ((GetRaycastShapeMask(static_cast<RaycastShapeType>(shapeType)) & shapeTypeMask) == 0)
+		{
+			continue;
+		}
+
+		int numShapesOfType = GetNumShapes(static_cast<RaycastShapeType>(shapeType));
+		for (int shapeIndex = 0; shapeIndex < numShapesOfType; ++shapeIndex)
+		{
+			++out_stats.m_numPrimitivesTested;
+			RaycastResult2D impact = RaycastShape(static_cast<RaycastShapeType>(shapeType), shapeIndex, rayStart, rayFwdNormal, rayMaxLength);
+			if (impact.m_didImpact && (hit.m_shapeIndex < 0 || impact.m_impactDist < hit.m_result.m_impactDist))
+			{
+				hit.m_result = impact;
+				hit.m_shapeType = static_cast<RaycastShapeType>(shapeType);
+				hit.m_shapeIndex = shapeIndex;
+			}
+		}
+	}
+	return hit;
+}
+
+void RaycastScene2D::RaycastNearestBatch(WorkerPool& workerPool, std::vector<BVH2DRay> const& rays, unsigned int shapeTypeMask,
+	std::vector<RaycastSceneHit2D>& out_hits, BVH2DQueryStats& out_stats) const
+{
+	std::vector<RaycastResult2D> results;
+	std::vector<int> primitiveIndices;
+	m_bvh.RaycastNearestBatch(workerPool, rays,
+		[this, shapeTypeMask](BVH2DRay const& ray, int primitiveIndex)
+		{
+			return RaycastPrimitive(primitiveIndex, ray.m_start, ray.m_fwdNormal, ray.m_maxLength, shapeTypeMask);
+		},
+		results, primitiveIndices, out_stats);
+
+	int numRays = static_cast<int>(rays.size());
+	out_hits.resize(numRays);
+	for (int rayIndex = 0; rayIndex < numRays; ++rayIndex)
+	{
+		out_hits[rayIndex].m_result = results[rayIndex];
+		SetHitShape(out_hits[rayIndex], primitiveIndices[rayIndex]);
+	}
+}
+
+bool RaycastScene2D::RaycastAny(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, unsigned int shapeTypeMask,
+	RaycastShapeType& out_shapeType, int& out_shapeIndex, BVH2DQueryStats& out_stats) const
+{
+	int primitiveIndex = -1;
+	bool didHit = m_bvh.RaycastAny(rayStart, rayFwdNormal, rayMaxLength,
+		[this, &rayStart, &rayFwdNormal, rayMaxLength, shapeTypeMask](int primitiveIndex)
+		{
+			return DoesRayHitPrimitive(primitiveIndex, rayStart, rayFwdNormal, rayMaxLength, shapeTypeMask);
+		},
+		primitiveIndex, out_stats);
+	if (didHit)
+	{
+		out_shapeType = static_cast<RaycastShapeType>(m_primitiveShapeTypes[primitiveIndex]);
+		out_shapeIndex = m_primitiveShapeIndices[primitiveIndex];
+	}
+	return didHit;
+}
+
+bool RaycastScene2D::RaycastAnyBruteForce(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, unsigned int shapeTypeMask,
+	RaycastShapeType& out_shapeType, int& out_shapeIndex, BVH2DQueryStats& out_stats) const
+{
+	out_stats = BVH2DQueryStats();
+	for (int shapeType = 0; shapeType < RAYCAST_SHAPE_COUNT; ++shapeType)
+	{
+		if ((GetRaycastShapeMask(static_cast<RaycastShapeType>(shapeType)) & shapeTypeMask) == 0)
+		{
+			continue;
+		}
+
+		int numShapesOfType = GetNumShapes(static_cast<RaycastShapeType>(shapeType));
+		for (int shapeIndex = 0; shapeIndex < numShapesOfType; ++shapeIndex)
+		{
+			++out_stats.m_numPrimitivesTested;
+			if (DoesRayHitShape(static_cast<RaycastShapeType>(shapeType), shapeIndex, rayStart, rayFwdNormal, rayMaxLength))
+			{
+				out_shapeType = static_cast<RaycastShapeType>(shapeType);
+				out_shapeIndex = shapeIndex;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void RaycastScene2D::AddVertsForShape(std::vector<Vertex_PCU>& verts, RaycastShapeType shapeType, int shapeIndex, Rgba8 const& color) const
+{
+	switch (shapeType)
+	{
+	case RAYCAST_SHAPE_DISC:
+		AddVertsForDisc2D(verts, m_discCenters[shapeIndex], m_discRadii[shapeIndex], color);
+		break;
+	case RAYCAST_SHAPE_LINE_SEGMENT:
+		AddVertsForLineSegment2D(verts, m_lineSegmentStarts[shapeIndex], m_lineSegmentEnds[shapeIndex], 3.f, color);
+		break;
+	case RAYCAST_SHAPE_AABB2:
+		AddVertsForAABB2D(verts, m_AABB2s[shapeIndex], color);
+		break;
+	case RAYCAST_SHAPE_OBB2:
+		AddVertsForOBB2D(verts, OBB2(m_OBB2Centers[shapeIndex], m_OBB2IBasisNormals[shapeIndex], m_OBB2HalfDimensions[shapeIndex]), color);
+		break;
+	case RAYCAST_SHAPE_CAPSULE:
+		AddVertsForCapsule2D(verts, m_capsuleBoneStarts[shapeIndex], m_capsuleBoneEnds[shapeIndex], m_capsuleRadii[shapeIndex], color);
+		break;
+	default:
+		break;
+	}
+}
+
+void RaycastScene2D::AddVertsForShapes(std::vector<Vertex_PCU>& verts, unsigned int shapeTypeMask, Rgba8 const& color) const
+{
+	for (int shapeType = 0; shapeType < RAYCAST_SHAPE_COUNT; ++shapeType)
+	{
+		if ((GetRaycastShapeMask(static_cast<RaycastShapeType>(shapeType)) & shapeTypeMask) == 0)
+		{
+			continue;
+		}
+
+		int numShapesOfType = GetNumShapes(static_cast<RaycastShapeType>(shapeType));
+		for (int shapeIndex = 0; shapeIndex < numShapesOfType; ++shapeIndex)
+		{
+			AddVertsForShape(verts, static_cast<RaycastShapeType>(shapeType), shapeIndex, color);
+		}
+	}
+}
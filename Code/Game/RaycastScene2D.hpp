@@ -0,0 +1,118 @@
+#pragma once
+#include "Game/BVH2D.hpp"
+#include "Engine/Math/AABB2.h"
+#include "Engine/Math/OBB2.hpp"
+#include "Engine/Math/RaycastUtils.hpp"
+#include "Engine/Core/Rgba8.h"
+#include "Engine/Core/Vertex_PCU.h"
+#include <vector>
+// -----------------------------------------------------------------------------
+class WorkerPool;
+// -----------------------------------------------------------------------------
+enum RaycastShapeType
+{
+	RAYCAST_SHAPE_DISC,
+	RAYCAST_SHAPE_LINE_SEGMENT,
+	RAYCAST_SHAPE_AABB2,
+	RAYCAST_SHAPE_OBB2,
+	RAYCAST_SHAPE_CAPSULE,
+	RAYCAST_SHAPE_COUNT
+};
+
+// Queries take a mask of the shape types they see, bit (1 << RaycastShapeType) per type
+const unsigned int RAYCAST_SHAPE_MASK_ALL = (1u << RAYCAST_SHAPE_COUNT) - 1u;
+
+unsigned int GetRaycastShapeMask(RaycastShapeType shapeType);
+char const*	 GetRaycastShapeTypeName(RaycastShapeType shapeType);
+// -----------------------------------------------------------------------------
+struct RaycastSceneHit2D
+{
+	RaycastResult2D	 m_result;
+	RaycastShapeType m_shapeType = RAYCAST_SHAPE_DISC;
+	int				 m_shapeIndex = -1;
+};
+// -----------------------------------------------------------------------------
+// Engine-style raycasts for the two shapes RaycastUtils has no 2D version of. A ray starting
+// inside the shape hits it at distance 0, facing back along the ray.
+RaycastResult2D RaycastVsOBB2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, OBB2 const& box);
+RaycastResult2D RaycastVsCapsule2D(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, Vec2 const& boneStart, Vec2 const& boneEnd, float radius);
+// -----------------------------------------------------------------------------
+// Discs, line segments, AABB2s, OBB2s and capsules, each type in its own pool of per-field
+// arrays, all under one BVH2D. A shape is named by its type and its index in that type's pool,
+// which is the order it was added in. Queries skip the types their mask leaves out, so one
+// scene can serve views of a single type as well as the mixed whole.
+// -----------------------------------------------------------------------------
+class RaycastScene2D
+{
+public:
+	void Clear();
+	int  AddDisc(Vec2 const& center, float radius);
+	int  AddLineSegment(Vec2 const& start, Vec2 const& end);
+	int  AddAABB2(AABB2 const& box);
+	int  AddOBB2(OBB2 const& box);
+	int  AddCapsule(Vec2 const& boneStart, Vec2 const& boneEnd, float radius);
+
+	// A shape of the given type about size across, turned to face direction where that means anything
+	int  AddShape(RaycastShapeType shapeType, Vec2 const& center, float size, Vec2 const& direction);
+
+	// Moves a shape without touching the BVH, which needs a refit or rebuild before queries see it
+	void TranslateShape(RaycastShapeType shapeType, int shapeIndex, Vec2 const& displacement);
+
+	// Shapes added since the last build aren't queried until the BVH is built again. A refit is
+	// enough after shapes only moved, but the tree gets slower to query the further they go.
+	void BuildBVH();
+	void RefitBVH();
+
+	int  GetNumShapes() const;
+	int  GetNumShapes(RaycastShapeType shapeType) const;
+	BVH2D const& GetBVH() const			{ return m_bvh; }
+	AABB2 GetShapeBounds(RaycastShapeType shapeType, int shapeIndex) const;
+
+	RaycastResult2D RaycastShape(RaycastShapeType shapeType, int shapeIndex, Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength) const;
+	bool DoesRayHitShape(RaycastShapeType shapeType, int shapeIndex, Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength) const;
+
+	// Nearest hit among the shape types in shapeTypeMask; m_shapeIndex is -1 on a miss
+	RaycastSceneHit2D RaycastNearest(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, unsigned int shapeTypeMask, BVH2DQueryStats& out_stats) const;
+	RaycastSceneHit2D RaycastNearestBruteForce(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, unsigned int shapeTypeMask, BVH2DQueryStats& out_stats) const;
+	void RaycastNearestBatch(WorkerPool& workerPool, std::vector<BVH2DRay> const& rays, unsigned int shapeTypeMask,
+		std::vector<RaycastSceneHit2D>& out_hits, BVH2DQueryStats& out_stats) const;
+
+	// Whether anything in shapeTypeMask blocks the ray, stopping at the first shape found; the
+	// out shape is that one, which needn't be the nearest, and is left alone on a miss
+	bool RaycastAny(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, unsigned int shapeTypeMask,
+		RaycastShapeType& out_shapeType, int& out_shapeIndex, BVH2DQueryStats& out_stats) const;
+	bool RaycastAnyBruteForce(Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, unsigned int shapeTypeMask,
+		RaycastShapeType& out_shapeType, int& out_shapeIndex, BVH2DQueryStats& out_stats) const;
+
+	void AddVertsForShape(std::vector<Vertex_PCU>& verts, RaycastShapeType shapeType, int shapeIndex, Rgba8 const& color) const;
+	void AddVertsForShapes(std::vector<Vertex_PCU>& verts, unsigned int shapeTypeMask, Rgba8 const& color) const;
+
+private:
+	void UpdatePrimitiveBounds();
+	RaycastResult2D RaycastPrimitive(int primitiveIndex, Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, unsigned int shapeTypeMask) const;
+	bool DoesRayHitPrimitive(int primitiveIndex, Vec2 const& rayStart, Vec2 const& rayFwdNormal, float rayMaxLength, unsigned int shapeTypeMask) const;
+	void SetHitShape(RaycastSceneHit2D& hit, int primitiveIndex) const;
+
+private:
+	std::vector<Vec2>  m_discCenters;
+	std::vector<float> m_discRadii;
+
+	std::vector<Vec2>  m_lineSegmentStarts;
+	std::vector<Vec2>  m_lineSegmentEnds;
+
+	std::vector<AABB2> m_AABB2s;
+
+	std::vector<Vec2>  m_OBB2Centers;
+	std::vector<Vec2>  m_OBB2IBasisNormals;
+	std::vector<Vec2>  m_OBB2HalfDimensions;
+
+	std::vector<Vec2>  m_capsuleBoneStarts;
+	std::vector<Vec2>  m_capsuleBoneEnds;
+	std::vector<float> m_capsuleRadii;
+
+	// BVH primitive i is shape m_primitiveShapeIndices[i] of type m_primitiveShapeTypes[i]
+	BVH2D m_bvh;
+	std::vector<unsigned char> m_primitiveShapeTypes;
+	std::vector<int>		   m_primitiveShapeIndices;
+	std::vector<AABB2>		   m_primitiveBounds;
+};
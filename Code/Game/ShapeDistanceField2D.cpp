@@ -0,0 +1,311 @@
+#include "Game/ShapeDistanceField2D.hpp"
+#include "Engine/Math/MathUtils.h"
+#include <chrono>
+#include <math.h>
+
+static double GetBakeTimeSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool IsBakeCancelled(std::atomic<bool> const* isCancelled)
+{
+	return isCancelled != nullptr && isCancelled->load(std::memory_order_relaxed);
+}
+
+static float GetSmallest(float a, float b)
+{
+	return (a < b) ? a : b;
+}
+
+// -----------------------------------------------------------------------------
+Vec2 GetNearestPointOnShapes2D(Vec2 const& point, NearestPointShapes2D const& shapes)
+{
+	Vec2 points[7] =
+	{
+		GetNearestPointOnDisc2D(point, shapes.m_discCenter, shapes.m_discRadius),
+		GetNearestPointOnAABB2D(point, shapes.m_alignedBox),
+		GetNearestPointOnOBB2D(point, shapes.m_orientedBox),
+		GetNearestPointOnCapsule2D(point, shapes.m_boneStart, shapes.m_boneEnd, shapes.m_capsuleRadius),
+		GetNearestPointOnTriangle2D(point, shapes.m_ccw0, shapes.m_ccw1, shapes.m_ccw2),
+		GetNearestPointOnLineSegment2D(point, shapes.m_start, shapes.m_end),
+		GetNearestPointOnInfiniteLine2D(point, shapes.m_infiniteStart, shapes.m_infiniteEnd)
+	};
+
+	// Same tie-break as GameNearestPoint::GetClosestPointToPlayer, first shape wins
+	int closestIndex = 0;
+	float closestDistSquared = GetDistanceSquared2D(points[0], point);
+	for (int pointIndex = 1; pointIndex < 7; ++pointIndex)
+	{
+		float distSquared = GetDistanceSquared2D(points[pointIndex], point);
+		if (distSquared < closestDistSquared)
+		{
+			closestDistSquared = distSquared;
+			closestIndex = pointIndex;
+		}
+	}
+	return points[closestIndex];
+}
+
+float GetSignedDistanceToShapes2D(Vec2 const& point, NearestPointShapes2D const& shapes)
+{
+	float discDist = GetDistance2D(point, shapes.m_discCenter) - shapes.m_discRadius;
+
+	float alignedBoxDist = 0.f;
+	AABB2 const& alignedBox = shapes.m_alignedBox;
+	if (IsPointInsideAABB2D(point, alignedBox))
+	{
+		float edgeDistX = GetSmallest(point.x - alignedBox.m_mins.x, alignedBox.m_maxs.x - point.x);
+		float edgeDistY = GetSmallest(point.y - alignedBox.m_mins.y, alignedBox.m_maxs.y - point.y);
+		alignedBoxDist = -GetSmallest(edgeDistX, edgeDistY);
+	}
+	else
+	{
+		alignedBoxDist = GetDistance2D(point, GetNearestPointOnAABB2D(point, alignedBox));
+	}
+
+	float orientedBoxDist = 0.f;
+	OBB2 const& orientedBox = shapes.m_orientedBox;
+	Vec2 iBasis = orientedBox.m_iBasisNormal;
+	Vec2 jBasis(-iBasis.y, iBasis.x);
+	Vec2 centerToPoint = point - orientedBox.m_center;
+	float edgeDistI = orientedBox.m_halfDimensions.x - fabsf(DotProduct2D(centerToPoint, iBasis));
+	float edgeDistJ = orientedBox.m_halfDimensions.y - fabsf(DotProduct2D(centerToPoint, jBasis));
+	if (edgeDistI >= 0.f && edgeDistJ >= 0.f)
+	{
+		orientedBoxDist = -GetSmallest(edgeDistI, edgeDistJ);
+	}
+	else
+	{
+		orientedBoxDist = GetDistance2D(point, GetNearestPointOnOBB2D(point, orientedBox));
+	}
+
+	Vec2 nearestBonePoint = GetNearestPointOnLineSegment2D(point, shapes.m_boneStart, shapes.m_boneEnd);
+	float capsuleDist = GetDistance2D(point, nearestBonePoint) - shapes.m_capsuleRadius;
+
+	float triangleDist = 0.f;
+	if (IsPointInsideTriangle2D(point, shapes.m_ccw0, shapes.m_ccw1, shapes.m_ccw2))
+	{
+		float edgeDist01 = GetDistance2D(point, GetNearestPointOnLineSegment2D(point, shapes.m_ccw0, shapes.m_ccw1));
+		float edgeDist12 = GetDistance2D(point, GetNearestPointOnLineSegment2D(point, shapes.m_ccw1, shapes.m_ccw2));
+		float edgeDist20 = GetDistance2D(point, GetNearestPointOnLineSegment2D(point, shapes.m_ccw2, shapes.m_ccw0));
+		triangleDist = -GetSmallest(edgeDist01, GetSmallest(edgeDist12, edgeDist20));
+	}
+	else
+	{
+		triangleDist = GetDistance2D(point, GetNearestPointOnTriangle2D(point, shapes.m_ccw0, shapes.m_ccw1, shapes.m_ccw2));
+	}
+
+	float lineSegmentDist = GetDistance2D(point, GetNearestPointOnLineSegment2D(point, shapes.m_start, shapes.m_end));
+	float infiniteLineDist = GetDistance2D(point, GetNearestPointOnInfiniteLine2D(point, shapes.m_infiniteStart, shapes.m_infiniteEnd));
+
+	// The union is as far as its nearest shape, and as deep inside as its deepest
+	float signedDist = GetSmallest(discDist, alignedBoxDist);
+	signedDist = GetSmallest(signedDist, orientedBoxDist);
+	signedDist = GetSmallest(signedDist, capsuleDist);
+	signedDist = GetSmallest(signedDist, triangleDist);
+	signedDist = GetSmallest(signedDist, lineSegmentDist);
+	signedDist = GetSmallest(signedDist, infiniteLineDist);
+	return signedDist;
+}
+
+// -----------------------------------------------------------------------------
+bool ShapeDistanceField2D::Bake(NearestPointShapes2D const& shapes, AABB2 const& bounds, float coarseCellSize, int numFineCellsPerCoarseCell, float refineTolerance, std::atomic<bool> const* isCancelled)
+{
+	double bakeStartTime = GetBakeTimeSeconds();
+
+	m_shapes = shapes;
+	m_coarseCellSize = (coarseCellSize > 0.f) ? coarseCellSize : 1.f;
+	m_numFineCellsPerCoarseCell = (numFineCellsPerCoarseCell > 0) ? numFineCellsPerCoarseCell : 1;
+	m_fineCellSize = m_coarseCellSize / static_cast<float>(m_numFineCellsPerCoarseCell);
+
+	// The bounds grow to a whole number of coarse cells
+	Vec2 boundsDims = bounds.GetDimensions();
+	m_numCoarseCellsX = static_cast<int>(ceilf(boundsDims.x / m_coarseCellSize));
+	m_numCoarseCellsY = static_cast<int>(ceilf(boundsDims.y / m_coarseCellSize));
+	m_numCoarseCellsX = (m_numCoarseCellsX > 0) ? m_numCoarseCellsX : 1;
+	m_numCoarseCellsY = (m_numCoarseCellsY > 0) ? m_numCoarseCellsY : 1;
+	m_bounds = AABB2(bounds.m_mins, bounds.m_mins + Vec2(m_numCoarseCellsX * m_coarseCellSize, m_numCoarseCellsY * m_coarseCellSize));
+
+	int numCoarseSamplesX = m_numCoarseCellsX + 1;
+	m_coarseSamples.resize(numCoarseSamplesX * (m_numCoarseCellsY + 1));
+	for (int sampleY = 0; sampleY <= m_numCoarseCellsY; ++sampleY)
+	{
+		if (IsBakeCancelled(isCancelled))
+		{
+			return false;
+		}
+		for (int sampleX = 0; sampleX <= m_numCoarseCellsX; ++sampleX)
+		{
+			Vec2 samplePoint = m_bounds.m_mins + Vec2(sampleX * m_coarseCellSize, sampleY * m_coarseCellSize);
+			m_coarseSamples[sampleY * numCoarseSamplesX + sampleX] = GetSignedDistanceToShapes2D(samplePoint, m_shapes);
+		}
+	}
+
+	// The distance changes by at most the distance moved, so a cell no corner of which is
+	// within a diagonal of an edge has no edge in it
+	float refineDist = m_coarseCellSize * 1.4143f;
+	int numFineSamplesPerRow = m_numFineCellsPerCoarseCell + 1;
+	int numFineSamplesPerBlock = numFineSamplesPerRow * numFineSamplesPerRow;
+	m_coarseCellFineBlocks.assign(m_numCoarseCellsX * m_numCoarseCellsY, -1);
+	m_fineSamples.clear();
+	m_numFineBlocks = 0;
+	for (int cellY = 0; cellY < m_numCoarseCellsY; ++cellY)
+	{
+		if (IsBakeCancelled(isCancelled))
+		{
+			return false;
+		}
+		for (int cellX = 0; cellX < m_numCoarseCellsX; ++cellX)
+		{
+			int cornerIndex = cellY * numCoarseSamplesX + cellX;
+			float nearestCornerDist = fabsf(m_coarseSamples[cornerIndex]);
+			nearestCornerDist = GetSmallest(nearestCornerDist, fabsf(m_coarseSamples[cornerIndex + 1]));
+			nearestCornerDist = GetSmallest(nearestCornerDist, fabsf(m_coarseSamples[cornerIndex + numCoarseSamplesX]));
+			nearestCornerDist = GetSmallest(nearestCornerDist, fabsf(m_coarseSamples[cornerIndex + numCoarseSamplesX + 1]));
+			if (nearestCornerDist > refineDist)
+			{
+				// Away from edges the field only bends where the nearest shape changes
+				Vec2 cellCenter = m_bounds.m_mins + Vec2((cellX + 0.5f) * m_coarseCellSize, (cellY + 0.5f) * m_coarseCellSize);
+				float interpolatedDist = 0.25f * (m_coarseSamples[cornerIndex] + m_coarseSamples[cornerIndex + 1]
+					+ m_coarseSamples[cornerIndex + numCoarseSamplesX] + m_coarseSamples[cornerIndex + numCoarseSamplesX + 1]);
+				if (fabsf(GetSignedDistanceToShapes2D(cellCenter, m_shapes) - interpolatedDist) <= refineTolerance)
+				{
+					continue;
+				}
+			}
+
+			m_coarseCellFineBlocks[cellY * m_numCoarseCellsX + cellX] = m_numFineBlocks;
+			++m_numFineBlocks;
+
+			Vec2 cellMins = m_bounds.m_mins + Vec2(cellX * m_coarseCellSize, cellY * m_coarseCellSize);
+			int firstSample = static_cast<int>(m_fineSamples.size());
+			m_fineSamples.resize(firstSample + numFineSamplesPerBlock);
+			for (int sampleY = 0; sampleY < numFineSamplesPerRow; ++sampleY)
+			{
+				for (int sampleX = 0; sampleX < numFineSamplesPerRow; ++sampleX)
+				{
+					Vec2 samplePoint = cellMins + Vec2(sampleX * m_fineCellSize, sampleY * m_fineCellSize);
+					m_fineSamples[firstSample + sampleY * numFineSamplesPerRow + sampleX] = GetSignedDistanceToShapes2D(samplePoint, m_shapes);
+				}
+			}
+		}
+	}
+
+	m_bakeSeconds = GetBakeTimeSeconds() - bakeStartTime;
+	return true;
+}
+
+bool ShapeDistanceField2D::BakeErrorHeatmap(int numColumns, int numRows, std::atomic<bool> const* isCancelled)
+{
+	m_numHeatmapColumns = (numColumns > 0) ? numColumns : 1;
+	m_numHeatmapRows = (numRows > 0) ? numRows : 1;
+	m_heatmapErrors.resize(m_numHeatmapColumns * m_numHeatmapRows);
+
+	Vec2 boundsDims = m_bounds.GetDimensions();
+	Vec2 heatmapCellDims(boundsDims.x / static_cast<float>(m_numHeatmapColumns), boundsDims.y / static_cast<float>(m_numHeatmapRows));
+	double errorSum = 0.0;
+	m_maxHeatmapError = 0.f;
+	for (int row = 0; row < m_numHeatmapRows; ++row)
+	{
+		if (IsBakeCancelled(isCancelled))
+		{
+			return false;
+		}
+		for (int column = 0; column < m_numHeatmapColumns; ++column)
+		{
+			Vec2 cellCenter = m_bounds.m_mins + Vec2((column + 0.5f) * heatmapCellDims.x, (row + 0.5f) * heatmapCellDims.y);
+			float exactDist = GetSignedDistanceToShapes2D(cellCenter, m_shapes);
+			exactDist = (exactDist > 0.f) ? exactDist : 0.f;
+
+			Vec2 nearestPoint;
+			float error = fabsf(GetDistanceAndNearestPoint(cellCenter, nearestPoint) - exactDist);
+			m_heatmapErrors[row * m_numHeatmapColumns + column] = error;
+			errorSum += error;
+			if (error > m_maxHeatmapError)
+			{
+				m_maxHeatmapError = error;
+			}
+		}
+	}
+	m_meanHeatmapError = static_cast<float>(errorSum / static_cast<double>(m_heatmapErrors.size()));
+	return true;
+}
+
+float ShapeDistanceField2D::GetSignedDistance(Vec2 const& point) const
+{
+	Vec2 clampedPoint(GetClamped(point.x, m_bounds.m_mins.x, m_bounds.m_maxs.x), GetClamped(point.y, m_bounds.m_mins.y, m_bounds.m_maxs.y));
+	Vec2 gradient;
+	return LookupInsideBounds(clampedPoint, gradient) + GetDistance2D(point, clampedPoint);
+}
+
+float ShapeDistanceField2D::GetDistanceAndNearestPoint(Vec2 const& point, Vec2& out_nearestPoint) const
+{
+	Vec2 clampedPoint(GetClamped(point.x, m_bounds.m_mins.x, m_bounds.m_maxs.x), GetClamped(point.y, m_bounds.m_mins.y, m_bounds.m_maxs.y));
+	Vec2 gradient;
+	float signedDist = LookupInsideBounds(clampedPoint, gradient);
+
+	// Inside a shape the nearest point is the point itself, as with the GetNearestPointOn* functions
+	out_nearestPoint = clampedPoint;
+	float gradientLength = gradient.GetLength();
+	if (signedDist > 0.f && gradientLength > 0.f)
+	{
+		out_nearestPoint = clampedPoint - gradient * (signedDist / gradientLength);
+	}
+	return GetDistance2D(point, out_nearestPoint);
+}
+
+int ShapeDistanceField2D::GetNumSamples() const
+{
+	return static_cast<int>(m_coarseSamples.size()) + static_cast<int>(m_fineSamples.size());
+}
+
+float ShapeDistanceField2D::SampleCell(float const* samples, int samplesPerRow, int cellX, int cellY, float cellSize, Vec2 const& gridOffset, Vec2& out_gradient) const
+{
+	int cornerIndex = cellY * samplesPerRow + cellX;
+	float dist00 = samples[cornerIndex];
+	float dist10 = samples[cornerIndex + 1];
+	float dist01 = samples[cornerIndex + samplesPerRow];
+	float dist11 = samples[cornerIndex + samplesPerRow + 1];
+
+	float u = GetClampedZeroToOne(gridOffset.x / cellSize - static_cast<float>(cellX));
+	float v = GetClampedZeroToOne(gridOffset.y / cellSize - static_cast<float>(cellY));
+
+	out_gradient.x = ((dist10 - dist00) * (1.f - v) + (dist11 - dist01) * v) / cellSize;
+	out_gradient.y = ((dist01 - dist00) * (1.f - u) + (dist11 - dist10) * u) / cellSize;
+
+	float bottomDist = dist00 + (dist10 - dist00) * u;
+	float topDist = dist01 + (dist11 - dist01) * u;
+	return bottomDist + (topDist - bottomDist) * v;
+}
+
+float ShapeDistanceField2D::LookupInsideBounds(Vec2 const& point, Vec2& out_gradient) const
+{
+	Vec2 boundsOffset = point - m_bounds.m_mins;
+	int cellX = static_cast<int>(boundsOffset.x / m_coarseCellSize);
+	int cellY = static_cast<int>(boundsOffset.y / m_coarseCellSize);
+	cellX = (cellX < m_numCoarseCellsX - 1) ? cellX : m_numCoarseCellsX - 1;
+	cellY = (cellY < m_numCoarseCellsY - 1) ? cellY : m_numCoarseCellsY - 1;
+	cellX = (cellX > 0) ? cellX : 0;
+	cellY = (cellY > 0) ? cellY : 0;
+
+	int fineBlock = m_coarseCellFineBlocks[cellY * m_numCoarseCellsX + cellX];
+	if (fineBlock < 0)
+	{
+		return SampleCell(m_coarseSamples.data(), m_numCoarseCellsX + 1, cellX, cellY, m_coarseCellSize, boundsOffset, out_gradient);
+	}
+
+	// Fine blocks are their own little grids, starting at the coarse cell's mins
+	Vec2 cellOffset = boundsOffset - Vec2(cellX * m_coarseCellSize, cellY * m_coarseCellSize);
+	int fineCellX = static_cast<int>(cellOffset.x / m_fineCellSize);
+	int fineCellY = static_cast<int>(cellOffset.y / m_fineCellSize);
+	int lastFineCell = m_numFineCellsPerCoarseCell - 1;
+	fineCellX = (fineCellX < lastFineCell) ? fineCellX : lastFineCell;
+	fineCellY = (fineCellY < lastFineCell) ? fineCellY : lastFineCell;
+	fineCellX = (fineCellX > 0) ? fineCellX : 0;
+	fineCellY = (fineCellY > 0) ? fineCellY : 0;
+
+	int numFineSamplesPerRow = m_numFineCellsPerCoarseCell + 1;
+	float const* blockSamples = m_fineSamples.data() + fineBlock * numFineSamplesPerRow * numFineSamplesPerRow;
+	return SampleCell(blockSamples, numFineSamplesPerRow, fineCellX, fineCellY, m_fineCellSize, cellOffset, out_gradient);
+}
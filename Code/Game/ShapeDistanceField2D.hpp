@@ -0,0 +1,103 @@
+#pragma once
+#include "Engine/Math/Vec2.hpp"
+#include "Engine/Math/AABB2.h"
+#include "Engine/Math/OBB2.hpp"
+#include <atomic>
+#include <vector>
+// -----------------------------------------------------------------------------
+// The seven shapes of the nearest point mode, by value so a bake can own a copy
+struct NearestPointShapes2D
+{
+	Vec2  m_discCenter = Vec2::ZERO;
+	float m_discRadius = 0.f;
+
+	AABB2 m_alignedBox;
+	OBB2  m_orientedBox;
+
+	Vec2  m_boneStart = Vec2::ZERO;
+	Vec2  m_boneEnd = Vec2::ZERO;
+	float m_capsuleRadius = 0.f;
+
+	Vec2 m_ccw0 = Vec2::ZERO;
+	Vec2 m_ccw1 = Vec2::ZERO;
+	Vec2 m_ccw2 = Vec2::ZERO;
+
+	Vec2 m_start = Vec2::ZERO;
+	Vec2 m_end = Vec2::ZERO;
+
+	Vec2 m_infiniteStart = Vec2::ZERO;
+	Vec2 m_infiniteEnd = Vec2::ZERO;
+};
+// -----------------------------------------------------------------------------
+// Exact answers, from the same seven GetNearestPointOn* calls the mode makes. The signed
+// distance is negative inside the disc, boxes, capsule and triangle, by how far the nearest
+// edge is; the segment and infinite line have no inside.
+Vec2  GetNearestPointOnShapes2D(Vec2 const& point, NearestPointShapes2D const& shapes);
+float GetSignedDistanceToShapes2D(Vec2 const& point, NearestPointShapes2D const& shapes);
+// -----------------------------------------------------------------------------
+// Signed distance to a NearestPointShapes2D, sampled at the corners of a coarse grid over
+// fixed bounds. Coarse cells the field bends sharply in, at shape edges and where two shapes
+// are equally near, get a block of fine cells instead. A lookup finds its cell in one step and
+// interpolates the four corners bilinearly; the nearest point is one distance back down the
+// interpolated gradient, or the point itself when it is inside a shape.
+// -----------------------------------------------------------------------------
+class ShapeDistanceField2D
+{
+public:
+	// A coarse cell is refined if a shape edge could pass through it, or if the exact distance
+	// at its center is more than refineTolerance off what its corners interpolate to there.
+	// Both bakes check isCancelled once a row and return false, half done, once it is set.
+	bool Bake(NearestPointShapes2D const& shapes, AABB2 const& bounds, float coarseCellSize, int numFineCellsPerCoarseCell, float refineTolerance, std::atomic<bool> const* isCancelled = nullptr);
+
+	// Samples the lookup error against the exact distance at the centers of a
+	// numColumns by numRows grid over the bounds, for the heatmap overlay
+	bool BakeErrorHeatmap(int numColumns, int numRows, std::atomic<bool> const* isCancelled = nullptr);
+
+	// Points outside the bounds use the nearest point on the bounds, plus how far off they are
+	float GetSignedDistance(Vec2 const& point) const;
+	float GetDistanceAndNearestPoint(Vec2 const& point, Vec2& out_nearestPoint) const;
+
+	NearestPointShapes2D const& GetShapes() const	{ return m_shapes; }
+	AABB2 const& GetBounds() const					{ return m_bounds; }
+	float GetCoarseCellSize() const					{ return m_coarseCellSize; }
+	float GetFineCellSize() const					{ return m_fineCellSize; }
+	int   GetNumCoarseCells() const					{ return m_numCoarseCellsX * m_numCoarseCellsY; }
+	int   GetNumFineBlocks() const					{ return m_numFineBlocks; }
+	int   GetNumSamples() const;
+	double GetBakeSeconds() const					{ return m_bakeSeconds; }
+
+	int   GetNumHeatmapColumns() const				{ return m_numHeatmapColumns; }
+	int   GetNumHeatmapRows() const					{ return m_numHeatmapRows; }
+	float GetHeatmapError(int column, int row) const { return m_heatmapErrors[row * m_numHeatmapColumns + column]; }
+	float GetMaxHeatmapError() const				{ return m_maxHeatmapError; }
+	float GetMeanHeatmapError() const				{ return m_meanHeatmapError; }
+
+private:
+	// Bilinear distance within one cell of a sample grid, and its gradient
+	float SampleCell(float const* samples, int samplesPerRow, int cellX, int cellY, float cellSize, Vec2 const& gridOffset, Vec2& out_gradient) const;
+	float LookupInsideBounds(Vec2 const& point, Vec2& out_gradient) const;
+
+private:
+	NearestPointShapes2D m_shapes;
+	AABB2 m_bounds;
+	float m_coarseCellSize = 1.f;
+	float m_fineCellSize = 1.f;
+	int	  m_numCoarseCellsX = 0;
+	int	  m_numCoarseCellsY = 0;
+	int	  m_numFineCellsPerCoarseCell = 1;
+	int	  m_numFineBlocks = 0;
+
+	// (m_numCoarseCellsX + 1) by (m_numCoarseCellsY + 1) corner samples, row by row
+	std::vector<float> m_coarseSamples;
+	// Per coarse cell, the index of its fine block or -1; block b's (m_numFineCellsPerCoarseCell + 1)
+	// squared corner samples start at b times that in m_fineSamples
+	std::vector<int>   m_coarseCellFineBlocks;
+	std::vector<float> m_fineSamples;
+	double m_bakeSeconds = 0.0;
+
+	int	  m_numHeatmapColumns = 0;
+	int	  m_numHeatmapRows = 0;
+	std::vector<float> m_heatmapErrors;
+	float m_maxHeatmapError = 0.f;
+	float m_meanHeatmapError = 0.f;
+};
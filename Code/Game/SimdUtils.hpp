@@ -0,0 +1,51 @@
+#pragma once
+#include <immintrin.h>
+// -----------------------------------------------------------------------------
+// Thin wrappers so kernels can be written once and compiled 8-wide when the
+// build enables AVX (/arch:AVX), falling back to 4-wide SSE2 otherwise.
+// -----------------------------------------------------------------------------
+#if defined(__AVX__)
+typedef __m256 SimdFloat;
+constexpr int SIMD_WIDTH = 8;
+
+inline SimdFloat SimdLoad(float const* source)					{ return _mm256_loadu_ps(source); }
+inline void		 SimdStore(float* destination, SimdFloat value)	{ _mm256_storeu_ps(destination, value); }
+inline SimdFloat SimdSet(float value)							{ return _mm256_set1_ps(value); }
+inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b)				{ return _mm256_add_ps(a, b); }
+inline SimdFloat SimdSub(SimdFloat a, SimdFloat b)				{ return _mm256_sub_ps(a, b); }
+inline SimdFloat SimdMul(SimdFloat a, SimdFloat b)				{ return _mm256_mul_ps(a, b); }
+inline SimdFloat SimdDiv(SimdFloat a, SimdFloat b)				{ return _mm256_div_ps(a, b); }
+inline SimdFloat SimdMin(SimdFloat a, SimdFloat b)				{ return _mm256_min_ps(a, b); }
+inline SimdFloat SimdMax(SimdFloat a, SimdFloat b)				{ return _mm256_max_ps(a, b); }
+inline SimdFloat SimdSqrt(SimdFloat a)							{ return _mm256_sqrt_ps(a); }
+inline SimdFloat SimdLessThan(SimdFloat a, SimdFloat b)			{ return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline SimdFloat SimdLessEqual(SimdFloat a, SimdFloat b)		{ return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+inline SimdFloat SimdGreaterThan(SimdFloat a, SimdFloat b)		{ return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline SimdFloat SimdAnd(SimdFloat a, SimdFloat b)				{ return _mm256_and_ps(a, b); }
+inline SimdFloat SimdOr(SimdFloat a, SimdFloat b)				{ return _mm256_or_ps(a, b); }
+inline SimdFloat SimdAndNot(SimdFloat mask, SimdFloat value)	{ return _mm256_andnot_ps(mask, value); }
+inline SimdFloat SimdSelect(SimdFloat mask, SimdFloat ifTrue, SimdFloat ifFalse) { return _mm256_blendv_ps(ifFalse, ifTrue, mask); }
+inline int		 SimdMoveMask(SimdFloat mask)					{ return _mm256_movemask_ps(mask); }
+#else
+typedef __m128 SimdFloat;
+constexpr int SIMD_WIDTH = 4;
+
+inline SimdFloat SimdLoad(float const* source)					{ return _mm_loadu_ps(source); }
+inline void		 SimdStore(float* destination, SimdFloat value)	{ _mm_storeu_ps(destination, value); }
+inline SimdFloat SimdSet(float value)							{ return _mm_set1_ps(value); }
+inline SimdFloat SimdAdd(SimdFloat a, SimdFloat b)				{ return _mm_add_ps(a, b); }
+inline SimdFloat SimdSub(SimdFloat a, SimdFloat b)				{ return _mm_sub_ps(a, b); }
+inline SimdFloat SimdMul(SimdFloat a, SimdFloat b)				{ return _mm_mul_ps(a, b); }
+inline SimdFloat SimdDiv(SimdFloat a, SimdFloat b)				{ return _mm_div_ps(a, b); }
+inline SimdFloat SimdMin(SimdFloat a, SimdFloat b)				{ return _mm_min_ps(a, b); }
+inline SimdFloat SimdMax(SimdFloat a, SimdFloat b)				{ return _mm_max_ps(a, b); }
+inline SimdFloat SimdSqrt(SimdFloat a)							{ return _mm_sqrt_ps(a); }
+inline SimdFloat SimdLessThan(SimdFloat a, SimdFloat b)			{ return _mm_cmplt_ps(a, b); }
+inline SimdFloat SimdLessEqual(SimdFloat a, SimdFloat b)		{ return _mm_cmple_ps(a, b); }
+inline SimdFloat SimdGreaterThan(SimdFloat a, SimdFloat b)		{ return _mm_cmpgt_ps(a, b); }
+inline SimdFloat SimdAnd(SimdFloat a, SimdFloat b)				{ return _mm_and_ps(a, b); }
+inline SimdFloat SimdOr(SimdFloat a, SimdFloat b)				{ return _mm_or_ps(a, b); }
+inline SimdFloat SimdAndNot(SimdFloat mask, SimdFloat value)	{ return _mm_andnot_ps(mask, value); }
+inline SimdFloat SimdSelect(SimdFloat mask, SimdFloat ifTrue, SimdFloat ifFalse) { return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse)); }
+inline int		 SimdMoveMask(SimdFloat mask)					{ return _mm_movemask_ps(mask); }
+#endif
@@ -0,0 +1,93 @@
+#include "Game/WorkerPool.hpp"
+
+WorkerPool::WorkerPool(int numThreads)
+	:m_nextTask(0)
+{
+	// The calling thread always works too, so spawn one fewer
+	for (int threadIndex = 1; threadIndex < numThreads; ++threadIndex)
+	{
+		m_workers.emplace_back(&WorkerPool::WorkerMain, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isQuitting = true;
+	}
+	m_workAvailable.notify_all();
+
+	for (int workerIndex = 0; workerIndex < static_cast<int>(m_workers.size()); ++workerIndex)
+	{
+		m_workers[workerIndex].join();
+	}
+}
+
+void WorkerPool::ParallelFor(int numTasks, WorkerTaskFunction taskFunction, void const* context)
+{
+	if (m_workers.empty() || numTasks <= 1)
+	{
+		for (int taskIndex = 0; taskIndex < numTasks; ++taskIndex)
+		{
+			taskFunction(context, taskIndex);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_taskFunction = taskFunction;
+		m_taskContext = context;
+		m_numTasks = numTasks;
+		m_nextTask.store(0);
+		m_numWorkersDone = 0;
+		++m_generation;
+	}
+	m_workAvailable.notify_all();
+
+	RunTasks();
+
+	// Every worker checks in once per batch, so none can still be holding this batch's context afterwards
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_workFinished.wait(lock, [this]() { return m_numWorkersDone == static_cast<int>(m_workers.size()); });
+}
+
+void WorkerPool::WorkerMain()
+{
+	int seenGeneration = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_workAvailable.wait(lock, [this, seenGeneration]() { return m_isQuitting || m_generation != seenGeneration; });
+			if (m_isQuitting)
+			{
+				return;
+			}
+			seenGeneration = m_generation;
+		}
+
+		RunTasks();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			++m_numWorkersDone;
+		}
+		m_workFinished.notify_one();
+	}
+}
+
+void WorkerPool::RunTasks()
+{
+	while (true)
+	{
+		int taskIndex = m_nextTask.fetch_add(1);
+		if (taskIndex >= m_numTasks)
+		{
+			return;
+		}
+		m_taskFunction(m_taskContext, taskIndex);
+	}
+}
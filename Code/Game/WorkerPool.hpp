@@ -0,0 +1,58 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <vector>
+// -----------------------------------------------------------------------------
+typedef void (*WorkerTaskFunction)(void const* context, int taskIndex);
+// -----------------------------------------------------------------------------
+// Fixed set of worker threads that run ParallelFor batches alongside the calling
+// thread. Which thread runs a task is unspecified, so tasks must not depend on it.
+// -----------------------------------------------------------------------------
+class WorkerPool
+{
+public:
+	WorkerPool(int numThreads);
+	~WorkerPool();
+
+	int  GetNumThreads() const { return static_cast<int>(m_workers.size()) + 1; }
+
+	// Runs taskFunction(taskIndex) for taskIndex in [0, numTasks) and returns once all of them are done
+	template <typename TaskFunction>
+	void ParallelFor(int numTasks, TaskFunction const& taskFunction);
+	void ParallelFor(int numTasks, WorkerTaskFunction taskFunction, void const* context);
+
+private:
+	void WorkerMain();
+	void RunTasks();
+
+	template <typename TaskFunction>
+	static void InvokeTask(void const* context, int taskIndex);
+
+private:
+	std::vector<std::thread> m_workers;
+	std::mutex				 m_mutex;
+	std::condition_variable  m_workAvailable;
+	std::condition_variable  m_workFinished;
+
+	WorkerTaskFunction m_taskFunction = nullptr;
+	void const*		   m_taskContext = nullptr;
+	int				   m_numTasks = 0;
+	std::atomic<int>   m_nextTask;
+	int				   m_numWorkersDone = 0;
+	int				   m_generation = 0;
+	bool			   m_isQuitting = false;
+};
+// -----------------------------------------------------------------------------
+template <typename TaskFunction>
+void WorkerPool::ParallelFor(int numTasks, TaskFunction const& taskFunction)
+{
+	ParallelFor(numTasks, &InvokeTask<TaskFunction>, &taskFunction);
+}
+
+template <typename TaskFunction>
+void WorkerPool::InvokeTask(void const* context, int taskIndex)
+{
+	(*static_cast<TaskFunction const*>(context))(taskIndex);
+}
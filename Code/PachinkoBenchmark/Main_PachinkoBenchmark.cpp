@@ -0,0 +1,306 @@
+#include "Game/PachinkoSimulation.hpp"
+#include "Game/PachinkoRecording.hpp"
+#include "Game/GameCommon.h"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Math/RandomNumberGenerator.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------------------------
+// Headless pachinko benchmark: steps PachinkoSimulation with no Renderer, Window or Input and
+// prints ns/step per phase as JSON on stdout. With --replay it steps a recording made in
+// Game2DPachinko instead, as fast as it can, checking its checksums and finding the slowest step.
+// Usage (from the Run folder): PachinkoBenchmark [configFile] [--replay recordingFile]
+// The config defaults to Data/PachinkoBenchmark.xml. A replay takes the step config, toggles and
+// solver iterations from each recorded session, so its config only picks the thread count.
+//-----------------------------------------------------------------------------------------------
+static bool LoadBenchmarkConfig(char const* configXMLFilePath)
+{
+	XmlDocument configXml;
+	XmlError result = configXml.LoadFile(configXMLFilePath);
+	if (result != tinyxml2::XML_SUCCESS)
+	{
+		fprintf(stderr, "Failed to load benchmark config from file \"%s\"\n", configXMLFilePath);
+		return false;
+	}
+
+	XmlElement* rootElement = configXml.RootElement();
+	if (rootElement == nullptr)
+	{
+		fprintf(stderr, "Benchmark config from file \"%s\" was invalid (missing root element)\n", configXMLFilePath);
+		return false;
+	}
+
+	g_gameConfigBlackboard.PopulateFromXmlElementAttributes(*rootElement);
+	return true;
+}
+
+//-----------------------------------------------------------------------------------------------
+// The Engine RandomNumberGenerator has no seed of its own and rolls from the C runtime's rand(),
+// so srand is what makes a run repeatable. Checked rather than assumed: generators made after the
+// same srand must roll the same numbers, and another seed must change them.
+static bool SeedBenchmarkRandomNumbers(unsigned int seed)
+{
+	constexpr int NUM_CHECK_ROLLS = 4;
+	float otherSeedRolls[NUM_CHECK_ROLLS];
+	float firstRolls[NUM_CHECK_ROLLS];
+	float secondRolls[NUM_CHECK_ROLLS];
+
+	srand(seed + 1);
+	RandomNumberGenerator otherSeedRng;
+	for (int rollIndex = 0; rollIndex < NUM_CHECK_ROLLS; ++rollIndex)
+	{
+		otherSeedRolls[rollIndex] = otherSeedRng.RollRandomFloatZeroToOne();
+	}
+	srand(seed);
+	RandomNumberGenerator firstRng;
+	for (int rollIndex = 0; rollIndex < NUM_CHECK_ROLLS; ++rollIndex)
+	{
+		firstRolls[rollIndex] = firstRng.RollRandomFloatZeroToOne();
+	}
+	srand(seed);
+	RandomNumberGenerator secondRng;
+	for (int rollIndex = 0; rollIndex < NUM_CHECK_ROLLS; ++rollIndex)
+	{
+		secondRolls[rollIndex] = secondRng.RollRandomFloatZeroToOne();
+	}
+
+	bool isRepeatable = true;
+	bool isSeedUsed = false;
+	for (int rollIndex = 0; rollIndex < NUM_CHECK_ROLLS; ++rollIndex)
+	{
+		isRepeatable = isRepeatable && (firstRolls[rollIndex] == secondRolls[rollIndex]);
+		isSeedUsed = isSeedUsed || (firstRolls[rollIndex] != otherSeedRolls[rollIndex]);
+	}
+	if (!isRepeatable || !isSeedUsed)
+	{
+		fprintf(stderr, "The Engine RandomNumberGenerator no longer rolls from rand(), so srand cannot seed this benchmark\n");
+		return false;
+	}
+
+	srand(seed);
+	return true;
+}
+
+static double GetSecondsSince(std::chrono::steady_clock::time_point startTime)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+static void PrintPhaseNsPerStep(double totalSeconds, double const* phaseSeconds, int numSteps)
+{
+	double nsPerStepScale = (numSteps > 0) ? 1.0e9 / static_cast<double>(numSteps) : 0.0;
+	printf("  \"nsPerStep\": {\n");
+	printf("    \"total\": %.1f", totalSeconds * nsPerStepScale);
+	for (int phaseIndex = 0; phaseIndex < PACHINKO_PHASE_COUNT; ++phaseIndex)
+	{
+		printf(",\n    \"%s\": %.1f", GetPachinkoPhaseName(static_cast<PachinkoPhase>(phaseIndex)), phaseSeconds[phaseIndex] * nsPerStepScale);
+	}
+	printf("\n  }\n");
+}
+
+static int RunReplay(char const* configXMLFilePath, char const* recordingFilePath)
+{
+	PachinkoReplayer replayer;
+	if (!replayer.Open(recordingFilePath))
+	{
+		fprintf(stderr, "Failed to open recording \"%s\"\n", recordingFilePath);
+		return 1;
+	}
+
+	PachinkoSimulation simulation;
+	double phaseSeconds[PACHINKO_PHASE_COUNT] = {};
+	double slowestStepSeconds = 0.0;
+	int slowestStepIndex = -1;
+	double slowestStepPhaseSeconds[PACHINKO_PHASE_COUNT] = {};
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	while (replayer.ReplayNextStep(simulation))
+	{
+		double stepSeconds = 0.0;
+		for (int phaseIndex = 0; phaseIndex < PACHINKO_PHASE_COUNT; ++phaseIndex)
+		{
+			double stepPhaseSeconds = simulation.GetLastStepPhaseSeconds(static_cast<PachinkoPhase>(phaseIndex));
+			phaseSeconds[phaseIndex] += stepPhaseSeconds;
+			stepSeconds += stepPhaseSeconds;
+		}
+
+		if (stepSeconds > slowestStepSeconds)
+		{
+			slowestStepSeconds = stepSeconds;
+			slowestStepIndex = replayer.GetNumStepsReplayed() - 1;
+			for (int phaseIndex = 0; phaseIndex < PACHINKO_PHASE_COUNT; ++phaseIndex)
+			{
+				slowestStepPhaseSeconds[phaseIndex] = simulation.GetLastStepPhaseSeconds(static_cast<PachinkoPhase>(phaseIndex));
+			}
+		}
+	}
+	double totalSeconds = GetSecondsSince(startTime);
+
+	printf("{\n");
+	printf("  \"config\": \"%s\",\n", configXMLFilePath);
+	printf("  \"recording\": \"%s\",\n", recordingFilePath);
+	printf("  \"sessions\": %d,\n", replayer.GetNumSessions());
+	printf("  \"numSteps\": %d,\n", replayer.GetNumStepsReplayed());
+	printf("  \"numThreads\": %d,\n", simulation.GetNumThreads());
+	printf("  \"ballsAtEnd\": %d,\n", simulation.GetBalls().GetNumBalls());
+	printf("  \"checksumsVerified\": %d,\n", replayer.GetNumChecksumsVerified());
+	printf("  \"checksumMismatches\": %d,\n", replayer.GetNumChecksumMismatches());
+	printf("  \"firstMismatchStep\": %d,\n", replayer.GetFirstMismatchStep());
+	printf("  \"truncated\": %s,\n", replayer.IsTruncated() ? "true" : "false");
+	printf("  \"invalid\": %s,\n", replayer.IsInvalid() ? "true" : "false");
+	printf("  \"slowestStep\": {\n");
+	printf("    \"index\": %d,\n", slowestStepIndex);
+	printf("    \"ns\": %.1f", slowestStepSeconds * 1.0e9);
+	for (int phaseIndex = 0; phaseIndex < PACHINKO_PHASE_COUNT; ++phaseIndex)
+	{
+		printf(",\n    \"%s\": %.1f", GetPachinkoPhaseName(static_cast<PachinkoPhase>(phaseIndex)), slowestStepPhaseSeconds[phaseIndex] * 1.0e9);
+	}
+	printf("\n  },\n");
+	PrintPhaseNsPerStep(totalSeconds, phaseSeconds, replayer.GetNumStepsReplayed());
+	printf("}\n");
+
+	return (replayer.GetNumChecksumMismatches() > 0 || replayer.IsInvalid()) ? 1 : 0;
+}
+
+//-----------------------------------------------------------------------------------------------
+// How far the deepest pair of balls overlaps and how fast balls move on average, so piles
+// settled with different solvers and steps can be compared; brute force, only run once
+static void MeasureBallPile(PachinkoBalls const& balls, float& out_maxOverlap, float& out_meanSpeed)
+{
+	out_maxOverlap = 0.f;
+	out_meanSpeed = 0.f;
+	for (int ballIndexA = 0; ballIndexA < balls.GetNumBalls(); ++ballIndexA)
+	{
+		for (int ballIndexB = ballIndexA + 1; ballIndexB < balls.GetNumBalls(); ++ballIndexB)
+		{
+			float deltaX = balls.m_positionX[ballIndexB] - balls.m_positionX[ballIndexA];
+			float deltaY = balls.m_positionY[ballIndexB] - balls.m_positionY[ballIndexA];
+			float overlap = balls.m_radius[ballIndexA] + balls.m_radius[ballIndexB] - sqrtf(deltaX * deltaX + deltaY * deltaY);
+			out_maxOverlap = fmaxf(out_maxOverlap, overlap);
+		}
+		out_meanSpeed += sqrtf(balls.m_velocityX[ballIndexA] * balls.m_velocityX[ballIndexA] + balls.m_velocityY[ballIndexA] * balls.m_velocityY[ballIndexA]);
+	}
+
+	if (balls.GetNumBalls() > 0)
+	{
+		out_meanSpeed /= static_cast<float>(balls.GetNumBalls());
+	}
+}
+
+//-----------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	char const* configXMLFilePath = "Data/PachinkoBenchmark.xml";
+	char const* recordingFilePath = nullptr;
+	for (int argIndex = 1; argIndex < argc; ++argIndex)
+	{
+		if (strcmp(argv[argIndex], "--replay") == 0 && argIndex + 1 < argc)
+		{
+			recordingFilePath = argv[argIndex + 1];
+			++argIndex;
+		}
+		else
+		{
+			configXMLFilePath = argv[argIndex];
+		}
+	}
+
+	if (!LoadBenchmarkConfig(configXMLFilePath))
+	{
+		return 1;
+	}
+
+	if (recordingFilePath != nullptr)
+	{
+		return RunReplay(configXMLFilePath, recordingFilePath);
+	}
+
+	int seed = g_gameConfigBlackboard.GetValue("benchmarkSeed", 1);
+	int numBalls = g_gameConfigBlackboard.GetValue("benchmarkNumBalls", 1000);
+	int numSteps = g_gameConfigBlackboard.GetValue("benchmarkNumSteps", 1000);
+	float timeStep = g_gameConfigBlackboard.GetValue("benchmarkTimeStep", 0.005f);
+	bool isBottomWarpOn = g_gameConfigBlackboard.GetValue("benchmarkBottomWarp", true);
+	bool isBallGridOn = g_gameConfigBlackboard.GetValue("benchmarkBallGrid", true);
+	bool isSleepingOn = g_gameConfigBlackboard.GetValue("benchmarkSleeping", true);
+	bool isContactSolverOn = g_gameConfigBlackboard.GetValue("benchmarkContactSolver", false);
+
+	if (!SeedBenchmarkRandomNumbers(static_cast<unsigned int>(seed)))
+	{
+		return 1;
+	}
+	RandomNumberGenerator rng;
+
+	PachinkoSimulation simulation;
+	simulation.RandomizeFixedShapes(rng);
+	if (simulation.IsBottomWarpOn() != isBottomWarpOn)
+	{
+		simulation.ToggleBottomWarp();
+	}
+	if (simulation.IsBallGridOn() != isBallGridOn)
+	{
+		simulation.ToggleBallGrid();
+	}
+	if (simulation.IsSleepingOn() != isSleepingOn)
+	{
+		simulation.ToggleSleeping();
+	}
+	if (simulation.IsContactSolverOn() != isContactSolverOn)
+	{
+		simulation.ToggleContactSolver();
+	}
+
+	for (int ballIndex = 0; ballIndex < numBalls; ++ballIndex)
+	{
+		float ballRadius = rng.RollRandomFloatInRange(simulation.GetMinBallRadius(), simulation.GetMaxBallRadius());
+		Vec2 ballCenter(rng.RollRandomFloatInRange(ballRadius, SCREEN_SIZE_X - ballRadius), rng.RollRandomFloatInRange(ballRadius, SCREEN_SIZE_Y - ballRadius));
+		Vec2 ballVelocity(rng.RollRandomFloatInRange(-200.f, 200.f), rng.RollRandomFloatInRange(-200.f, 200.f));
+		if (!simulation.SpawnBall(ballCenter, ballRadius, ballVelocity, 0.9f, Rgba8::WHITE))
+		{
+			fprintf(stderr, "Ball pool is full at %d balls, raise pachinkoMaxBalls\n", ballIndex);
+			return 1;
+		}
+	}
+
+	double phaseSeconds[PACHINKO_PHASE_COUNT] = {};
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (int stepIndex = 0; stepIndex < numSteps; ++stepIndex)
+	{
+		simulation.Step(timeStep);
+		for (int phaseIndex = 0; phaseIndex < PACHINKO_PHASE_COUNT; ++phaseIndex)
+		{
+			phaseSeconds[phaseIndex] += simulation.GetLastStepPhaseSeconds(static_cast<PachinkoPhase>(phaseIndex));
+		}
+	}
+	double totalSeconds = GetSecondsSince(startTime);
+
+	PachinkoBalls const& balls = simulation.GetBalls();
+	float maxOverlap = 0.f;
+	float meanSpeed = 0.f;
+	MeasureBallPile(balls, maxOverlap, meanSpeed);
+
+	printf("{\n");
+	printf("  \"config\": \"%s\",\n", configXMLFilePath);
+	printf("  \"seed\": %d,\n", seed);
+	printf("  \"numBalls\": %d,\n", balls.GetNumBalls());
+	printf("  \"numBumpers\": %d,\n", simulation.GetBumpers().GetNumBumpers());
+	printf("  \"numSteps\": %d,\n", numSteps);
+	printf("  \"timeStep\": %g,\n", timeStep);
+	printf("  \"numThreads\": %d,\n", simulation.GetNumThreads());
+	printf("  \"bottomWarp\": %s,\n", simulation.IsBottomWarpOn() ? "true" : "false");
+	printf("  \"ballGrid\": %s,\n", simulation.IsBallGridOn() ? "true" : "false");
+	printf("  \"sleeping\": %s,\n", simulation.IsSleepingOn() ? "true" : "false");
+	printf("  \"contactSolver\": %s,\n", simulation.IsContactSolverOn() ? "true" : "false");
+	printf("  \"solverIterations\": %d,\n", simulation.GetSolverIterations());
+	printf("  \"awakeBallsAtEnd\": %d,\n", balls.GetNumAwakeBalls());
+	printf("  \"sleepingBallsAtEnd\": %d,\n", balls.GetNumSleepingBalls());
+	printf("  \"maxOverlapAtEnd\": %.3f,\n", maxOverlap);
+	printf("  \"meanSpeedAtEnd\": %.3f,\n", meanSpeed);
+	PrintPhaseNsPerStep(totalSeconds, phaseSeconds, numSteps);
+	printf("}\n");
+
+	return 0;
+}
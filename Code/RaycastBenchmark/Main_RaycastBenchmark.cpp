@@ -0,0 +1,213 @@
+#include "Game/RaycastBatchBenchmark.hpp"
+#include "Game/RaycastScene2D.hpp"
+#include "Game/GameCommon.h"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Math/MathUtils.h"
+#include "Engine/Math/RandomNumberGenerator.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+//-----------------------------------------------------------------------------------------------
+// Headless 2D raycast benchmark: fills a RaycastScene2D with random shapes, fires a batch of rays
+// at it through the worker pool on 1, 2, 4... threads and prints rays per second, speedup and hit
+// ratio as JSON on stdout, first against every shape and then against each shape type alone, so
+// each RaycastUtils kernel has its own number. A sample of the rays is also checked against
+// RaycastNearestBruteForce. Exits with 1 if any thread count disagreed with brute force on a
+// sampled ray's nearest hit, or with the 1-thread run on any ray's.
+// Usage (from the Run folder): RaycastBenchmark [configFile]
+// The config defaults to Data/RaycastBenchmark.xml.
+//-----------------------------------------------------------------------------------------------
+static bool LoadBenchmarkConfig(char const* configXMLFilePath)
+{
+	XmlDocument configXml;
+	XmlError result = configXml.LoadFile(configXMLFilePath);
+	if (result != tinyxml2::XML_SUCCESS)
+	{
+		fprintf(stderr, "Failed to load benchmark config from file \"%s\"\n", configXMLFilePath);
+		return false;
+	}
+
+	XmlElement* rootElement = configXml.RootElement();
+	if (rootElement == nullptr)
+	{
+		fprintf(stderr, "Benchmark config from file \"%s\" was invalid (missing root element)\n", configXMLFilePath);
+		return false;
+	}
+
+	g_gameConfigBlackboard.PopulateFromXmlElementAttributes(*rootElement);
+	return true;
+}
+
+//-----------------------------------------------------------------------------------------------
+// The Engine RandomNumberGenerator has no seed of its own and rolls from the C runtime's rand(),
+// so srand is what makes a run repeatable. Checked rather than assumed: generators made after the
+// same srand must roll the same numbers, and another seed must change them.
+static bool SeedBenchmarkRandomNumbers(unsigned int seed)
+{
+	constexpr int NUM_CHECK_ROLLS = 4;
+	float otherSeedRolls[NUM_CHECK_ROLLS];
+	float firstRolls[NUM_CHECK_ROLLS];
+	float secondRolls[NUM_CHECK_ROLLS];
+
+	srand(seed + 1);
+	RandomNumberGenerator otherSeedRng;
+	for (int rollIndex = 0; rollIndex < NUM_CHECK_ROLLS; ++rollIndex)
+	{
+		otherSeedRolls[rollIndex] = otherSeedRng.RollRandomFloatZeroToOne();
+	}
+	srand(seed);
+	RandomNumberGenerator firstRng;
+	for (int rollIndex = 0; rollIndex < NUM_CHECK_ROLLS; ++rollIndex)
+	{
+		firstRolls[rollIndex] = firstRng.RollRandomFloatZeroToOne();
+	}
+	srand(seed);
+	RandomNumberGenerator secondRng;
+	for (int rollIndex = 0; rollIndex < NUM_CHECK_ROLLS; ++rollIndex)
+	{
+		secondRolls[rollIndex] = secondRng.RollRandomFloatZeroToOne();
+	}
+
+	bool isRepeatable = true;
+	bool isSeedUsed = false;
+	for (int rollIndex = 0; rollIndex < NUM_CHECK_ROLLS; ++rollIndex)
+	{
+		isRepeatable = isRepeatable && (firstRolls[rollIndex] == secondRolls[rollIndex]);
+		isSeedUsed = isSeedUsed || (firstRolls[rollIndex] != otherSeedRolls[rollIndex]);
+	}
+	if (!isRepeatable || !isSeedUsed)
+	{
+		fprintf(stderr, "The Engine RandomNumberGenerator no longer rolls from rand(), so srand cannot seed this benchmark\n");
+		return false;
+	}
+
+	srand(seed);
+	return true;
+}
+
+static double GetSecondsSince(std::chrono::steady_clock::time_point startTime)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// Prints one "runs" entry and returns its mismatch count, against 1 thread and brute force
+static int PrintBenchmarkRun(char const* shapesName, std::vector<RaycastBatchBenchmarkResult> const& results, bool isLastRun)
+{
+	int numMismatches = 0;
+	printf("    {\n");
+	printf("      \"shapes\": \"%s\",\n", shapesName);
+	printf("      \"threads\": [\n");
+	for (int resultIndex = 0; resultIndex < static_cast<int>(results.size()); ++resultIndex)
+	{
+		RaycastBatchBenchmarkResult const& result = results[resultIndex];
+		printf("        { \"numThreads\": %d, \"raysPerSecond\": %.0f, \"speedup\": %.3f, \"nodesPerRay\": %.2f, \"shapesPerRay\": %.2f, \"hitRatio\": %.4f, \"mismatches\": %d, "
+			"\"bruteForceRays\": %d, \"bruteForceMismatches\": %d }%s\n",
+			result.m_numThreads, result.m_raysPerSecond, result.m_speedup, result.m_nodesPerRay, result.m_shapesPerRay, result.m_hitRatio, result.m_numMismatches,
+			result.m_numBruteForceRays, result.m_numBruteForceMismatches, (resultIndex + 1 < static_cast<int>(results.size())) ? "," : "");
+		numMismatches += result.m_numMismatches + result.m_numBruteForceMismatches;
+	}
+	printf("      ]\n");
+	printf("    }%s\n", isLastRun ? "" : ",");
+	return numMismatches;
+}
+
+//-----------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	char const* configXMLFilePath = (argc > 1) ? argv[1] : "Data/RaycastBenchmark.xml";
+	if (!LoadBenchmarkConfig(configXMLFilePath))
+	{
+		return 1;
+	}
+
+	static char const* const SHAPE_COUNT_KEYS[RAYCAST_SHAPE_COUNT] =
+	{
+		"benchmarkNumDiscs", "benchmarkNumLineSegments", "benchmarkNumAABB2s", "benchmarkNumOBB2s", "benchmarkNumCapsules"
+	};
+
+	int seed = g_gameConfigBlackboard.GetValue("benchmarkSeed", 1);
+	float minShapeSize = g_gameConfigBlackboard.GetValue("benchmarkMinShapeSize", 2.5f);
+	float maxShapeSize = g_gameConfigBlackboard.GetValue("benchmarkMaxShapeSize", 10.f);
+	int numRays = g_gameConfigBlackboard.GetValue("benchmarkNumRays", 1000000);
+	RaycastBatchPattern rayPattern = GetRaycastBatchPatternFromName(g_gameConfigBlackboard.GetValue("benchmarkRayPattern", "grid"));
+	float rayLength = g_gameConfigBlackboard.GetValue("benchmarkRayLength", 400.f);
+	int numPasses = g_gameConfigBlackboard.GetValue("benchmarkNumPasses", 3);
+	int maxNumThreads = g_gameConfigBlackboard.GetValue("benchmarkMaxThreads", 0);
+	bool isPerShapeTypeOn = g_gameConfigBlackboard.GetValue("benchmarkPerShapeType", true);
+	int numBruteForceRays = g_gameConfigBlackboard.GetValue("benchmarkNumBruteForceRays", 1000);
+
+	int numShapesOfType[RAYCAST_SHAPE_COUNT] = {};
+	for (int shapeType = 0; shapeType < RAYCAST_SHAPE_COUNT; ++shapeType)
+	{
+		numShapesOfType[shapeType] = g_gameConfigBlackboard.GetValue(SHAPE_COUNT_KEYS[shapeType], 20000);
+	}
+
+	if (!SeedBenchmarkRandomNumbers(static_cast<unsigned int>(seed)))
+	{
+		return 1;
+	}
+	RandomNumberGenerator rng;
+
+	RaycastScene2D scene;
+	for (int shapeType = 0; shapeType < RAYCAST_SHAPE_COUNT; ++shapeType)
+	{
+		for (int shapeIndex = 0; shapeIndex < numShapesOfType[shapeType]; ++shapeIndex)
+		{
+			Vec2 center(rng.RollRandomFloatInRange(0.f, SCREEN_SIZE_X), rng.RollRandomFloatInRange(0.f, SCREEN_SIZE_Y));
+			float size = rng.RollRandomFloatInRange(minShapeSize, maxShapeSize);
+			float angle = rng.RollRandomFloatInRange(0.f, 360.f);
+			scene.AddShape(static_cast<RaycastShapeType>(shapeType), center, size, Vec2(CosDegrees(angle), SinDegrees(angle)));
+		}
+	}
+	std::chrono::steady_clock::time_point buildStartTime = std::chrono::steady_clock::now();
+	scene.BuildBVH();
+	double buildSeconds = GetSecondsSince(buildStartTime);
+
+	std::vector<BVH2DRay> rays;
+	GenerateRaycastBatchRays(rays, rayPattern, numRays, AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y)), rayLength, rng);
+
+	printf("{\n");
+	printf("  \"config\": \"%s\",\n", configXMLFilePath);
+	printf("  \"seed\": %d,\n", seed);
+	printf("  \"numShapes\": { ");
+	for (int shapeType = 0; shapeType < RAYCAST_SHAPE_COUNT; ++shapeType)
+	{
+		printf("\"%s\": %d, ", GetRaycastShapeTypeName(static_cast<RaycastShapeType>(shapeType)), numShapesOfType[shapeType]);
+	}
+	printf("\"all\": %d },\n", scene.GetNumShapes());
+	printf("  \"numRays\": %d,\n", numRays);
+	printf("  \"rayPattern\": \"%s\",\n", GetRaycastBatchPatternName(rayPattern));
+	printf("  \"rayLength\": %g,\n", rayLength);
+	printf("  \"numPasses\": %d,\n", numPasses);
+	printf("  \"numBruteForceRays\": %d,\n", numBruteForceRays);
+	printf("  \"bvhNodes\": %d,\n", scene.GetBVH().GetNumNodes());
+	printf("  \"bvhDepth\": %d,\n", scene.GetBVH().GetDepth());
+	printf("  \"bvhBuildMs\": %.3f,\n", buildSeconds * 1000.0);
+	printf("  \"runs\": [\n");
+
+	// Per shape type runs only see their own type through the shared BVH
+	std::vector<int> runShapeTypes;
+	runShapeTypes.push_back(-1);
+	for (int shapeType = 0; shapeType < RAYCAST_SHAPE_COUNT && isPerShapeTypeOn; ++shapeType)
+	{
+		if (numShapesOfType[shapeType] > 0)
+		{
+			runShapeTypes.push_back(shapeType);
+		}
+	}
+
+	int numMismatches = 0;
+	for (int runIndex = 0; runIndex < static_cast<int>(runShapeTypes.size()); ++runIndex)
+	{
+		int shapeType = runShapeTypes[runIndex];
+		unsigned int shapeTypeMask = (shapeType < 0) ? RAYCAST_SHAPE_MASK_ALL : GetRaycastShapeMask(static_cast<RaycastShapeType>(shapeType));
+		char const* shapesName = (shapeType < 0) ? "all" : GetRaycastShapeTypeName(static_cast<RaycastShapeType>(shapeType));
+		std::vector<RaycastBatchBenchmarkResult> results = RunRaycastBatchBenchmark(scene, rays, shapeTypeMask, maxNumThreads, numPasses, numBruteForceRays);
+		numMismatches += PrintBenchmarkRun(shapesName, results, runIndex + 1 == static_cast<int>(runShapeTypes.size()));
+	}
+	printf("  ]\n");
+	printf("}\n");
+
+	return (numMismatches > 0) ? 1 : 0;
+}